@@ -493,6 +493,10 @@ static const bool quick_menu_show_download_thumbnails         = true;
 
 #define DEFAULT_MENU_HORIZONTAL_ANIMATION true
 
+/* Stop redrawing the menu while nothing on screen
+ * changes (no input, animations or messages) */
+#define DEFAULT_MENU_SKIP_IDLE_FRAMES true
+
 static const bool menu_show_online_updater     = true;
 static const bool menu_show_load_core          = true;
 static const bool menu_show_load_content       = true;
@@ -884,6 +888,10 @@ static const int netplay_check_frames = 600;
 
 static const bool netplay_use_mitm_server = false;
 
+/* Send netplay input over UDP, with redundancy, rather than
+ * queueing it behind everything else on the TCP connection. */
+static const bool netplay_udp_input = false;
+
 #define DEFAULT_NETPLAY_MITM_SERVER "nyc"
 
 #ifdef HAVE_NETWORKING
@@ -1058,6 +1066,13 @@ static const unsigned menu_left_thumbnails_default = 0;
 
 static const unsigned gfx_thumbnail_upscale_threshold = 0;
 
+/* Size in MB of the thumbnail texture cache */
+static const unsigned gfx_thumbnail_cache_size = 64;
+
+/* Size in MB of the on-disk cache of pre-scaled
+ * thumbnail images */
+static const unsigned gfx_thumbnail_disk_cache_size = 256;
+
 #ifdef HAVE_MENU
 static const unsigned menu_timedate_style = MENU_TIMEDATE_STYLE_DDMM_HM;
 #endif
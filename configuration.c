@@ -1358,6 +1358,7 @@ static struct config_bool_setting *populate_settings_bool(settings_t *settings,
    SETTING_BOOL("netplay_stateless_mode",        &settings->bools.netplay_stateless_mode, true, netplay_stateless_mode, false);
    SETTING_OVERRIDE(RARCH_OVERRIDE_SETTING_NETPLAY_STATELESS_MODE);
    SETTING_BOOL("netplay_use_mitm_server",       &settings->bools.netplay_use_mitm_server, true, netplay_use_mitm_server, false);
+   SETTING_BOOL("netplay_udp_input",             &settings->bools.netplay_udp_input, true, netplay_udp_input, false);
    SETTING_BOOL("netplay_request_device_p1",     &settings->bools.netplay_request_devices[0], true, false, false);
    SETTING_BOOL("netplay_request_device_p2",     &settings->bools.netplay_request_devices[1], true, false, false);
    SETTING_BOOL("netplay_request_device_p3",     &settings->bools.netplay_request_devices[2], true, false, false);
@@ -1458,6 +1459,7 @@ static struct config_bool_setting *populate_settings_bool(settings_t *settings,
 #ifdef HAVE_MENU
    SETTING_BOOL("menu_unified_controls",         &settings->bools.menu_unified_controls, true, false, false);
    SETTING_BOOL("menu_throttle_framerate",       &settings->bools.menu_throttle_framerate, true, true, false);
+   SETTING_BOOL("menu_skip_idle_frames",         &settings->bools.menu_skip_idle_frames, true, DEFAULT_MENU_SKIP_IDLE_FRAMES, false);
    SETTING_BOOL("menu_linear_filter",            &settings->bools.menu_linear_filter, true, true, false);
    SETTING_BOOL("menu_horizontal_animation",     &settings->bools.menu_horizontal_animation, true, DEFAULT_MENU_HORIZONTAL_ANIMATION, false);
    SETTING_BOOL("menu_pause_libretro",           &settings->bools.menu_pause_libretro, true, true, false);
@@ -1793,6 +1795,8 @@ static struct config_uint_setting *populate_settings_uint(settings_t *settings,
    SETTING_UINT("menu_thumbnails",              &settings->uints.gfx_thumbnails, true, gfx_thumbnails_default, false);
    SETTING_UINT("menu_left_thumbnails",         &settings->uints.menu_left_thumbnails, true, menu_left_thumbnails_default, false);
    SETTING_UINT("menu_thumbnail_upscale_threshold", &settings->uints.gfx_thumbnail_upscale_threshold, true, gfx_thumbnail_upscale_threshold, false);
+   SETTING_UINT("menu_thumbnail_cache_size",    &settings->uints.gfx_thumbnail_cache_size, true, gfx_thumbnail_cache_size, false);
+   SETTING_UINT("menu_thumbnail_disk_cache_size", &settings->uints.gfx_thumbnail_disk_cache_size, true, gfx_thumbnail_disk_cache_size, false);
    SETTING_UINT("menu_timedate_style", &settings->uints.menu_timedate_style, true, menu_timedate_style, false);
    SETTING_UINT("menu_ticker_type",             &settings->uints.menu_ticker_type, true, DEFAULT_MENU_TICKER_TYPE, false);
 #ifdef HAVE_RGUI
@@ -3811,7 +3815,9 @@ bool config_save_file(const char *path)
    if (!conf)
       conf = config_file_new_alloc();
 
-   if (!conf || rarch_ctl(RARCH_CTL_IS_OVERRIDES_ACTIVE, NULL))
+   if (     !conf
+         || rarch_ctl(RARCH_CTL_IS_OVERRIDES_ACTIVE, NULL)
+         || rarch_ctl(RARCH_CTL_IS_BLOCK_CONFIG_WRITE, NULL))
    {
       if (conf)
          config_file_free(conf);
@@ -4051,7 +4057,9 @@ bool config_save_overrides(enum override_type type, void *data)
    if (!string_is_empty(rarch_path_basename))
       fill_pathname_parent_dir_name(content_dir_name, rarch_path_basename, sizeof(content_dir_name));
 
-   if (string_is_empty(core_name) || string_is_empty(game_name))
+   if (     string_is_empty(core_name)
+         || string_is_empty(game_name)
+         || rarch_ctl(RARCH_CTL_IS_BLOCK_CONFIG_WRITE, NULL))
       return false;
 
    settings           = (settings_t*)calloc(1, sizeof(settings_t));
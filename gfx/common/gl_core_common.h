@@ -40,6 +40,8 @@ RETRO_BEGIN_DECLS
 
 #define GL_CORE_NUM_TEXTURES 4
 #define GL_CORE_NUM_PBOS 4
+/* Frames the PBO readback keeps running after a screenshot */
+#define GL_CORE_SCREENSHOT_READBACK_FRAMES 300
 #define GL_CORE_NUM_VBOS 256
 #define GL_CORE_NUM_FENCES 8
 struct gl_core_streamed_texture
@@ -47,6 +49,15 @@ struct gl_core_streamed_texture
    GLuint tex;
    unsigned width;
    unsigned height;
+
+   /* Persistently mapped upload buffer handed to
+    * the core as its software framebuffer */
+   GLuint pbo;
+   GLsync fence;
+   void *mapped;
+   size_t pitch;
+   unsigned pbo_width;
+   unsigned pbo_height;
 };
 
 typedef struct gl_core
@@ -129,10 +140,13 @@ typedef struct gl_core
    GLsync fences[GL_CORE_NUM_FENCES];
    unsigned fence_count;
 
+   bool have_buffer_storage;
+
    void *readback_buffer_screenshot;
    struct scaler_ctx pbo_readback_scaler;
    bool pbo_readback_enable;
    unsigned pbo_readback_index;
+   unsigned pbo_readback_frames;
    bool pbo_readback_valid[GL_CORE_NUM_PBOS];
    GLuint pbo_readback[GL_CORE_NUM_PBOS];
 } gl_core_t;
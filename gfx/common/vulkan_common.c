@@ -859,24 +859,99 @@ struct vk_texture vulkan_create_texture(vk_t *vk,
 #endif
       vkQueueSubmit(vk->context->queue,
             1, &submit_info, VK_NULL_HANDLE);
-
-      /* TODO: Very crude, but texture uploads only happen
-       * during init, so waiting for GPU to complete transfer
-       * and blocking isn't a big deal. */
-      vkQueueWaitIdle(vk->context->queue);
 #ifdef HAVE_THREADS
       slock_unlock(vk->context->queue_lock);
 #endif
 
-      vkFreeCommandBuffers(vk->context->device,
-            vk->staging_pool, 1, &staging);
-      vulkan_destroy_texture(
-            vk->context->device, &tmp);
+      /* Don't wait for the transfer (and mipmap generation)
+       * to complete - frames are submitted to the same queue,
+       * so will not sample the texture before it is ready.
+       * Staging buffer is released with the next frame */
+      if (!vulkan_deferred_push(vk, &tmp, staging))
+      {
+#ifdef HAVE_THREADS
+         slock_lock(vk->context->queue_lock);
+#endif
+         vkQueueWaitIdle(vk->context->queue);
+#ifdef HAVE_THREADS
+         slock_unlock(vk->context->queue_lock);
+#endif
+
+         vkFreeCommandBuffers(vk->context->device,
+               vk->staging_pool, 1, &staging);
+         vulkan_destroy_texture(
+               vk->context->device, &tmp);
+      }
       tex.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
    }
    return tex;
 }
 
+bool vulkan_deferred_push(vk_t *vk,
+      const struct vk_texture *tex, VkCommandBuffer cmd)
+{
+   struct vk_deferred_item *item = NULL;
+   struct vk_per_frame *chain    =
+      &vk->swapchain[vk->context->current_swapchain_index];
+
+   if (chain->num_deferred >= chain->cap_deferred)
+   {
+      unsigned new_cap                   = chain->cap_deferred
+         ? chain->cap_deferred * 2 : 16;
+      struct vk_deferred_item *deferred  = (struct vk_deferred_item*)
+         realloc(chain->deferred, new_cap * sizeof(*deferred));
+
+      if (!deferred)
+         return false;
+
+      chain->deferred     = deferred;
+      chain->cap_deferred = new_cap;
+   }
+
+   item = &chain->deferred[chain->num_deferred++];
+
+   if (tex)
+      item->texture = *tex;
+   else
+      memset(&item->texture, 0, sizeof(item->texture));
+   item->cmd = cmd;
+
+   return true;
+}
+
+void vulkan_deferred_retire(struct vk_per_frame *chain)
+{
+   chain->num_deferred_retired = chain->num_deferred;
+}
+
+void vulkan_deferred_flush(vk_t *vk,
+      struct vk_per_frame *chain, bool all)
+{
+   unsigned i;
+   unsigned count = all ? chain->num_deferred : chain->num_deferred_retired;
+
+   if (count == 0)
+      return;
+
+   for (i = 0; i < count; i++)
+   {
+      struct vk_deferred_item *item = &chain->deferred[i];
+
+      if (item->cmd != VK_NULL_HANDLE)
+         vkFreeCommandBuffers(vk->context->device,
+               vk->staging_pool, 1, &item->cmd);
+      if (item->texture.memory != VK_NULL_HANDLE)
+         vulkan_destroy_texture(vk->context->device, &item->texture);
+   }
+
+   /* Keep items released after the last submission */
+   chain->num_deferred        -= count;
+   chain->num_deferred_retired = 0;
+   if (chain->num_deferred)
+      memmove(chain->deferred, chain->deferred + count,
+            chain->num_deferred * sizeof(*chain->deferred));
+}
+
 void vulkan_destroy_texture(
       VkDevice device,
       struct vk_texture *tex)
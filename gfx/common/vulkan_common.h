@@ -283,6 +283,16 @@ struct vk_descriptor_manager
    unsigned num_sizes;
 };
 
+/* A resource released while a frame was being
+ * prepared. It may still be referenced by GPU work,
+ * so it is destroyed only once the fence of the
+ * frame that follows it has been waited on */
+struct vk_deferred_item
+{
+   struct vk_texture texture;
+   VkCommandBuffer cmd;
+};
+
 struct vk_per_frame
 {
    struct vk_image backbuffer;
@@ -294,6 +304,13 @@ struct vk_per_frame
 
    VkCommandPool cmd_pool;
    VkCommandBuffer cmd;
+
+   struct vk_deferred_item *deferred;
+   unsigned num_deferred;
+   /* Leading items in 'deferred' that were released
+    * before this frame was last submitted */
+   unsigned num_deferred_retired;
+   unsigned cap_deferred;
 };
 
 struct vk_draw_quad
@@ -455,6 +472,25 @@ struct vk_texture vulkan_create_texture(vk_t *vk,
       const void *initial, const VkComponentMapping *swizzle,
       enum vk_texture_type type);
 
+/* Queues a texture and/or transfer command buffer
+ * for destruction once the GPU has finished the
+ * frame currently being prepared
+ * > Returns false on allocation failure, in which
+ *   case the caller must destroy them immediately */
+bool vulkan_deferred_push(vk_t *vk,
+      const struct vk_texture *tex, VkCommandBuffer cmd);
+
+/* Marks all deferred items of 'chain' as covered by
+ * the fence of the submission just made for it */
+void vulkan_deferred_retire(struct vk_per_frame *chain);
+
+/* Destroys deferred items of 'chain'. If 'all' is
+ * false, only retired items are destroyed (fence of
+ * 'chain' must have been waited on); otherwise the
+ * queue must be idle */
+void vulkan_deferred_flush(vk_t *vk,
+      struct vk_per_frame *chain, bool all);
+
 void vulkan_sync_texture_to_gpu(vk_t *vk, const struct vk_texture *tex);
 void vulkan_sync_texture_to_cpu(vk_t *vk, const struct vk_texture *tex);
 
@@ -54,6 +54,7 @@
 #include "../../configuration.h"
 #include "../../dynamic.h"
 
+#include "../../performance_counters.h"
 #include "../../retroarch.h"
 #include "../../verbosity.h"
 #include "../common/gl_common.h"
@@ -157,6 +158,24 @@ typedef struct __GLsync *GLsync;
 #endif
 #endif
 
+#if !defined(HAVE_OPENGLES) && defined(HAVE_GL_SYNC)
+#define HAVE_GL_SW_FRAMEBUFFER
+#endif
+
+#ifdef HAVE_GL_SW_FRAMEBUFFER
+/* Persistently mapped upload buffer handed to
+ * the core as its software framebuffer */
+struct gl2_sw_framebuffer
+{
+   GLuint pbo;
+   GLsync fence;
+   void *mapped;
+   size_t pitch;
+   unsigned width;
+   unsigned height;
+};
+#endif
+
 typedef struct gl2_renderchain_data
 {
    bool egl_images;
@@ -178,6 +197,12 @@ typedef struct gl2_renderchain_data
    GLsync fences[MAX_FENCES];
 #endif
 
+#ifdef HAVE_GL_SW_FRAMEBUFFER
+   bool has_buffer_storage;
+   /* One per streamed texture */
+   struct gl2_sw_framebuffer sw_fb[GFX_MAX_TEXTURES];
+#endif
+
    struct gfx_fbo_scale fbo_scale[GFX_MAX_SHADERS];
 } gl2_renderchain_data_t;
 
@@ -1391,6 +1416,105 @@ error:
    glDisable(GL_DITHER)
 #endif
 
+#ifdef HAVE_GL_SW_FRAMEBUFFER
+static void gl2_renderchain_free_sw_framebuffer(
+      struct gl2_sw_framebuffer *sw_fb)
+{
+   if (sw_fb->fence)
+      glDeleteSync(sw_fb->fence);
+   /* Deleting the buffer also unmaps it */
+   if (sw_fb->pbo != 0)
+      glDeleteBuffers(1, &sw_fb->pbo);
+
+   memset(sw_fb, 0, sizeof(*sw_fb));
+}
+
+static void gl2_renderchain_free_sw_framebuffers(
+      gl2_renderchain_data_t *chain)
+{
+   unsigned i;
+
+   if (!chain)
+      return;
+
+   for (i = 0; i < GFX_MAX_TEXTURES; i++)
+      gl2_renderchain_free_sw_framebuffer(&chain->sw_fb[i]);
+}
+
+static bool gl2_renderchain_init_sw_framebuffer(gl_t *gl,
+      struct gl2_sw_framebuffer *sw_fb,
+      unsigned width, unsigned height)
+{
+   /* Readable too, the frontend may send the same frame again */
+   GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT
+      | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+   size_t pitch     = width * gl->base_size;
+
+   gl2_renderchain_free_sw_framebuffer(sw_fb);
+
+   glGenBuffers(1, &sw_fb->pbo);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, sw_fb->pbo);
+   glBufferStorage(GL_PIXEL_UNPACK_BUFFER, pitch * height, NULL, flags);
+   sw_fb->mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+         0, pitch * height, flags);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+   if (!sw_fb->mapped)
+   {
+      gl2_renderchain_free_sw_framebuffer(sw_fb);
+      return false;
+   }
+
+   sw_fb->pitch  = pitch;
+   sw_fb->width  = width;
+   sw_fb->height = height;
+   return true;
+}
+
+/* Returns true if the core rendered straight into one
+ * of our upload buffers, in which case the texture is
+ * filled from it on the GPU without a CPU copy. */
+static bool gl2_renderchain_upload_sw_framebuffer(
+      gl_t *gl,
+      gl2_renderchain_data_t *chain,
+      const void *frame,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   unsigned i;
+   struct gl2_sw_framebuffer *sw_fb = NULL;
+
+   if (!chain->has_buffer_storage)
+      return false;
+
+   for (i = 0; i < GFX_MAX_TEXTURES; i++)
+   {
+      if (chain->sw_fb[i].mapped && frame == chain->sw_fb[i].mapped)
+      {
+         sw_fb = &chain->sw_fb[i];
+         break;
+      }
+   }
+
+   if (!sw_fb)
+      return false;
+
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, sw_fb->pbo);
+   glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(pitch));
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / gl->base_size);
+   glTexSubImage2D(GL_TEXTURE_2D,
+         0, 0, 0, width, height, gl->texture_type,
+         gl->texture_fmt, NULL);
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+   /* The buffer can be written again once the upload is done */
+   if (sw_fb->fence)
+      glDeleteSync(sw_fb->fence);
+   sw_fb->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   return true;
+}
+#endif
+
 static void gl2_renderchain_copy_frame(
       gl_t *gl,
       gl2_renderchain_data_t *chain,
@@ -1498,6 +1622,13 @@ static void gl2_renderchain_copy_frame(
 #else
    {
       const GLvoid *data_buf = frame;
+
+#ifdef HAVE_GL_SW_FRAMEBUFFER
+      if (gl2_renderchain_upload_sw_framebuffer(gl, chain,
+               frame, width, height, pitch))
+         return;
+#endif
+
       glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(pitch));
 
       if (gl->base_size == 2 && !gl->have_es2_compat)
@@ -1649,6 +1780,15 @@ static void gl2_renderchain_resolve_extensions(gl_t *gl,
       && gl_check_capability(GL_CAPS_EGLIMAGE) 
       && gl->ctx_driver->image_buffer_init
       && gl->ctx_driver->image_buffer_init(gl->ctx_data, video);
+
+#ifdef HAVE_GL_SW_FRAMEBUFFER
+   chain->has_buffer_storage        = !gl->hw_render_use
+      && gl->have_sync
+      && gl_check_capability(GL_CAPS_BUFFER_STORAGE);
+
+   if (chain->has_buffer_storage)
+      RARCH_LOG("[GL]: Using persistently mapped buffers for software framebuffers.\n");
+#endif
 }
 
 static void gl_load_texture_data(
@@ -2812,6 +2952,7 @@ static bool gl2_frame(void *data, const void *frame,
 {
    video_shader_ctx_params_t params;
    struct video_tex_info feedback_info;
+   retro_time_t span_start             = 0;
    gl_t                            *gl = (gl_t*)data;
    gl2_renderchain_data_t       *chain = (gl2_renderchain_data_t*)gl->renderchain_data;
    unsigned width                      = gl->video_width;
@@ -3106,7 +3247,9 @@ static bool gl2_frame(void *data, const void *frame,
    }
 #endif
 
+   span_start = perf_span_begin();
    gl->ctx_driver->swap_buffers(context_data);
+   perf_span_end(PERF_SPAN_PRESENT, span_start);
 
    /* check if we are fast forwarding or in menu, if we are ignore hard sync */
    if (  gl->have_sync
@@ -3116,8 +3259,10 @@ static bool gl2_frame(void *data, const void *frame,
    {
       glClear(GL_COLOR_BUFFER_BIT);
 
+      span_start = perf_span_begin();
       gl2_renderchain_fence_iterate(gl, chain,
             hard_sync_frames);
+      perf_span_end(PERF_SPAN_SYNC_WAIT, span_start);
    }
 
 #ifndef HAVE_OPENGLES
@@ -3208,6 +3353,11 @@ static void gl2_free(void *data)
    }
 #endif
 
+#ifdef HAVE_GL_SW_FRAMEBUFFER
+   gl2_renderchain_free_sw_framebuffers(
+         (gl2_renderchain_data_t*)gl->renderchain_data);
+#endif
+
    gl2_renderchain_deinit_fbo(gl, (gl2_renderchain_data_t*)gl->renderchain_data);
    gl2_renderchain_deinit_hw_render(gl, (gl2_renderchain_data_t*)gl->renderchain_data);
    gl2_deinit_chain(gl);
@@ -4505,6 +4655,67 @@ static uint32_t gl2_get_flags(void *data)
    return flags;
 }
 
+#ifdef HAVE_GL_SW_FRAMEBUFFER
+static bool gl2_get_current_sw_framebuffer(void *data,
+      struct retro_framebuffer *framebuffer)
+{
+   struct gl2_sw_framebuffer *sw_fb = NULL;
+   gl2_renderchain_data_t *chain    = NULL;
+   gl_t *gl                         = (gl_t*)data;
+
+   if (!gl || gl->hw_render_fbo_init)
+      return false;
+
+   chain = (gl2_renderchain_data_t*)gl->renderchain_data;
+
+   if (!chain || !chain->has_buffer_storage)
+      return false;
+
+   /* 16-bit frames are converted on the CPU
+    * unless GL_RGB565 textures are supported */
+   if (gl->base_size != sizeof(uint32_t) && !gl->have_es2_compat)
+      return false;
+
+   /* The next frame goes to the next texture, see gl2_frame */
+   sw_fb = &chain->sw_fb[(gl->tex_index + 1) % gl->textures];
+
+   gl2_context_bind_hw_render(gl, false);
+
+   if (     sw_fb->width  != framebuffer->width
+         || sw_fb->height != framebuffer->height)
+   {
+      if (!gl2_renderchain_init_sw_framebuffer(gl, sw_fb,
+               framebuffer->width, framebuffer->height))
+      {
+         chain->has_buffer_storage = false;
+         RARCH_WARN("[GL]: Failed to map software framebuffer.\n");
+         gl2_context_bind_hw_render(gl, true);
+         return false;
+      }
+   }
+   else if (sw_fb->fence)
+   {
+      /* Uploaded gl->textures frames ago,
+       * so this rarely has to wait. */
+      glClientWaitSync(sw_fb->fence,
+            GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+      glDeleteSync(sw_fb->fence);
+      sw_fb->fence = NULL;
+   }
+
+   gl2_context_bind_hw_render(gl, true);
+
+   framebuffer->data         = sw_fb->mapped;
+   framebuffer->pitch        = sw_fb->pitch;
+   framebuffer->format       = (gl->base_size == sizeof(uint32_t))
+      ? RETRO_PIXEL_FORMAT_XRGB8888 : RETRO_PIXEL_FORMAT_RGB565;
+   /* Write-combined, so reading back is slow */
+   framebuffer->memory_flags = 0;
+
+   return true;
+}
+#endif
+
 static const video_poke_interface_t gl2_poke_interface = {
    gl2_get_flags,
    gl2_load_texture,
@@ -4525,7 +4736,11 @@ static const video_poke_interface_t gl2_poke_interface = {
    gl2_show_mouse,
    NULL,
    gl2_get_current_shader,
+#ifdef HAVE_GL_SW_FRAMEBUFFER
+   gl2_get_current_sw_framebuffer,
+#else
    NULL,                      /* get_current_software_framebuffer */
+#endif
    NULL                       /* get_hw_render_interface */
 };
 
@@ -34,6 +34,7 @@
 #include "../../configuration.h"
 #include "../../dynamic.h"
 #include "../../managers/state_manager.h"
+#include "../../performance_counters.h"
 
 #include "../../retroarch.h"
 #include "../../verbosity.h"
@@ -254,7 +255,9 @@ static void gl_core_slow_readback(gl_core_t *gl, void *buffer)
 
 static void gl_core_pbo_async_readback(gl_core_t *gl)
 {
-   glBindBuffer(GL_PIXEL_PACK_BUFFER, gl->pbo_readback[gl->pbo_readback_index++]);
+   unsigned index = gl->pbo_readback_index++;
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, gl->pbo_readback[index]);
    glPixelStorei(GL_PACK_ALIGNMENT, 4);
    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
 #ifndef HAVE_OPENGLES
@@ -262,7 +265,8 @@ static void gl_core_pbo_async_readback(gl_core_t *gl)
 #endif
    if (gl->pbo_readback_index >= GL_CORE_NUM_PBOS)
       gl->pbo_readback_index = 0;
-   gl->pbo_readback_valid[gl->pbo_readback_index] = true;
+   /* Read back once the ring wraps around to it */
+   gl->pbo_readback_valid[index] = true;
 
    glReadPixels(gl->vp.x, gl->vp.y,
                 gl->vp.width, gl->vp.height,
@@ -544,6 +548,23 @@ static void gl_core_deinit_hw_render(gl_core_t *gl)
    gl->hw_render_enable = false;
 }
 
+static void gl_core_free_streamed_buffer(
+      struct gl_core_streamed_texture *streamed)
+{
+   if (streamed->fence)
+      glDeleteSync(streamed->fence);
+   /* Deleting the buffer also unmaps it */
+   if (streamed->pbo != 0)
+      glDeleteBuffers(1, &streamed->pbo);
+
+   streamed->fence      = NULL;
+   streamed->pbo        = 0;
+   streamed->mapped     = NULL;
+   streamed->pitch      = 0;
+   streamed->pbo_width  = 0;
+   streamed->pbo_height = 0;
+}
+
 static void gl_core_destroy_resources(gl_core_t *gl)
 {
    unsigned i;
@@ -564,6 +585,7 @@ static void gl_core_destroy_resources(gl_core_t *gl)
    {
       if (gl->textures[i].tex != 0)
          glDeleteTextures(1, &gl->textures[i].tex);
+      gl_core_free_streamed_buffer(&gl->textures[i]);
    }
    memset(gl->textures, 0, sizeof(gl->textures));
 
@@ -1257,6 +1279,10 @@ static void *gl_core_init(const video_info_t *video,
    if (!string_is_empty(version))
       sscanf(version, "%u.%u", &gl->version_major, &gl->version_minor);
 
+   gl->have_buffer_storage = gl_check_capability(GL_CAPS_BUFFER_STORAGE);
+   if (gl->have_buffer_storage)
+      RARCH_LOG("[GLCore]: Using persistently mapped buffers for software framebuffers.\n");
+
    {
       char device_str[128];
 
@@ -1677,14 +1703,33 @@ static bool gl_core_read_viewport(void *data, uint8_t *buffer, bool is_idle)
 {
    gl_core_t *gl = (gl_core_t*)data;
    unsigned num_pixels = 0;
+   bool use_pbo        = false;
 
    if (!gl)
       return false;
 
    gl_core_context_bind_hw_render(gl, false);
    num_pixels = gl->vp.width * gl->vp.height;
+   use_pbo    = gl->pbo_readback_enable;
 
-   if (gl->pbo_readback_enable)
+   /* Readback kept running by an earlier screenshot */
+   if (gl->pbo_readback_frames)
+   {
+      if (     gl->pbo_readback_scaler.in_width  != gl->vp.width
+            || gl->pbo_readback_scaler.in_height != gl->vp.height)
+      {
+         gl_core_deinit_pbo_readback(gl);
+         gl->pbo_readback_enable = false;
+         gl->pbo_readback_frames = 0;
+      }
+      else
+         gl->pbo_readback_frames = GL_CORE_SCREENSHOT_READBACK_FRAMES;
+
+      use_pbo = gl->pbo_readback_enable && !is_idle
+         && gl->pbo_readback_valid[gl->pbo_readback_index];
+   }
+
+   if (use_pbo)
    {
       const void *ptr = NULL;
       struct scaler_ctx *ctx = &gl->pbo_readback_scaler;
@@ -1731,6 +1776,23 @@ static bool gl_core_read_viewport(void *data, uint8_t *buffer, bool is_idle)
 
       free(gl->readback_buffer_screenshot);
       gl->readback_buffer_screenshot = NULL;
+
+      /* Screenshots tend to come in bursts. Keep reading back
+       * every frame for a while, so the next ones only map a
+       * frame which is already on its way to the CPU instead
+       * of rendering and waiting for one. */
+      if (!is_idle && !gl->pbo_readback_enable)
+      {
+         gl->pbo_readback_index = 0;
+         memset(gl->pbo_readback_valid, 0,
+               sizeof(gl->pbo_readback_valid));
+
+         if (gl_core_init_pbo_readback(gl))
+         {
+            gl->pbo_readback_enable = true;
+            gl->pbo_readback_frames = GL_CORE_SCREENSHOT_READBACK_FRAMES;
+         }
+      }
    }
 
    gl_core_context_bind_hw_render(gl, true);
@@ -1765,6 +1827,34 @@ static void gl_core_update_cpu_texture(gl_core_t *gl,
    else
       glBindTexture(GL_TEXTURE_2D, streamed->tex);
 
+   /* The core rendered straight into our upload buffer,
+    * so the GPU can copy from it without a CPU copy. */
+   if (frame && frame == streamed->mapped)
+   {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, streamed->pbo);
+      if (gl->video_info.rgb32)
+      {
+         glPixelStorei(GL_UNPACK_ROW_LENGTH, streamed->pitch >> 2);
+         glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+               width, height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+      }
+      else
+      {
+         glPixelStorei(GL_UNPACK_ROW_LENGTH, streamed->pitch >> 1);
+         glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+               width, height, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, NULL);
+      }
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+      /* The buffer can be written again once the upload is done */
+      if (streamed->fence)
+         glDeleteSync(streamed->fence);
+      streamed->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      return;
+   }
+
    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
    if (gl->video_info.rgb32)
    {
@@ -1836,6 +1926,7 @@ static bool gl_core_frame(void *data, const void *frame,
 {
    struct gl_core_filter_chain_texture texture;
    struct gl_core_streamed_texture *streamed   = NULL;
+   retro_time_t span_start                     = 0;
    gl_core_t *gl                               = (gl_core_t*)data;
    unsigned width                              = video_info->width;
    unsigned height                             = video_info->height;
@@ -1963,6 +2054,13 @@ static bool gl_core_frame(void *data, const void *frame,
       if (!gl->menu_texture_enable)
 #endif
          gl_core_pbo_async_readback(gl);
+
+      /* No screenshots for a while, stop reading back */
+      if (gl->pbo_readback_frames && --gl->pbo_readback_frames == 0)
+      {
+         gl_core_deinit_pbo_readback(gl);
+         gl->pbo_readback_enable = false;
+      }
    }
 
    /* Disable BFI during fast forward, slow-motion,
@@ -1977,13 +2075,17 @@ static bool gl_core_frame(void *data, const void *frame,
       glClear(GL_COLOR_BUFFER_BIT);
    }
 
+   span_start = perf_span_begin();
    gl->ctx_driver->swap_buffers(context_data);
+   perf_span_end(PERF_SPAN_PRESENT, span_start);
 
    if (video_info->hard_sync &&
        !input_driver_nonblock_state &&
        !gl->menu_texture_enable)
    {
+      span_start = perf_span_begin();
       gl_core_fence_iterate(gl, hard_sync_frames);
+      perf_span_end(PERF_SPAN_SYNC_WAIT, span_start);
    }
 
    glBindVertexArray(0);
@@ -2029,6 +2131,85 @@ static void gl_core_apply_state_changes(void *data)
       gl->should_resize = true;
 }
 
+static bool gl_core_init_streamed_buffer(gl_core_t *gl,
+      struct gl_core_streamed_texture *streamed,
+      unsigned width, unsigned height)
+{
+#ifndef HAVE_OPENGLES
+   /* Readable too, the frontend may send the same frame again */
+   GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT
+      | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+   size_t pitch     = width * (gl->video_info.rgb32
+         ? sizeof(uint32_t) : sizeof(uint16_t));
+
+   gl_core_free_streamed_buffer(streamed);
+
+   glGenBuffers(1, &streamed->pbo);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, streamed->pbo);
+   glBufferStorage(GL_PIXEL_UNPACK_BUFFER, pitch * height, NULL, flags);
+   streamed->mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+         0, pitch * height, flags);
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+   if (!streamed->mapped)
+   {
+      gl_core_free_streamed_buffer(streamed);
+      return false;
+   }
+
+   streamed->pitch      = pitch;
+   streamed->pbo_width  = width;
+   streamed->pbo_height = height;
+   return true;
+#else
+   return false;
+#endif
+}
+
+static bool gl_core_get_current_sw_framebuffer(void *data,
+      struct retro_framebuffer *framebuffer)
+{
+   struct gl_core_streamed_texture *streamed = NULL;
+   gl_core_t *gl                             = (gl_core_t*)data;
+
+   if (!gl || !gl->have_buffer_storage || gl->hw_render_enable)
+      return false;
+
+   /* The next frame goes to the next texture, see gl_core_frame */
+   streamed = &gl->textures[
+      (gl->textures_index + 1) & (GL_CORE_NUM_TEXTURES - 1)];
+
+   if (     streamed->pbo_width  != framebuffer->width
+         || streamed->pbo_height != framebuffer->height)
+   {
+      if (!gl_core_init_streamed_buffer(gl, streamed,
+               framebuffer->width, framebuffer->height))
+      {
+         gl->have_buffer_storage = false;
+         RARCH_WARN("[GLCore]: Failed to map software framebuffer.\n");
+         return false;
+      }
+   }
+   else if (streamed->fence)
+   {
+      /* Uploaded GL_CORE_NUM_TEXTURES frames ago,
+       * so this rarely has to wait. */
+      glClientWaitSync(streamed->fence,
+            GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+      glDeleteSync(streamed->fence);
+      streamed->fence = NULL;
+   }
+
+   framebuffer->data         = streamed->mapped;
+   framebuffer->pitch        = streamed->pitch;
+   framebuffer->format       = gl->video_info.rgb32
+      ? RETRO_PIXEL_FORMAT_XRGB8888 : RETRO_PIXEL_FORMAT_RGB565;
+   /* Write-combined, so reading back is slow */
+   framebuffer->memory_flags = 0;
+
+   return true;
+}
+
 static struct video_shader *gl_core_get_current_shader(void *data)
 {
    gl_core_t *gl = (gl_core_t*)data;
@@ -2230,7 +2411,7 @@ static const video_poke_interface_t gl_core_poke_interface = {
    gl_core_show_mouse,
    NULL,                               /* grab_mouse_toggle */
    gl_core_get_current_shader,
-   NULL,
+   gl_core_get_current_sw_framebuffer,
    NULL,
 };
 
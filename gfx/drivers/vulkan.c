@@ -27,6 +27,8 @@
 #include <retro_math.h>
 #include <retro_assert.h>
 #include <string/stdstring.h>
+#include <file/file_path.h>
+#include <streams/file_stream.h>
 #include <libretro.h>
 
 #ifdef HAVE_CONFIG_H
@@ -47,6 +49,7 @@
 #include "../../driver.h"
 #include "../../configuration.h"
 #include "../../managers/state_manager.h"
+#include "../../performance_counters.h"
 
 #include "../../retroarch.h"
 #include "../../verbosity.h"
@@ -864,6 +867,136 @@ static void vulkan_init_resources(vk_t *vk)
    vulkan_init_command_buffers(vk);
 }
 
+/* Pipeline cache data is only valid for the device and
+ * driver build it came from, which its header identifies
+ * by pipelineCacheUUID - one file is kept per UUID. */
+static void vulkan_pipeline_cache_path(vk_t *vk, char *s, size_t len)
+{
+   unsigned i;
+   char name[64];
+   char dir[PATH_MAX_LENGTH];
+   const VkPhysicalDeviceProperties *props = &vk->context->gpu_properties;
+
+   *s = '\0';
+
+   video_driver_get_shader_cache_dir(dir, sizeof(dir), "vulkan");
+   if (string_is_empty(dir))
+      return;
+
+   for (i = 0; i < VK_UUID_SIZE; i++)
+      snprintf(name + i * 2, sizeof(name) - i * 2, "%02x",
+            props->pipelineCacheUUID[i]);
+   strlcat(name, ".bin", sizeof(name));
+
+   fill_pathname_join(s, dir, name, len);
+}
+
+static bool vulkan_pipeline_cache_is_valid(vk_t *vk,
+      const uint8_t *data, int64_t len)
+{
+   uint32_t header[4];
+   const VkPhysicalDeviceProperties *props = &vk->context->gpu_properties;
+
+   /* Header: length, version, vendor ID, device ID, then UUID */
+   if (len < (int64_t)(sizeof(header) + VK_UUID_SIZE))
+      return false;
+
+   memcpy(header, data, sizeof(header));
+
+   return header[0] >= sizeof(header) + VK_UUID_SIZE
+      && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+      && header[2] == props->vendorID
+      && header[3] == props->deviceID
+      && !memcmp(data + sizeof(header),
+            props->pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+static void vulkan_load_pipeline_cache(vk_t *vk)
+{
+   char path[PATH_MAX_LENGTH];
+   void *data                      = NULL;
+   int64_t len                     = 0;
+   VkPipelineCacheCreateInfo cache = {
+      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+
+   vulkan_pipeline_cache_path(vk, path, sizeof(path));
+
+   if (     !string_is_empty(path)
+         && path_is_valid(path)
+         && filestream_read_file(path, &data, &len))
+   {
+      if (vulkan_pipeline_cache_is_valid(vk, (const uint8_t*)data, len))
+      {
+         cache.initialDataSize = (size_t)len;
+         cache.pInitialData    = data;
+         RARCH_LOG("[Vulkan]: Loaded pipeline cache \"%s\".\n", path);
+      }
+      else
+         RARCH_WARN("[Vulkan]: Ignoring stale pipeline cache \"%s\".\n",
+               path);
+   }
+
+   if (vkCreatePipelineCache(vk->context->device,
+            &cache, NULL, &vk->pipelines.cache) != VK_SUCCESS
+         && cache.pInitialData)
+   {
+      /* Drivers may still refuse data that passed the header
+       * check; start over from an empty cache then */
+      cache.initialDataSize = 0;
+      cache.pInitialData    = NULL;
+      vkCreatePipelineCache(vk->context->device,
+            &cache, NULL, &vk->pipelines.cache);
+   }
+
+   free(data);
+}
+
+static void vulkan_save_pipeline_cache(vk_t *vk)
+{
+   char path[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH];
+   char dir[PATH_MAX_LENGTH];
+   size_t len = 0;
+   void *data = NULL;
+
+   if (vk->pipelines.cache == VK_NULL_HANDLE)
+      return;
+
+   vulkan_pipeline_cache_path(vk, path, sizeof(path));
+   if (string_is_empty(path))
+      return;
+
+   if (vkGetPipelineCacheData(vk->context->device,
+            vk->pipelines.cache, &len, NULL) != VK_SUCCESS || !len)
+      return;
+
+   if (!(data = malloc(len)))
+      return;
+
+   if (vkGetPipelineCacheData(vk->context->device,
+            vk->pipelines.cache, &len, data) != VK_SUCCESS)
+      goto end;
+
+   fill_pathname_basedir(dir, path, sizeof(dir));
+   if (!path_is_directory(dir) && !path_mkdir(dir))
+      goto end;
+
+   /* Write next to the final file and rename it into place,
+    * so an interrupted write never leaves a truncated cache */
+   strlcpy(tmp_path, path, sizeof(tmp_path));
+   strlcat(tmp_path, ".tmp", sizeof(tmp_path));
+
+   if (filestream_write_file(tmp_path, data, len))
+   {
+      filestream_delete(path);
+      if (filestream_rename(tmp_path, path) != 0)
+         filestream_delete(tmp_path);
+   }
+
+end:
+   free(data);
+}
+
 static void vulkan_init_static_resources(vk_t *vk)
 {
    unsigned i;
@@ -871,17 +1004,13 @@ static void vulkan_init_static_resources(vk_t *vk)
    VkCommandPoolCreateInfo pool_info = {
       VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
 
-   /* Create the pipeline cache. */
-   VkPipelineCacheCreateInfo cache   = {
-      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-
    pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
    if (!vk->context)
       return;
 
-   vkCreatePipelineCache(vk->context->device,
-         &cache, NULL, &vk->pipelines.cache);
+   /* Create the pipeline cache. */
+   vulkan_load_pipeline_cache(vk);
 
    pool_info.queueFamilyIndex = vk->context->graphics_queue_index;
 
@@ -899,6 +1028,7 @@ static void vulkan_init_static_resources(vk_t *vk)
 static void vulkan_deinit_static_resources(vk_t *vk)
 {
    unsigned i;
+   vulkan_save_pipeline_cache(vk);
    vkDestroyPipelineCache(vk->context->device,
          vk->pipelines.cache, NULL);
    vulkan_destroy_texture(
@@ -917,8 +1047,17 @@ static void vulkan_deinit_static_resources(vk_t *vk)
                &vk->readback.staging[i]);
 }
 
+static void vulkan_deinit_deferred(vk_t *vk)
+{
+   unsigned i;
+   for (i = 0; i < VULKAN_MAX_SWAPCHAIN_IMAGES; i++)
+      vulkan_deferred_flush(vk, &vk->swapchain[i], true);
+}
+
 static void vulkan_deinit_resources(vk_t *vk)
 {
+   /* Queue is idle - release everything */
+   vulkan_deinit_deferred(vk);
    vulkan_deinit_pipelines(vk);
    vulkan_deinit_framebuffers(vk);
    vulkan_deinit_descriptor_pool(vk);
@@ -943,6 +1082,7 @@ static void vulkan_deinit_menu(vk_t *vk)
 
 static void vulkan_free(void *data)
 {
+   unsigned i;
    vk_t *vk = (vk_t*)data;
    if (!vk)
       return;
@@ -968,6 +1108,15 @@ static void vulkan_free(void *data)
       vulkan_overlay_free(vk);
 #endif
 
+      /* Textures unloaded by the above */
+      vulkan_deinit_deferred(vk);
+      for (i = 0; i < VULKAN_MAX_SWAPCHAIN_IMAGES; i++)
+      {
+         free(vk->swapchain[i].deferred);
+         vk->swapchain[i].deferred     = NULL;
+         vk->swapchain[i].cap_deferred = 0;
+      }
+
       if (vk->filter_chain)
          vulkan_filter_chain_free((vulkan_filter_chain_t*)vk->filter_chain);
 
@@ -1658,6 +1807,7 @@ static void vulkan_inject_black_frame(vk_t *vk, video_frame_info_t *video_info,
 #ifdef HAVE_THREADS
    slock_unlock(vk->context->queue_lock);
 #endif
+   vulkan_deferred_retire(chain);
 
    vk->ctx_driver->swap_buffers(context_data);
 }
@@ -1671,6 +1821,7 @@ static bool vulkan_frame(void *data, const void *frame,
    VkSemaphore signal_semaphores[2];
    vk_t *vk                                      = (vk_t*)data;
    struct vk_per_frame *chain                    = NULL;
+   retro_time_t span_start                       = 0;
    bool waits_for_semaphores                     = false;
    unsigned width                                = video_info->width;
    unsigned height                               = video_info->height;
@@ -1700,6 +1851,11 @@ static bool vulkan_frame(void *data, const void *frame,
    chain     = &vk->swapchain[frame_index];
    vk->chain = chain;
 
+   /* Fence for this frame has been waited on -
+    * resources released before its last submission
+    * are no longer in use */
+   vulkan_deferred_flush(vk, chain, false);
+
    {
       struct vk_descriptor_manager *manager = &chain->descriptor_manager;
       VK_DESCRIPTOR_MANAGER_RESTART(manager);
@@ -2115,8 +2271,11 @@ static bool vulkan_frame(void *data, const void *frame,
 #ifdef HAVE_THREADS
    slock_unlock(vk->context->queue_lock);
 #endif
+   vulkan_deferred_retire(chain);
 
+   span_start = perf_span_begin();
    vk->ctx_driver->swap_buffers(context_data);
+   perf_span_end(PERF_SPAN_PRESENT, span_start);
 
    if (!vk->context->swap_interval_emulation_lock)
       vk->ctx_driver->update_window_title(context_data);
@@ -2389,17 +2548,20 @@ static void vulkan_unload_texture(void *data, uintptr_t handle)
    if (!texture || !vk)
       return;
 
-   /* TODO: We really want to defer this deletion instead,
-    * but this will do for now. */
+   /* Texture may still be referenced by frames in
+    * flight - destroy it once they have completed */
+   if (!vulkan_deferred_push(vk, texture, VK_NULL_HANDLE))
+   {
 #ifdef HAVE_THREADS
-   slock_lock(vk->context->queue_lock);
+      slock_lock(vk->context->queue_lock);
 #endif
-   vkQueueWaitIdle(vk->context->queue);
+      vkQueueWaitIdle(vk->context->queue);
 #ifdef HAVE_THREADS
-   slock_unlock(vk->context->queue_lock);
+      slock_unlock(vk->context->queue_lock);
 #endif
-   vulkan_destroy_texture(
-         vk->context->device, texture);
+      vulkan_destroy_texture(
+            vk->context->device, texture);
+   }
    free(texture);
 }
 
@@ -2551,37 +2713,24 @@ static bool vulkan_read_viewport(void *data, uint8_t *buffer, bool is_idle)
       vulkan_sync_texture_to_cpu(vk, staging);
 
       {
-         unsigned x, y;
          const uint8_t *src = (const uint8_t*)staging->mapped;
          buffer += 3 * (vk->vp.height - 1) * vk->vp.width;
 
+         /* Flip vertically while converting, with the
+          * SIMD paths of the scaler's pixel converters */
          switch (vk->context->swapchain_format)
          {
             case VK_FORMAT_B8G8R8A8_UNORM:
-               for (y = 0; y < vk->vp.height; y++,
-                     src += staging->stride, buffer -= 3 * vk->vp.width)
-               {
-                  for (x = 0; x < vk->vp.width; x++)
-                  {
-                     buffer[3 * x + 0] = src[4 * x + 0];
-                     buffer[3 * x + 1] = src[4 * x + 1];
-                     buffer[3 * x + 2] = src[4 * x + 2];
-                  }
-               }
+               conv_argb8888_bgr24(buffer, src,
+                     vk->vp.width, vk->vp.height,
+                     -(int)vk->vp.width * 3, (int)staging->stride);
                break;
 
             case VK_FORMAT_R8G8B8A8_UNORM:
             case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
-               for (y = 0; y < vk->vp.height; y++,
-                     src += staging->stride, buffer -= 3 * vk->vp.width)
-               {
-                  for (x = 0; x < vk->vp.width; x++)
-                  {
-                     buffer[3 * x + 2] = src[4 * x + 0];
-                     buffer[3 * x + 1] = src[4 * x + 1];
-                     buffer[3 * x + 0] = src[4 * x + 2];
-                  }
-               }
+               conv_abgr8888_bgr24(buffer, src,
+                     vk->vp.width, vk->vp.height,
+                     -(int)vk->vp.width * 3, (int)staging->stride);
                break;
 
             default:
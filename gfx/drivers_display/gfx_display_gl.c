@@ -417,5 +417,10 @@ gfx_display_ctx_driver_t gfx_display_ctx_gl = {
    "gl",
    false,
    gfx_display_gl_scissor_begin,
-   gfx_display_gl_scissor_end
+   gfx_display_gl_scissor_end,
+#ifdef MALI_BUG
+   false /* Rectangles must be discarded one by one */
+#else
+   true
+#endif
 };
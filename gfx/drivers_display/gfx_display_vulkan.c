@@ -399,5 +399,6 @@ gfx_display_ctx_driver_t gfx_display_ctx_vulkan = {
    "vulkan",
    false,
    gfx_display_vk_scissor_begin,
-   gfx_display_vk_scissor_end
+   gfx_display_vk_scissor_end,
+   true
 };
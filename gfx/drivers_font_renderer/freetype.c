@@ -42,8 +42,10 @@ typedef struct freetype_atlas_slot
 {
    struct font_glyph glyph;
    unsigned charcode;
-   unsigned last_used;
    struct freetype_atlas_slot* next;
+   /* Usage list - most recently used slot first */
+   struct freetype_atlas_slot* lru_prev;
+   struct freetype_atlas_slot* lru_next;
 }freetype_atlas_slot_t;
 
 typedef struct freetype_renderer
@@ -53,7 +55,8 @@ typedef struct freetype_renderer
    struct font_atlas atlas;
    freetype_atlas_slot_t atlas_slots[FT_ATLAS_SIZE];
    freetype_atlas_slot_t* uc_map[0x100];
-   unsigned usage_counter;
+   freetype_atlas_slot_t* lru_head;
+   freetype_atlas_slot_t* lru_tail;
    struct font_line_metrics line_metrics;
 } ft_font_renderer_t;
 
@@ -80,29 +83,43 @@ static void font_renderer_ft_free(void *data)
    free(handle);
 }
 
-static freetype_atlas_slot_t* font_renderer_get_slot(ft_font_renderer_t *handle)
+/* Moves slot to the front of the usage list */
+static void font_renderer_touch_slot(ft_font_renderer_t *handle,
+      freetype_atlas_slot_t *slot)
 {
-   int i, map_id;
-   unsigned oldest = 0;
+   if (handle->lru_head == slot)
+      return;
+
+   /* Unlink (slot is never the head here) */
+   slot->lru_prev->lru_next = slot->lru_next;
+   if (slot->lru_next)
+      slot->lru_next->lru_prev = slot->lru_prev;
+   else
+      handle->lru_tail         = slot->lru_prev;
 
-   for (i = 1; i < FT_ATLAS_SIZE; i++)
-      if ((handle->usage_counter - handle->atlas_slots[i].last_used) >
-         (handle->usage_counter - handle->atlas_slots[oldest].last_used))
-         oldest = i;
+   slot->lru_prev             = NULL;
+   slot->lru_next             = handle->lru_head;
+   handle->lru_head->lru_prev = slot;
+   handle->lru_head           = slot;
+}
+
+/* Returns the least recently used slot, removed
+ * from the map and marked as most recently used */
+static freetype_atlas_slot_t* font_renderer_get_slot(ft_font_renderer_t *handle)
+{
+   freetype_atlas_slot_t *oldest = handle->lru_tail;
+   freetype_atlas_slot_t **ptr   = &handle->uc_map[oldest->charcode & 0xFF];
 
    /* remove from map */
-   map_id = handle->atlas_slots[oldest].charcode & 0xFF;
-   if (handle->uc_map[map_id] == &handle->atlas_slots[oldest])
-      handle->uc_map[map_id] = handle->atlas_slots[oldest].next;
-   else if (handle->uc_map[map_id])
-   {
-      freetype_atlas_slot_t* ptr = handle->uc_map[map_id];
-      while(ptr->next && ptr->next != &handle->atlas_slots[oldest])
-         ptr = ptr->next;
-      ptr->next = handle->atlas_slots[oldest].next;
-   }
+   while (*ptr && *ptr != oldest)
+      ptr = &(*ptr)->next;
+   if (*ptr)
+      *ptr = oldest->next;
+   oldest->next = NULL;
+
+   font_renderer_touch_slot(handle, oldest);
 
-   return &handle->atlas_slots[oldest];
+   return oldest;
 }
 
 static const struct font_glyph *font_renderer_ft_get_glyph(
@@ -124,7 +141,7 @@ static const struct font_glyph *font_renderer_ft_get_glyph(
    {
       if (atlas_slot->charcode == charcode)
       {
-         atlas_slot->last_used = handle->usage_counter++;
+         font_renderer_touch_slot(handle, atlas_slot);
          return &atlas_slot->glyph;
       }
       atlas_slot = atlas_slot->next;
@@ -164,7 +181,6 @@ static const struct font_glyph *font_renderer_ft_get_glyph(
    }
 
    handle->atlas.dirty = true;
-   atlas_slot->last_used = handle->usage_counter++;
    return &atlas_slot->glyph;
 }
 
@@ -201,6 +217,17 @@ static bool font_renderer_create_atlas(ft_font_renderer_t *handle, float font_si
       }
    }
 
+   /* All slots are initially unused - the first
+    * slot is the first to be filled */
+   for (i = 0; i < FT_ATLAS_SIZE; i++)
+   {
+      slot           = &handle->atlas_slots[i];
+      slot->lru_prev = (i < FT_ATLAS_SIZE - 1) ? slot + 1 : NULL;
+      slot->lru_next = (i > 0) ? slot - 1 : NULL;
+   }
+   handle->lru_head = &handle->atlas_slots[FT_ATLAS_SIZE - 1];
+   handle->lru_tail = &handle->atlas_slots[0];
+
    for (i = 0; i < 256; i++)
       font_renderer_ft_get_glyph(handle, i);
 
@@ -46,8 +46,10 @@ typedef struct stb_unicode_atlas_slot
 {
    struct font_glyph glyph;
    unsigned charcode;
-   unsigned last_used;
    struct stb_unicode_atlas_slot* next;
+   /* Usage list - most recently used slot first */
+   struct stb_unicode_atlas_slot* lru_prev;
+   struct stb_unicode_atlas_slot* lru_next;
 }stb_unicode_atlas_slot_t;
 
 typedef struct
@@ -63,7 +65,8 @@ typedef struct
    struct font_atlas atlas;
    stb_unicode_atlas_slot_t atlas_slots[STB_UNICODE_ATLAS_SIZE];
    stb_unicode_atlas_slot_t* uc_map[0x100];
-   unsigned usage_counter;
+   stb_unicode_atlas_slot_t* lru_head;
+   stb_unicode_atlas_slot_t* lru_tail;
 } stb_unicode_font_renderer_t;
 
 static struct font_atlas *font_renderer_stb_unicode_get_atlas(void *data)
@@ -81,29 +84,43 @@ static void font_renderer_stb_unicode_free(void *data)
    free(self);
 }
 
-static stb_unicode_atlas_slot_t* font_renderer_stb_unicode_get_slot(stb_unicode_font_renderer_t *handle)
+/* Moves slot to the front of the usage list */
+static void font_renderer_stb_unicode_touch_slot(
+      stb_unicode_font_renderer_t *handle, stb_unicode_atlas_slot_t *slot)
 {
-   int i, map_id;
-   unsigned oldest = 0;
+   if (handle->lru_head == slot)
+      return;
+
+   /* Unlink (slot is never the head here) */
+   slot->lru_prev->lru_next = slot->lru_next;
+   if (slot->lru_next)
+      slot->lru_next->lru_prev = slot->lru_prev;
+   else
+      handle->lru_tail         = slot->lru_prev;
 
-   for (i = 1; i < STB_UNICODE_ATLAS_SIZE; i++)
-      if((handle->usage_counter - handle->atlas_slots[i].last_used) >
-         (handle->usage_counter - handle->atlas_slots[oldest].last_used))
-         oldest = i;
+   slot->lru_prev             = NULL;
+   slot->lru_next             = handle->lru_head;
+   handle->lru_head->lru_prev = slot;
+   handle->lru_head           = slot;
+}
+
+/* Returns the least recently used slot, removed
+ * from the map and marked as most recently used */
+static stb_unicode_atlas_slot_t* font_renderer_stb_unicode_get_slot(stb_unicode_font_renderer_t *handle)
+{
+   stb_unicode_atlas_slot_t *oldest = handle->lru_tail;
+   stb_unicode_atlas_slot_t **ptr   = &handle->uc_map[oldest->charcode & 0xFF];
 
    /* remove from map */
-   map_id = handle->atlas_slots[oldest].charcode & 0xFF;
-   if(handle->uc_map[map_id] == &handle->atlas_slots[oldest])
-      handle->uc_map[map_id] = handle->atlas_slots[oldest].next;
-   else if (handle->uc_map[map_id])
-   {
-      stb_unicode_atlas_slot_t* ptr = handle->uc_map[map_id];
-      while(ptr->next && ptr->next != &handle->atlas_slots[oldest])
-         ptr = ptr->next;
-      ptr->next = handle->atlas_slots[oldest].next;
-   }
+   while (*ptr && *ptr != oldest)
+      ptr = &(*ptr)->next;
+   if (*ptr)
+      *ptr = oldest->next;
+   oldest->next = NULL;
+
+   font_renderer_stb_unicode_touch_slot(handle, oldest);
 
-   return &handle->atlas_slots[oldest];
+   return oldest;
 }
 
 static const struct font_glyph *font_renderer_stb_unicode_get_glyph(
@@ -131,7 +148,7 @@ static const struct font_glyph *font_renderer_stb_unicode_get_glyph(
    {
       if(atlas_slot->charcode == charcode)
       {
-         atlas_slot->last_used = self->usage_counter++;
+         font_renderer_stb_unicode_touch_slot(self, atlas_slot);
          return &atlas_slot->glyph;
       }
       atlas_slot = atlas_slot->next;
@@ -183,7 +200,6 @@ static const struct font_glyph *font_renderer_stb_unicode_get_glyph(
          floor((double)glyph_draw_offset_y) : ceil((double)glyph_draw_offset_y));
 
    self->atlas.dirty = true;
-   atlas_slot->last_used = self->usage_counter++;
    return &atlas_slot->glyph;
 }
 
@@ -217,6 +233,17 @@ static bool font_renderer_stb_unicode_create_atlas(
       }
    }
 
+   /* All slots are initially unused - the first
+    * slot is the first to be filled */
+   for (i = 0; i < STB_UNICODE_ATLAS_SIZE; i++)
+   {
+      slot           = &self->atlas_slots[i];
+      slot->lru_prev = (i < STB_UNICODE_ATLAS_SIZE - 1) ? slot + 1 : NULL;
+      slot->lru_next = (i > 0) ? slot - 1 : NULL;
+   }
+   self->lru_head = &self->atlas_slots[STB_UNICODE_ATLAS_SIZE - 1];
+   self->lru_tail = &self->atlas_slots[0];
+
    for (i = 0; i < 256; i++)
       font_renderer_stb_unicode_get_glyph(self, i);
 
@@ -0,0 +1,240 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <encodings/crc32.h>
+#include <file/file_path.h>
+#include <retro_miscellaneous.h>
+#include <rhash.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+
+#ifdef HAVE_CONFIG_H
+#include "../../config.h"
+#endif
+
+#include "gl_program_cache.h"
+#include "../../retroarch.h"
+#include "../../verbosity.h"
+
+/* Cache file layout, all native-endian 32-bit words:
+ * magic, version, binary format, binary size, CRC32
+ * of the binary, then the binary itself. */
+#define GL_PROGRAM_CACHE_MAGIC   0x42505247
+#define GL_PROGRAM_CACHE_VERSION 1
+#define GL_PROGRAM_CACHE_HEADER  5
+
+/* GLES2 only has program binaries through an extension
+ * which is not worth the trouble for the GLES2 shaders */
+#if !defined(HAVE_OPENGLES) || defined(HAVE_OPENGLES3)
+#define HAVE_GL_PROGRAM_BINARY
+#endif
+
+#ifdef HAVE_GL_PROGRAM_BINARY
+static bool gl_program_cache_supported(void)
+{
+   GLint formats = 0;
+
+#ifndef HAVE_OPENGLES
+   /* Core since GL 4.1, resolved at runtime */
+   if (!glGetProgramBinary || !glProgramBinary)
+      return false;
+#endif
+
+   glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+   return formats > 0;
+}
+
+static void gl_program_cache_hash_string(char **key, size_t *key_len,
+      const char *str)
+{
+   size_t len = str ? strlen(str) + 1 : 1;
+   char *tmp  = (char*)realloc(*key, *key_len + len);
+
+   if (!tmp)
+      return;
+
+   if (str)
+      memcpy(tmp + *key_len, str, len);
+   else
+      tmp[*key_len] = '\0';
+
+   *key      = tmp;
+   *key_len += len;
+}
+#endif
+
+void gl_program_cache_path(char *s, size_t len,
+      const char **sources, unsigned num_sources)
+{
+#ifdef HAVE_GL_PROGRAM_BINARY
+   unsigned i;
+   char name[128];
+   char dir[PATH_MAX_LENGTH];
+   char *key      = NULL;
+   size_t key_len = 0;
+#endif
+
+   *s = '\0';
+
+#ifdef HAVE_GL_PROGRAM_BINARY
+   if (!gl_program_cache_supported())
+      return;
+
+   video_driver_get_shader_cache_dir(dir, sizeof(dir), "gl");
+   if (string_is_empty(dir))
+      return;
+
+   snprintf(name, sizeof(name), "gl-program %d", GL_PROGRAM_CACHE_VERSION);
+   gl_program_cache_hash_string(&key, &key_len, name);
+   gl_program_cache_hash_string(&key, &key_len,
+         (const char*)glGetString(GL_VENDOR));
+   gl_program_cache_hash_string(&key, &key_len,
+         (const char*)glGetString(GL_RENDERER));
+   gl_program_cache_hash_string(&key, &key_len,
+         (const char*)glGetString(GL_VERSION));
+
+   for (i = 0; i < num_sources; i++)
+      gl_program_cache_hash_string(&key, &key_len, sources[i]);
+
+   if (!key)
+      return;
+
+   sha256_hash(name, (const uint8_t*)key, key_len);
+   strlcat(name, ".bin", sizeof(name));
+   free(key);
+
+   fill_pathname_join(s, dir, name, len);
+#endif
+}
+
+GLuint gl_program_cache_load(const char *path)
+{
+#ifdef HAVE_GL_PROGRAM_BINARY
+   GLint status         = GL_FALSE;
+   GLuint program       = 0;
+   void *buf            = NULL;
+   int64_t len          = 0;
+   const uint32_t *data = NULL;
+
+   if (string_is_empty(path) || !path_is_valid(path))
+      return 0;
+
+   if (!filestream_read_file(path, &buf, &len))
+      return 0;
+
+   data = (const uint32_t*)buf;
+
+   if (     len < (int64_t)(GL_PROGRAM_CACHE_HEADER * sizeof(uint32_t))
+         || data[0] != GL_PROGRAM_CACHE_MAGIC
+         || data[1] != GL_PROGRAM_CACHE_VERSION
+         || len != (int64_t)(GL_PROGRAM_CACHE_HEADER
+            * sizeof(uint32_t) + data[3])
+         || data[4] != encoding_crc32(0,
+            (const uint8_t*)(data + GL_PROGRAM_CACHE_HEADER), data[3]))
+      goto error;
+
+   program = glCreateProgram();
+   glProgramBinary(program, (GLenum)data[2],
+         data + GL_PROGRAM_CACHE_HEADER, (GLsizei)data[3]);
+   glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+   /* Drivers reject binaries from other driver builds
+    * even when the version string did not change */
+   if (status != GL_TRUE)
+      goto error;
+
+   free(buf);
+   return program;
+
+error:
+   RARCH_LOG("[GL]: Discarding stale program binary \"%s\".\n", path);
+   if (program)
+      glDeleteProgram(program);
+   filestream_delete(path);
+   free(buf);
+#endif
+   return 0;
+}
+
+void gl_program_cache_prepare(GLuint program)
+{
+#if defined(HAVE_GL_PROGRAM_BINARY) && defined(GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+#ifndef HAVE_OPENGLES
+   if (!glProgramParameteri)
+      return;
+#endif
+   glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+}
+
+void gl_program_cache_save(GLuint program, const char *path)
+{
+#ifdef HAVE_GL_PROGRAM_BINARY
+   char dir[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH];
+   GLint size       = 0;
+   GLsizei length   = 0;
+   GLenum format    = 0;
+   uint32_t *data   = NULL;
+
+   if (string_is_empty(path))
+      return;
+
+   glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+   if (size <= 0)
+      return;
+
+   if (!(data = (uint32_t*)malloc(
+               GL_PROGRAM_CACHE_HEADER * sizeof(uint32_t) + size)))
+      return;
+
+   glGetProgramBinary(program, size, &length, &format,
+         data + GL_PROGRAM_CACHE_HEADER);
+   if (length <= 0)
+      goto end;
+
+   data[0] = GL_PROGRAM_CACHE_MAGIC;
+   data[1] = GL_PROGRAM_CACHE_VERSION;
+   data[2] = format;
+   data[3] = (uint32_t)length;
+   data[4] = encoding_crc32(0,
+         (const uint8_t*)(data + GL_PROGRAM_CACHE_HEADER), length);
+
+   fill_pathname_basedir(dir, path, sizeof(dir));
+   if (!path_is_directory(dir) && !path_mkdir(dir))
+      goto end;
+
+   /* Write next to the final entry and rename it into place,
+    * so an interrupted write never leaves a truncated entry */
+   strlcpy(tmp_path, path, sizeof(tmp_path));
+   strlcat(tmp_path, ".tmp", sizeof(tmp_path));
+
+   if (filestream_write_file(tmp_path, data,
+            GL_PROGRAM_CACHE_HEADER * sizeof(uint32_t) + length))
+   {
+      if (filestream_rename(tmp_path, path) != 0)
+         filestream_delete(tmp_path);
+   }
+
+end:
+   free(data);
+#endif
+}
@@ -0,0 +1,52 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_GL_PROGRAM_CACHE_H
+#define __RARCH_GL_PROGRAM_CACHE_H
+
+#include <stddef.h>
+
+#include <boolean.h>
+#include <retro_common_api.h>
+#include <glsym/glsym.h>
+
+RETRO_BEGIN_DECLS
+
+/* On-disk cache of linked GL program binaries.
+ *
+ * Entries are named after a hash of the GL vendor,
+ * renderer and version strings plus every string the
+ * program was built from, so a driver update or any
+ * change to the sources simply misses the cache.
+ * The current context must be bound for all calls. */
+
+/* Sets 's' to the cache file of the program built
+ * from 'sources', or to an empty string when the
+ * context cannot return program binaries. */
+void gl_program_cache_path(char *s, size_t len,
+      const char **sources, unsigned num_sources);
+
+/* Returns a linked program restored from 'path',
+ * or 0 if there is none or the driver rejects it. */
+GLuint gl_program_cache_load(const char *path);
+
+/* Call before linking a program that will be saved. */
+void gl_program_cache_prepare(GLuint program);
+
+void gl_program_cache_save(GLuint program, const char *path);
+
+RETRO_END_DECLS
+
+#endif
@@ -26,6 +26,7 @@
 #endif
 #include <vector>
 #include <iostream>
+#include <cstdio>
 #include <cstring>
 #include <cstdlib>
 #include <mutex>
@@ -45,25 +46,34 @@ struct SlangProcess
       TBuiltInResource Resources;
 };
 
-/* We don't use glslang from multiple threads, but to be sure.
- * Initializing TLS and freeing it for glslang works around 
+/* Initializing TLS and freeing it for glslang works around 
  * a really bizarre issue where the TLS key is suddenly 
  * corrupted *somehow*.
+ *
+ * Passes of a preset are compiled from several threads, so
+ * the process is shared by reference count: it is torn down
+ * once the last concurrent compile is done, never while
+ * another thread still uses the TLS keys. Compiles
+ * themselves run unlocked - glslang initializes each
+ * thread on its own when parsing.
  */
 static std::mutex glslang_global_lock;
+static unsigned glslang_process_refs;
 
 struct SlangProcessHolder
 {
    SlangProcessHolder()
    {
-      glslang_global_lock.lock();
-      InitializeProcess();
+      std::lock_guard<std::mutex> lock(glslang_global_lock);
+      if (glslang_process_refs++ == 0)
+         InitializeProcess();
    }
 
    ~SlangProcessHolder()
    {
-      FinalizeProcess();
-      glslang_global_lock.unlock();
+      std::lock_guard<std::mutex> lock(glslang_global_lock);
+      if (--glslang_process_refs == 0)
+         FinalizeProcess();
    }
 };
 
@@ -428,3 +438,15 @@ bool glslang::compile_spirv(const string &source, Stage stage,
    GlslangToSpv(*program.getIntermediate(language), *spirv);
    return true;
 }
+
+string glslang::compiler_version()
+{
+   string spirv_version;
+   char tool_id[16];
+
+   GetSpirvVersion(spirv_version);
+   snprintf(tool_id, sizeof(tool_id), "%d", GetKhronosToolId());
+
+   return string(GetGlslVersionString()) + " " + spirv_version
+      + " tool " + tool_id;
+}
@@ -18,6 +18,10 @@ namespace glslang
     };
 
     bool compile_spirv(const std::string &source, Stage stage, std::vector<uint32_t> *spirv);
+
+    /* Identifies the compiler and SPIR-V generator,
+     * for keying caches of compiled shaders. */
+    std::string compiler_version();
 }
 
 #endif
@@ -77,6 +77,10 @@ enum glslang_format glslang_find_format(const char *fmt);
 bool glslang_read_shader_file(const char *path,
       struct string_list *output, bool root_file);
 
+/* Directory where compiled SPIR-V is kept across runs,
+ * or NULL/empty to always compile from source. */
+void glslang_set_spirv_cache_dir(const char *dir);
+
 bool slang_texture_semantic_is_array(enum slang_texture_semantic sem);
 
 enum slang_texture_semantic slang_name_to_texture_semantic_array(
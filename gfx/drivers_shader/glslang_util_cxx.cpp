@@ -15,15 +15,24 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <string>
 #include <sstream>
 #include <algorithm>
 
 #include <retro_miscellaneous.h>
+#include <compat/strl.h>
 #include <file/file_path.h>
 #include <file/config_file.h>
+#include <lists/dir_list.h>
 #include <streams/file_stream.h>
 #include <string/stdstring.h>
+#include <encodings/crc32.h>
+#include <features/features_cpu.h>
+#include <rhash.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -36,6 +45,272 @@
 #endif
 #include "../../verbosity.h"
 
+/* SPIR-V cache file layout, all native-endian 32-bit words:
+ * magic, version, vertex word count, fragment word count,
+ * CRC32 of the payload, time the entry was last used (in
+ * seconds since the epoch), then the vertex and fragment
+ * SPIR-V. Bump the version whenever compile options change. */
+#define SLANG_SPIRV_CACHE_MAGIC    0x56505352
+#define SLANG_SPIRV_CACHE_VERSION  2
+#define SLANG_SPIRV_CACHE_HEADER   6
+#define SLANG_SPIRV_CACHE_LAST_USE 5
+#define SPIRV_MAGIC                0x07230203
+
+/* Least recently used entries are deleted when the
+ * cache directory is set, until the cache fits */
+#define SLANG_SPIRV_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+static char glslang_spirv_cache_dir[PATH_MAX_LENGTH];
+
+struct glslang_spirv_cache_entry
+{
+   std::string path;
+   uint32_t last_used;
+   size_t size;
+};
+
+static bool glslang_spirv_cache_entry_newer(
+      const glslang_spirv_cache_entry &a,
+      const glslang_spirv_cache_entry &b)
+{
+   return a.last_used > b.last_used;
+}
+
+/* Deletes stale temporary files and entries written by
+ * another cache version, then the least recently used
+ * entries until the rest fit in SLANG_SPIRV_CACHE_MAX_SIZE */
+static void glslang_spirv_cache_prune(const char *dir)
+{
+   size_t i;
+   size_t total_size   = 0;
+   unsigned removed    = 0;
+   std::vector<glslang_spirv_cache_entry> entries;
+   struct string_list *list = dir_list_new(dir, "spv|tmp",
+         false, true, false, false);
+
+   if (!list)
+      return;
+
+   for (i = 0; i < list->size; i++)
+   {
+      uint32_t header[SLANG_SPIRV_CACHE_HEADER];
+      glslang_spirv_cache_entry entry;
+      const char *path = list->elems[i].data;
+      int32_t size     = path_get_size(path);
+      RFILE *file      = NULL;
+      bool valid       = false;
+
+      if (     string_is_equal_noncase(path_get_extension(path), "spv")
+            && size > 0
+            && (file = filestream_open(path,
+                  RETRO_VFS_FILE_ACCESS_READ,
+                  RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      {
+         valid = filestream_read(file, header, sizeof(header))
+               == (int64_t)sizeof(header)
+            && header[0] == SLANG_SPIRV_CACHE_MAGIC
+            && header[1] == SLANG_SPIRV_CACHE_VERSION;
+         filestream_close(file);
+      }
+
+      if (!valid)
+      {
+         filestream_delete(path);
+         removed++;
+         continue;
+      }
+
+      entry.path      = path;
+      entry.last_used = header[SLANG_SPIRV_CACHE_LAST_USE];
+      entry.size      = (size_t)size;
+      entries.push_back(entry);
+   }
+
+   string_list_free(list);
+
+   std::sort(entries.begin(), entries.end(),
+         glslang_spirv_cache_entry_newer);
+
+   for (i = 0; i < entries.size(); i++)
+   {
+      total_size += entries[i].size;
+
+      if (total_size <= SLANG_SPIRV_CACHE_MAX_SIZE)
+         continue;
+
+      filestream_delete(entries[i].path.c_str());
+      removed++;
+   }
+
+   if (removed)
+      RARCH_LOG("[slang]: Removed %u entries from SPIR-V cache \"%s\".\n",
+            removed, dir);
+}
+
+void glslang_set_spirv_cache_dir(const char *dir)
+{
+   if (string_is_empty(dir))
+   {
+      glslang_spirv_cache_dir[0] = '\0';
+      return;
+   }
+
+   if (string_is_equal(dir, glslang_spirv_cache_dir))
+      return;
+
+   strlcpy(glslang_spirv_cache_dir, dir,
+         sizeof(glslang_spirv_cache_dir));
+
+   if (path_is_directory(glslang_spirv_cache_dir))
+      glslang_spirv_cache_prune(glslang_spirv_cache_dir);
+}
+
+#if defined(HAVE_GLSLANG)
+/* Cache entries are named after a SHA-256 of both
+ * preprocessed stages and the compiler identity, so
+ * editing a shader or any file it includes, or updating
+ * glslang, simply misses the cache. */
+static void glslang_spirv_cache_path(char *s, size_t len,
+      const std::string &vertex_source,
+      const std::string &fragment_source)
+{
+   char name[128];
+   std::string key;
+
+   name[0] = '\0';
+
+   snprintf(name, sizeof(name), "slang-spirv %d ",
+         SLANG_SPIRV_CACHE_VERSION);
+
+   key     = name;
+   key    += glslang::compiler_version();
+   key    += '\n';
+   key    += vertex_source;
+   key    += '\0';
+   key    += fragment_source;
+
+   sha256_hash(name, (const uint8_t*)key.data(), key.size());
+   strlcat(name, ".spv", sizeof(name));
+
+   fill_pathname_join(s, glslang_spirv_cache_dir, name, len);
+}
+
+/* Records that an entry was used, so that pruning
+ * deletes the least recently used entries first */
+static void glslang_spirv_cache_touch(const char *path)
+{
+   uint32_t now = (uint32_t)time(NULL);
+   RFILE *file  = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_READ_WRITE
+         | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+   if (!file)
+      return;
+
+   if (filestream_seek(file,
+            SLANG_SPIRV_CACHE_LAST_USE * sizeof(uint32_t),
+            RETRO_VFS_SEEK_POSITION_START) != -1)
+      filestream_write(file, &now, sizeof(now));
+
+   filestream_close(file);
+}
+
+static bool glslang_spirv_cache_load(const char *path,
+      glslang_output *output)
+{
+   void *buf            = NULL;
+   int64_t len          = 0;
+   const uint32_t *data = NULL;
+   size_t vertex_size, fragment_size;
+
+   if (!path_is_valid(path))
+      return false;
+
+   if (!filestream_read_file(path, &buf, &len))
+      return false;
+
+   data = (const uint32_t*)buf;
+
+   if (len < (int64_t)(SLANG_SPIRV_CACHE_HEADER * sizeof(uint32_t)))
+      goto error;
+
+   vertex_size   = data[2];
+   fragment_size = data[3];
+
+   if (     data[0] != SLANG_SPIRV_CACHE_MAGIC
+         || data[1] != SLANG_SPIRV_CACHE_VERSION
+         || !vertex_size
+         || !fragment_size
+         || len != (int64_t)((SLANG_SPIRV_CACHE_HEADER
+               + vertex_size + fragment_size) * sizeof(uint32_t)))
+      goto error;
+
+   data += SLANG_SPIRV_CACHE_HEADER;
+
+   if (     ((const uint32_t*)buf)[4] != encoding_crc32(0,
+               (const uint8_t*)data,
+               (vertex_size + fragment_size) * sizeof(uint32_t))
+         || data[0]           != SPIRV_MAGIC
+         || data[vertex_size] != SPIRV_MAGIC)
+      goto error;
+
+   output->vertex.assign(data, data + vertex_size);
+   output->fragment.assign(data + vertex_size,
+         data + vertex_size + fragment_size);
+
+   free(buf);
+   glslang_spirv_cache_touch(path);
+   return true;
+
+error:
+   RARCH_WARN("[slang]: Ignoring invalid SPIR-V cache entry \"%s\".\n",
+         path);
+   free(buf);
+   return false;
+}
+
+static void glslang_spirv_cache_save(const char *path,
+      const glslang_output *output)
+{
+   char tmp_path[PATH_MAX_LENGTH];
+   std::vector<uint32_t> data;
+   size_t vertex_size   = output->vertex.size();
+   size_t fragment_size = output->fragment.size();
+
+   tmp_path[0] = '\0';
+
+   if (!path_is_directory(glslang_spirv_cache_dir)
+         && !path_mkdir(glslang_spirv_cache_dir))
+      return;
+
+   data.reserve(SLANG_SPIRV_CACHE_HEADER + vertex_size + fragment_size);
+   data.push_back(SLANG_SPIRV_CACHE_MAGIC);
+   data.push_back(SLANG_SPIRV_CACHE_VERSION);
+   data.push_back((uint32_t)vertex_size);
+   data.push_back((uint32_t)fragment_size);
+   data.push_back(0);
+   data.push_back((uint32_t)time(NULL));
+   data.insert(data.end(), output->vertex.begin(), output->vertex.end());
+   data.insert(data.end(), output->fragment.begin(), output->fragment.end());
+   data[4] = encoding_crc32(0,
+         (const uint8_t*)&data[SLANG_SPIRV_CACHE_HEADER],
+         (vertex_size + fragment_size) * sizeof(uint32_t));
+
+   /* Write next to the final entry and rename it into place,
+    * so an interrupted write never leaves a truncated entry */
+   strlcpy(tmp_path, path, sizeof(tmp_path));
+   strlcat(tmp_path, ".tmp", sizeof(tmp_path));
+
+   if (!filestream_write_file(tmp_path, data.data(),
+            data.size() * sizeof(uint32_t)))
+      return;
+
+   if (filestream_rename(tmp_path, path) != 0)
+      filestream_delete(tmp_path);
+}
+#endif
+
 static std::string build_stage_source(
       const struct string_list *lines, const char *stage)
 {
@@ -228,18 +503,45 @@ bool glslang_compile_shader(const char *shader_path, glslang_output *output)
    if (!glslang_parse_meta(lines, &output->meta))
       goto error;
 
-   if (!glslang::compile_spirv(build_stage_source(lines, "vertex"),
-            glslang::StageVertex, &output->vertex))
    {
-      RARCH_ERR("Failed to compile vertex shader stage.\n");
-      goto error;
-   }
+      char cache_path[PATH_MAX_LENGTH];
+      std::string vertex_source   = build_stage_source(lines, "vertex");
+      std::string fragment_source = build_stage_source(lines, "fragment");
+      bool cache_enabled          = !string_is_empty(
+            glslang_spirv_cache_dir);
 
-   if (!glslang::compile_spirv(build_stage_source(lines, "fragment"),
-            glslang::StageFragment, &output->fragment))
-   {
-      RARCH_ERR("Failed to compile fragment shader stage.\n");
-      goto error;
+      cache_path[0] = '\0';
+
+      if (cache_enabled)
+      {
+         glslang_spirv_cache_path(cache_path, sizeof(cache_path),
+               vertex_source, fragment_source);
+
+         if (glslang_spirv_cache_load(cache_path, output))
+         {
+            RARCH_LOG("[slang]: Using cached SPIR-V \"%s\".\n",
+                  cache_path);
+            string_list_free(lines);
+            return true;
+         }
+      }
+
+      if (!glslang::compile_spirv(vertex_source,
+               glslang::StageVertex, &output->vertex))
+      {
+         RARCH_ERR("Failed to compile vertex shader stage.\n");
+         goto error;
+      }
+
+      if (!glslang::compile_spirv(fragment_source,
+               glslang::StageFragment, &output->fragment))
+      {
+         RARCH_ERR("Failed to compile fragment shader stage.\n");
+         goto error;
+      }
+
+      if (cache_enabled)
+         glslang_spirv_cache_save(cache_path, output);
    }
 
    string_list_free(lines);
@@ -252,3 +554,145 @@ error:
 
    return false;
 }
+
+struct glslang_compile_job
+{
+   const char *path;
+   glslang_output *output;
+   retro_time_t time;
+   bool ok;
+};
+
+struct glslang_compile_queue
+{
+   std::vector<glslang_compile_job> *jobs;
+#ifdef HAVE_THREADS
+   slock_t *lock;
+#endif
+   size_t next;
+};
+
+static void glslang_compile_worker(void *data)
+{
+   glslang_compile_queue *queue = (glslang_compile_queue*)data;
+
+   for (;;)
+   {
+      size_t idx;
+      glslang_compile_job *job = NULL;
+      retro_time_t start;
+
+#ifdef HAVE_THREADS
+      slock_lock(queue->lock);
+#endif
+      idx = queue->next++;
+#ifdef HAVE_THREADS
+      slock_unlock(queue->lock);
+#endif
+
+      if (idx >= queue->jobs->size())
+         break;
+
+      job       = &(*queue->jobs)[idx];
+      start     = cpu_features_get_time_usec();
+      job->ok   = glslang_compile_shader(job->path, job->output);
+      job->time = cpu_features_get_time_usec() - start;
+   }
+}
+
+bool glslang_compile_shaders(const char **paths, unsigned count,
+      std::vector<glslang_output> *outputs)
+{
+   unsigned i, j;
+   unsigned num_threads = 1;
+   bool ok              = true;
+   retro_time_t start   = cpu_features_get_time_usec();
+   std::vector<glslang_compile_job> jobs;
+   std::vector<unsigned> job_of(count);
+   glslang_compile_queue queue;
+
+   outputs->clear();
+   outputs->resize(count);
+
+   /* Presets often run the same shader in several passes,
+    * compile each file once */
+   for (i = 0; i < count; i++)
+   {
+      for (j = 0; j < i; j++)
+         if (string_is_equal(paths[i], paths[j]))
+            break;
+
+      if (j < i)
+         job_of[i] = job_of[j];
+      else
+      {
+         glslang_compile_job job;
+         job.path   = paths[i];
+         job.output = &(*outputs)[i];
+         job.time   = 0;
+         job.ok     = false;
+         job_of[i]  = (unsigned)jobs.size();
+         jobs.push_back(job);
+      }
+   }
+
+   queue.jobs = &jobs;
+   queue.next = 0;
+
+#ifdef HAVE_THREADS
+   num_threads = MIN(cpu_features_get_core_amount(), (unsigned)jobs.size());
+   queue.lock  = num_threads > 1 ? slock_new() : NULL;
+
+   if (queue.lock)
+   {
+      /* The calling thread takes part as well */
+      std::vector<sthread_t*> threads;
+
+      for (i = 1; i < num_threads; i++)
+      {
+         sthread_t *thread = sthread_create(glslang_compile_worker, &queue);
+         if (thread)
+            threads.push_back(thread);
+      }
+
+      glslang_compile_worker(&queue);
+
+      for (i = 0; i < threads.size(); i++)
+         sthread_join(threads[i]);
+
+      num_threads = (unsigned)threads.size() + 1;
+      slock_free(queue.lock);
+   }
+   else
+#endif
+   {
+      num_threads = 1;
+      glslang_compile_worker(&queue);
+   }
+
+   for (i = 0; i < count; i++)
+   {
+      const glslang_compile_job *job = &jobs[job_of[i]];
+
+      if (job->output != &(*outputs)[i])
+      {
+         (*outputs)[i] = *job->output;
+         continue;
+      }
+
+      RARCH_LOG("[slang]: Pass #%u \"%s\" took %.1f ms.\n",
+            i, paths[i], job->time / 1000.0);
+
+      if (!job->ok)
+      {
+         RARCH_ERR("Failed to compile shader: \"%s\".\n", paths[i]);
+         ok = false;
+      }
+   }
+
+   RARCH_LOG("[slang]: Compiled %u passes on %u threads in %.1f ms.\n",
+         count, num_threads,
+         (cpu_features_get_time_usec() - start) / 1000.0);
+
+   return ok;
+}
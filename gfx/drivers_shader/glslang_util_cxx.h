@@ -55,6 +55,11 @@ struct glslang_output
 
 bool glslang_compile_shader(const char *shader_path, glslang_output *output);
 
+/* Compiles several shaders concurrently on a pool of
+ * worker threads; outputs[i] belongs to paths[i]. */
+bool glslang_compile_shaders(const char **paths, unsigned count,
+      std::vector<glslang_output> *outputs);
+
 /* Helpers for internal use. */
 bool glslang_parse_meta(const struct string_list *lines, glslang_meta *meta);
 
@@ -28,11 +28,13 @@
 #include <formats/image.h>
 #include <retro_miscellaneous.h>
 
+#include "slang_fbo_plan.h"
 #include "slang_reflection.h"
 #include "slang_reflection.hpp"
 #include "spirv_glsl.hpp"
 
 #include "../common/gl_core_common.h"
+#include "gl_program_cache.h"
 
 #include "../../verbosity.h"
 #include "../../msg_hash.h"
@@ -173,55 +175,73 @@ GLuint gl_core_cross_compile_program(
 
       auto vertex_source = vertex_compiler.compile();
       auto fragment_source = fragment_compiler.compile();
-      GLuint vertex_shader = gl_core_compile_shader(GL_VERTEX_SHADER, vertex_source.c_str());
-      GLuint fragment_shader = gl_core_compile_shader(GL_FRAGMENT_SHADER, fragment_source.c_str());
 
-#if 0
-      RARCH_LOG("[GLCore]: Vertex shader:\n========\n%s\n=======\n", vertex_source.c_str());
-      RARCH_LOG("[GLCore]: Fragment shader:\n========\n%s\n=======\n", fragment_source.c_str());
-#endif
+      /* Attribute locations are bound by name from the
+       * vertex source, so the sources identify the program */
+      char cache_path[PATH_MAX_LENGTH];
+      const char *cache_sources[] = {
+         vertex_source.c_str(), fragment_source.c_str() };
 
-      if (!vertex_shader || !fragment_shader)
-      {
-         RARCH_ERR("[GLCore]: One or more shaders failed to compile.\n");
-         if (vertex_shader)
-            glDeleteShader(vertex_shader);
-         if (fragment_shader)
-            glDeleteShader(fragment_shader);
-         return 0;
-      }
+      gl_program_cache_path(cache_path, sizeof(cache_path),
+            cache_sources, ARRAY_SIZE(cache_sources));
 
-      program = glCreateProgram();
-      glAttachShader(program, vertex_shader);
-      glAttachShader(program, fragment_shader);
-      for (auto &res : vertex_resources.stage_inputs)
+      if ((program = gl_program_cache_load(cache_path)))
+         RARCH_LOG("[GLCore]: Using cached program binary.\n");
+      else
       {
-         uint32_t location = vertex_compiler.get_decoration(res.id, spv::DecorationLocation);
-         glBindAttribLocation(program, location, (string("RARCH_ATTRIBUTE_") + to_string(location)).c_str());
-      }
-      glLinkProgram(program);
-      glDeleteShader(vertex_shader);
-      glDeleteShader(fragment_shader);
+         GLuint vertex_shader = gl_core_compile_shader(GL_VERTEX_SHADER, vertex_source.c_str());
+         GLuint fragment_shader = gl_core_compile_shader(GL_FRAGMENT_SHADER, fragment_source.c_str());
 
-      GLint status;
-      glGetProgramiv(program, GL_LINK_STATUS, &status);
-      if (!status)
-      {
-         GLint length;
-         glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
-         if (length > 0)
+#if 0
+         RARCH_LOG("[GLCore]: Vertex shader:\n========\n%s\n=======\n", vertex_source.c_str());
+         RARCH_LOG("[GLCore]: Fragment shader:\n========\n%s\n=======\n", fragment_source.c_str());
+#endif
+
+         if (!vertex_shader || !fragment_shader)
          {
-            char *info_log = (char*)malloc(length);
+            RARCH_ERR("[GLCore]: One or more shaders failed to compile.\n");
+            if (vertex_shader)
+               glDeleteShader(vertex_shader);
+            if (fragment_shader)
+               glDeleteShader(fragment_shader);
+            return 0;
+         }
 
-            if (info_log)
+         program = glCreateProgram();
+         glAttachShader(program, vertex_shader);
+         glAttachShader(program, fragment_shader);
+         for (auto &res : vertex_resources.stage_inputs)
+         {
+            uint32_t location = vertex_compiler.get_decoration(res.id, spv::DecorationLocation);
+            glBindAttribLocation(program, location, (string("RARCH_ATTRIBUTE_") + to_string(location)).c_str());
+         }
+         gl_program_cache_prepare(program);
+         glLinkProgram(program);
+         glDeleteShader(vertex_shader);
+         glDeleteShader(fragment_shader);
+
+         GLint status;
+         glGetProgramiv(program, GL_LINK_STATUS, &status);
+         if (!status)
+         {
+            GLint length;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+            if (length > 0)
             {
-               glGetProgramInfoLog(program, length, &length, info_log);
-               RARCH_ERR("[GLCore]: Failed to link program: %s\n", info_log);
-               free(info_log);
-               glDeleteProgram(program);
-               return 0;
+               char *info_log = (char*)malloc(length);
+
+               if (info_log)
+               {
+                  glGetProgramInfoLog(program, length, &length, info_log);
+                  RARCH_ERR("[GLCore]: Failed to link program: %s\n", info_log);
+                  free(info_log);
+                  glDeleteProgram(program);
+                  return 0;
+               }
             }
          }
+
+         gl_program_cache_save(program, cache_path);
       }
 
       glUseProgram(program);
@@ -665,6 +685,56 @@ Framebuffer::~Framebuffer()
       glDeleteTextures(1, &image);
 }
 
+static unsigned format_bytes(GLenum format)
+{
+   switch (format)
+   {
+      case GL_R8:
+      case GL_R8I:
+      case GL_R8UI:
+         return 1;
+      case GL_RG8:
+      case GL_RG8I:
+      case GL_RG8UI:
+      case GL_R16F:
+      case GL_R16I:
+      case GL_R16UI:
+         return 2;
+      case GL_RG32F:
+      case GL_RG32I:
+      case GL_RG32UI:
+      case GL_RGBA16F:
+      case GL_RGBA16I:
+      case GL_RGBA16UI:
+         return 8;
+      case GL_RGBA32F:
+      case GL_RGBA32I:
+      case GL_RGBA32UI:
+         return 16;
+      default:
+         break;
+   }
+
+   return 4;
+}
+
+static size_t framebuffer_memory(const Framebuffer &fb)
+{
+   unsigned i;
+   size_t bytes    = 0;
+   unsigned width  = fb.get_size().width;
+   unsigned height = fb.get_size().height;
+
+   for (i = 0; i < fb.get_levels(); i++)
+   {
+      bytes  += size_t(width) * height * format_bytes(fb.get_format());
+      width   = MAX(width  >> 1, 1u);
+      height  = MAX(height >> 1, 1u);
+   }
+
+   return bytes;
+}
+
 class UBORing
 {
 public:
@@ -700,6 +770,12 @@ public:
       return framebuffer_feedback.get();
    }
 
+   /* Renders into the framebuffer of 'pass' from now on */
+   void share_framebuffer(const Pass &pass)
+   {
+      framebuffer = pass.framebuffer;
+   }
+
    void set_pass_info(const gl_core_filter_chain_pass_info &info);
 
    void set_shader(GLenum stage,
@@ -790,8 +866,8 @@ private:
 
    vector<uint32_t> vertex_shader;
    vector<uint32_t> fragment_shader;
-   unique_ptr<Framebuffer> framebuffer;
-   unique_ptr<Framebuffer> framebuffer_feedback;
+   shared_ptr<Framebuffer> framebuffer;
+   shared_ptr<Framebuffer> framebuffer_feedback;
 
    bool init_pipeline();
 
@@ -1633,11 +1709,18 @@ private:
    bool init_history();
    bool init_feedback();
    bool init_alias();
+   void init_shared_framebuffers();
    vector<unique_ptr<gl_core_shader::Framebuffer>> original_history;
    bool require_clear = false;
    void clear_history_and_feedback();
    void update_feedback_info();
    void update_history_info();
+
+   /* Passes owning the framebuffers
+    * the offscreen passes render to */
+   vector<unsigned> framebuffer_owners;
+   size_t framebuffer_memory = 0;
+   void update_framebuffer_memory();
 };
 
 
@@ -1726,6 +1809,36 @@ void gl_core_filter_chain::build_offscreen_passes(const gl_core_viewport &vp)
 
       common.pass_outputs[i]           = source;
    }
+
+   update_framebuffer_memory();
+}
+
+void gl_core_filter_chain::update_framebuffer_memory()
+{
+   unsigned i;
+   size_t memory = 0;
+
+   for (i = 0; i < framebuffer_owners.size(); i++)
+      memory += gl_core_shader::framebuffer_memory(
+            passes[framebuffer_owners[i]]->get_framebuffer());
+
+   for (i = 0; i < passes.size(); i++)
+   {
+      gl_core_shader::Framebuffer *fb = passes[i]->get_feedback_framebuffer();
+      if (fb)
+         memory += gl_core_shader::framebuffer_memory(*fb);
+   }
+
+   for (i = 0; i < original_history.size(); i++)
+      memory += gl_core_shader::framebuffer_memory(*original_history[i]);
+
+   /* Only changes when the input or viewport is resized */
+   if (memory != framebuffer_memory)
+   {
+      framebuffer_memory = memory;
+      RARCH_LOG("[GLCore]: Filter chain framebuffers use %.2f MiB.\n",
+            memory / (1024.0 * 1024.0));
+   }
 }
 
 void gl_core_filter_chain::end_frame()
@@ -1895,6 +2008,54 @@ bool gl_core_filter_chain::init_feedback()
    return true;
 }
 
+void gl_core_filter_chain::init_shared_framebuffers()
+{
+   unsigned i, j;
+   unsigned num_passes = passes.size() - 1;
+   unsigned num_framebuffers;
+   vector<slang_fbo_plan_pass> plan(num_passes);
+   vector<unsigned> slots(num_passes);
+
+   framebuffer_owners.clear();
+   framebuffer_memory = 0;
+
+   for (i = 0; i < num_passes; i++)
+   {
+      plan[i].scale_type_x = (enum slang_fbo_plan_scale)pass_info[i].scale_type_x;
+      plan[i].scale_type_y = (enum slang_fbo_plan_scale)pass_info[i].scale_type_y;
+      plan[i].scale_x      = pass_info[i].scale_x;
+      plan[i].scale_y      = pass_info[i].scale_y;
+      plan[i].format       = pass_info[i].rt_format;
+      plan[i].levels       = pass_info[i].max_levels;
+      plan[i].feedback     = passes[i]->get_feedback_framebuffer() != nullptr;
+
+      /* The next pass always reads this one as Source. */
+      plan[i].last_reader  = i + 1;
+
+      for (j = i + 2; j < passes.size(); j++)
+      {
+         auto &outputs = passes[j]->get_reflection().semantic_textures[
+            SLANG_TEXTURE_SEMANTIC_PASS_OUTPUT];
+
+         if (i < outputs.size() && outputs[i].texture)
+            plan[i].last_reader = j;
+      }
+   }
+
+   num_framebuffers = slang_fbo_plan(plan.data(), num_passes, slots.data());
+
+   for (i = 0; i < num_passes; i++)
+   {
+      if (slots[i] == framebuffer_owners.size())
+         framebuffer_owners.push_back(i);
+      else
+         passes[i]->share_framebuffer(*passes[framebuffer_owners[slots[i]]]);
+   }
+
+   RARCH_LOG("[GLCore]: Rendering %u offscreen passes to %u framebuffers.\n",
+         num_passes, num_framebuffers);
+}
+
 bool gl_core_filter_chain::init_alias()
 {
    unsigned i, j;
@@ -2003,6 +2164,7 @@ bool gl_core_filter_chain::init()
       return false;
    if (!init_feedback())
       return false;
+   init_shared_framebuffers();
    common.pass_outputs.resize(passes.size());
    return true;
 }
@@ -2188,6 +2350,8 @@ gl_core_filter_chain_t *gl_core_filter_chain_create_from_preset(
 {
    unsigned i;
    config_file_t *conf            = NULL;
+   vector<glslang_output> outputs;
+   vector<const char*> paths;
    unique_ptr<video_shader> shader{ new video_shader() };
    if (!shader)
       return nullptr;
@@ -2212,9 +2376,17 @@ gl_core_filter_chain_t *gl_core_filter_chain_create_from_preset(
 
    shader->num_parameters = 0;
 
+   /* Passes are independent until they are chained up,
+    * compile them all at once */
+   for (i = 0; i < shader->passes; i++)
+      paths.push_back(shader->pass[i].source.path);
+
+   if (!glslang_compile_shaders(paths.data(), shader->passes, &outputs))
+      goto error;
+
    for (i = 0; i < shader->passes; i++)
    {
-      glslang_output output;
+      glslang_output &output             = outputs[i];
       struct gl_core_filter_chain_pass_info pass_info;
       const video_shader_pass *pass      = &shader->pass[i];
       const video_shader_pass *next_pass =
@@ -2230,13 +2402,6 @@ gl_core_filter_chain_t *gl_core_filter_chain_create_from_preset(
       pass_info.address       = GL_CORE_FILTER_CHAIN_ADDRESS_REPEAT;
       pass_info.max_levels    = 0;
 
-      if (!glslang_compile_shader(pass->source.path, &output))
-      {
-         RARCH_ERR("Failed to compile shader: \"%s\".\n",
-               pass->source.path);
-         goto error;
-      }
-
       for (auto &meta_param : output.meta.parameters)
       {
          if (shader->num_parameters >= GFX_MAX_PARAMETERS)
@@ -34,6 +34,7 @@
 #endif
 
 #include "shader_glsl.h"
+#include "gl_program_cache.h"
 #include "../../managers/state_manager.h"
 #include "../../core.h"
 #include "../../verbosity.h"
@@ -345,14 +346,45 @@ static bool gl_glsl_compile_program(
       void *program_data,
       struct shader_program_info *program_info)
 {
+   char cache_path[PATH_MAX_LENGTH];
    glsl_shader_data_t *glsl = (glsl_shader_data_t*)data;
    struct shader_program_glsl_data *program = (struct shader_program_glsl_data*)program_data;
-   GLuint prog = glCreateProgram();
+   GLuint prog = 0;
+
+   cache_path[0] = '\0';
 
    if (!program)
       program = &glsl->prg[idx];
 
-   if (!prog)
+   if (program_info->vertex || program_info->fragment)
+   {
+      /* The GLSL version header depends on the context */
+      char context[64];
+      const char *sources[4];
+
+      snprintf(context, sizeof(context), "%d %u.%u",
+            glsl_core, glsl_major, glsl_minor);
+
+      sources[0] = context;
+      sources[1] = glsl->alias_define;
+      sources[2] = program_info->vertex;
+      sources[3] = program_info->fragment;
+
+      gl_program_cache_path(cache_path, sizeof(cache_path),
+            sources, ARRAY_SIZE(sources));
+
+      if ((prog = gl_program_cache_load(cache_path)))
+      {
+         RARCH_LOG("[GLSL]: Using cached program binary.\n");
+         glUseProgram(prog);
+         glUniform1i(gl_glsl_get_uniform(glsl, prog, "Texture"), 0);
+         glUseProgram(0);
+         program->id = prog;
+         return true;
+      }
+   }
+
+   if (!(prog = glCreateProgram()))
       goto error;
 
    if (program_info->vertex)
@@ -389,9 +421,12 @@ static bool gl_glsl_compile_program(
    if (program_info->vertex || program_info->fragment)
    {
       RARCH_LOG("[GLSL]: Linking GLSL program.\n");
+      gl_program_cache_prepare(prog);
       if (!gl_glsl_link_program(prog))
          goto error;
 
+      gl_program_cache_save(prog, cache_path);
+
       /* Clean up dead memory. We're not going to relink the program.
        * Detaching first seems to kill some mobile drivers
        * (according to the intertubes anyways). */
@@ -28,6 +28,7 @@
 #include <formats/image.h>
 #include <retro_miscellaneous.h>
 
+#include "slang_fbo_plan.h"
 #include "slang_reflection.h"
 #include "slang_reflection.hpp"
 
@@ -217,6 +218,7 @@ class Framebuffer
       VkRenderPass get_render_pass() const { return render_pass; }
 
       unsigned get_levels() const { return levels; }
+      size_t get_memory_size() const { return memory.size; }
 
    private:
       Size2D size;
@@ -290,6 +292,12 @@ class Pass
       const Framebuffer &get_framebuffer() const { return *framebuffer; }
       Framebuffer *get_feedback_framebuffer() { return fb_feedback.get(); }
 
+      /* Renders into the framebuffer of 'pass' from now on */
+      void share_framebuffer(const Pass &pass)
+      {
+         framebuffer = pass.framebuffer;
+      }
+
       Size2D set_pass_info(
             const Size2D &max_original,
             const Size2D &max_source,
@@ -364,8 +372,8 @@ class Pass
 
       vector<uint32_t> vertex_shader;
       vector<uint32_t> fragment_shader;
-      unique_ptr<Framebuffer> framebuffer;
-      unique_ptr<Framebuffer> fb_feedback;
+      shared_ptr<Framebuffer> framebuffer;
+      shared_ptr<Framebuffer> fb_feedback;
       VkRenderPass swapchain_render_pass;
 
       void clear_vk();
@@ -494,12 +502,19 @@ struct vulkan_filter_chain
       bool init_history();
       bool init_feedback();
       bool init_alias();
+      void init_shared_framebuffers();
       void update_history(DeferredDisposer &disposer, VkCommandBuffer cmd);
       vector<unique_ptr<Framebuffer>> original_history;
       bool require_clear = false;
       void clear_history_and_feedback(VkCommandBuffer cmd);
       void update_feedback_info();
       void update_history_info();
+
+      /* Passes owning the framebuffers
+       * the offscreen passes render to */
+      vector<unsigned> framebuffer_owners;
+      size_t framebuffer_memory = 0;
+      void update_framebuffer_memory();
 };
 
 vulkan_filter_chain::vulkan_filter_chain(
@@ -673,6 +688,36 @@ void vulkan_filter_chain::build_offscreen_passes(VkCommandBuffer cmd,
 
       common.pass_outputs[i]  = source;
    }
+
+   update_framebuffer_memory();
+}
+
+void vulkan_filter_chain::update_framebuffer_memory()
+{
+   unsigned i;
+   size_t memory = 0;
+
+   for (i = 0; i < framebuffer_owners.size(); i++)
+      memory += passes[framebuffer_owners[i]]->get_framebuffer()
+         .get_memory_size();
+
+   for (i = 0; i < passes.size(); i++)
+   {
+      Framebuffer *fb = passes[i]->get_feedback_framebuffer();
+      if (fb)
+         memory += fb->get_memory_size();
+   }
+
+   for (i = 0; i < original_history.size(); i++)
+      memory += original_history[i]->get_memory_size();
+
+   /* Only changes when the input or viewport is resized */
+   if (memory != framebuffer_memory)
+   {
+      framebuffer_memory = memory;
+      RARCH_LOG("[Vulkan filter chain]: Framebuffers use %.2f MiB.\n",
+            memory / (1024.0 * 1024.0));
+   }
 }
 
 void vulkan_filter_chain::update_history(DeferredDisposer &disposer,
@@ -874,6 +919,54 @@ bool vulkan_filter_chain::init_feedback()
 }
 
 
+void vulkan_filter_chain::init_shared_framebuffers()
+{
+   unsigned i, j;
+   unsigned num_passes = passes.size() - 1;
+   unsigned num_framebuffers;
+   vector<slang_fbo_plan_pass> plan(num_passes);
+   vector<unsigned> slots(num_passes);
+
+   framebuffer_owners.clear();
+   framebuffer_memory = 0;
+
+   for (i = 0; i < num_passes; i++)
+   {
+      plan[i].scale_type_x = (enum slang_fbo_plan_scale)pass_info[i].scale_type_x;
+      plan[i].scale_type_y = (enum slang_fbo_plan_scale)pass_info[i].scale_type_y;
+      plan[i].scale_x      = pass_info[i].scale_x;
+      plan[i].scale_y      = pass_info[i].scale_y;
+      plan[i].format       = pass_info[i].rt_format;
+      plan[i].levels       = pass_info[i].max_levels;
+      plan[i].feedback     = passes[i]->get_feedback_framebuffer() != nullptr;
+
+      /* The next pass always reads this one as Source. */
+      plan[i].last_reader  = i + 1;
+
+      for (j = i + 2; j < passes.size(); j++)
+      {
+         auto &outputs = passes[j]->get_reflection().semantic_textures[
+            SLANG_TEXTURE_SEMANTIC_PASS_OUTPUT];
+
+         if (i < outputs.size() && outputs[i].texture)
+            plan[i].last_reader = j;
+      }
+   }
+
+   num_framebuffers = slang_fbo_plan(plan.data(), num_passes, slots.data());
+
+   for (i = 0; i < num_passes; i++)
+   {
+      if (slots[i] == framebuffer_owners.size())
+         framebuffer_owners.push_back(i);
+      else
+         passes[i]->share_framebuffer(*passes[framebuffer_owners[slots[i]]]);
+   }
+
+   RARCH_LOG("[Vulkan filter chain]: Rendering %u offscreen passes to %u framebuffers.\n",
+         num_passes, num_framebuffers);
+}
+
 bool vulkan_filter_chain::init_alias()
 {
    unsigned i, j;
@@ -1026,6 +1119,7 @@ bool vulkan_filter_chain::init()
       return false;
    if (!init_feedback())
       return false;
+   init_shared_framebuffers();
    common.pass_outputs.resize(passes.size());
    return true;
 }
@@ -2560,6 +2654,8 @@ vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
 {
    unsigned i;
    config_file_t *conf            = NULL;
+   vector<glslang_output> outputs;
+   vector<const char*> paths;
    unique_ptr<video_shader> shader{ new video_shader() };
    if (!shader)
       return nullptr;
@@ -2586,9 +2682,17 @@ vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
 
    shader->num_parameters = 0;
 
+   /* Passes are independent until they are chained up,
+    * compile them all at once */
+   for (i = 0; i < shader->passes; i++)
+      paths.push_back(shader->pass[i].source.path);
+
+   if (!glslang_compile_shaders(paths.data(), shader->passes, &outputs))
+      goto error;
+
    for (i = 0; i < shader->passes; i++)
    {
-      glslang_output output;
+      glslang_output &output             = outputs[i];
       struct vulkan_filter_chain_pass_info pass_info;
       const video_shader_pass *pass      = &shader->pass[i];
       const video_shader_pass *next_pass =
@@ -2604,13 +2708,6 @@ vulkan_filter_chain_t *vulkan_filter_chain_create_from_preset(
       pass_info.address       = VULKAN_FILTER_CHAIN_ADDRESS_REPEAT;
       pass_info.max_levels    = 0;
 
-      if (!glslang_compile_shader(pass->source.path, &output))
-      {
-         RARCH_ERR("Failed to compile shader: \"%s\".\n",
-               pass->source.path);
-         goto error;
-      }
-
       for (auto &meta_param : output.meta.parameters)
       {
          if (shader->num_parameters >= GFX_MAX_PARAMETERS)
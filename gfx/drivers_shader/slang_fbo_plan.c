@@ -0,0 +1,160 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include "slang_fbo_plan.h"
+
+/* Output sizes are tracked per axis as a tree of
+ * 'parent size times scale' nodes. The roots are the
+ * original (input) size, the viewport size and, for
+ * absolute sizes, zero. Two passes have the same size
+ * on every frame if they end up on the same node. */
+#define SLANG_FBO_PLAN_ORIGINAL 0
+#define SLANG_FBO_PLAN_VIEWPORT 1
+#define SLANG_FBO_PLAN_ABSOLUTE 2
+#define SLANG_FBO_PLAN_ROOTS    3
+
+struct slang_fbo_plan_node
+{
+   unsigned parent;
+   float scale;
+};
+
+struct slang_fbo_plan_slot
+{
+   unsigned size_x;
+   unsigned size_y;
+   unsigned format;
+   unsigned levels;
+   unsigned busy_until;
+   bool dedicated;
+};
+
+static unsigned slang_fbo_plan_node(struct slang_fbo_plan_node *nodes,
+      unsigned *num_nodes, unsigned parent, float scale)
+{
+   unsigned i;
+
+   /* Sizes are rounded to whole pixels after every
+    * pass, so scaling by one keeps the parent size */
+   if (scale == 1.0f && parent != SLANG_FBO_PLAN_ABSOLUTE)
+      return parent;
+
+   for (i = SLANG_FBO_PLAN_ROOTS; i < *num_nodes; i++)
+      if (nodes[i].parent == parent && nodes[i].scale == scale)
+         return i;
+
+   nodes[*num_nodes].parent = parent;
+   nodes[*num_nodes].scale  = scale;
+   return (*num_nodes)++;
+}
+
+static unsigned slang_fbo_plan_size(struct slang_fbo_plan_node *nodes,
+      unsigned *num_nodes, enum slang_fbo_plan_scale type,
+      float scale, unsigned source)
+{
+   switch (type)
+   {
+      case SLANG_FBO_PLAN_SCALE_ORIGINAL:
+         return slang_fbo_plan_node(nodes, num_nodes,
+               SLANG_FBO_PLAN_ORIGINAL, scale);
+      case SLANG_FBO_PLAN_SCALE_SOURCE:
+         return slang_fbo_plan_node(nodes, num_nodes, source, scale);
+      case SLANG_FBO_PLAN_SCALE_VIEWPORT:
+         return slang_fbo_plan_node(nodes, num_nodes,
+               SLANG_FBO_PLAN_VIEWPORT, scale);
+      case SLANG_FBO_PLAN_SCALE_ABSOLUTE:
+      default:
+         break;
+   }
+
+   return slang_fbo_plan_node(nodes, num_nodes,
+         SLANG_FBO_PLAN_ABSOLUTE, scale);
+}
+
+unsigned slang_fbo_plan(const struct slang_fbo_plan_pass *passes,
+      unsigned num_passes, unsigned *slots)
+{
+   unsigned i, j;
+   unsigned num_slots                 = 0;
+   unsigned num_nodes                 = SLANG_FBO_PLAN_ROOTS;
+   unsigned source_x                  = SLANG_FBO_PLAN_ORIGINAL;
+   unsigned source_y                  = SLANG_FBO_PLAN_ORIGINAL;
+   struct slang_fbo_plan_node *nodes  = NULL;
+   struct slang_fbo_plan_slot *plan   = NULL;
+
+   if (!num_passes)
+      return 0;
+
+   nodes = (struct slang_fbo_plan_node*)
+      malloc((SLANG_FBO_PLAN_ROOTS + 2 * num_passes) * sizeof(*nodes));
+   plan  = (struct slang_fbo_plan_slot*)
+      malloc(num_passes * sizeof(*plan));
+
+   /* Without memory to plan, give every pass its own */
+   if (!nodes || !plan)
+   {
+      for (i = 0; i < num_passes; i++)
+         slots[i] = i;
+      free(nodes);
+      free(plan);
+      return num_passes;
+   }
+
+   for (i = 0; i < num_passes; i++)
+   {
+      const struct slang_fbo_plan_pass *pass = &passes[i];
+      unsigned size_x = slang_fbo_plan_size(nodes, &num_nodes,
+            pass->scale_type_x, pass->scale_x, source_x);
+      unsigned size_y = slang_fbo_plan_size(nodes, &num_nodes,
+            pass->scale_type_y, pass->scale_y, source_y);
+
+      source_x = size_x;
+      source_y = size_y;
+
+      /* A framebuffer is free once its last reader has run.
+       * Pass 'i' cannot render into a framebuffer it samples,
+       * hence the strict comparison. */
+      for (j = 0; j < num_slots; j++)
+      {
+         if (     !plan[j].dedicated
+               && !pass->feedback
+               && plan[j].busy_until < i
+               && plan[j].size_x     == size_x
+               && plan[j].size_y     == size_y
+               && plan[j].format     == pass->format
+               && plan[j].levels     == pass->levels)
+            break;
+      }
+
+      if (j == num_slots)
+      {
+         plan[j].size_x    = size_x;
+         plan[j].size_y    = size_y;
+         plan[j].format    = pass->format;
+         plan[j].levels    = pass->levels;
+         plan[j].dedicated = pass->feedback;
+         num_slots++;
+      }
+
+      plan[j].busy_until = pass->last_reader > i ? pass->last_reader : i;
+      slots[i]           = j;
+   }
+
+   free(nodes);
+   free(plan);
+   return num_slots;
+}
@@ -0,0 +1,77 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_SLANG_FBO_PLAN_H
+#define __RARCH_SLANG_FBO_PLAN_H
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Same order as the scale types of the
+ * Vulkan and GLCore filter chains */
+enum slang_fbo_plan_scale
+{
+   SLANG_FBO_PLAN_SCALE_ORIGINAL = 0,
+   SLANG_FBO_PLAN_SCALE_SOURCE,
+   SLANG_FBO_PLAN_SCALE_VIEWPORT,
+   SLANG_FBO_PLAN_SCALE_ABSOLUTE
+};
+
+struct slang_fbo_plan_pass
+{
+   enum slang_fbo_plan_scale scale_type_x;
+   enum slang_fbo_plan_scale scale_type_y;
+   float scale_x;
+   float scale_y;
+
+   /* Passes only share a framebuffer if both
+    * of these are the same. */
+   unsigned format;
+   unsigned levels;
+
+   /* Last pass which samples the output of this one,
+    * either as its source or as a PassOutput. */
+   unsigned last_reader;
+
+   /* The framebuffer is read back in the next frame,
+    * so it cannot be shared. */
+   bool feedback;
+};
+
+/**
+ * slang_fbo_plan:
+ * @passes            : Offscreen passes of a filter chain,
+ *                      without the final pass.
+ * @num_passes        : Number of passes in @passes.
+ * @slots             : Set to the framebuffer of each pass.
+ *
+ * Plans which offscreen passes of a chain can render into
+ * the same framebuffer. A framebuffer is reused once no later
+ * pass samples its contents any more, and only by passes which
+ * always have the same output size, format and mip levels,
+ * so sharing never causes a resize.
+ *
+ * Framebuffers are numbered in order of first use.
+ *
+ * Returns: number of framebuffers needed.
+ **/
+unsigned slang_fbo_plan(const struct slang_fbo_plan_pass *passes,
+      unsigned num_passes, unsigned *slots);
+
+RETRO_END_DECLS
+
+#endif
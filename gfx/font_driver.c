@@ -17,11 +17,16 @@
 #include <stdlib.h>
 #include <math.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #ifdef HAVE_CONFIG_H
 #include "../config.h"
 #endif
 
 #include "font_driver.h"
+#include "gfx_display.h"
 #include "video_thread_wrapper.h"
 
 #include "../retroarch.h"
@@ -707,11 +712,21 @@ static bool fbdev_font_init_first(
 }
 #endif
 
+#ifdef HAVE_THREADS
+/* Thread on which the most recent font_init_first()
+ * call ran (the video thread, with threaded video) */
+static uintptr_t font_init_thread_id;
+#endif
+
 static bool font_init_first(
       const void **font_driver, void **font_handle,
       void *video_data, const char *font_path, float font_size,
       enum font_driver_render_api api, bool is_threaded)
 {
+#ifdef HAVE_THREADS
+   font_init_thread_id = sthread_get_current_thread_id();
+#endif
+
    if (font_path && !font_path[0])
       font_path = NULL;
 
@@ -1083,6 +1098,11 @@ void font_driver_render_msg(
       char *new_msg = (char*)msg;
 #endif
 
+      /* Without a bound block, text is drawn
+       * immediately - on top of any queued quads */
+      if (!font->block)
+         gfx_display_flush();
+
       font->renderer->render_msg(data,
             font->renderer_data, new_msg, params);
 #ifdef HAVE_LANGEXTRA
@@ -1096,25 +1116,43 @@ void font_driver_bind_block(void *font_data, void *block)
    font_data_t *font = (font_data_t*)(font_data ? font_data : video_font_driver);
 
    if (font && font->renderer && font->renderer->bind_block)
+   {
       font->renderer->bind_block(font->renderer_data, block);
+      font->block = block;
+   }
 }
 
 void font_driver_flush(unsigned width, unsigned height, void *font_data)
 {
    font_data_t *font = (font_data_t*)(font_data ? font_data : video_font_driver);
    if (font && font->renderer && font->renderer->flush)
+   {
+      gfx_display_flush();
       font->renderer->flush(width, height, font->renderer_data);
+   }
 }
 
 int font_driver_get_message_width(void *font_data,
       const char *msg, unsigned len, float scale)
 {
+   int width         = -1;
    font_data_t *font = (font_data_t*)(font_data ? font_data : video_font_driver);
    if (len == 0 && msg)
       len = (unsigned)strlen(msg);
-   if (font && font->renderer && font->renderer->get_message_width)
+   if (!font || !font->renderer || !font->renderer->get_message_width)
+      return -1;
+#ifdef HAVE_THREADS
+   /* Text measured on any other thread (e.g. menu
+    * layout on the main thread, with threaded video)
+    * bypasses the cache */
+   if (font->width_cache_thread != sthread_get_current_thread_id())
       return font->renderer->get_message_width(font->renderer_data, msg, len, scale);
-   return -1;
+#endif
+   if (font_width_cache_get(font->width_cache, msg, len, scale, &width))
+      return width;
+   width = font->renderer->get_message_width(font->renderer_data, msg, len, scale);
+   font_width_cache_set(font->width_cache, msg, len, scale, width);
+   return width;
 }
 
 int font_driver_get_line_height(void *font_data, float scale)
@@ -1197,8 +1235,11 @@ void font_driver_free(void *font_data)
       if (font->renderer && font->renderer->free)
          font->renderer->free(font->renderer_data, is_threaded);
 
+      font_width_cache_free(font->width_cache);
+
       font->renderer      = NULL;
       font->renderer_data = NULL;
+      font->width_cache   = NULL;
 
       free(font);
    }
@@ -1230,6 +1271,10 @@ font_data_t *font_driver_init_first(
       font_data_t *font   = (font_data_t*)calloc(1, sizeof(*font));
       font->renderer      = (const font_renderer_t*)font_driver;
       font->renderer_data = font_handle;
+      font->width_cache   = font_width_cache_new();
+#ifdef HAVE_THREADS
+      font->width_cache_thread = font_init_thread_id;
+#endif
       font->size          = font_size;
       return font;
    }
@@ -25,6 +25,7 @@
 #include "../retroarch.h"
 
 #include "video_defines.h"
+#include "font_width_cache.h"
 
 RETRO_BEGIN_DECLS
 
@@ -128,6 +129,14 @@ typedef struct
 {
    const font_renderer_t *renderer;
    void *renderer_data;
+   /* Vertex block bound with font_driver_bind_block() */
+   void *block;
+   font_width_cache_t *width_cache;
+#ifdef HAVE_THREADS
+   /* Thread that renders with the font; the width
+    * cache is only used on this thread */
+   uintptr_t width_cache_thread;
+#endif
    float size;
 } font_data_t;
 
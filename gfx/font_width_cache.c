@@ -0,0 +1,144 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "font_width_cache.h"
+
+/* Set associative, so that labels drawn every frame
+ * do not keep evicting each other. Number of sets
+ * must be a power of 2 */
+#define FONT_WIDTH_CACHE_SETS 256
+#define FONT_WIDTH_CACHE_WAYS 4
+
+typedef struct
+{
+   uint64_t hash;
+   /* Copy of the measured string (not NUL terminated),
+    * compared on every hit. Buffer is reused when the
+    * entry is replaced */
+   char *str;
+   unsigned len;
+   unsigned cap;
+   float scale;
+   int width;
+} font_width_cache_entry_t;
+
+struct font_width_cache
+{
+   font_width_cache_entry_t entries[FONT_WIDTH_CACHE_SETS][FONT_WIDTH_CACHE_WAYS];
+   /* Next way of each set to be replaced */
+   uint8_t next[FONT_WIDTH_CACHE_SETS];
+};
+
+/* FNV-1a */
+static uint64_t font_width_cache_hash(const char *msg, unsigned len)
+{
+   unsigned i;
+   uint64_t hash = 0xCBF29CE484222325ULL;
+
+   for (i = 0; i < len; i++)
+   {
+      hash ^= (uint8_t)msg[i];
+      hash *= 0x100000001B3ULL;
+   }
+
+   /* 0 marks an unused entry */
+   return hash ? hash : 1;
+}
+
+font_width_cache_t *font_width_cache_new(void)
+{
+   return (font_width_cache_t*)calloc(1, sizeof(font_width_cache_t));
+}
+
+void font_width_cache_free(font_width_cache_t *cache)
+{
+   unsigned i, j;
+
+   if (!cache)
+      return;
+
+   for (i = 0; i < FONT_WIDTH_CACHE_SETS; i++)
+      for (j = 0; j < FONT_WIDTH_CACHE_WAYS; j++)
+         free(cache->entries[i][j].str);
+
+   free(cache);
+}
+
+bool font_width_cache_get(font_width_cache_t *cache,
+      const char *msg, unsigned len, float scale, int *width)
+{
+   unsigned i;
+   uint64_t hash;
+   font_width_cache_entry_t *set = NULL;
+
+   if (!cache || !msg)
+      return false;
+
+   hash = font_width_cache_hash(msg, len);
+   set  = cache->entries[hash & (FONT_WIDTH_CACHE_SETS - 1)];
+
+   for (i = 0; i < FONT_WIDTH_CACHE_WAYS; i++)
+   {
+      if (     set[i].hash  == hash
+            && set[i].len   == len
+            && set[i].scale == scale
+            && !memcmp(set[i].str, msg, len))
+      {
+         *width = set[i].width;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void font_width_cache_set(font_width_cache_t *cache,
+      const char *msg, unsigned len, float scale, int width)
+{
+   uint64_t hash;
+   unsigned set;
+   font_width_cache_entry_t *entry = NULL;
+
+   if (!cache || !msg || width < 0)
+      return;
+
+   hash  = font_width_cache_hash(msg, len);
+   set   = (unsigned)(hash & (FONT_WIDTH_CACHE_SETS - 1));
+   entry = &cache->entries[set][cache->next[set]];
+
+   if (entry->cap < len || !entry->str)
+   {
+      /* Allocate at least one byte, so that
+       * empty strings have a valid buffer */
+      char *str = (char*)realloc(entry->str, len ? len : 1);
+
+      if (!str)
+         return;
+
+      entry->str = str;
+      entry->cap = len ? len : 1;
+   }
+
+   cache->next[set] = (cache->next[set] + 1) % FONT_WIDTH_CACHE_WAYS;
+   memcpy(entry->str, msg, len);
+   entry->hash      = hash;
+   entry->len       = len;
+   entry->scale     = scale;
+   entry->width     = width;
+}
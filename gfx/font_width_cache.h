@@ -0,0 +1,55 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FONT_WIDTH_CACHE_H__
+#define __FONT_WIDTH_CACHE_H__
+
+#include <boolean.h>
+#include <retro_common_api.h>
+
+RETRO_BEGIN_DECLS
+
+/* Caches the results of font_driver_get_message_width().
+ *
+ * Menu drivers measure the same labels every frame;
+ * measuring means one glyph lookup per character, so
+ * each font keeps the widths of recently measured
+ * strings. Strings are located by a 64 bit hash, and
+ * a copy is kept to verify each hit.
+ *
+ * A cache is not thread safe: the font driver only
+ * uses it on the thread that renders with the font. */
+
+typedef struct font_width_cache font_width_cache_t;
+
+font_width_cache_t *font_width_cache_new(void);
+
+void font_width_cache_free(font_width_cache_t *cache);
+
+/* Returns true and sets 'width' if the width of
+ * msg (of length len) at the specified scale is
+ * in the cache */
+bool font_width_cache_get(font_width_cache_t *cache,
+      const char *msg, unsigned len, float scale, int *width);
+
+/* Stores the width of msg (of length len) at the
+ * specified scale, replacing the oldest entry
+ * of its set */
+void font_width_cache_set(font_width_cache_t *cache,
+      const char *msg, unsigned len, float scale, int width);
+
+RETRO_END_DECLS
+
+#endif
@@ -15,6 +15,7 @@
  */
 
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <compat/strl.h>
@@ -25,40 +26,43 @@
 #include <features/features_cpu.h>
 #include <lists/string_list.h>
 
-#define DG_DYNARR_IMPLEMENTATION
-#include <retro_assert.h>
-#define DG_DYNARR_ASSERT(cond, msg)  (void)0
-#include <array/dynarray.h>
-#undef DG_DYNARR_IMPLEMENTATION
-
 #include "gfx_animation.h"
 #include "../performance_counters.h"
 
 typedef float (*easing_cb) (float, float, float, float);
 
-struct tween
-{
-   float       duration;
-   float       running_since;
-   float       initial_value;
-   float       target_value;
-   float       *subject;
-   uintptr_t   tag;
-   easing_cb   easing;
-   tween_cb    cb;
-   void        *userdata;
-   bool        deleted;
-};
-
-DA_TYPEDEF(struct tween, tween_array_t)
+/* Running tweens, stored as one array per field
+ * (structure of arrays) so that the per-frame update
+ * walks contiguous memory. Tweens keep the order in
+ * which they were pushed: removal only flags them as
+ * deleted, and the arrays are compacted once per
+ * update. */
+typedef struct gfx_animation_tweens
+{
+   float     *duration;
+   float     *running_since;
+   float     *initial_value;
+   float     *target_value;
+   float     *value;       /* Eased value of the current update */
+   float     **subject;
+   uintptr_t *tag;
+   tween_cb  *cb;
+   void      **userdata;
+   size_t    *tag_next;    /* Next tween in the same tag bucket, plus one */
+   size_t    *order;       /* Tween indices, grouped by easing type */
+   uint8_t   *easing;
+   uint8_t   *deleted;
+   size_t    count;
+   size_t    capacity;
+   size_t    deleted_count;
+} gfx_animation_tweens_t;
 
 struct gfx_animation
 {
-   bool initialized;
-   bool pending_deletes;
    bool in_update;
    bool animation_is_active;
    bool ticker_is_active;
+   bool ticker_scrolled;
 
    uint64_t ticker_idx;            /* updated every TICKER_SPEED us */
    uint64_t ticker_slow_idx;       /* updated every TICKER_SLOW_SPEED us */
@@ -69,8 +73,12 @@ struct gfx_animation
 
    float delta_time;
 
-   tween_array_t list;
-   tween_array_t pending;
+   gfx_animation_tweens_t tweens;
+
+   /* Hash table of tween indices (plus one) by tag,
+    * chained through tweens.tag_next */
+   size_t *tag_buckets;
+   size_t tag_bucket_mask;
 };
 
 typedef struct gfx_animation gfx_animation_t;
@@ -327,6 +335,168 @@ static float easing_out_in_bounce(float t, float b, float c, float d)
    return easing_in_bounce((t * 2) - d, b + c / 2, c / 2, d);
 }
 
+/* Indexed by enum gfx_animation_easing_type */
+static const easing_cb easing_funcs[EASING_LAST] = {
+   /* Linear */
+   easing_linear,
+   /* Quad */
+   easing_in_quad,
+   easing_out_quad,
+   easing_in_out_quad,
+   easing_out_in_quad,
+   /* Cubic */
+   easing_in_cubic,
+   easing_out_cubic,
+   easing_in_out_cubic,
+   easing_out_in_cubic,
+   /* Quart */
+   easing_in_quart,
+   easing_out_quart,
+   easing_in_out_quart,
+   easing_out_in_quart,
+   /* Quint */
+   easing_in_quint,
+   easing_out_quint,
+   easing_in_out_quint,
+   easing_out_in_quint,
+   /* Sine */
+   easing_in_sine,
+   easing_out_sine,
+   easing_in_out_sine,
+   easing_out_in_sine,
+   /* Expo */
+   easing_in_expo,
+   easing_out_expo,
+   easing_in_out_expo,
+   easing_out_in_expo,
+   /* Circ */
+   easing_in_circ,
+   easing_out_circ,
+   easing_in_out_circ,
+   easing_out_in_circ,
+   /* Bounce */
+   easing_in_bounce,
+   easing_out_bounce,
+   easing_in_out_bounce,
+   easing_out_in_bounce
+};
+
+static size_t gfx_animation_tag_hash(uintptr_t tag, size_t mask)
+{
+   uint32_t h = (uint32_t)tag ^ (uint32_t)((uint64_t)tag >> 32);
+   h         ^= h >> 16;
+   h         *= 0x45d9f3bU;
+   h         ^= h >> 16;
+   return h & mask;
+}
+
+static void gfx_animation_tag_link(gfx_animation_t *p_anim, size_t i)
+{
+   size_t bucket = gfx_animation_tag_hash(
+         p_anim->tweens.tag[i], p_anim->tag_bucket_mask);
+
+   p_anim->tweens.tag_next[i]  = p_anim->tag_buckets[bucket];
+   p_anim->tag_buckets[bucket] = i + 1;
+}
+
+static void gfx_animation_tag_rebuild(gfx_animation_t *p_anim)
+{
+   size_t i;
+
+   memset(p_anim->tag_buckets, 0,
+         (p_anim->tag_bucket_mask + 1) * sizeof(size_t));
+
+   for (i = 0; i < p_anim->tweens.count; i++)
+      gfx_animation_tag_link(p_anim, i);
+}
+
+#define GFX_ANIMATION_REALLOC(field) \
+   tmp = realloc(tw->field, capacity * sizeof(*tw->field)); \
+   if (!tmp) \
+      return false; \
+   tw->field = tmp
+
+/* Makes room for at least one more tween */
+static bool gfx_animation_reserve(gfx_animation_t *p_anim)
+{
+   gfx_animation_tweens_t *tw = &p_anim->tweens;
+   size_t capacity            = tw->capacity ? tw->capacity * 2 : 64;
+   size_t *buckets            = NULL;
+   void *tmp                  = NULL;
+
+   if (tw->count < tw->capacity)
+      return true;
+
+   GFX_ANIMATION_REALLOC(duration);
+   GFX_ANIMATION_REALLOC(running_since);
+   GFX_ANIMATION_REALLOC(initial_value);
+   GFX_ANIMATION_REALLOC(target_value);
+   GFX_ANIMATION_REALLOC(value);
+   GFX_ANIMATION_REALLOC(subject);
+   GFX_ANIMATION_REALLOC(tag);
+   GFX_ANIMATION_REALLOC(cb);
+   GFX_ANIMATION_REALLOC(userdata);
+   GFX_ANIMATION_REALLOC(tag_next);
+   GFX_ANIMATION_REALLOC(order);
+   GFX_ANIMATION_REALLOC(easing);
+   GFX_ANIMATION_REALLOC(deleted);
+
+   /* Keep the tag table at most half full */
+   if (!(buckets = (size_t*)malloc(capacity * 2 * sizeof(size_t))))
+      return false;
+
+   free(p_anim->tag_buckets);
+   p_anim->tag_buckets     = buckets;
+   p_anim->tag_bucket_mask = capacity * 2 - 1;
+   tw->capacity            = capacity;
+
+   gfx_animation_tag_rebuild(p_anim);
+
+   return true;
+}
+
+#undef GFX_ANIMATION_REALLOC
+
+/* Drops deleted and finished tweens, preserving
+ * the order of the remaining ones */
+static void gfx_animation_compact(gfx_animation_t *p_anim)
+{
+   gfx_animation_tweens_t *tw = &p_anim->tweens;
+   size_t i, j                = 0;
+
+   for (i = 0; i < tw->count; i++)
+   {
+      if (tw->deleted[i])
+         continue;
+
+      if (i != j)
+      {
+         tw->duration[j]      = tw->duration[i];
+         tw->running_since[j] = tw->running_since[i];
+         tw->initial_value[j] = tw->initial_value[i];
+         tw->target_value[j]  = tw->target_value[i];
+         tw->subject[j]       = tw->subject[i];
+         tw->tag[j]           = tw->tag[i];
+         tw->cb[j]            = tw->cb[i];
+         tw->userdata[j]      = tw->userdata[i];
+         tw->easing[j]        = tw->easing[i];
+         tw->deleted[j]       = 0;
+      }
+      j++;
+   }
+
+   tw->count         = j;
+   tw->deleted_count = 0;
+
+   gfx_animation_tag_rebuild(p_anim);
+}
+
+static void gfx_animation_delete(gfx_animation_t *p_anim, size_t i)
+{
+   p_anim->tweens.deleted[i] = 1;
+   p_anim->tweens.deleted_count++;
+}
+
 static void gfx_animation_ticker_generic(uint64_t idx,
       size_t max_width, size_t *offset, size_t *width)
 {
@@ -1059,147 +1229,35 @@ void gfx_animation_push_delayed(
 
 bool gfx_animation_push(gfx_animation_ctx_entry_t *entry)
 {
-   struct tween t;
-
-   t.duration           = entry->duration;
-   t.running_since      = 0;
-   t.initial_value      = *entry->subject;
-   t.target_value       = entry->target_value;
-   t.subject            = entry->subject;
-   t.tag                = entry->tag;
-   t.cb                 = entry->cb;
-   t.userdata           = entry->userdata;
-   t.easing             = NULL;
-   t.deleted            = false;
-
-   switch (entry->easing_enum)
-   {
-      case EASING_LINEAR:
-         t.easing       = &easing_linear;
-         break;
-         /* Quad */
-      case EASING_IN_QUAD:
-         t.easing       = &easing_in_quad;
-         break;
-      case EASING_OUT_QUAD:
-         t.easing       = &easing_out_quad;
-         break;
-      case EASING_IN_OUT_QUAD:
-         t.easing       = &easing_in_out_quad;
-         break;
-      case EASING_OUT_IN_QUAD:
-         t.easing       = &easing_out_in_quad;
-         break;
-         /* Cubic */
-      case EASING_IN_CUBIC:
-         t.easing       = &easing_in_cubic;
-         break;
-      case EASING_OUT_CUBIC:
-         t.easing       = &easing_out_cubic;
-         break;
-      case EASING_IN_OUT_CUBIC:
-         t.easing       = &easing_in_out_cubic;
-         break;
-      case EASING_OUT_IN_CUBIC:
-         t.easing       = &easing_out_in_cubic;
-         break;
-         /* Quart */
-      case EASING_IN_QUART:
-         t.easing       = &easing_in_quart;
-         break;
-      case EASING_OUT_QUART:
-         t.easing       = &easing_out_quart;
-         break;
-      case EASING_IN_OUT_QUART:
-         t.easing       = &easing_in_out_quart;
-         break;
-      case EASING_OUT_IN_QUART:
-         t.easing       = &easing_out_in_quart;
-         break;
-         /* Quint */
-      case EASING_IN_QUINT:
-         t.easing       = &easing_in_quint;
-         break;
-      case EASING_OUT_QUINT:
-         t.easing       = &easing_out_quint;
-         break;
-      case EASING_IN_OUT_QUINT:
-         t.easing       = &easing_in_out_quint;
-         break;
-      case EASING_OUT_IN_QUINT:
-         t.easing       = &easing_out_in_quint;
-         break;
-         /* Sine */
-      case EASING_IN_SINE:
-         t.easing       = &easing_in_sine;
-         break;
-      case EASING_OUT_SINE:
-         t.easing       = &easing_out_sine;
-         break;
-      case EASING_IN_OUT_SINE:
-         t.easing       = &easing_in_out_sine;
-         break;
-      case EASING_OUT_IN_SINE:
-         t.easing       = &easing_out_in_sine;
-         break;
-         /* Expo */
-      case EASING_IN_EXPO:
-         t.easing       = &easing_in_expo;
-         break;
-      case EASING_OUT_EXPO:
-         t.easing       = &easing_out_expo;
-         break;
-      case EASING_IN_OUT_EXPO:
-         t.easing       = &easing_in_out_expo;
-         break;
-      case EASING_OUT_IN_EXPO:
-         t.easing       = &easing_out_in_expo;
-         break;
-         /* Circ */
-      case EASING_IN_CIRC:
-         t.easing       = &easing_in_circ;
-         break;
-      case EASING_OUT_CIRC:
-         t.easing       = &easing_out_circ;
-         break;
-      case EASING_IN_OUT_CIRC:
-         t.easing       = &easing_in_out_circ;
-         break;
-      case EASING_OUT_IN_CIRC:
-         t.easing       = &easing_out_in_circ;
-         break;
-         /* Bounce */
-      case EASING_IN_BOUNCE:
-         t.easing       = &easing_in_bounce;
-         break;
-      case EASING_OUT_BOUNCE:
-         t.easing       = &easing_out_bounce;
-         break;
-      case EASING_IN_OUT_BOUNCE:
-         t.easing       = &easing_in_out_bounce;
-         break;
-      case EASING_OUT_IN_BOUNCE:
-         t.easing       = &easing_out_in_bounce;
-         break;
-      default:
-         break;
-   }
+   size_t i;
+   gfx_animation_t *p_anim    = anim_get_ptr();
+   gfx_animation_tweens_t *tw = &p_anim->tweens;
 
    /* ignore born dead tweens */
-   if (!t.easing || t.duration == 0 || t.initial_value == t.target_value)
+   if (     (unsigned)entry->easing_enum >= EASING_LAST
+         || entry->duration == 0
+         || *entry->subject == entry->target_value)
       return false;
 
-   if (!anim.initialized)
-   {
-      da_init(anim.list);
-      da_init(anim.pending);
-      anim.initialized = true;
-   }
+   if (!gfx_animation_reserve(p_anim))
+      return false;
 
-   if (anim.in_update)
-      da_push(anim.pending, t);
-   else
-      da_push(anim.list, t);
+   /* Tweens pushed from a callback during an update
+    * are appended past the range being updated, so
+    * they first run on the next frame */
+   i                     = tw->count++;
+   tw->duration[i]       = entry->duration;
+   tw->running_since[i]  = 0;
+   tw->initial_value[i]  = *entry->subject;
+   tw->target_value[i]   = entry->target_value;
+   tw->subject[i]        = entry->subject;
+   tw->tag[i]            = entry->tag;
+   tw->cb[i]             = entry->cb;
+   tw->userdata[i]       = entry->userdata;
+   tw->easing[i]         = (uint8_t)entry->easing_enum;
+   tw->deleted[i]        = 0;
+
+   gfx_animation_tag_link(p_anim, i);
 
    return true;
 }
@@ -1339,8 +1397,11 @@ bool gfx_animation_update(
       unsigned video_width,
       unsigned video_height)
 {
-   unsigned i;
-   gfx_animation_t *p_anim = anim_get_ptr();
+   size_t i, count;
+   size_t group_start[EASING_LAST + 1];
+   size_t group_end[EASING_LAST + 1];
+   gfx_animation_t *p_anim    = anim_get_ptr();
+   gfx_animation_tweens_t *tw = &p_anim->tweens;
 
    gfx_animation_update_time(
          current_time,
@@ -1349,59 +1410,70 @@ bool gfx_animation_update(
          ticker_speed);
 
    p_anim->in_update       = true;
-   p_anim->pending_deletes = false;
+   count                   = tw->count;
 
-   for (i = 0; i < da_count(p_anim->list); i++)
-   {
-      struct tween *tween   = da_getptr(p_anim->list, i);
+   /* Advance all tweens, and sort them by easing
+    * type, so that each easing function is evaluated
+    * for a whole group at once */
+   memset(group_start, 0, sizeof(group_start));
 
-      if (!tween || tween->deleted)
-         continue;
+   for (i = 0; i < count; i++)
+   {
+      tw->running_since[i] += p_anim->delta_time;
+      group_start[tw->easing[i] + 1]++;
+   }
 
-      tween->running_since += p_anim->delta_time;
+   for (i = 1; i <= EASING_LAST; i++)
+      group_start[i] += group_start[i - 1];
 
-      *tween->subject       = tween->easing(
-            tween->running_since,
-            tween->initial_value,
-            tween->target_value - tween->initial_value,
-            tween->duration);
+   memcpy(group_end, group_start, sizeof(group_end));
 
-      if (tween->running_since >= tween->duration)
-      {
-         *tween->subject = tween->target_value;
+   for (i = 0; i < count; i++)
+      tw->order[group_end[tw->easing[i]]++] = i;
 
-         if (tween->cb)
-            tween->cb(tween->userdata);
+   for (i = 0; i < EASING_LAST; i++)
+   {
+      size_t j;
+      easing_cb easing = easing_funcs[i];
 
-         da_delete(p_anim->list, i);
-         i--;
+      for (j = group_start[i]; j < group_end[i]; j++)
+      {
+         size_t k     = tw->order[j];
+         tw->value[k] = easing(
+               tw->running_since[k],
+               tw->initial_value[k],
+               tw->target_value[k] - tw->initial_value[k],
+               tw->duration[k]);
       }
    }
 
-   if (p_anim->pending_deletes)
+   /* Apply values and run callbacks in push order.
+    * Callbacks may push (and so reallocate) or kill
+    * tweens, so nothing is cached across them */
+   for (i = 0; i < count; i++)
    {
-      for (i = 0; i < da_count(p_anim->list); i++)
+      if (tw->deleted[i])
+         continue;
+
+      if (tw->running_since[i] >= tw->duration[i])
       {
-         struct tween *tween = da_getptr(p_anim->list, i);
-         if (!tween)
-            continue;
-         if (tween->deleted)
-         {
-            da_delete(p_anim->list, i);
-            i--;
-         }
+         tween_cb cb     = tw->cb[i];
+         *tw->subject[i] = tw->target_value[i];
+
+         gfx_animation_delete(p_anim, i);
+
+         if (cb)
+            cb(tw->userdata[i]);
       }
-      p_anim->pending_deletes = false;
+      else
+         *tw->subject[i] = tw->value[i];
    }
 
-   if (da_count(p_anim->pending) > 0)
-   {
-      da_addn(p_anim->list, p_anim->pending.p, da_count(p_anim->pending));
-      da_clear(p_anim->pending);
-   }
+   if (tw->deleted_count > 0)
+      gfx_animation_compact(p_anim);
 
    p_anim->in_update           = false;
-   p_anim->animation_is_active = da_count(p_anim->list) > 0;
+   p_anim->animation_is_active = tw->count > 0;
 
    return p_anim->animation_is_active;
 }
@@ -1519,6 +1591,7 @@ bool gfx_animation_ticker(gfx_animation_ctx_ticker_t *ticker)
    }
 
    p_anim->ticker_is_active = true;
+   p_anim->ticker_scrolled  = true;
 
    return true;
 }
@@ -1660,6 +1733,7 @@ bool gfx_animation_ticker_smooth_fw(gfx_animation_ctx_ticker_smooth_t *ticker)
    success                  = true;
    is_active                = true;
    p_anim->ticker_is_active = true;
+   p_anim->ticker_scrolled  = true;
 
 end:
 
@@ -1878,6 +1952,7 @@ bool gfx_animation_ticker_smooth(gfx_animation_ctx_ticker_smooth_t *ticker)
    success                  = true;
    is_active                = true;
    p_anim->ticker_is_active = true;
+   p_anim->ticker_scrolled  = true;
 
 end:
 
@@ -2009,6 +2084,7 @@ bool gfx_animation_line_ticker(gfx_animation_ctx_line_ticker_t *line_ticker)
    success                  = true;
    is_active                = true;
    p_anim->ticker_is_active = true;
+   p_anim->ticker_scrolled  = true;
 
 end:
 
@@ -2187,6 +2263,7 @@ bool gfx_animation_line_ticker_smooth(gfx_animation_ctx_line_ticker_smooth_t *li
    success                  = true;
    is_active                = true;
    p_anim->ticker_is_active = true;
+   p_anim->ticker_scrolled  = true;
 
 end:
 
@@ -2229,29 +2306,37 @@ bool gfx_animation_is_active(void)
    return p_anim->animation_is_active || p_anim->ticker_is_active;
 }
 
+/* Returns true if any ticker text was scrolled since
+ * the last call. Unlike ticker_is_active (which stays
+ * set once a ticker has moved), this is cleared on
+ * every call, so it tells whether tickers are still
+ * running on screen. */
+bool gfx_animation_ticker_scrolled(void)
+{
+   gfx_animation_t *p_anim = anim_get_ptr();
+   bool scrolled           = p_anim->ticker_scrolled;
+   p_anim->ticker_scrolled = false;
+   return scrolled;
+}
+
 bool gfx_animation_kill_by_tag(gfx_animation_ctx_tag *tag)
 {
-   unsigned i;
+   size_t i;
+   gfx_animation_t *p_anim = anim_get_ptr();
 
    if (!tag || *tag == (uintptr_t)-1)
       return false;
 
-   for (i = 0; i < da_count(anim.list); ++i)
-   {
-      struct tween *t = da_getptr(anim.list, i);
-      if (!t || t->tag != *tag)
-         continue;
+   if (!p_anim->tag_buckets)
+      return true;
 
-      if (anim.in_update)
-      {
-         t->deleted = true;
-         anim.pending_deletes = true;
-      }
-      else
-      {
-         da_delete(anim.list, i);
-         --i;
-      }
+   for (i = p_anim->tag_buckets[gfx_animation_tag_hash(
+            *tag, p_anim->tag_bucket_mask)];
+         i; i = p_anim->tweens.tag_next[i - 1])
+   {
+      if (     (p_anim->tweens.tag[i - 1] == *tag)
+            && !p_anim->tweens.deleted[i - 1])
+         gfx_animation_delete(p_anim, i - 1);
    }
 
    return true;
@@ -2259,31 +2344,23 @@ bool gfx_animation_kill_by_tag(gfx_animation_ctx_tag *tag)
 
 void gfx_animation_kill_by_subject(gfx_animation_ctx_subject_t *subject)
 {
-   unsigned i, j,  killed = 0;
-   float            **sub = (float**)subject->data;
+   size_t i;
+   unsigned j, killed         = 0;
+   float **sub                = (float**)subject->data;
+   gfx_animation_t *p_anim    = anim_get_ptr();
+   gfx_animation_tweens_t *tw = &p_anim->tweens;
 
-   for (i = 0; i < da_count(anim.list) && killed < subject->count; ++i)
+   for (i = 0; i < tw->count && killed < subject->count; ++i)
    {
-      struct tween *t = da_getptr(anim.list, i);
-      if (!t)
+      if (tw->deleted[i])
          continue;
 
       for (j = 0; j < subject->count; ++j)
       {
-         if (t->subject != sub[j])
+         if (tw->subject[i] != sub[j])
             continue;
 
-         if (anim.in_update)
-         {
-            t->deleted = true;
-            anim.pending_deletes = true;
-         }
-         else
-         {
-            da_delete(anim.list, i);
-            --i;
-         }
-
+         gfx_animation_delete(p_anim, i);
          killed++;
          break;
       }
@@ -2304,20 +2381,22 @@ bool gfx_animation_ctl(enum gfx_animation_ctl_state state, void *data)
    {
       case MENU_ANIMATION_CTL_DEINIT:
          {
-            size_t i;
-
-            for (i = 0; i < da_count(anim.list); i++)
-            {
-               struct tween *t = da_getptr(anim.list, i);
-               if (!t)
-                  continue;
-
-               if (t->subject)
-                  t->subject = NULL;
-            }
-
-            da_free(anim.list);
-            da_free(anim.pending);
+            gfx_animation_tweens_t *tw = &p_anim->tweens;
+
+            free(tw->duration);
+            free(tw->running_since);
+            free(tw->initial_value);
+            free(tw->target_value);
+            free(tw->value);
+            free(tw->subject);
+            free(tw->tag);
+            free(tw->cb);
+            free(tw->userdata);
+            free(tw->tag_next);
+            free(tw->order);
+            free(tw->easing);
+            free(tw->deleted);
+            free(p_anim->tag_buckets);
 
             memset(&anim, 0, sizeof(anim));
          }
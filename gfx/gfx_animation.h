@@ -219,6 +219,8 @@ float gfx_animation_get_delta_time(void);
 
 bool gfx_animation_is_active(void);
 
+bool gfx_animation_ticker_scrolled(void);
+
 bool gfx_animation_kill_by_tag(gfx_animation_ctx_tag *tag);
 
 void gfx_animation_kill_by_subject(gfx_animation_ctx_subject_t *subject);
@@ -14,6 +14,8 @@
  *  You should have received a copy of the GNU General Public License along with RetroArch.
  *  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <string.h>
+
 #include "gfx_display.h"
 #include "gfx_animation.h"
 
@@ -23,6 +25,10 @@
 
 #define PARTICLES_COUNT            100
 
+/* Maximum number of quads merged into
+ * a single draw call */
+#define GFX_DISPLAY_BATCH_QUADS    256
+
 /* Number of pixels corner-to-corner on a 1080p
  * display:
  * > sqrt((1920 * 1920) + (1080 * 1080))
@@ -48,11 +54,26 @@ static float osk_dark[16] =  {
  * needs to be refactored */
 uintptr_t gfx_display_white_texture;
 
+/* Consecutive untextured quads, waiting to
+ * be drawn with a single draw call.
+ * Vertices are in full-viewport coordinates */
+typedef struct gfx_display_batch
+{
+   void *userdata;
+   unsigned video_width;
+   unsigned video_height;
+   unsigned quads;
+   float vertex[GFX_DISPLAY_BATCH_QUADS * 6 * 2];
+   float tex_coord[GFX_DISPLAY_BATCH_QUADS * 6 * 2];
+   float color[GFX_DISPLAY_BATCH_QUADS * 6 * 4];
+} gfx_display_batch_t;
+
 struct gfx_display
 {
    bool has_windowed;
    bool msg_force;
    bool framebuf_dirty;
+   bool redraw_requested;
    
    /* Width, height and pitch of the display framebuffer */
    unsigned framebuf_width;
@@ -65,6 +86,13 @@ struct gfx_display
    enum menu_driver_id_type menu_driver_id;
 
    video_coord_array_t dispca;
+
+   /* Draw call statistics, see
+    * gfx_display_get_draw_stats() */
+   unsigned draw_calls;
+   unsigned batched_quads;
+
+   gfx_display_batch_t batch;
 };
 
 typedef struct gfx_display gfx_display_t;
@@ -129,7 +157,8 @@ gfx_display_ctx_driver_t gfx_display_ctx_null = {
    "null",
    false,
    NULL,
-   NULL
+   NULL,
+   true
 };
 
 /* Menu display drivers */
@@ -642,9 +671,149 @@ void gfx_display_coords_array_reset(void)
    p_dispca->coords.vertices = 0;
 }
 
+/* Draws all queued quads with a single draw call.
+ * Must be called before anything else is drawn,
+ * or the render state is changed, so that the
+ * queued quads end up underneath it */
+void gfx_display_flush(void)
+{
+   gfx_display_ctx_draw_t draw;
+   struct video_coords coords;
+   gfx_display_t *p_disp      = disp_get_ptr();
+   gfx_display_batch_t *batch = &p_disp->batch;
+
+   if (!batch->quads)
+      return;
+
+   coords.vertices             = batch->quads * 6;
+   coords.vertex               = batch->vertex;
+   coords.tex_coord            = batch->tex_coord;
+   coords.lut_tex_coord        = batch->tex_coord;
+   coords.color                = batch->color;
+
+   draw.x                      = 0;
+   draw.y                      = 0;
+   draw.width                  = batch->video_width;
+   draw.height                 = batch->video_height;
+   draw.coords                 = &coords;
+   draw.matrix_data            = NULL;
+   draw.texture                = gfx_display_white_texture;
+   draw.prim_type              = GFX_DISPLAY_PRIM_TRIANGLES;
+   draw.pipeline.id            = 0;
+   draw.pipeline.backend_data  = NULL;
+   draw.pipeline.backend_data_size = 0;
+   draw.scale_factor           = 1.0f;
+   draw.rotation               = 0.0f;
+
+   p_disp->batched_quads      += batch->quads;
+   batch->quads                = 0;
+
+   if (!dispctx || !dispctx->draw)
+      return;
+
+   if (dispctx->blend_begin)
+      dispctx->blend_begin(batch->userdata);
+   dispctx->draw(&draw, batch->userdata,
+         batch->video_width, batch->video_height);
+   if (dispctx->blend_end)
+      dispctx->blend_end(batch->userdata);
+
+   p_disp->draw_calls++;
+}
+
+/* Queues a blended, untextured quad.
+ * (x, y) is the bottom left corner, as for
+ * gfx_display_ctx_draw_t.
+ * Returns false if the display driver cannot
+ * draw quads in batches */
+static bool gfx_display_batch_quad(gfx_display_t *p_disp,
+      void *userdata, unsigned video_width, unsigned video_height,
+      float x, float y, unsigned w, unsigned h, const float *color)
+{
+   unsigned i;
+   float x0, y0, x1, y1;
+   float *vertex                    = NULL;
+   float *tex_coord                 = NULL;
+   float *quad_color                = NULL;
+   gfx_display_batch_t *batch       = &p_disp->batch;
+   /* Triangle strip order of the four corners,
+    * split into two triangles */
+   static const unsigned corners[6] = { 0, 1, 2, 2, 1, 3 };
+   static const float white[16]     = {
+      1.0f, 1.0f, 1.0f, 1.0f,
+      1.0f, 1.0f, 1.0f, 1.0f,
+      1.0f, 1.0f, 1.0f, 1.0f,
+      1.0f, 1.0f, 1.0f, 1.0f,
+   };
+
+   if (     !dispctx
+         || !dispctx->batch_quads
+         || !video_width
+         || !video_height)
+      return false;
+
+   if (batch->quads && (
+            batch->userdata     != userdata    ||
+            batch->video_width  != video_width ||
+            batch->video_height != video_height))
+      gfx_display_flush();
+   else if (batch->quads == GFX_DISPLAY_BATCH_QUADS)
+      gfx_display_flush();
+
+   batch->userdata     = userdata;
+   batch->video_width  = video_width;
+   batch->video_height = video_height;
+
+   if (!color)
+      color            = white;
+
+   x0                  = x / (float)video_width;
+   y0                  = y / (float)video_height;
+   x1                  = (x + w) / (float)video_width;
+   y1                  = (y + h) / (float)video_height;
+
+   vertex              = &batch->vertex[batch->quads * 6 * 2];
+   tex_coord           = &batch->tex_coord[batch->quads * 6 * 2];
+   quad_color          = &batch->color[batch->quads * 6 * 4];
+
+   for (i = 0; i < 6; i++)
+   {
+      unsigned corner  = corners[i];
+      /* Same layout as the default vertices and
+       * texture coordinates of the display drivers */
+      *vertex++        = (corner & 1) ? x1 : x0;
+      *vertex++        = (corner & 2) ? y1 : y0;
+      *tex_coord++     = (corner & 1) ? 1.0f : 0.0f;
+      *tex_coord++     = (corner & 2) ? 0.0f : 1.0f;
+      memcpy(quad_color, &color[corner * 4], 4 * sizeof(float));
+      quad_color      += 4;
+   }
+
+   batch->quads++;
+   return true;
+}
+
+/* Returns the number of draw calls submitted to
+ * the display driver, and the number of quads that
+ * were drawn in batches, since the previous call */
+void gfx_display_get_draw_stats(unsigned *draw_calls,
+      unsigned *batched_quads)
+{
+   gfx_display_t *p_disp = disp_get_ptr();
+
+   if (draw_calls)
+      *draw_calls        = p_disp->draw_calls;
+   if (batched_quads)
+      *batched_quads     = p_disp->batched_quads;
+
+   p_disp->draw_calls    = 0;
+   p_disp->batched_quads = 0;
+}
+
 /* Begin blending operation */
 void gfx_display_blend_begin(void *data)
 {
+   gfx_display_flush();
    if (dispctx && dispctx->blend_begin)
       dispctx->blend_begin(data);
 }
@@ -652,6 +821,7 @@ void gfx_display_blend_begin(void *data)
 /* End blending operation */
 void gfx_display_blend_end(void *data)
 {
+   gfx_display_flush();
    if (dispctx && dispctx->blend_end)
       dispctx->blend_end(data);
 }
@@ -662,6 +832,7 @@ void gfx_display_scissor_begin(void *userdata,
       unsigned video_height,
       int x, int y, unsigned width, unsigned height)
 {
+   gfx_display_flush();
    if (dispctx && dispctx->scissor_begin)
    {
       if (y < 0)
@@ -708,6 +879,7 @@ void gfx_display_scissor_end(
       unsigned video_height
       )
 {
+   gfx_display_flush();
    if (dispctx && dispctx->scissor_end)
       dispctx->scissor_end(userdata,
             video_width, video_height);
@@ -737,6 +909,7 @@ font_data_t *gfx_display_font_file(
 
 bool gfx_display_restore_clear_color(void)
 {
+   gfx_display_flush();
    if (!dispctx || !dispctx->restore_clear_color)
       return false;
    dispctx->restore_clear_color();
@@ -746,6 +919,7 @@ bool gfx_display_restore_clear_color(void)
 /* TODO/FIXME - this is no longer used - consider getting rid of it */
 void gfx_display_clear_color(gfx_display_ctx_clearcolor_t *color, void *data)
 {
+   gfx_display_flush();
    if (dispctx && dispctx->clear_color)
       dispctx->clear_color(color, data);
 }
@@ -755,6 +929,7 @@ void gfx_display_draw(gfx_display_ctx_draw_t *draw,
       unsigned video_width, 
       unsigned video_height)
 {
+   gfx_display_flush();
    if (!dispctx || !draw || !dispctx->draw)
       return;
 
@@ -763,6 +938,7 @@ void gfx_display_draw(gfx_display_ctx_draw_t *draw,
    if (draw->width <= 0)
       return;
    dispctx->draw(draw, data, video_width, video_height);
+   disp_get_ptr()->draw_calls++;
 }
 
 void gfx_display_draw_blend(
@@ -771,6 +947,7 @@ void gfx_display_draw_blend(
       unsigned video_width,
       unsigned video_height)
 {
+   gfx_display_flush();
    if (!dispctx || !draw || !dispctx->draw)
       return;
 
@@ -781,6 +958,7 @@ void gfx_display_draw_blend(
    gfx_display_blend_begin(data);
    dispctx->draw(draw, data, video_width, video_height);
    gfx_display_blend_end(data);
+   disp_get_ptr()->draw_calls++;
 }
 
 void gfx_display_draw_pipeline(
@@ -789,9 +967,18 @@ void gfx_display_draw_pipeline(
       unsigned video_width,
       unsigned video_height)
 {
+   gfx_display_flush();
+
+   /* Shader pipelines are animated by the GPU, so
+    * the menu cannot be considered idle */
+   gfx_display_request_redraw();
+
    if (dispctx && draw && dispctx->draw_pipeline)
+   {
       dispctx->draw_pipeline(draw, userdata,
             video_width, video_height);
+      disp_get_ptr()->draw_calls++;
+   }
 }
 
 void gfx_display_draw_bg(gfx_display_ctx_draw_t *draw,
@@ -865,12 +1052,22 @@ void gfx_display_draw_quad(
    gfx_display_ctx_draw_t draw;
    struct video_coords coords;
 
+   if (w == 0 || h == 0)
+      return;
+
+   /* Consecutive quads are drawn together */
+   if (gfx_display_batch_quad(disp_get_ptr(), data,
+            video_width, video_height,
+            x, (int)height - y - (int)h, w, h, color))
+      return;
+
    coords.vertices      = 4;
    coords.vertex        = NULL;
    coords.tex_coord     = NULL;
    coords.lut_tex_coord = NULL;
    coords.color         = color;
 
+   gfx_display_flush();
    if (dispctx && dispctx->blend_begin)
       dispctx->blend_begin(data);
 
@@ -924,6 +1121,7 @@ void gfx_display_draw_polygon(
    coords.lut_tex_coord = NULL;
    coords.color         = color;
 
+   gfx_display_flush();
    if (dispctx && dispctx->blend_begin)
       dispctx->blend_begin(userdata);
 
@@ -1376,6 +1574,7 @@ void gfx_display_draw_cursor(
    coords.lut_tex_coord = NULL;
    coords.color         = (const float*)color;
 
+   gfx_display_flush();
    if (dispctx && dispctx->blend_begin)
       dispctx->blend_begin(userdata);
 
@@ -1449,6 +1648,8 @@ void gfx_display_snow(
    static int timeout      = 0;
    unsigned i, max_gen     = 2;
 
+   gfx_display_request_redraw();
+
    for (i = 0; i < PARTICLES_COUNT; ++i)
    {
       struct display_particle *p = (struct display_particle*)&particles[i];
@@ -1630,11 +1831,13 @@ bool gfx_display_get_update_pending(void)
 
 void gfx_display_set_viewport(unsigned width, unsigned height)
 {
+   gfx_display_flush();
    video_driver_set_viewport(width, height, true, false);
 }
 
 void gfx_display_unset_viewport(unsigned width, unsigned height)
 {
+   gfx_display_flush();
    video_driver_set_viewport(width, height, false, true);
 }
 
@@ -1661,6 +1864,26 @@ void gfx_display_unset_framebuffer_dirty_flag(void)
    p_disp->framebuf_dirty = false;
 }
 
+/* Asks for the next menu frame to be drawn, even if
+ * there is no input and no animation is running
+ * (e.g. a thumbnail became available, or the menu
+ * draws something that changes every frame). */
+void gfx_display_request_redraw(void)
+{
+   gfx_display_t *p_disp   = disp_get_ptr();
+   p_disp->redraw_requested = true;
+}
+
+/* Returns true if a redraw was requested since the
+ * last call, and clears the request. */
+bool gfx_display_take_redraw_request(void)
+{
+   gfx_display_t *p_disp   = disp_get_ptr();
+   bool requested          = p_disp->redraw_requested;
+   p_disp->redraw_requested = false;
+   return requested;
+}
+
 void gfx_display_draw_keyboard(
       void *userdata,
       unsigned video_width,
@@ -1882,6 +2105,7 @@ void gfx_display_free(void)
    p_disp->framebuf_height     = 0;
    p_disp->framebuf_pitch      = 0;
    p_disp->has_windowed        = false;
+   p_disp->batch.quads         = 0;
    dispctx                     = NULL;
 }
 
@@ -1920,6 +2144,7 @@ bool gfx_display_init_first_driver(bool video_is_threaded)
       RARCH_LOG("[Menu]: Found menu display driver: \"%s\".\n",
             gfx_display_ctx_drivers[i]->ident);
       dispctx = gfx_display_ctx_drivers[i];
+      disp_get_ptr()->batch.quads = 0;
       return true;
    }
    return false;
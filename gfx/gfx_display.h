@@ -141,6 +141,10 @@ typedef struct gfx_display_ctx_driver
          int x, int y, unsigned width, unsigned height);
    void (*scissor_end)(void *data, unsigned video_width,
          unsigned video_height);
+   /* Set if 'draw' accepts GFX_DISPLAY_PRIM_TRIANGLES
+    * with any number of vertices, so that consecutive
+    * quads can be drawn with a single call */
+   bool batch_quads;
 } gfx_display_ctx_driver_t;
 
 struct gfx_display_ctx_draw
@@ -205,6 +209,11 @@ void gfx_display_free(void);
 
 void gfx_display_init(void);
 
+void gfx_display_flush(void);
+
+void gfx_display_get_draw_stats(unsigned *draw_calls,
+      unsigned *batched_quads);
+
 void gfx_display_blend_begin(void *data);
 
 void gfx_display_blend_end(void *data);
@@ -264,6 +273,8 @@ void gfx_display_unset_viewport(unsigned width, unsigned height);
 bool gfx_display_get_framebuffer_dirty_flag(void);
 void gfx_display_set_framebuffer_dirty_flag(void);
 void gfx_display_unset_framebuffer_dirty_flag(void);
+void gfx_display_request_redraw(void);
+bool gfx_display_take_redraw_request(void);
 bool gfx_display_init_first_driver(bool video_is_threaded);
 bool gfx_display_restore_clear_color(void);
 
@@ -26,193 +26,1553 @@
 
 #include <features/features_cpu.h>
 #include <file/file_path.h>
+#include <lists/dir_list.h>
 #include <string/stdstring.h>
+#include <streams/file_stream.h>
+#include <formats/image.h>
+
+#if defined(HAVE_ZLIB)
+#include <streams/rzip_stream.h>
+#endif
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
 
 #include "gfx_display.h"
 #include "gfx_animation.h"
 
-#include "gfx_thumbnail.h"
+#include "gfx_thumbnail.h"
+
+#include "../msg_hash.h"
+#include "../tasks/tasks_internal.h"
+
+#define DEFAULT_GFX_THUMBNAIL_STREAM_DELAY  83.333333f
+#define DEFAULT_GFX_THUMBNAIL_FADE_DURATION 166.66667f
+#define DEFAULT_GFX_THUMBNAIL_CACHE_SIZE    (64 * 1024 * 1024)
+#define DEFAULT_GFX_THUMBNAIL_DISK_CACHE_SIZE (256 * 1024 * 1024)
+
+/* Number of hash buckets used to index cache
+ * entries (must be a power of 2) */
+#define GFX_THUMBNAIL_CACHE_BUCKETS         256
+
+/* On-disk thumbnail cache file header
+ * > magic, version, width, height, key length,
+ *   followed by key string and raw pixel data */
+#define GFX_THUMBNAIL_DISK_CACHE_MAGIC      0x43485452 /* 'RTHC' */
+#define GFX_THUMBNAIL_DISK_CACHE_VERSION    1
+#define GFX_THUMBNAIL_DISK_CACHE_HEADER_LEN (5 * sizeof(uint32_t))
+#define GFX_THUMBNAIL_DISK_CACHE_EXT        ".tcache"
+/* Lists on-disk cache files, most recently used
+ * first, so that eviction order survives restarts */
+#define GFX_THUMBNAIL_DISK_CACHE_INDEX      "index.txt"
+
+/* A texture held by the thumbnail texture cache
+ * > 'refs' is the number of gfx_thumbnail_t objects
+ *   currently displaying the texture. Entries with no
+ *   references are evicted in least recently used
+ *   order when the cache exceeds its size budget */
+typedef struct gfx_thumbnail_cache_entry
+{
+   struct gfx_thumbnail_cache_entry *prev;
+   struct gfx_thumbnail_cache_entry *next;
+   /* Hash bucket chains, by key and by texture */
+   struct gfx_thumbnail_cache_entry *key_next;
+   struct gfx_thumbnail_cache_entry *texture_next;
+   char *key;
+   uintptr_t texture;
+   size_t size;
+   uint32_t hash;
+   unsigned width;
+   unsigned height;
+   unsigned refs;
+} gfx_thumbnail_cache_entry_t;
+
+#ifdef HAVE_THREADS
+/* A file held by the on-disk thumbnail cache
+ * > Files are named after 'hash'. Least recently
+ *   used files are deleted when the total size
+ *   of the cache exceeds its budget */
+typedef struct gfx_thumbnail_disk_entry
+{
+   struct gfx_thumbnail_disk_entry *prev;
+   struct gfx_thumbnail_disk_entry *next;
+   struct gfx_thumbnail_disk_entry *hash_next;
+   size_t size;
+   uint32_t hash;
+} gfx_thumbnail_disk_entry_t;
+
+/* Upper limit on the number of thumbnail decode threads */
+#define GFX_THUMBNAIL_MAX_THREADS          4
+/* Per-frame GPU upload budget of gfx_thumbnail_update()
+ * > When a burst of decodes completes, uploads are
+ *   spread over several frames instead of stalling
+ *   a single one. At least one thumbnail is always
+ *   uploaded per frame */
+#define GFX_THUMBNAIL_UPLOAD_BYTES         (4 * 1024 * 1024)
+#define GFX_THUMBNAIL_UPLOAD_TIME          2000 /* usec */
+
+enum gfx_thumbnail_job_state
+{
+   GFX_THUMBNAIL_JOB_QUEUED = 0,
+   GFX_THUMBNAIL_JOB_RUNNING,
+   GFX_THUMBNAIL_JOB_DONE
+};
+
+/* A single image decode request, handled by
+ * the thumbnail worker threads */
+typedef struct gfx_thumbnail_job
+{
+   struct texture_image img;
+   struct gfx_thumbnail_job *next;
+   gfx_thumbnail_t *thumbnail;
+   char *path;
+   char *key;
+   char *cache_path;
+   uint64_t list_id;
+   size_t idx;
+   unsigned upscale_threshold;
+   unsigned max_width;
+   unsigned max_height;
+   uint32_t cache_hash;
+   enum gfx_thumbnail_job_state state;
+   bool has_idx;
+   bool cancelled;
+   bool cache_written;
+} gfx_thumbnail_job_t;
+#endif
+
+/* Structure containing all gfx_thumbnail
+ * global variables */
+struct gfx_thumbnail_state
+{
+   /* When streaming thumbnails, to minimise the processing
+    * of unnecessary images (i.e. when scrolling rapidly through
+    * playlists), we delay loading until an entry has been on screen
+    * for at least gfx_thumbnail_delay ms */
+   float stream_delay;
+
+   /* Duration in ms of the thumbnail 'fade in' animation */
+   float fade_duration;
+
+   /* Due to the asynchronous nature of thumbnail
+    * loading, it is quite possible to trigger a load
+    * then navigate to a different menu list before
+    * the load is complete/handled. As an additional
+    * safety check, we therefore tag the current menu
+    * list with counter value that is incremented whenever
+    * a list is cleared/set. This is sent as userdata when
+    * requesting a thumbnail, and the upload is only
+    * handled if the tag matches the most recent value
+    * at the time when the load completes */
+   uint64_t list_id;
+
+   /* Maximum dimensions of decoded thumbnails
+    * (0: use current video output size) */
+   unsigned max_width;
+   unsigned max_height;
+
+   /* Texture cache, most recently used entry first.
+    * Previously displayed thumbnails are fetched from
+    * here without touching the disk
+    * > Entries are indexed by key hash and by texture
+    *   handle */
+   gfx_thumbnail_cache_entry_t *cache_head;
+   gfx_thumbnail_cache_entry_t *cache_tail;
+   gfx_thumbnail_cache_entry_t *cache_keys[GFX_THUMBNAIL_CACHE_BUCKETS];
+   gfx_thumbnail_cache_entry_t *cache_textures[GFX_THUMBNAIL_CACHE_BUCKETS];
+   size_t cache_size;
+   size_t cache_budget;
+   bool cache_budget_set;
+
+   /* Directory holding pre-scaled thumbnail images
+    * (empty: on-disk cache disabled) */
+   char cache_dir[PATH_MAX_LENGTH];
+
+#ifdef HAVE_THREADS
+   /* Files of the on-disk cache, most recently used
+    * first. Only accessed on the main thread */
+   gfx_thumbnail_disk_entry_t *disk_head;
+   gfx_thumbnail_disk_entry_t *disk_tail;
+   gfx_thumbnail_disk_entry_t *disk_buckets[GFX_THUMBNAIL_CACHE_BUCKETS];
+   size_t disk_size;
+   size_t disk_budget;
+   bool disk_budget_set;
+   bool disk_index_dirty;
+
+   /* Thumbnails are decoded by a small pool of
+    * worker threads. Decoded images are returned
+    * to the main thread (which owns the video
+    * context) by gfx_thumbnail_update(), where
+    * they are uploaded to the GPU */
+   slock_t *lock;
+   scond_t *cond;
+   sthread_t *threads[GFX_THUMBNAIL_MAX_THREADS];
+   gfx_thumbnail_job_t *jobs;
+   /* Current menu selection; queued jobs are
+    * serviced in order of distance from this
+    * entry, so on-screen thumbnails nearest the
+    * cursor appear first */
+   size_t selection;
+   unsigned num_threads;
+   bool shutdown;
+   bool pool_failed;
+#endif
+};
+
+typedef struct gfx_thumbnail_state gfx_thumbnail_state_t;
+
+/* Utility structure, sent as userdata when pushing
+ * an image load */
+typedef struct
+{
+   gfx_thumbnail_t *thumbnail;
+   char *key;
+   retro_time_t list_id;
+} gfx_thumbnail_tag_t;
+
+/* Global gfx_thumbnail_state structure */
+static gfx_thumbnail_state_t gfx_thumb_state;
+
+/* Global variable access */
+
+/* Returns pointer to global gfx_thumbnail_state
+ * structure */
+static gfx_thumbnail_state_t *gfx_thumb_get_ptr(void)
+{
+   return &gfx_thumb_state;
+}
+
+#ifdef HAVE_THREADS
+/* On-disk cache index */
+
+static size_t gfx_thumbnail_disk_cache_get_budget(
+      gfx_thumbnail_state_t *p_gfx_thumb)
+{
+   return p_gfx_thumb->disk_budget_set
+         ? p_gfx_thumb->disk_budget
+         : DEFAULT_GFX_THUMBNAIL_DISK_CACHE_SIZE;
+}
+
+static void gfx_thumbnail_disk_cache_get_path(
+      gfx_thumbnail_state_t *p_gfx_thumb, uint32_t hash,
+      char *s, size_t len)
+{
+   char file_name[32];
+
+   snprintf(file_name, sizeof(file_name), "%08x" GFX_THUMBNAIL_DISK_CACHE_EXT,
+         (unsigned)hash);
+   fill_pathname_join(s, p_gfx_thumb->cache_dir, file_name, len);
+}
+
+static gfx_thumbnail_disk_entry_t *gfx_thumbnail_disk_cache_find(
+      gfx_thumbnail_state_t *p_gfx_thumb, uint32_t hash)
+{
+   gfx_thumbnail_disk_entry_t *entry = NULL;
+
+   for (entry = p_gfx_thumb->disk_buckets[hash & (GFX_THUMBNAIL_CACHE_BUCKETS - 1)];
+         entry; entry = entry->hash_next)
+      if (entry->hash == hash)
+         return entry;
+
+   return NULL;
+}
+
+static void gfx_thumbnail_disk_cache_unlink(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      gfx_thumbnail_disk_entry_t *entry)
+{
+   if (entry->prev)
+      entry->prev->next      = entry->next;
+   else
+      p_gfx_thumb->disk_head = entry->next;
+
+   if (entry->next)
+      entry->next->prev      = entry->prev;
+   else
+      p_gfx_thumb->disk_tail = entry->prev;
+
+   entry->prev = NULL;
+   entry->next = NULL;
+}
+
+static void gfx_thumbnail_disk_cache_push_front(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      gfx_thumbnail_disk_entry_t *entry)
+{
+   entry->prev = NULL;
+   entry->next = p_gfx_thumb->disk_head;
+
+   if (p_gfx_thumb->disk_head)
+      p_gfx_thumb->disk_head->prev = entry;
+   else
+      p_gfx_thumb->disk_tail       = entry;
+
+   p_gfx_thumb->disk_head = entry;
+}
+
+static gfx_thumbnail_disk_entry_t *gfx_thumbnail_disk_cache_add(
+      gfx_thumbnail_state_t *p_gfx_thumb, uint32_t hash, size_t size)
+{
+   gfx_thumbnail_disk_entry_t **bucket = &p_gfx_thumb->disk_buckets[
+         hash & (GFX_THUMBNAIL_CACHE_BUCKETS - 1)];
+   gfx_thumbnail_disk_entry_t *entry   = (gfx_thumbnail_disk_entry_t*)
+         calloc(1, sizeof(*entry));
+
+   if (!entry)
+      return NULL;
+
+   entry->hash      = hash;
+   entry->size      = size;
+   entry->hash_next = *bucket;
+   *bucket          = entry;
+
+   gfx_thumbnail_disk_cache_push_front(p_gfx_thumb, entry);
+   p_gfx_thumb->disk_size += size;
+
+   return entry;
+}
+
+/* Drops 'entry' from the index, deleting the
+ * associated file if 'remove_file' is true */
+static void gfx_thumbnail_disk_cache_free_entry(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      gfx_thumbnail_disk_entry_t *entry, bool remove_file)
+{
+   gfx_thumbnail_disk_entry_t **link = &p_gfx_thumb->disk_buckets[
+         entry->hash & (GFX_THUMBNAIL_CACHE_BUCKETS - 1)];
+
+   while (*link && (*link != entry))
+      link = &(*link)->hash_next;
+   if (*link)
+      *link = entry->hash_next;
+
+   gfx_thumbnail_disk_cache_unlink(p_gfx_thumb, entry);
+   p_gfx_thumb->disk_size -= entry->size;
+
+   if (remove_file)
+   {
+      char path[PATH_MAX_LENGTH];
+
+      gfx_thumbnail_disk_cache_get_path(p_gfx_thumb,
+            entry->hash, path, sizeof(path));
+      filestream_delete(path);
+   }
+
+   free(entry);
+}
+
+/* Deletes least recently used files until the
+ * on-disk cache fits within its size budget */
+static void gfx_thumbnail_disk_cache_trim(gfx_thumbnail_state_t *p_gfx_thumb)
+{
+   size_t budget = gfx_thumbnail_disk_cache_get_budget(p_gfx_thumb);
+
+   while (p_gfx_thumb->disk_tail && (p_gfx_thumb->disk_size > budget))
+   {
+      gfx_thumbnail_disk_cache_free_entry(p_gfx_thumb,
+            p_gfx_thumb->disk_tail, true);
+      p_gfx_thumb->disk_index_dirty = true;
+   }
+}
+
+/* Records a read or write of the cache file
+ * named after 'hash', marking it as most
+ * recently used
+ * > The file size is only fetched if the file
+ *   is new to the index, or was rewritten */
+static void gfx_thumbnail_disk_cache_touch(
+      gfx_thumbnail_state_t *p_gfx_thumb, uint32_t hash, bool written)
+{
+   gfx_thumbnail_disk_entry_t *entry = gfx_thumbnail_disk_cache_find(
+         p_gfx_thumb, hash);
+
+   if (!entry || written)
+   {
+      char path[PATH_MAX_LENGTH];
+      int32_t file_size = 0;
+
+      gfx_thumbnail_disk_cache_get_path(p_gfx_thumb,
+            hash, path, sizeof(path));
+
+      if ((file_size = path_get_size(path)) < 0)
+      {
+         if (entry)
+            gfx_thumbnail_disk_cache_free_entry(p_gfx_thumb, entry, false);
+         return;
+      }
+
+      if (!entry)
+         entry = gfx_thumbnail_disk_cache_add(p_gfx_thumb,
+               hash, (size_t)file_size);
+      else
+      {
+         p_gfx_thumb->disk_size -= entry->size;
+         entry->size             = (size_t)file_size;
+         p_gfx_thumb->disk_size += entry->size;
+      }
+
+      if (!entry)
+         return;
+   }
+
+   gfx_thumbnail_disk_cache_unlink(p_gfx_thumb, entry);
+   gfx_thumbnail_disk_cache_push_front(p_gfx_thumb, entry);
+   p_gfx_thumb->disk_index_dirty = true;
+
+   gfx_thumbnail_disk_cache_trim(p_gfx_thumb);
+}
+
+/* Saves the usage order of on-disk cache files */
+static void gfx_thumbnail_disk_cache_write_index(
+      gfx_thumbnail_state_t *p_gfx_thumb)
+{
+   char path[PATH_MAX_LENGTH];
+   gfx_thumbnail_disk_entry_t *entry = NULL;
+   size_t num_entries                = 0;
+   size_t pos                        = 0;
+   char *buf                         = NULL;
+
+   if (     !p_gfx_thumb->disk_index_dirty
+         || string_is_empty(p_gfx_thumb->cache_dir))
+      return;
+
+   for (entry = p_gfx_thumb->disk_head; entry; entry = entry->next)
+      num_entries++;
+
+   if (!(buf = (char*)malloc(num_entries * 9 + 1)))
+      return;
+
+   for (entry = p_gfx_thumb->disk_head; entry; entry = entry->next)
+   {
+      snprintf(buf + pos, 10, "%08x\n", (unsigned)entry->hash);
+      pos += 9;
+   }
+
+   fill_pathname_join(path, p_gfx_thumb->cache_dir,
+         GFX_THUMBNAIL_DISK_CACHE_INDEX, sizeof(path));
+
+   if (filestream_write_file(path, buf, (int64_t)pos))
+      p_gfx_thumb->disk_index_dirty = false;
+
+   free(buf);
+}
+
+/* Empties the on-disk cache index (files are
+ * left untouched) */
+static void gfx_thumbnail_disk_cache_clear(gfx_thumbnail_state_t *p_gfx_thumb)
+{
+   while (p_gfx_thumb->disk_head)
+      gfx_thumbnail_disk_cache_free_entry(p_gfx_thumb,
+            p_gfx_thumb->disk_head, false);
+
+   p_gfx_thumb->disk_size        = 0;
+   p_gfx_thumb->disk_index_dirty = false;
+}
+
+/* Builds the on-disk cache index from the contents
+ * of the cache directory, then trims the cache to
+ * its size budget
+ * > Files are ordered as listed in the saved index;
+ *   files missing from it are evicted first */
+static void gfx_thumbnail_disk_cache_scan(gfx_thumbnail_state_t *p_gfx_thumb)
+{
+   size_t i;
+   char path[PATH_MAX_LENGTH];
+   struct string_list *files = NULL;
+   uint32_t *order           = NULL;
+   size_t num_order          = 0;
+   void *buf                 = NULL;
+   int64_t len               = 0;
+
+   gfx_thumbnail_disk_cache_clear(p_gfx_thumb);
+
+   if (string_is_empty(p_gfx_thumb->cache_dir))
+      return;
+
+   /* Note: extension is passed without its leading '.' */
+   if (!(files = dir_list_new(p_gfx_thumb->cache_dir,
+               GFX_THUMBNAIL_DISK_CACHE_EXT + 1,
+               false, false, false, false)))
+      return;
+
+   for (i = 0; i < files->size; i++)
+   {
+      const char *file_path = files->elems[i].data;
+      const char *file_name = path_basename(file_path);
+      char *end             = NULL;
+      uint32_t hash         = 0;
+      int32_t file_size     = 0;
+
+      if (string_is_empty(file_name))
+         continue;
+
+      hash = (uint32_t)strtoul(file_name, &end, 16);
+
+      if (     (end != file_name + 8)
+            || !string_is_equal(end, GFX_THUMBNAIL_DISK_CACHE_EXT)
+            || gfx_thumbnail_disk_cache_find(p_gfx_thumb, hash))
+         continue;
+
+      if ((file_size = path_get_size(file_path)) < 0)
+         continue;
+
+      gfx_thumbnail_disk_cache_add(p_gfx_thumb, hash, (size_t)file_size);
+   }
+
+   string_list_free(files);
+
+   fill_pathname_join(path, p_gfx_thumb->cache_dir,
+         GFX_THUMBNAIL_DISK_CACHE_INDEX, sizeof(path));
+
+   if (     path_is_valid(path)
+         && filestream_read_file(path, &buf, &len)
+         && (order = (uint32_t*)malloc((size_t)(len / 9 + 1) * sizeof(uint32_t))))
+   {
+      const char *str = (const char*)buf;
+
+      while (*str)
+      {
+         char *end     = NULL;
+         uint32_t hash = (uint32_t)strtoul(str, &end, 16);
+
+         if (end == str)
+            break;
+
+         order[num_order++] = hash;
+         str                = end;
+
+         while (*str == '\n' || *str == '\r')
+            str++;
+      }
+
+      /* Index lists most recently used files first */
+      while (num_order > 0)
+      {
+         gfx_thumbnail_disk_entry_t *entry = gfx_thumbnail_disk_cache_find(
+               p_gfx_thumb, order[--num_order]);
+
+         if (entry)
+         {
+            gfx_thumbnail_disk_cache_unlink(p_gfx_thumb, entry);
+            gfx_thumbnail_disk_cache_push_front(p_gfx_thumb, entry);
+         }
+      }
+   }
+
+   free(order);
+   free(buf);
+
+   gfx_thumbnail_disk_cache_trim(p_gfx_thumb);
+}
+#endif
+
+/* Setters */
+
+/* When streaming thumbnails, sets time in ms that an
+ * entry must be on screen before an image load is
+ * requested
+ * > if 'delay' is negative, default value is set */
+void gfx_thumbnail_set_stream_delay(float delay)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+   p_gfx_thumb->stream_delay = (delay >= 0.0f) ?
+         delay : DEFAULT_GFX_THUMBNAIL_STREAM_DELAY;
+}
+
+/* Sets duration in ms of the thumbnail 'fade in'
+ * animation
+ * > If 'duration' is negative, default value is set */
+void gfx_thumbnail_set_fade_duration(float duration)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+   p_gfx_thumb->fade_duration = (duration >= 0.0f) ?
+         duration : DEFAULT_GFX_THUMBNAIL_FADE_DURATION;
+}
+
+/* Sets the maximum dimensions of decoded thumbnail
+ * images; larger images are downscaled (preserving
+ * aspect ratio) before upload
+ * > If 'width' or 'height' is zero, the current video
+ *   output size is used
+ * > Only applies when thumbnails are decoded on the
+ *   worker threads (HAVE_THREADS) */
+void gfx_thumbnail_set_max_size(unsigned width, unsigned height)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+   p_gfx_thumb->max_width  = width;
+   p_gfx_thumb->max_height = height;
+}
+
+/* Sets the maximum size in bytes of thumbnail
+ * textures retained for reuse after they leave
+ * the screen
+ * > If 'size' is zero, textures are freed as soon
+ *   as they are no longer displayed */
+void gfx_thumbnail_set_cache_size(size_t size)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+   p_gfx_thumb->cache_budget     = size;
+   p_gfx_thumb->cache_budget_set = true;
+}
+
+/* Sets the directory in which pre-scaled copies of
+ * thumbnail images are stored
+ * > If 'dir' is NULL or empty, the on-disk cache
+ *   is disabled */
+void gfx_thumbnail_set_cache_dir(const char *dir)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+#ifdef HAVE_THREADS
+   gfx_thumbnail_disk_cache_write_index(p_gfx_thumb);
+   gfx_thumbnail_disk_cache_clear(p_gfx_thumb);
+#endif
+
+   p_gfx_thumb->cache_dir[0] = '\0';
+
+   if (string_is_empty(dir))
+      return;
+
+   if (!path_is_directory(dir) && !path_mkdir(dir))
+      return;
+
+   strlcpy(p_gfx_thumb->cache_dir, dir, sizeof(p_gfx_thumb->cache_dir));
+
+#ifdef HAVE_THREADS
+   gfx_thumbnail_disk_cache_scan(p_gfx_thumb);
+#endif
+}
+
+/* Sets the maximum total size in bytes of the
+ * on-disk thumbnail cache; least recently used
+ * files are deleted when it is exceeded
+ * > If 'size' is zero, the on-disk cache is
+ *   disabled (and emptied) */
+void gfx_thumbnail_set_disk_cache_size(size_t size)
+{
+#ifdef HAVE_THREADS
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+   p_gfx_thumb->disk_budget     = size;
+   p_gfx_thumb->disk_budget_set = true;
+
+   gfx_thumbnail_disk_cache_trim(p_gfx_thumb);
+#endif
+}
+
+/* Getters */
+
+/* Fetches current streaming thumbnails request delay */
+float gfx_thumbnail_get_stream_delay(void)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+   return p_gfx_thumb->stream_delay;
+}
+
+/* Fetches current 'fade in' animation duration */
+float gfx_thumbnail_get_fade_duration(void)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+   return p_gfx_thumb->fade_duration;
+}
+
+/* Texture cache */
+
+static size_t gfx_thumbnail_cache_get_budget(
+      gfx_thumbnail_state_t *p_gfx_thumb)
+{
+   return p_gfx_thumb->cache_budget_set
+         ? p_gfx_thumb->cache_budget
+         : DEFAULT_GFX_THUMBNAIL_CACHE_SIZE;
+}
+
+/* Generates the cache key of a thumbnail image,
+ * identifying both the source file and the scaling
+ * applied to it
+ * > Source file modification time is not available
+ *   via the VFS interface, so file size is used to
+ *   detect replaced images
+ * > Returns false if the file does not exist */
+static bool gfx_thumbnail_get_key(const char *path,
+      unsigned upscale_threshold, char *s, size_t len)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   unsigned max_width                 = p_gfx_thumb->max_width;
+   unsigned max_height                = p_gfx_thumb->max_height;
+   int32_t file_size                  = path_get_size(path);
+
+   if (file_size < 0)
+      return false;
+
+   if ((max_width < 1) || (max_height < 1))
+      video_driver_get_size(&max_width, &max_height);
+
+   snprintf(s, len, "%s|%d|%ux%u|%u|%d",
+         path, (int)file_size, max_width, max_height,
+         upscale_threshold, video_driver_supports_rgba() ? 1 : 0);
+
+   return true;
+}
+
+static void gfx_thumbnail_cache_unlink(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      gfx_thumbnail_cache_entry_t *entry)
+{
+   if (entry->prev)
+      entry->prev->next       = entry->next;
+   else
+      p_gfx_thumb->cache_head = entry->next;
+
+   if (entry->next)
+      entry->next->prev       = entry->prev;
+   else
+      p_gfx_thumb->cache_tail = entry->prev;
+
+   entry->prev = NULL;
+   entry->next = NULL;
+}
+
+static void gfx_thumbnail_cache_push_front(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      gfx_thumbnail_cache_entry_t *entry)
+{
+   entry->prev = NULL;
+   entry->next = p_gfx_thumb->cache_head;
+
+   if (p_gfx_thumb->cache_head)
+      p_gfx_thumb->cache_head->prev = entry;
+   else
+      p_gfx_thumb->cache_tail       = entry;
+
+   p_gfx_thumb->cache_head = entry;
+}
+
+static size_t gfx_thumbnail_cache_texture_bucket(uintptr_t texture)
+{
+   /* Texture handles are either small sequential
+    * integers (GL) or aligned pointers */
+   return (size_t)(texture ^ (texture >> 4) ^ (texture >> 12))
+         & (GFX_THUMBNAIL_CACHE_BUCKETS - 1);
+}
+
+static void gfx_thumbnail_cache_index_add(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      gfx_thumbnail_cache_entry_t *entry)
+{
+   gfx_thumbnail_cache_entry_t **key_bucket     = &p_gfx_thumb->cache_keys[
+         entry->hash & (GFX_THUMBNAIL_CACHE_BUCKETS - 1)];
+   gfx_thumbnail_cache_entry_t **texture_bucket = &p_gfx_thumb->cache_textures[
+         gfx_thumbnail_cache_texture_bucket(entry->texture)];
+
+   entry->key_next     = *key_bucket;
+   *key_bucket         = entry;
+   entry->texture_next = *texture_bucket;
+   *texture_bucket     = entry;
+}
+
+static void gfx_thumbnail_cache_index_remove(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      gfx_thumbnail_cache_entry_t *entry)
+{
+   gfx_thumbnail_cache_entry_t **link = &p_gfx_thumb->cache_keys[
+         entry->hash & (GFX_THUMBNAIL_CACHE_BUCKETS - 1)];
+
+   while (*link && (*link != entry))
+      link = &(*link)->key_next;
+   if (*link)
+      *link = entry->key_next;
+
+   link = &p_gfx_thumb->cache_textures[
+         gfx_thumbnail_cache_texture_bucket(entry->texture)];
+
+   while (*link && (*link != entry))
+      link = &(*link)->texture_next;
+   if (*link)
+      *link = entry->texture_next;
+
+   entry->key_next     = NULL;
+   entry->texture_next = NULL;
+}
+
+static void gfx_thumbnail_cache_free_entry(
+      gfx_thumbnail_state_t *p_gfx_thumb,
+      gfx_thumbnail_cache_entry_t *entry)
+{
+   gfx_thumbnail_cache_unlink(p_gfx_thumb, entry);
+   gfx_thumbnail_cache_index_remove(p_gfx_thumb, entry);
+   p_gfx_thumb->cache_size -= entry->size;
+
+   /* Texture is only owned by the cache once
+    * no thumbnail is displaying it */
+   if (entry->refs == 0)
+      video_driver_texture_unload(&entry->texture);
+
+   free(entry->key);
+   free(entry);
+}
+
+/* Evicts least recently used, unreferenced textures
+ * until the cache fits within its size budget */
+static void gfx_thumbnail_cache_trim(gfx_thumbnail_state_t *p_gfx_thumb)
+{
+   size_t budget                      = gfx_thumbnail_cache_get_budget(p_gfx_thumb);
+   gfx_thumbnail_cache_entry_t *entry = p_gfx_thumb->cache_tail;
+
+   while (entry && (p_gfx_thumb->cache_size > budget))
+   {
+      gfx_thumbnail_cache_entry_t *prev = entry->prev;
+
+      if (entry->refs == 0)
+         gfx_thumbnail_cache_free_entry(p_gfx_thumb, entry);
+
+      entry = prev;
+   }
+}
+
+static gfx_thumbnail_cache_entry_t *gfx_thumbnail_cache_find(
+      gfx_thumbnail_state_t *p_gfx_thumb, const char *key)
+{
+   gfx_thumbnail_cache_entry_t *entry = NULL;
+   uint32_t hash                      = msg_hash_calculate(key);
+
+   for (entry = p_gfx_thumb->cache_keys[hash & (GFX_THUMBNAIL_CACHE_BUCKETS - 1)];
+         entry; entry = entry->key_next)
+      if ((entry->hash == hash) && string_is_equal(entry->key, key))
+         return entry;
+
+   return NULL;
+}
+
+static gfx_thumbnail_cache_entry_t *gfx_thumbnail_cache_find_texture(
+      gfx_thumbnail_state_t *p_gfx_thumb, uintptr_t texture)
+{
+   gfx_thumbnail_cache_entry_t *entry = NULL;
+
+   if (!texture)
+      return NULL;
+
+   for (entry = p_gfx_thumb->cache_textures[
+         gfx_thumbnail_cache_texture_bucket(texture)];
+         entry; entry = entry->texture_next)
+      if (entry->texture == texture)
+         return entry;
+
+   return NULL;
+}
+
+/* Assigns a cached texture to 'thumbnail'
+ * > Returns false on cache miss */
+static bool gfx_thumbnail_cache_acquire(
+      const char *key, gfx_thumbnail_t *thumbnail)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   gfx_thumbnail_cache_entry_t *entry = gfx_thumbnail_cache_find(
+         p_gfx_thumb, key);
+
+   if (!entry)
+      return false;
+
+   entry->refs++;
+
+   gfx_thumbnail_cache_unlink(p_gfx_thumb, entry);
+   gfx_thumbnail_cache_push_front(p_gfx_thumb, entry);
+
+   /* Texture is already resident - no need
+    * for a 'fade in' animation */
+   thumbnail->texture = entry->texture;
+   thumbnail->width   = entry->width;
+   thumbnail->height  = entry->height;
+   thumbnail->alpha   = 1.0f;
+   thumbnail->status  = GFX_THUMBNAIL_STATUS_AVAILABLE;
+
+   gfx_display_request_redraw();
+
+   return true;
+}
+
+/* Adds the newly uploaded texture of 'thumbnail'
+ * to the cache */
+static void gfx_thumbnail_cache_insert(
+      const char *key, gfx_thumbnail_t *thumbnail)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   gfx_thumbnail_cache_entry_t *entry = NULL;
+
+   if (gfx_thumbnail_cache_get_budget(p_gfx_thumb) == 0)
+      return;
+
+   /* If the same image was loaded twice, keep
+    * the first copy (the second is owned by its
+    * thumbnail, and freed on reset as normal) */
+   if (gfx_thumbnail_cache_find(p_gfx_thumb, key))
+      return;
+
+   if (!(entry = (gfx_thumbnail_cache_entry_t*)calloc(1, sizeof(*entry))))
+      return;
+
+   if (!(entry->key = strdup(key)))
+   {
+      free(entry);
+      return;
+   }
+
+   entry->hash    = msg_hash_calculate(key);
+   entry->texture = thumbnail->texture;
+   entry->width   = thumbnail->width;
+   entry->height  = thumbnail->height;
+   entry->size    = (size_t)thumbnail->width * thumbnail->height * sizeof(uint32_t);
+   entry->refs    = 1;
+
+   gfx_thumbnail_cache_push_front(p_gfx_thumb, entry);
+   gfx_thumbnail_cache_index_add(p_gfx_thumb, entry);
+   p_gfx_thumb->cache_size += entry->size;
+
+   gfx_thumbnail_cache_trim(p_gfx_thumb);
+}
+
+/* Releases the current texture of 'thumbnail'
+ * > Cached textures are retained; any other
+ *   texture is unloaded */
+static void gfx_thumbnail_cache_release(gfx_thumbnail_t *thumbnail)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   gfx_thumbnail_cache_entry_t *entry = gfx_thumbnail_cache_find_texture(
+         p_gfx_thumb, thumbnail->texture);
+
+   if (entry && (entry->refs > 0))
+   {
+      entry->refs--;
+      gfx_thumbnail_cache_trim(p_gfx_thumb);
+   }
+   else
+      video_driver_texture_unload(&thumbnail->texture);
+}
+
+/* Callbacks */
+
+/* Uploads decoded thumbnail image data to the GPU,
+ * provided that 'thumbnail' is still waiting for it */
+static void gfx_thumbnail_upload(
+      gfx_thumbnail_t *thumbnail, uint64_t list_id,
+      const char *key, struct texture_image *img)
+{
+   gfx_animation_ctx_entry_t animation_entry;
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+   /* Ensure that we are operating on the correct
+    * thumbnail... */
+   if (list_id != p_gfx_thumb->list_id)
+      return;
+
+   /* Only process image if we are waiting for it */
+   if (thumbnail->status != GFX_THUMBNAIL_STATUS_PENDING)
+      return;
+
+   /* Sanity check: if thumbnail already has a texture,
+    * we're in some kind of weird error state - in this
+    * case, the best course of action is to just reset
+    * the thumbnail... */
+   if (thumbnail->texture)
+      gfx_thumbnail_reset(thumbnail);
+
+   /* Set thumbnail 'missing' status by default
+    * (saves a number of checks later) */
+   thumbnail->status = GFX_THUMBNAIL_STATUS_MISSING;
+
+   /* Check we have a valid image */
+   if (!img)
+      return;
+
+   if ((img->width < 1) || (img->height < 1))
+      return;
+
+   /* Upload texture to GPU */
+   if (!video_driver_texture_load(
+            img, TEXTURE_FILTER_MIPMAP_LINEAR, &thumbnail->texture))
+      return;
+
+   /* Cache dimensions */
+   thumbnail->width  = img->width;
+   thumbnail->height = img->height;
+
+   /* Update thumbnail status */
+   thumbnail->status = GFX_THUMBNAIL_STATUS_AVAILABLE;
+
+   if (key)
+      gfx_thumbnail_cache_insert(key, thumbnail);
+
+   /* Make sure the new image is shown even when
+    * the menu is otherwise idle */
+   gfx_display_request_redraw();
+
+   /* Trigger 'fade in' animation, if required */
+   if (p_gfx_thumb->fade_duration > 0.0f)
+   {
+      thumbnail->alpha             = 0.0f;
+
+      animation_entry.easing_enum  = EASING_OUT_QUAD;
+      animation_entry.tag          = (uintptr_t)&thumbnail->alpha;
+      animation_entry.duration     = p_gfx_thumb->fade_duration;
+      animation_entry.target_value = 1.0f;
+      animation_entry.subject      = &thumbnail->alpha;
+      animation_entry.cb           = NULL;
+      animation_entry.userdata     = NULL;
+
+      gfx_animation_push(&animation_entry);
+   }
+   else
+      thumbnail->alpha             = 1.0f;
+}
+
+/* Used to process thumbnail data following completion
+ * of image load task */
+static void gfx_thumbnail_handle_upload(
+      retro_task_t *task, void *task_data, void *user_data, const char *err)
+{
+   struct texture_image *img          = (struct texture_image*)task_data;
+   gfx_thumbnail_tag_t *thumbnail_tag = (gfx_thumbnail_tag_t*)user_data;
+
+   if (thumbnail_tag)
+      gfx_thumbnail_upload(thumbnail_tag->thumbnail,
+            thumbnail_tag->list_id, thumbnail_tag->key, img);
+
+   /* Clean up */
+   if (img)
+   {
+      image_texture_free(img);
+      free(img);
+   }
+
+   if (thumbnail_tag)
+   {
+      if (thumbnail_tag->key)
+         free(thumbnail_tag->key);
+      free(thumbnail_tag);
+   }
+}
+
+#ifdef HAVE_THREADS
+/* Worker threads */
+
+/* Shrinks 'img' (box filter) so that it fits inside
+ * max_width x max_height, preserving aspect ratio.
+ * Each byte of a pixel is averaged independently,
+ * so this works for both ARGB and ABGR data */
+static void gfx_thumbnail_downscale(struct texture_image *img,
+      unsigned max_width, unsigned max_height)
+{
+   unsigned x_dst, y_dst;
+   unsigned dst_width, dst_height;
+   uint32_t *dst_pixels = NULL;
+
+   if (!img->pixels || (img->width < 1) || (img->height < 1))
+      return;
+
+   if (     ((max_width  < 1) || (img->width  <= max_width))
+         && ((max_height < 1) || (img->height <= max_height)))
+      return;
+
+   dst_width  = img->width;
+   dst_height = img->height;
+
+   if ((max_width > 0) && (dst_width > max_width))
+   {
+      dst_height = (unsigned)(((uint64_t)dst_height * max_width) / dst_width);
+      dst_width  = max_width;
+   }
+
+   if ((max_height > 0) && (dst_height > max_height))
+   {
+      dst_width  = (unsigned)(((uint64_t)dst_width * max_height) / dst_height);
+      dst_height = max_height;
+   }
+
+   if (dst_width  < 1)
+      dst_width  = 1;
+   if (dst_height < 1)
+      dst_height = 1;
+
+   dst_pixels = (uint32_t*)malloc(dst_width * dst_height * sizeof(uint32_t));
+   if (!dst_pixels)
+      return;
+
+   for (y_dst = 0; y_dst < dst_height; y_dst++)
+   {
+      unsigned y_start = (unsigned)(((uint64_t)y_dst       * img->height) / dst_height);
+      unsigned y_end   = (unsigned)(((uint64_t)(y_dst + 1) * img->height) / dst_height);
+
+      if (y_end <= y_start)
+         y_end = y_start + 1;
+
+      for (x_dst = 0; x_dst < dst_width; x_dst++)
+      {
+         unsigned x, y;
+         uint32_t sum[4]  = {0};
+         unsigned x_start = (unsigned)(((uint64_t)x_dst       * img->width) / dst_width);
+         unsigned x_end   = (unsigned)(((uint64_t)(x_dst + 1) * img->width) / dst_width);
+         unsigned count;
+
+         if (x_end <= x_start)
+            x_end = x_start + 1;
+
+         count = (x_end - x_start) * (y_end - y_start);
+
+         for (y = y_start; y < y_end; y++)
+         {
+            const uint32_t *src = img->pixels + (y * img->width);
+
+            for (x = x_start; x < x_end; x++)
+            {
+               uint32_t col = src[x];
+               sum[0] +=  col        & 0xFF;
+               sum[1] += (col >>  8) & 0xFF;
+               sum[2] += (col >> 16) & 0xFF;
+               sum[3] += (col >> 24) & 0xFF;
+            }
+         }
+
+         dst_pixels[(y_dst * dst_width) + x_dst] =
+                (sum[0] / count)
+             | ((sum[1] / count) <<  8)
+             | ((sum[2] / count) << 16)
+             | ((sum[3] / count) << 24);
+      }
+   }
+
+   free(img->pixels);
+   img->pixels = dst_pixels;
+   img->width  = dst_width;
+   img->height = dst_height;
+}
+
+/* Nearest neighbour upscale of 'img', such that its
+ * smallest dimension reaches 'upscale_threshold'
+ * (integer scale factors only) */
+static void gfx_thumbnail_upscale(struct texture_image *img,
+      unsigned upscale_threshold)
+{
+   unsigned min_size;
+   unsigned scale_factor;
+   unsigned x_dst, y_dst;
+   unsigned dst_width, dst_height;
+   uint32_t *dst_pixels = NULL;
+
+   if (!img->pixels || (img->width < 1) || (img->height < 1))
+      return;
+
+   if (     (upscale_threshold < 1)
+         || ((img->width  >= upscale_threshold)
+         &&  (img->height >= upscale_threshold)))
+      return;
+
+   min_size     = (img->width < img->height) ? img->width : img->height;
+   scale_factor = (upscale_threshold + min_size - 1) / min_size;
+
+   if (scale_factor < 2)
+      return;
+
+   dst_width  = img->width  * scale_factor;
+   dst_height = img->height * scale_factor;
+   dst_pixels = (uint32_t*)malloc(dst_width * dst_height * sizeof(uint32_t));
+   if (!dst_pixels)
+      return;
+
+   for (y_dst = 0; y_dst < dst_height; y_dst++)
+   {
+      const uint32_t *src = img->pixels + ((y_dst / scale_factor) * img->width);
+      uint32_t *dst       = dst_pixels  + (y_dst * dst_width);
 
-#include "../tasks/tasks_internal.h"
+      for (x_dst = 0; x_dst < dst_width; x_dst++)
+         dst[x_dst] = src[x_dst / scale_factor];
+   }
 
-#define DEFAULT_GFX_THUMBNAIL_STREAM_DELAY  83.333333f
-#define DEFAULT_GFX_THUMBNAIL_FADE_DURATION 166.66667f
+   free(img->pixels);
+   img->pixels = dst_pixels;
+   img->width  = dst_width;
+   img->height = dst_height;
+}
 
-/* Structure containing all gfx_thumbnail
- * global variables */
-struct gfx_thumbnail_state
+/* Loads a pre-scaled image from the on-disk cache
+ * > Returns false if the file is missing, or does
+ *   not match 'key' */
+static bool gfx_thumbnail_disk_cache_read(const char *path,
+      const char *key, struct texture_image *img)
 {
-   /* When streaming thumbnails, to minimise the processing
-    * of unnecessary images (i.e. when scrolling rapidly through
-    * playlists), we delay loading until an entry has been on screen
-    * for at least gfx_thumbnail_delay ms */
-   float stream_delay;
+   uint32_t header[5];
+   size_t key_len    = strlen(key);
+   size_t pixels_len = 0;
+   void *buf         = NULL;
+   int64_t len       = 0;
+
+   if (!path_is_valid(path))
+      return false;
+
+#if defined(HAVE_ZLIB)
+   if (!rzipstream_read_file(path, &buf, &len))
+      return false;
+#else
+   if (!filestream_read_file(path, &buf, &len))
+      return false;
+#endif
 
-   /* Duration in ms of the thumbnail 'fade in' animation */
-   float fade_duration;
+   if ((size_t)len < GFX_THUMBNAIL_DISK_CACHE_HEADER_LEN)
+      goto error;
 
-   /* Due to the asynchronous nature of thumbnail
-    * loading, it is quite possible to trigger a load
-    * then navigate to a different menu list before
-    * the load is complete/handled. As an additional
-    * safety check, we therefore tag the current menu
-    * list with counter value that is incremented whenever
-    * a list is cleared/set. This is sent as userdata when
-    * requesting a thumbnail, and the upload is only
-    * handled if the tag matches the most recent value
-    * at the time when the load completes */
-   uint64_t list_id;
-};
+   memcpy(header, buf, sizeof(header));
 
-typedef struct gfx_thumbnail_state gfx_thumbnail_state_t;
+   if (     (header[0] != GFX_THUMBNAIL_DISK_CACHE_MAGIC)
+         || (header[1] != GFX_THUMBNAIL_DISK_CACHE_VERSION)
+         || (header[2] < 1) || (header[3] < 1)
+         || (header[4] != key_len))
+      goto error;
 
-/* Utility structure, sent as userdata when pushing
- * an image load */
-typedef struct
-{
-   gfx_thumbnail_t *thumbnail;
-   retro_time_t list_id;
-} gfx_thumbnail_tag_t;
+   pixels_len = (size_t)header[2] * header[3] * sizeof(uint32_t);
 
-/* Global gfx_thumbnail_state structure */
-static gfx_thumbnail_state_t gfx_thumb_state;
+   if ((size_t)len != GFX_THUMBNAIL_DISK_CACHE_HEADER_LEN + key_len + pixels_len)
+      goto error;
 
-/* Global variable access */
+   if (memcmp((uint8_t*)buf + GFX_THUMBNAIL_DISK_CACHE_HEADER_LEN,
+            key, key_len))
+      goto error;
 
-/* Returns pointer to global gfx_thumbnail_state
- * structure */
-static gfx_thumbnail_state_t *gfx_thumb_get_ptr(void)
-{
-   return &gfx_thumb_state;
-}
+   /* Reuse file buffer for pixel data */
+   memmove(buf, (uint8_t*)buf + GFX_THUMBNAIL_DISK_CACHE_HEADER_LEN + key_len,
+         pixels_len);
 
-/* Setters */
+   img->pixels = (uint32_t*)buf;
+   img->width  = header[2];
+   img->height = header[3];
 
-/* When streaming thumbnails, sets time in ms that an
- * entry must be on screen before an image load is
- * requested
- * > if 'delay' is negative, default value is set */
-void gfx_thumbnail_set_stream_delay(float delay)
-{
-   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   return true;
 
-   p_gfx_thumb->stream_delay = (delay >= 0.0f) ?
-         delay : DEFAULT_GFX_THUMBNAIL_STREAM_DELAY;
+error:
+   free(buf);
+   return false;
 }
 
-/* Sets duration in ms of the thumbnail 'fade in'
- * animation
- * > If 'duration' is negative, default value is set */
-void gfx_thumbnail_set_fade_duration(float duration)
+/* Stores a decoded, scaled image in the on-disk cache
+ * > Returns false if the file could not be written */
+static bool gfx_thumbnail_disk_cache_write(const char *path,
+      const char *key, const struct texture_image *img)
 {
-   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   uint32_t header[5];
+   size_t key_len    = strlen(key);
+   size_t pixels_len = (size_t)img->width * img->height * sizeof(uint32_t);
+   size_t len        = GFX_THUMBNAIL_DISK_CACHE_HEADER_LEN + key_len + pixels_len;
+   uint8_t *buf      = (uint8_t*)malloc(len);
+   bool ret          = false;
+
+   if (!buf)
+      return false;
+
+   header[0] = GFX_THUMBNAIL_DISK_CACHE_MAGIC;
+   header[1] = GFX_THUMBNAIL_DISK_CACHE_VERSION;
+   header[2] = img->width;
+   header[3] = img->height;
+   header[4] = (uint32_t)key_len;
+
+   memcpy(buf, header, sizeof(header));
+   memcpy(buf + GFX_THUMBNAIL_DISK_CACHE_HEADER_LEN, key, key_len);
+   memcpy(buf + GFX_THUMBNAIL_DISK_CACHE_HEADER_LEN + key_len,
+         img->pixels, pixels_len);
+
+#if defined(HAVE_ZLIB)
+   ret = rzipstream_write_file(path, buf, (int64_t)len);
+#else
+   ret = filestream_write_file(path, buf, (int64_t)len);
+#endif
 
-   p_gfx_thumb->fade_duration = (duration >= 0.0f) ?
-         duration : DEFAULT_GFX_THUMBNAIL_FADE_DURATION;
+   free(buf);
+   return ret;
 }
 
-/* Getters */
+static void gfx_thumbnail_job_free(gfx_thumbnail_job_t *job)
+{
+   image_texture_free(&job->img);
+   free(job->path);
+   if (job->key)
+      free(job->key);
+   if (job->cache_path)
+      free(job->cache_path);
+   free(job);
+}
 
-/* Fetches current streaming thumbnails request delay */
-float gfx_thumbnail_get_stream_delay(void)
+/* Returns true if another worker is handling a job
+ * with the same on-disk cache file as 'job'
+ * > Must be called with the pool lock held */
+static bool gfx_thumbnail_job_cache_busy(
+      gfx_thumbnail_state_t *p_gfx_thumb, const gfx_thumbnail_job_t *job)
 {
-   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   const gfx_thumbnail_job_t *other = NULL;
 
-   return p_gfx_thumb->stream_delay;
+   if (!job->cache_path)
+      return false;
+
+   for (other = p_gfx_thumb->jobs; other; other = other->next)
+      if (     (other->state == GFX_THUMBNAIL_JOB_RUNNING)
+            && other->cache_path
+            && (other->cache_hash == job->cache_hash))
+         return true;
+
+   return false;
 }
 
-/* Fetches current 'fade in' animation duration */
-float gfx_thumbnail_get_fade_duration(void)
+/* Returns the queued job closest to the current
+ * menu selection, or NULL if the queue is empty
+ * > Jobs whose cache file is being read or written
+ *   by another worker are held back, so that two
+ *   workers never write the same file at once. The
+ *   worker that finishes picks the held job up next,
+ *   and usually finds it in the cache
+ * > Must be called with the pool lock held */
+static gfx_thumbnail_job_t *gfx_thumbnail_next_job(
+      gfx_thumbnail_state_t *p_gfx_thumb)
 {
-   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   gfx_thumbnail_job_t *job  = NULL;
+   gfx_thumbnail_job_t *best = NULL;
+   size_t best_dist          = 0;
 
-   return p_gfx_thumb->fade_duration;
+   for (job = p_gfx_thumb->jobs; job; job = job->next)
+   {
+      size_t dist = 0;
+
+      if (     (job->state != GFX_THUMBNAIL_JOB_QUEUED)
+            || gfx_thumbnail_job_cache_busy(p_gfx_thumb, job))
+         continue;
+
+      if (job->has_idx)
+         dist = (job->idx > p_gfx_thumb->selection)
+               ? job->idx - p_gfx_thumb->selection
+               : p_gfx_thumb->selection - job->idx;
+
+      if (!best || (dist < best_dist))
+      {
+         best      = job;
+         best_dist = dist;
+
+         if (dist == 0)
+            break;
+      }
+   }
+
+   return best;
 }
 
-/* Callbacks */
+static void gfx_thumbnail_worker(void *data)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = (gfx_thumbnail_state_t*)data;
 
-/* Used to process thumbnail data following completion
- * of image load task */
-static void gfx_thumbnail_handle_upload(
-      retro_task_t *task, void *task_data, void *user_data, const char *err)
+   slock_lock(p_gfx_thumb->lock);
+
+   for (;;)
+   {
+      gfx_thumbnail_job_t *job = NULL;
+
+      while (     !p_gfx_thumb->shutdown
+            && !(job = gfx_thumbnail_next_job(p_gfx_thumb)))
+         scond_wait(p_gfx_thumb->cond, p_gfx_thumb->lock);
+
+      if (p_gfx_thumb->shutdown)
+         break;
+
+      job->state = GFX_THUMBNAIL_JOB_RUNNING;
+      slock_unlock(p_gfx_thumb->lock);
+
+      /* Job now belongs to this thread until it
+       * is marked as done - its members may be
+       * accessed without holding the lock */
+      if (     !job->cache_path
+            || !gfx_thumbnail_disk_cache_read(
+                  job->cache_path, job->key, &job->img))
+      {
+         if (image_texture_load(&job->img, job->path))
+         {
+            gfx_thumbnail_downscale(&job->img,
+                  job->max_width, job->max_height);
+            gfx_thumbnail_upscale(&job->img,
+                  job->upscale_threshold);
+
+            if (job->cache_path)
+               job->cache_written = gfx_thumbnail_disk_cache_write(
+                     job->cache_path, job->key, &job->img);
+         }
+      }
+
+      slock_lock(p_gfx_thumb->lock);
+      job->state = GFX_THUMBNAIL_JOB_DONE;
+   }
+
+   slock_unlock(p_gfx_thumb->lock);
+}
+
+/* Starts thumbnail worker threads, if required
+ * > Returns false if threads could not be created,
+ *   in which case the task queue is used instead */
+static bool gfx_thumbnail_pool_init(gfx_thumbnail_state_t *p_gfx_thumb)
 {
-   gfx_animation_ctx_entry_t animation_entry;
-   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
-   struct texture_image *img          = (struct texture_image*)task_data;
-   gfx_thumbnail_tag_t *thumbnail_tag = (gfx_thumbnail_tag_t*)user_data;
+   unsigned i;
+   unsigned num_threads;
 
-   /* Sanity check */
-   if (!thumbnail_tag)
-      goto end;
+   if (p_gfx_thumb->num_threads > 0)
+      return true;
 
-   /* Ensure that we are operating on the correct
-    * thumbnail... */
-   if (thumbnail_tag->list_id != p_gfx_thumb->list_id)
-      goto end;
+   if (p_gfx_thumb->pool_failed)
+      return false;
 
-   /* Only process image if we are waiting for it */
-   if (thumbnail_tag->thumbnail->status != GFX_THUMBNAIL_STATUS_PENDING)
-      goto end;
+   /* Leave one core for the main thread */
+   num_threads = cpu_features_get_core_amount();
+   num_threads = (num_threads > 1) ? num_threads - 1 : 1;
+   if (num_threads > GFX_THUMBNAIL_MAX_THREADS)
+      num_threads = GFX_THUMBNAIL_MAX_THREADS;
 
-   /* Sanity check: if thumbnail already has a texture,
-    * we're in some kind of weird error state - in this
-    * case, the best course of action is to just reset
-    * the thumbnail... */
-   if (thumbnail_tag->thumbnail->texture)
-      gfx_thumbnail_reset(thumbnail_tag->thumbnail);
+   p_gfx_thumb->lock     = slock_new();
+   p_gfx_thumb->cond     = scond_new();
+   p_gfx_thumb->shutdown = false;
 
-   /* Set thumbnail 'missing' status by default
-    * (saves a number of checks later) */
-   thumbnail_tag->thumbnail->status = GFX_THUMBNAIL_STATUS_MISSING;
+   if (!p_gfx_thumb->lock || !p_gfx_thumb->cond)
+      goto error;
 
-   /* Check we have a valid image */
-   if (!img)
-      goto end;
+   for (i = 0; i < num_threads; i++)
+   {
+      p_gfx_thumb->threads[i] = sthread_create(
+            gfx_thumbnail_worker, p_gfx_thumb);
 
-   if ((img->width < 1) || (img->height < 1))
-      goto end;
+      if (!p_gfx_thumb->threads[i])
+         break;
 
-   /* Upload texture to GPU */
-   if (!video_driver_texture_load(
-            img, TEXTURE_FILTER_MIPMAP_LINEAR, &thumbnail_tag->thumbnail->texture))
-      goto end;
+      p_gfx_thumb->num_threads++;
+   }
 
-   /* Cache dimensions */
-   thumbnail_tag->thumbnail->width  = img->width;
-   thumbnail_tag->thumbnail->height = img->height;
+   if (p_gfx_thumb->num_threads > 0)
+      return true;
 
-   /* Update thumbnail status */
-   thumbnail_tag->thumbnail->status = GFX_THUMBNAIL_STATUS_AVAILABLE;
+error:
+   if (p_gfx_thumb->cond)
+      scond_free(p_gfx_thumb->cond);
+   if (p_gfx_thumb->lock)
+      slock_free(p_gfx_thumb->lock);
 
-   /* Trigger 'fade in' animation, if required */
-   if (p_gfx_thumb->fade_duration > 0.0f)
+   p_gfx_thumb->cond        = NULL;
+   p_gfx_thumb->lock        = NULL;
+   p_gfx_thumb->pool_failed = true;
+
+   return false;
+}
+
+/* Queues an image decode on the worker threads
+ * > Returns false if worker threads are unavailable */
+static bool gfx_thumbnail_push_job(const char *path, const char *key,
+      gfx_thumbnail_t *thumbnail, bool has_idx, size_t idx,
+      unsigned upscale_threshold)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   gfx_thumbnail_job_t *job           = NULL;
+   unsigned max_width                 = p_gfx_thumb->max_width;
+   unsigned max_height                = p_gfx_thumb->max_height;
+
+   if (!gfx_thumbnail_pool_init(p_gfx_thumb))
+      return false;
+
+   if (!(job = (gfx_thumbnail_job_t*)calloc(1, sizeof(*job))))
+      return false;
+
+   if (!(job->path = strdup(path)))
    {
-      thumbnail_tag->thumbnail->alpha  = 0.0f;
+      free(job);
+      return false;
+   }
 
-      animation_entry.easing_enum      = EASING_OUT_QUAD;
-      animation_entry.tag              = (uintptr_t)&thumbnail_tag->thumbnail->alpha;
-      animation_entry.duration         = p_gfx_thumb->fade_duration;
-      animation_entry.target_value     = 1.0f;
-      animation_entry.subject          = &thumbnail_tag->thumbnail->alpha;
-      animation_entry.cb               = NULL;
-      animation_entry.userdata         = NULL;
+   if (key)
+   {
+      job->key = strdup(key);
+
+      /* Pre-scaled copies are stored on disk under
+       * a hash of the key; the full key is kept in
+       * the file to reject collisions */
+      if (     job->key
+            && !string_is_empty(p_gfx_thumb->cache_dir)
+            && (gfx_thumbnail_disk_cache_get_budget(p_gfx_thumb) > 0))
+      {
+         char cache_path[PATH_MAX_LENGTH];
 
-      gfx_animation_push(&animation_entry);
+         job->cache_hash = msg_hash_calculate(key);
+         gfx_thumbnail_disk_cache_get_path(p_gfx_thumb,
+               job->cache_hash, cache_path, sizeof(cache_path));
+         job->cache_path = strdup(cache_path);
+      }
    }
-   else
-      thumbnail_tag->thumbnail->alpha  = 1.0f;
 
-end:
-   /* Clean up */
-   if (img)
+   /* Thumbnails can never be displayed at a size
+    * greater than the current video output */
+   if ((max_width < 1) || (max_height < 1))
+      video_driver_get_size(&max_width, &max_height);
+
+   job->thumbnail         = thumbnail;
+   job->list_id           = p_gfx_thumb->list_id;
+   job->idx               = idx;
+   job->has_idx           = has_idx;
+   job->upscale_threshold = upscale_threshold;
+   job->max_width         = max_width;
+   job->max_height        = max_height;
+   job->state             = GFX_THUMBNAIL_JOB_QUEUED;
+   job->img.supports_rgba = video_driver_supports_rgba();
+
+   slock_lock(p_gfx_thumb->lock);
+   job->next         = p_gfx_thumb->jobs;
+   p_gfx_thumb->jobs = job;
+   scond_signal(p_gfx_thumb->cond);
+   slock_unlock(p_gfx_thumb->lock);
+
+   return true;
+}
+
+/* Drops all outstanding jobs for 'thumbnail'
+ * (or for all thumbnails, if 'thumbnail' is NULL).
+ * Queued jobs are freed immediately; jobs currently
+ * being decoded are flagged, and discarded by
+ * gfx_thumbnail_update() once complete */
+static void gfx_thumbnail_cancel_jobs(gfx_thumbnail_t *thumbnail)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   gfx_thumbnail_job_t **prev         = NULL;
+
+   if (!p_gfx_thumb->lock)
+      return;
+
+   slock_lock(p_gfx_thumb->lock);
+
+   prev = &p_gfx_thumb->jobs;
+   while (*prev)
    {
-      image_texture_free(img);
-      free(img);
+      gfx_thumbnail_job_t *job = *prev;
+
+      if (thumbnail && (job->thumbnail != thumbnail))
+      {
+         prev = &job->next;
+         continue;
+      }
+
+      if (job->state == GFX_THUMBNAIL_JOB_QUEUED)
+      {
+         *prev = job->next;
+         gfx_thumbnail_job_free(job);
+         continue;
+      }
+
+      job->cancelled = true;
+      prev           = &job->next;
    }
 
-   if (thumbnail_tag)
-      free(thumbnail_tag);
+   slock_unlock(p_gfx_thumb->lock);
 }
+#endif
 
 /* Core interface */
 
@@ -227,6 +1587,165 @@ void gfx_thumbnail_cancel_pending_requests(void)
    gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
 
    p_gfx_thumb->list_id++;
+
+#ifdef HAVE_THREADS
+   gfx_thumbnail_cancel_jobs(NULL);
+#endif
+}
+
+/* Uploads thumbnails decoded by the worker threads
+ * - Must be called once per frame, on the main thread
+ * - 'selection' is the currently selected menu entry;
+ *   outstanding decodes are prioritised by their
+ *   distance from this entry */
+void gfx_thumbnail_update(size_t selection)
+{
+#ifdef HAVE_THREADS
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+   gfx_thumbnail_job_t *done          = NULL;
+   gfx_thumbnail_job_t **prev         = NULL;
+   size_t upload_bytes                = 0;
+   retro_time_t start_time            = 0;
+   bool uploaded                      = false;
+
+   if (!p_gfx_thumb->lock)
+      return;
+
+   /* Detach finished jobs from the queue, so that
+    * GPU uploads happen without holding the lock */
+   slock_lock(p_gfx_thumb->lock);
+
+   p_gfx_thumb->selection = selection;
+
+   prev = &p_gfx_thumb->jobs;
+   while (*prev)
+   {
+      gfx_thumbnail_job_t *job = *prev;
+
+      if (     (job->state == GFX_THUMBNAIL_JOB_DONE)
+            && (job->cancelled || (upload_bytes < GFX_THUMBNAIL_UPLOAD_BYTES)))
+      {
+         if (!job->cancelled)
+            upload_bytes += (size_t)job->img.width *
+                  job->img.height * sizeof(uint32_t);
+
+         *prev     = job->next;
+         job->next = done;
+         done      = job;
+         continue;
+      }
+
+      prev = &job->next;
+   }
+
+   slock_unlock(p_gfx_thumb->lock);
+
+   start_time = cpu_features_get_time_usec();
+
+   while (done)
+   {
+      gfx_thumbnail_job_t *next = done->next;
+
+      if (!done->cancelled)
+      {
+         /* Out of time - return remaining jobs
+          * to the queue for the next frame */
+         if (     uploaded
+               && (cpu_features_get_time_usec() - start_time
+                     > GFX_THUMBNAIL_UPLOAD_TIME))
+            break;
+
+         gfx_thumbnail_upload(done->thumbnail, done->list_id,
+               done->key, &done->img);
+         uploaded = true;
+      }
+
+      /* Record use of the on-disk cache file (the
+       * image was either read from it, or written
+       * to it) */
+      if (done->cache_path && done->img.pixels)
+         gfx_thumbnail_disk_cache_touch(p_gfx_thumb,
+               done->cache_hash, done->cache_written);
+
+      gfx_thumbnail_job_free(done);
+      done = next;
+   }
+
+   if (done)
+   {
+      gfx_thumbnail_job_t *last = done;
+
+      while (last->next)
+         last = last->next;
+
+      slock_lock(p_gfx_thumb->lock);
+      last->next        = p_gfx_thumb->jobs;
+      p_gfx_thumb->jobs = done;
+      slock_unlock(p_gfx_thumb->lock);
+   }
+#endif
+}
+
+/* Unloads all cached thumbnail textures
+ * > Must be called whenever the video context
+ *   is destroyed */
+void gfx_thumbnail_cache_flush(void)
+{
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+   /* Textures still in use are handed over to
+    * their thumbnails, and unloaded on reset */
+   while (p_gfx_thumb->cache_head)
+      gfx_thumbnail_cache_free_entry(p_gfx_thumb,
+            p_gfx_thumb->cache_head);
+
+   p_gfx_thumb->cache_size = 0;
+}
+
+/* Stops thumbnail worker threads and releases
+ * any outstanding decoded images
+ * > Must be called when the menu is deinitialised */
+void gfx_thumbnail_deinit(void)
+{
+#ifdef HAVE_THREADS
+   unsigned i;
+   gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
+
+   /* Save on-disk cache usage order for the
+    * next session */
+   gfx_thumbnail_disk_cache_write_index(p_gfx_thumb);
+   gfx_thumbnail_disk_cache_clear(p_gfx_thumb);
+
+   if (!p_gfx_thumb->lock)
+      return;
+
+   slock_lock(p_gfx_thumb->lock);
+   p_gfx_thumb->shutdown = true;
+   scond_broadcast(p_gfx_thumb->cond);
+   slock_unlock(p_gfx_thumb->lock);
+
+   for (i = 0; i < p_gfx_thumb->num_threads; i++)
+   {
+      sthread_join(p_gfx_thumb->threads[i]);
+      p_gfx_thumb->threads[i] = NULL;
+   }
+
+   while (p_gfx_thumb->jobs)
+   {
+      gfx_thumbnail_job_t *next = p_gfx_thumb->jobs->next;
+      gfx_thumbnail_job_free(p_gfx_thumb->jobs);
+      p_gfx_thumb->jobs = next;
+   }
+
+   scond_free(p_gfx_thumb->cond);
+   slock_free(p_gfx_thumb->lock);
+
+   p_gfx_thumb->cond        = NULL;
+   p_gfx_thumb->lock        = NULL;
+   p_gfx_thumb->num_threads = 0;
+   p_gfx_thumb->shutdown    = false;
+   p_gfx_thumb->pool_failed = false;
+#endif
 }
 
 /* Requests loading of the specified thumbnail
@@ -267,17 +1786,39 @@ void gfx_thumbnail_request(
    /* Load thumbnail, if required */
    if (has_thumbnail)
    {
-      if (path_is_valid(thumbnail_path))
+      char key[PATH_MAX_LENGTH + 64];
+
+      /* Note: key generation fails if thumbnail
+       * file does not exist */
+      if (gfx_thumbnail_get_key(thumbnail_path,
+            gfx_thumbnail_upscale_threshold, key, sizeof(key)))
       {
          gfx_thumbnail_state_t *p_gfx_thumb = gfx_thumb_get_ptr();
-         gfx_thumbnail_tag_t *thumbnail_tag =
-               (gfx_thumbnail_tag_t*)calloc(1, sizeof(gfx_thumbnail_tag_t));
+         gfx_thumbnail_tag_t *thumbnail_tag = NULL;
+
+         /* Reuse texture, if image has been
+          * displayed recently */
+         if (gfx_thumbnail_cache_acquire(key, thumbnail))
+            return;
+
+#ifdef HAVE_THREADS
+         if (gfx_thumbnail_push_job(thumbnail_path, key, thumbnail,
+               true, idx, gfx_thumbnail_upscale_threshold))
+         {
+            thumbnail->status = GFX_THUMBNAIL_STATUS_PENDING;
+            return;
+         }
+#endif
+
+         thumbnail_tag = (gfx_thumbnail_tag_t*)
+               calloc(1, sizeof(gfx_thumbnail_tag_t));
 
          if (!thumbnail_tag)
             return;
 
          /* Configure user data */
          thumbnail_tag->thumbnail = thumbnail;
+         thumbnail_tag->key       = strdup(key);
          thumbnail_tag->list_id   = p_gfx_thumb->list_id;
 
          /* Would like to cancel any existing image load tasks
@@ -365,6 +1906,18 @@ void gfx_thumbnail_request_file(
       return;
 
    /* Load thumbnail */
+#ifdef HAVE_THREADS
+   /* Not cached: images loaded via this function
+    * (e.g. savestate thumbnails) may be overwritten
+    * at any time */
+   if (gfx_thumbnail_push_job(file_path, NULL, thumbnail,
+         false, 0, gfx_thumbnail_upscale_threshold))
+   {
+      thumbnail->status = GFX_THUMBNAIL_STATUS_PENDING;
+      return;
+   }
+#endif
+
    thumbnail_tag = (gfx_thumbnail_tag_t*)calloc(1, sizeof(gfx_thumbnail_tag_t));
 
    if (!thumbnail_tag)
@@ -390,12 +1943,18 @@ void gfx_thumbnail_reset(gfx_thumbnail_t *thumbnail)
    if (!thumbnail)
       return;
 
+#ifdef HAVE_THREADS
+   /* Discard any outstanding image decode */
+   if (thumbnail->status == GFX_THUMBNAIL_STATUS_PENDING)
+      gfx_thumbnail_cancel_jobs(thumbnail);
+#endif
+
    if (thumbnail->texture)
    {
       gfx_animation_ctx_tag tag = (uintptr_t)&thumbnail->alpha;
 
-      /* Unload texture */
-      video_driver_texture_unload(&thumbnail->texture);
+      /* Unload texture (or return it to the cache) */
+      gfx_thumbnail_cache_release(thumbnail);
 
       /* Ensure any 'fade in' animation is killed */
       gfx_animation_kill_by_tag(&tag);
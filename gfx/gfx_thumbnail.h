@@ -104,6 +104,35 @@ void gfx_thumbnail_set_stream_delay(float delay);
  * > If 'duration' is negative, default value is set */
 void gfx_thumbnail_set_fade_duration(float duration);
 
+/* Sets the maximum dimensions of decoded thumbnail
+ * images; larger images are downscaled (preserving
+ * aspect ratio) before upload
+ * > If 'width' or 'height' is zero, the current video
+ *   output size is used
+ * > Only applies when thumbnails are decoded on the
+ *   worker threads (HAVE_THREADS) */
+void gfx_thumbnail_set_max_size(unsigned width, unsigned height);
+
+/* Sets the maximum size in bytes of thumbnail
+ * textures retained for reuse after they leave
+ * the screen
+ * > If 'size' is zero, textures are freed as soon
+ *   as they are no longer displayed */
+void gfx_thumbnail_set_cache_size(size_t size);
+
+/* Sets the directory in which pre-scaled copies of
+ * thumbnail images are stored
+ * > If 'dir' is NULL or empty, the on-disk cache
+ *   is disabled */
+void gfx_thumbnail_set_cache_dir(const char *dir);
+
+/* Sets the maximum total size in bytes of the
+ * on-disk thumbnail cache; least recently used
+ * files are deleted when it is exceeded
+ * > If 'size' is zero, the on-disk cache is
+ *   disabled (and emptied) */
+void gfx_thumbnail_set_disk_cache_size(size_t size);
+
 /* Getters */
 
 /* Fetches current streaming thumbnails request delay */
@@ -122,6 +151,23 @@ float gfx_thumbnail_get_fade_duration(void);
  *    heap-use-after-free errors *will* occur */
 void gfx_thumbnail_cancel_pending_requests(void);
 
+/* Uploads thumbnails decoded by the worker threads
+ * - Must be called once per frame, on the main thread
+ * - 'selection' is the currently selected menu entry;
+ *   outstanding decodes are prioritised by their
+ *   distance from this entry */
+void gfx_thumbnail_update(size_t selection);
+
+/* Unloads all cached thumbnail textures
+ * > Must be called whenever the video context
+ *   is destroyed */
+void gfx_thumbnail_cache_flush(void);
+
+/* Stops thumbnail worker threads and releases
+ * any outstanding decoded images
+ * > Must be called when the menu is deinitialised */
+void gfx_thumbnail_deinit(void);
+
 /* Requests loading of the specified thumbnail
  * - If operation fails, 'thumbnail->status' will be set to
  *   MUI_THUMBNAIL_STATUS_MISSING
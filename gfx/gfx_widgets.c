@@ -558,6 +558,10 @@ void gfx_widgets_msg_queue_push(
          msg_widget->task_finished     = task->finished;
          msg_widget->task_progress     = task->progress;
       }
+
+      /* New messages and task progress must not
+       * wait for an idle menu to be redrawn */
+      gfx_display_request_redraw();
    }
 }
 
@@ -1703,6 +1707,12 @@ void gfx_widgets_frame(void *data)
    }
 #endif
 
+   /* Messages expire (and task progress changes)
+    * while nothing else happens on screen - keep
+    * the menu redrawing while any are shown */
+   if (current_msgs->size > 0)
+      gfx_display_request_redraw();
+
    /* Draw all messages */
    for (i = 0; i < current_msgs->size; i++)
    {
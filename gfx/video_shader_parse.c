@@ -26,6 +26,7 @@
 #include <compat/msvc.h>
 #include <compat/strl.h>
 #include <file/file_path.h>
+#include <encodings/crc32.h>
 #include <rhash.h>
 #include <string/stdstring.h>
 #include <streams/file_stream.h>
@@ -45,6 +46,24 @@
 
 static path_change_data_t *file_change_data = NULL;
 
+/* Parameters found in the passes of the last shader
+ * scanned by video_shader_resolve_parameters(), so
+ * that editing one pass does not parse all the others
+ * again. 'num_parameters[i]' is the number of parameters
+ * found up to and including pass 'i'. A pass is matched
+ * on the size and CRC32 of its source as well as its
+ * path, so edited files are picked up even when shader
+ * files are not being watched for changes. */
+static struct
+{
+   char *path[GFX_MAX_SHADERS];
+   int32_t size[GFX_MAX_SHADERS];
+   uint32_t crc[GFX_MAX_SHADERS];
+   unsigned num_parameters[GFX_MAX_SHADERS];
+   unsigned passes;
+   struct video_shader_parameter parameters[GFX_MAX_PARAMETERS];
+} parameter_cache;
+
 /**
  * wrap_mode_to_str:
  * @type              : Wrap type.
@@ -466,108 +485,263 @@ bool video_shader_resolve_current_parameters(config_file_t *conf,
 }
 
 /**
- * video_shader_resolve_parameters:
- * @conf              : Preset file to read from.
+ * video_shader_parameter_cache_clear:
+ *
+ * Forgets the parameters found in earlier scans,
+ * so the next one reads every pass from disk again.
+ **/
+static void video_shader_parameter_cache_clear(void)
+{
+   unsigned i;
+
+   for (i = 0; i < parameter_cache.passes; i++)
+   {
+      free(parameter_cache.path[i]);
+      parameter_cache.path[i] = NULL;
+   }
+
+   parameter_cache.passes = 0;
+}
+
+/**
+ * video_shader_parameter_cache_key:
+ * @path              : Path of shader pass source.
+ * @size              : Size of the source, -1 if unreadable.
+ * @crc               : CRC32 of the source.
+ *
+ * Identifies the current contents of a shader pass.
+ **/
+static void video_shader_parameter_cache_key(const char *path,
+      int32_t *size, uint32_t *crc)
+{
+   void *buf    = NULL;
+   int64_t len  = 0;
+
+   *size        = -1;
+   *crc         = 0;
+
+   if (     string_is_empty(path)
+         || !path_is_valid(path)
+         || !filestream_read_file(path, &buf, &len))
+      return;
+
+   *size        = (int32_t)len;
+   *crc         = encoding_crc32(0, (const uint8_t*)buf, (size_t)len);
+
+   free(buf);
+}
+
+/**
+ * video_shader_parameter_cache_lookup:
  * @shader            : Shader passes handle.
  *
- * Resolves all shader parameters belonging to shaders.
+ * Restores the parameters of the leading passes of @shader
+ * which were scanned before, in the same order and with the
+ * same source contents, and drops the scans of any passes
+ * after the first one that differs.
  *
- * Returns: true (1) if successful, otherwise false (0).
+ * Returns: number of passes which need no scanning.
  **/
-bool video_shader_resolve_parameters(config_file_t *conf,
+static unsigned video_shader_parameter_cache_lookup(
       struct video_shader *shader)
 {
    unsigned i;
-   struct video_shader_parameter *param = &shader->parameters[0];
+   unsigned passes = 0;
 
-   shader->num_parameters = 0;
+   while (     passes < parameter_cache.passes
+            && passes < shader->passes
+            && string_is_equal(parameter_cache.path[passes],
+               shader->pass[passes].source.path))
+   {
+      int32_t size;
+      uint32_t crc;
 
-   /* Find all parameters in our shaders. */
+      video_shader_parameter_cache_key(
+            shader->pass[passes].source.path, &size, &crc);
 
-   for (i = 0; i < shader->passes; i++)
+      if (     size != parameter_cache.size[passes]
+            || crc  != parameter_cache.crc[passes])
+         break;
+
+      passes++;
+   }
+
+   /* Passes past the end of 'shader' are kept, they
+    * are still good when the pass count goes up again */
+   if (passes < shader->passes)
    {
-      const char *path          = shader->pass[i].source.path;
-      uint8_t *buf              = NULL;
-      int64_t buf_len           = 0;
-      struct string_list *lines = NULL;
-      size_t line_index         = 0;
+      for (i = passes; i < parameter_cache.passes; i++)
+      {
+         free(parameter_cache.path[i]);
+         parameter_cache.path[i] = NULL;
+      }
 
-      if (string_is_empty(path))
-         continue;
+      parameter_cache.passes = passes;
+   }
 
-      if (!path_is_valid(path))
-         continue;
+   if (passes)
+   {
+      shader->num_parameters = parameter_cache.num_parameters[passes - 1];
+      memcpy(shader->parameters, parameter_cache.parameters,
+            shader->num_parameters * sizeof(*shader->parameters));
+   }
+
+   return passes;
+}
+
+/**
+ * video_shader_parameter_cache_store:
+ * @shader            : Shader passes handle.
+ * @pass              : Pass which was just scanned.
+ *
+ * Remembers the parameters found up to and including @pass.
+ * Passes have to be stored in order.
+ **/
+static void video_shader_parameter_cache_store(
+      const struct video_shader *shader, unsigned pass)
+{
+   unsigned first = pass ? parameter_cache.num_parameters[pass - 1] : 0;
+
+   if (pass != parameter_cache.passes)
+      return;
+
+   parameter_cache.path[pass]           = strdup(
+         shader->pass[pass].source.path);
+   video_shader_parameter_cache_key(parameter_cache.path[pass],
+         &parameter_cache.size[pass], &parameter_cache.crc[pass]);
+   parameter_cache.num_parameters[pass] = shader->num_parameters;
+   memcpy(parameter_cache.parameters + first,
+         shader->parameters + first,
+         (shader->num_parameters - first) * sizeof(*shader->parameters));
+   parameter_cache.passes++;
+}
+
+/**
+ * video_shader_scan_pass_parameters:
+ * @shader            : Shader passes handle.
+ * @pass              : Pass to scan.
+ *
+ * Appends the parameters declared in the source of @pass.
+ **/
+static void video_shader_scan_pass_parameters(
+      struct video_shader *shader, unsigned pass)
+{
+   const char *path                     = shader->pass[pass].source.path;
+   uint8_t *buf                         = NULL;
+   int64_t buf_len                      = 0;
+   struct string_list *lines            = NULL;
+   size_t line_index                    = 0;
+   struct video_shader_parameter *param = NULL;
+
+   if (string_is_empty(path))
+      return;
+
+   if (!path_is_valid(path))
+      return;
 
 #if defined(HAVE_SLANG) && defined(HAVE_SPIRV_CROSS)
-      /* First try to use the more robust slang
-       * implementation to support #includes. */
-      /* FIXME: The check for slang can be removed
-       * if it's sufficiently tested for
-       * GLSL/Cg as well, it should be the same implementation. */
-      if (string_is_equal(path_get_extension(path), "slang") &&
-            slang_preprocess_parse_parameters(path, shader))
-         continue;
+   /* First try to use the more robust slang
+    * implementation to support #includes. */
+   /* FIXME: The check for slang can be removed
+    * if it's sufficiently tested for
+    * GLSL/Cg as well, it should be the same implementation. */
+   if (string_is_equal(path_get_extension(path), "slang") &&
+         slang_preprocess_parse_parameters(path, shader))
+      return;
 
-      /* If that doesn't work, fallback to the old path.
-       * Ideally, we'd get rid of this path sooner or later. */
+   /* If that doesn't work, fallback to the old path.
+    * Ideally, we'd get rid of this path sooner or later. */
 #endif
 
-      /* Read file contents */
-      if (!filestream_read_file(path, (void**)&buf, &buf_len))
-         continue;
+   /* Read file contents */
+   if (!filestream_read_file(path, (void**)&buf, &buf_len))
+      return;
 
-      /* Split into lines */
-      if (buf_len > 0)
-         lines = string_split((const char*)buf, "\n");
+   /* Split into lines */
+   if (buf_len > 0)
+      lines = string_split((const char*)buf, "\n");
 
-      /* Buffer is no longer required - clean up */
-      if ((void*)buf)
-         free((void*)buf);
+   /* Buffer is no longer required - clean up */
+   if ((void*)buf)
+      free((void*)buf);
 
-      if (!lines)
+   if (!lines)
+      return;
+
+   param = &shader->parameters[shader->num_parameters];
+
+   while ((shader->num_parameters < ARRAY_SIZE(shader->parameters)) &&
+          (line_index < lines->size))
+   {
+      int ret;
+      const char *line = lines->elems[line_index].data;
+      line_index++;
+
+      /* Check if this is a '#pragma parameter' line */
+      if (strncmp("#pragma parameter", line,
+               STRLEN_CONST("#pragma parameter")))
          continue;
 
-      /* even though the pass is set in the loop too, not all passes have parameters */
-      param->pass = i;
+      /* Parse line */
+      ret = sscanf(line, "#pragma parameter %63s \"%63[^\"]\" %f %f %f %f",
+            param->id,        param->desc,    &param->initial,
+            &param->minimum, &param->maximum, &param->step);
 
-      while ((shader->num_parameters < ARRAY_SIZE(shader->parameters)) &&
-             (line_index < lines->size))
-      {
-         int ret;
-         const char *line = lines->elems[line_index].data;
-         line_index++;
+      if (ret < 5)
+         continue;
 
-         /* Check if this is a '#pragma parameter' line */
-         if (strncmp("#pragma parameter", line,
-                  STRLEN_CONST("#pragma parameter")))
-            continue;
+      param->id[63]   = '\0';
+      param->desc[63] = '\0';
 
-         /* Parse line */
-         ret = sscanf(line, "#pragma parameter %63s \"%63[^\"]\" %f %f %f %f",
-               param->id,        param->desc,    &param->initial,
-               &param->minimum, &param->maximum, &param->step);
+      if (ret == 5)
+         param->step = 0.1f * (param->maximum - param->minimum);
 
-         if (ret < 5)
-            continue;
+      param->pass = pass;
 
-         param->id[63]   = '\0';
-         param->desc[63] = '\0';
+      RARCH_LOG("Found #pragma parameter %s (%s) %f %f %f %f in pass %d\n",
+            param->desc,    param->id,      param->initial,
+            param->minimum, param->maximum, param->step, param->pass);
+      param->current = param->initial;
 
-         if (ret == 5)
-            param->step = 0.1f * (param->maximum - param->minimum);
+      shader->num_parameters++;
+      param++;
+   }
 
-         param->pass = i;
+   string_list_free(lines);
+}
 
-         RARCH_LOG("Found #pragma parameter %s (%s) %f %f %f %f in pass %d\n",
-               param->desc,    param->id,      param->initial,
-               param->minimum, param->maximum, param->step, param->pass);
-         param->current = param->initial;
+/**
+ * video_shader_resolve_parameters:
+ * @conf              : Preset file to read from.
+ * @shader            : Shader passes handle.
+ *
+ * Resolves all shader parameters belonging to shaders.
+ *
+ * Loading a preset (@conf is set) always scans every pass.
+ * Without @conf, @shader is being edited, and only passes
+ * from the first one which changed since the last scan are
+ * parsed again.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool video_shader_resolve_parameters(config_file_t *conf,
+      struct video_shader *shader)
+{
+   unsigned i;
+   unsigned passes        = 0;
 
-         shader->num_parameters++;
-         param++;
-      }
+   shader->num_parameters = 0;
+
+   if (conf)
+      video_shader_parameter_cache_clear();
+   else
+      passes = video_shader_parameter_cache_lookup(shader);
 
-      string_list_free(lines);
+   /* Find all parameters in our shaders. */
+   for (i = passes; i < shader->passes; i++)
+   {
+      video_shader_scan_pass_parameters(shader, i);
+      video_shader_parameter_cache_store(shader, i);
    }
 
    return video_shader_resolve_current_parameters(conf, shader);
@@ -1263,10 +1437,81 @@ enum rarch_shader_type video_shader_get_type_from_ext(const char *ext,
    return RARCH_SHADER_NONE;
 }
 
+/**
+ * video_shader_is_same_chain:
+ * @a                 : Shader passes handle.
+ * @b                 : Shader passes handle.
+ *
+ * Compares everything of @a and @b that a driver builds
+ * its filter chain from: passes, their settings and
+ * textures, and the identifiers of the parameters.
+ * Parameter values are not compared.
+ *
+ * Returns: true (1) if the same chain would be built
+ * from both, otherwise false (0).
+ **/
+bool video_shader_is_same_chain(const struct video_shader *a,
+      const struct video_shader *b)
+{
+   unsigned i;
+
+   if (     a->passes         != b->passes
+         || a->luts           != b->luts
+         || a->num_parameters != b->num_parameters
+         || a->feedback_pass  != b->feedback_pass)
+      return false;
+
+   for (i = 0; i < a->passes; i++)
+   {
+      const struct video_shader_pass *pa = &a->pass[i];
+      const struct video_shader_pass *pb = &b->pass[i];
+
+      if (     !string_is_equal(pa->source.path, pb->source.path)
+            || !string_is_equal(pa->alias, pb->alias)
+            || pa->fbo.type_x      != pb->fbo.type_x
+            || pa->fbo.type_y      != pb->fbo.type_y
+            || pa->fbo.scale_x     != pb->fbo.scale_x
+            || pa->fbo.scale_y     != pb->fbo.scale_y
+            || pa->fbo.fp_fbo      != pb->fbo.fp_fbo
+            || pa->fbo.srgb_fbo    != pb->fbo.srgb_fbo
+            || pa->fbo.valid       != pb->fbo.valid
+            || pa->fbo.abs_x       != pb->fbo.abs_x
+            || pa->fbo.abs_y       != pb->fbo.abs_y
+            || pa->wrap            != pb->wrap
+            || pa->mipmap          != pb->mipmap
+            || pa->filter          != pb->filter
+            || pa->frame_count_mod != pb->frame_count_mod
+            || pa->feedback        != pb->feedback)
+         return false;
+   }
+
+   for (i = 0; i < a->luts; i++)
+   {
+      if (     !string_is_equal(a->lut[i].id, b->lut[i].id)
+            || !string_is_equal(a->lut[i].path, b->lut[i].path)
+            || a->lut[i].wrap   != b->lut[i].wrap
+            || a->lut[i].mipmap != b->lut[i].mipmap
+            || a->lut[i].filter != b->lut[i].filter)
+         return false;
+   }
+
+   for (i = 0; i < a->num_parameters; i++)
+   {
+      if (!string_is_equal(a->parameters[i].id, b->parameters[i].id))
+         return false;
+   }
+
+   return true;
+}
+
 bool video_shader_check_for_changes(void)
 {
    if (!file_change_data)
       return false;
 
-   return frontend_driver_check_for_path_changes(file_change_data);
+   if (!frontend_driver_check_for_path_changes(file_change_data))
+      return false;
+
+   video_shader_parameter_cache_clear();
+   return true;
 }
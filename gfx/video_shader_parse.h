@@ -250,6 +250,20 @@ bool video_shader_resolve_current_parameters(config_file_t *conf,
 bool video_shader_resolve_parameters(config_file_t *conf,
       struct video_shader *shader);
 
+/**
+ * video_shader_is_same_chain:
+ * @a                 : Shader passes handle.
+ * @b                 : Shader passes handle.
+ *
+ * Checks whether @a and @b only differ in the values
+ * of their parameters.
+ *
+ * Returns: true (1) if the same chain would be built
+ * from both, otherwise false (0).
+ **/
+bool video_shader_is_same_chain(const struct video_shader *a,
+      const struct video_shader *b);
+
 enum rarch_shader_type video_shader_get_type_from_ext(const char *ext,
       bool *is_preset);
 
@@ -328,6 +328,7 @@ VIDEO SHADERS
 
 #ifdef HAVE_SLANG
 #include "../gfx/drivers_shader/glslang_util.c"
+#include "../gfx/drivers_shader/slang_fbo_plan.c"
 #endif
 
 #ifdef HAVE_CG
@@ -340,6 +341,10 @@ VIDEO SHADERS
 #include "../gfx/drivers_shader/shader_glsl.c"
 #endif
 
+#if defined(HAVE_GLSL) || defined(HAVE_OPENGL_CORE)
+#include "../gfx/drivers_shader/gl_program_cache.c"
+#endif
+
 /*============================================================
 VIDEO IMAGE
 ============================================================ */
@@ -539,6 +544,7 @@ FONTS
 
 #include "../gfx/drivers_font_renderer/bitmapfont.c"
 #include "../gfx/font_driver.c"
+#include "../gfx/font_width_cache.c"
 
 #if defined(HAVE_D3D9) && defined(HAVE_D3DX)
 #include "../gfx/drivers_font/d3d_w32_font.c"
@@ -1210,6 +1216,7 @@ NETPLAY
 #include "../network/netplay/netplay_keyboard.c"
 #include "../network/netplay/netplay_sync.c"
 #include "../network/netplay/netplay_discovery.c"
+#include "../network/netplay/netplay_udp.c"
 #include "../network/netplay/netplay_buf.c"
 #include "../network/netplay/netplay_room_parse.c"
 #include "../libretro-common/net/net_compat.c"
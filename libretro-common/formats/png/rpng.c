@@ -37,6 +37,18 @@
 
 #include "rpng_internal.h"
 
+/* SIMD line filters/pixel conversion
+ * (may be disabled by defining RPNG_NO_SIMD) */
+#if !defined(RPNG_NO_SIMD)
+#if defined(__SSE2__)
+#define RPNG_SSE2
+#include <emmintrin.h>
+#elif (defined(__ARM_NEON__) || defined(__ARM_NEON)) && !defined(DONT_WANT_ARM_OPTIMIZATIONS)
+#define RPNG_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
 enum png_ihdr_color_type
 {
    PNG_IHDR_COLOR_GRAY       = 0,
@@ -78,6 +90,7 @@ struct idat_buffer
 {
    uint8_t *data;
    size_t size;
+   size_t capacity;
 };
 
 struct png_chunk
@@ -232,11 +245,28 @@ end:
 static void png_reverse_filter_copy_line_rgb(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+#if defined(RPNG_NEON)
+   if (bpp == 1)
+   {
+      for (; i + 16 <= width; i += 16, decoded += 48)
+      {
+         uint8x16x3_t rgb = vld3q_u8(decoded);
+         uint8x16x4_t out;
+
+         out.val[0] = rgb.val[2];
+         out.val[1] = rgb.val[1];
+         out.val[2] = rgb.val[0];
+         out.val[3] = vdupq_n_u8(0xff);
+         vst4q_u8((uint8_t*)(data + i), out);
+      }
+   }
+#endif
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b;
 
@@ -253,11 +283,40 @@ static void png_reverse_filter_copy_line_rgb(uint32_t *data,
 static void png_reverse_filter_copy_line_rgba(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+   if (bpp == 1)
+   {
+#if defined(RPNG_SSE2)
+      /* RGBA -> BGRA (i.e. little endian ARGB):
+       * swap bytes 0 and 2 of each pixel */
+      const __m128i mask_ga = _mm_set1_epi32((int)0xff00ff00);
+
+      for (; i + 4 <= width; i += 4, decoded += 16)
+      {
+         __m128i px = _mm_loadu_si128((const __m128i*)decoded);
+         __m128i rb = _mm_andnot_si128(mask_ga, px);
+
+         _mm_storeu_si128((__m128i*)(data + i), _mm_or_si128(
+                  _mm_and_si128(px, mask_ga),
+                  _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16))));
+      }
+#elif defined(RPNG_NEON)
+      for (; i + 16 <= width; i += 16, decoded += 64)
+      {
+         uint8x16x4_t px = vld4q_u8(decoded);
+         uint8x16_t r    = px.val[0];
+
+         px.val[0]       = px.val[2];
+         px.val[2]       = r;
+         vst4q_u8((uint8_t*)(data + i), px);
+      }
+#endif
+   }
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b, a;
       r        = *decoded;
@@ -289,6 +348,38 @@ static void png_reverse_filter_copy_line_bw(uint32_t *data,
       return;
    }
 
+   if (depth == 8)
+   {
+      i = 0;
+#if defined(RPNG_SSE2)
+      {
+         const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+         for (; i + 16 <= width; i += 16)
+         {
+            __m128i g    = _mm_loadu_si128((const __m128i*)(decoded + i));
+            __m128i g_lo = _mm_unpacklo_epi8(g, g);
+            __m128i g_hi = _mm_unpackhi_epi8(g, g);
+
+            _mm_storeu_si128((__m128i*)(data + i + 0),
+                  _mm_or_si128(_mm_unpacklo_epi16(g_lo, g_lo), alpha));
+            _mm_storeu_si128((__m128i*)(data + i + 4),
+                  _mm_or_si128(_mm_unpackhi_epi16(g_lo, g_lo), alpha));
+            _mm_storeu_si128((__m128i*)(data + i + 8),
+                  _mm_or_si128(_mm_unpacklo_epi16(g_hi, g_hi), alpha));
+            _mm_storeu_si128((__m128i*)(data + i + 12),
+                  _mm_or_si128(_mm_unpackhi_epi16(g_hi, g_hi), alpha));
+         }
+      }
+#endif
+      for (; i < width; i++)
+      {
+         uint32_t val = decoded[i];
+         data[i]      = (val * 0x010101) | (0xffu << 24);
+      }
+      return;
+   }
+
    mul  = mul_table[depth];
    mask = (1 << depth) - 1;
    bit  = 0;
@@ -580,44 +671,315 @@ error:
    return -1;
 }
 
-static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
-      struct rpng_process *pngp, unsigned filter)
+/* Line filters
+ * > Up has no dependency between adjacent bytes,
+ *   and is processed 16 bytes at a time
+ * > Sub, Average and Paeth depend on the previous
+ *   pixel of the same line. When SIMD is available,
+ *   3 and 4 byte pixels (i.e. 8 bit RGB and RGBA,
+ *   by far the most common formats) are processed
+ *   one whole pixel at a time */
+
+#if defined(RPNG_SSE2) || defined(RPNG_NEON)
+/* Pixels are moved in/out of vector registers
+ * via a 32 bit integer (little endian byte order) */
+static INLINE uint32_t png_load_pixel(const uint8_t *p, unsigned bpp)
+{
+   if (bpp == 4)
+      return (uint32_t)p[0] | ((uint32_t)p[1] << 8)
+         | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+   return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static INLINE void png_store_pixel(uint8_t *p, uint32_t v, unsigned bpp)
+{
+   p[0] = (uint8_t)v;
+   p[1] = (uint8_t)(v >> 8);
+   p[2] = (uint8_t)(v >> 16);
+   if (bpp == 4)
+      p[3] = (uint8_t)(v >> 24);
+}
+#endif
+
+#if defined(RPNG_SSE2)
+static INLINE __m128i png_sse2_load_pixel(const uint8_t *p, unsigned bpp)
+{
+   return _mm_cvtsi32_si128((int)png_load_pixel(p, bpp));
+}
+
+static INLINE void png_sse2_store_pixel(uint8_t *p, __m128i v, unsigned bpp)
+{
+   png_store_pixel(p, (uint32_t)_mm_cvtsi128_si32(v), bpp);
+}
+
+static INLINE __m128i png_sse2_abs_epi16(__m128i v)
+{
+   return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+}
+
+static INLINE void png_reverse_filter_line_sub_sse2(uint8_t *out,
+      const uint8_t *in, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      a = _mm_add_epi8(a, png_sse2_load_pixel(in + i, bpp));
+      png_sse2_store_pixel(out + i, a, bpp);
+   }
+}
+
+static INLINE void png_reverse_filter_line_avg_sse2(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a   = _mm_setzero_si128();
+   __m128i one = _mm_set1_epi8(1);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      __m128i b   = png_sse2_load_pixel(prev + i, bpp);
+      /* _mm_avg_epu8() rounds up - PNG requires
+       * (a + b) >> 1 */
+      __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+            _mm_and_si128(_mm_xor_si128(a, b), one));
+
+      a = _mm_add_epi8(avg, png_sse2_load_pixel(in + i, bpp));
+      png_sse2_store_pixel(out + i, a, bpp);
+   }
+}
+
+static INLINE void png_reverse_filter_line_paeth_sse2(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i zero = _mm_setzero_si128();
+   __m128i a    = zero;
+   __m128i c    = zero;
+
+   /* Predictor is evaluated with 16 bit lanes:
+    *   p  = a + b - c
+    *   pa = |p - a| = |b - c|
+    *   pb = |p - b| = |a - c|
+    *   pc = |p - c| = |(b - c) + (a - c)| */
+   for (i = 0; i < pitch; i += bpp)
+   {
+      __m128i b  = _mm_unpacklo_epi8(png_sse2_load_pixel(prev + i, bpp), zero);
+      __m128i x  = _mm_unpacklo_epi8(png_sse2_load_pixel(in + i, bpp), zero);
+      __m128i pa = _mm_sub_epi16(b, c);
+      __m128i pb = _mm_sub_epi16(a, c);
+      __m128i pc = png_sse2_abs_epi16(_mm_add_epi16(pa, pb));
+      __m128i smallest;
+      __m128i use_a;
+      __m128i use_b;
+      __m128i pred;
+
+      pa       = png_sse2_abs_epi16(pa);
+      pb       = png_sse2_abs_epi16(pb);
+      smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+      use_a    = _mm_cmpeq_epi16(smallest, pa);
+      use_b    = _mm_andnot_si128(use_a, _mm_cmpeq_epi16(smallest, pb));
+
+      pred     = _mm_or_si128(_mm_and_si128(use_a, a),
+            _mm_andnot_si128(use_a, c));
+      pred     = _mm_or_si128(_mm_and_si128(use_b, b),
+            _mm_andnot_si128(use_b, pred));
+
+      /* Adding in 8 bit lanes discards the carry,
+       * leaving the upper half of each lane zero */
+      a        = _mm_add_epi8(pred, x);
+      c        = b;
+      png_sse2_store_pixel(out + i, _mm_packus_epi16(a, a), bpp);
+   }
+}
+#elif defined(RPNG_NEON)
+static INLINE uint8x8_t png_neon_load_pixel(const uint8_t *p, unsigned bpp)
+{
+   return vreinterpret_u8_u32(vdup_n_u32(png_load_pixel(p, bpp)));
+}
+
+static INLINE void png_neon_store_pixel(uint8_t *p, uint8x8_t v, unsigned bpp)
+{
+   png_store_pixel(p, vget_lane_u32(vreinterpret_u32_u8(v), 0), bpp);
+}
+
+static INLINE void png_reverse_filter_line_sub_neon(uint8_t *out,
+      const uint8_t *in, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      a = vadd_u8(a, png_neon_load_pixel(in + i, bpp));
+      png_neon_store_pixel(out + i, a, bpp);
+   }
+}
+
+static INLINE void png_reverse_filter_line_avg_neon(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      /* vhadd_u8() computes (a + b) >> 1 */
+      a = vadd_u8(vhadd_u8(a, png_neon_load_pixel(prev + i, bpp)),
+            png_neon_load_pixel(in + i, bpp));
+      png_neon_store_pixel(out + i, a, bpp);
+   }
+}
+
+static INLINE void png_reverse_filter_line_paeth_neon(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   uint8x8_t a = vdup_n_u8(0);
+   uint8x8_t c = vdup_n_u8(0);
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      uint8x8_t b    = png_neon_load_pixel(prev + i, bpp);
+      uint16x8_t pa  = vabdl_u8(b, c);
+      uint16x8_t pb  = vabdl_u8(a, c);
+      uint16x8_t pc  = vabdq_u16(vaddl_u8(a, b), vaddl_u8(c, c));
+      uint8x8_t use_a = vmovn_u16(vandq_u16(
+               vcleq_u16(pa, pb), vcleq_u16(pa, pc)));
+      uint8x8_t use_b = vmovn_u16(vcleq_u16(pb, pc));
+      uint8x8_t pred  = vbsl_u8(use_a, a, vbsl_u8(use_b, b, c));
+
+      a = vadd_u8(pred, png_neon_load_pixel(in + i, bpp));
+      c = b;
+      png_neon_store_pixel(out + i, a, bpp);
+   }
+}
+#endif
+
+static void png_reverse_filter_line_sub(uint8_t *out,
+      const uint8_t *in, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+#if defined(RPNG_SSE2)
+   if (bpp == 4)
+      png_reverse_filter_line_sub_sse2(out, in, pitch, 4);
+   else if (bpp == 3)
+      png_reverse_filter_line_sub_sse2(out, in, pitch, 3);
+   if (bpp == 3 || bpp == 4)
+      return;
+#elif defined(RPNG_NEON)
+   if (bpp == 4)
+      png_reverse_filter_line_sub_neon(out, in, pitch, 4);
+   else if (bpp == 3)
+      png_reverse_filter_line_sub_neon(out, in, pitch, 3);
+   if (bpp == 3 || bpp == 4)
+      return;
+#endif
+
+   for (i = 0; i < bpp; i++)
+      out[i] = in[i];
+   for (i = bpp; i < pitch; i++)
+      out[i] = out[i - bpp] + in[i];
+}
+
+static void png_reverse_filter_line_up(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch)
+{
+   unsigned i = 0;
+
+#if defined(RPNG_SSE2)
+   for (; i + 16 <= pitch; i += 16)
+      _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi8(
+               _mm_loadu_si128((const __m128i*)(in + i)),
+               _mm_loadu_si128((const __m128i*)(prev + i))));
+#elif defined(RPNG_NEON)
+   for (; i + 16 <= pitch; i += 16)
+      vst1q_u8(out + i, vaddq_u8(vld1q_u8(in + i), vld1q_u8(prev + i)));
+#endif
+
+   for (; i < pitch; i++)
+      out[i] = prev[i] + in[i];
+}
+
+static void png_reverse_filter_line_avg(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch, unsigned bpp)
 {
    unsigned i;
 
+#if defined(RPNG_SSE2)
+   if (bpp == 4)
+      png_reverse_filter_line_avg_sse2(out, in, prev, pitch, 4);
+   else if (bpp == 3)
+      png_reverse_filter_line_avg_sse2(out, in, prev, pitch, 3);
+   if (bpp == 3 || bpp == 4)
+      return;
+#elif defined(RPNG_NEON)
+   if (bpp == 4)
+      png_reverse_filter_line_avg_neon(out, in, prev, pitch, 4);
+   else if (bpp == 3)
+      png_reverse_filter_line_avg_neon(out, in, prev, pitch, 3);
+   if (bpp == 3 || bpp == 4)
+      return;
+#endif
+
+   for (i = 0; i < bpp; i++)
+      out[i] = (prev[i] >> 1) + in[i];
+   for (i = bpp; i < pitch; i++)
+      out[i] = ((out[i - bpp] + prev[i]) >> 1) + in[i];
+}
+
+static void png_reverse_filter_line_paeth(uint8_t *out,
+      const uint8_t *in, const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+#if defined(RPNG_SSE2)
+   if (bpp == 4)
+      png_reverse_filter_line_paeth_sse2(out, in, prev, pitch, 4);
+   else if (bpp == 3)
+      png_reverse_filter_line_paeth_sse2(out, in, prev, pitch, 3);
+   if (bpp == 3 || bpp == 4)
+      return;
+#elif defined(RPNG_NEON)
+   if (bpp == 4)
+      png_reverse_filter_line_paeth_neon(out, in, prev, pitch, 4);
+   else if (bpp == 3)
+      png_reverse_filter_line_paeth_neon(out, in, prev, pitch, 3);
+   if (bpp == 3 || bpp == 4)
+      return;
+#endif
+
+   for (i = 0; i < bpp; i++)
+      out[i] = paeth(0, prev[i], 0) + in[i];
+   for (i = bpp; i < pitch; i++)
+      out[i] = paeth(out[i - bpp], prev[i], prev[i - bpp]) + in[i];
+}
+
+static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *ihdr,
+      struct rpng_process *pngp, unsigned filter)
+{
    switch (filter)
    {
       case PNG_FILTER_NONE:
          memcpy(pngp->decoded_scanline, pngp->inflate_buf, pngp->pitch);
          break;
       case PNG_FILTER_SUB:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->decoded_scanline[i - pngp->bpp] + pngp->inflate_buf[i];
+         png_reverse_filter_line_sub(pngp->decoded_scanline,
+               pngp->inflate_buf, pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_UP:
-         for (i = 0; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = pngp->prev_scanline[i] + pngp->inflate_buf[i];
+         png_reverse_filter_line_up(pngp->decoded_scanline,
+               pngp->inflate_buf, pngp->prev_scanline, pngp->pitch);
          break;
       case PNG_FILTER_AVERAGE:
-         for (i = 0; i < pngp->bpp; i++)
-         {
-            uint8_t avg = pngp->prev_scanline[i] >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-         {
-            uint8_t avg = (pngp->decoded_scanline[i - pngp->bpp] + pngp->prev_scanline[i]) >> 1;
-            pngp->decoded_scanline[i] = avg + pngp->inflate_buf[i];
-         }
+         png_reverse_filter_line_avg(pngp->decoded_scanline,
+               pngp->inflate_buf, pngp->prev_scanline, pngp->pitch, pngp->bpp);
          break;
       case PNG_FILTER_PAETH:
-         for (i = 0; i < pngp->bpp; i++)
-            pngp->decoded_scanline[i] = paeth(0, pngp->prev_scanline[i], 0) + pngp->inflate_buf[i];
-         for (i = pngp->bpp; i < pngp->pitch; i++)
-            pngp->decoded_scanline[i] = paeth(pngp->decoded_scanline[i - pngp->bpp],
-                  pngp->prev_scanline[i], pngp->prev_scanline[i - pngp->bpp]) + pngp->inflate_buf[i];
+         png_reverse_filter_line_paeth(pngp->decoded_scanline,
+               pngp->inflate_buf, pngp->prev_scanline, pngp->pitch, pngp->bpp);
          break;
 
       default:
@@ -645,7 +1007,12 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
          break;
    }
 
-   memcpy(pngp->prev_scanline, pngp->decoded_scanline, pngp->pitch);
+   /* Decoded line becomes the previous line */
+   {
+      uint8_t *tmp           = pngp->prev_scanline;
+      pngp->prev_scanline    = pngp->decoded_scanline;
+      pngp->decoded_scanline = tmp;
+   }
 
    return IMAGE_PROCESS_NEXT;
 }
@@ -858,12 +1225,40 @@ static bool png_read_trns(uint8_t *buf, uint32_t *palette, unsigned entries)
 
 bool png_realloc_idat(const struct png_chunk *chunk, struct idat_buffer *buf)
 {
-   uint8_t *new_buffer = (uint8_t*)realloc(buf->data, buf->size + chunk->size);
+   uint8_t *new_buffer = NULL;
+   size_t new_capacity = buf->capacity;
+   size_t size         = buf->size + chunk->size;
+
+   if (size < buf->size)
+      return false;
+
+   if (size <= buf->capacity)
+      return true;
+
+   /* Encoders typically split image data into
+    * many small IDAT chunks - grow the buffer
+    * geometrically to avoid reallocating (and
+    * copying) it for every chunk */
+   if (new_capacity < 65536)
+      new_capacity = 65536;
+
+   while (new_capacity < size)
+   {
+      if (new_capacity > ((size_t)-1 >> 1))
+      {
+         new_capacity = size;
+         break;
+      }
+      new_capacity <<= 1;
+   }
+
+   new_buffer = (uint8_t*)realloc(buf->data, new_capacity);
 
    if (!new_buffer)
       return false;
 
-   buf->data  = new_buffer;
+   buf->data     = new_buffer;
+   buf->capacity = new_capacity;
    return true;
 }
 
@@ -976,7 +1371,6 @@ static bool png_parse_ihdr(uint8_t *buf,
 
 bool rpng_iterate_image(rpng_t *rpng)
 {
-   unsigned i;
    struct png_chunk chunk;
    uint8_t *buf           = (uint8_t*)rpng->buff_data;
 
@@ -992,9 +1386,10 @@ bool rpng_iterate_image(rpng_t *rpng)
       goto error;
 
 #if 0
-   for (i = 0; i < 4; i++)
    {
-      fprintf(stderr, "chunktype: %c\n", chunk.type[i]);
+      unsigned i;
+      for (i = 0; i < 4; i++)
+         fprintf(stderr, "chunktype: %c\n", chunk.type[i]);
    }
 #endif
 
@@ -1074,8 +1469,7 @@ bool rpng_iterate_image(rpng_t *rpng)
 
          buf += 8;
 
-         for (i = 0; i < chunk.size; i++)
-            rpng->idat_buf.data[i + rpng->idat_buf.size] = buf[i];
+         memcpy(rpng->idat_buf.data + rpng->idat_buf.size, buf, chunk.size);
 
          rpng->idat_buf.size += chunk.size;
 
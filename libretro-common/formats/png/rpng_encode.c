@@ -204,7 +204,8 @@ static unsigned filter_paeth(uint8_t *target,
 }
 
 bool rpng_save_image_stream(const uint8_t *data, intfstream_t* intf_s,
-      unsigned width, unsigned height, signed pitch, unsigned bpp)
+      unsigned width, unsigned height, signed pitch, unsigned bpp,
+      bool fast)
 {
    unsigned h;
    struct png_ihdr ihdr = {0};
@@ -270,13 +271,18 @@ bool rpng_save_image_stream(const uint8_t *data, intfstream_t* intf_s,
        *
        * This is probably not very optimal, but it's very
        * simple to implement.
+       *
+       * The fast mode skips the costly average and Paeth
+       * filters, sub and up already catch flat areas.
        */
       {
          unsigned none_score  = count_sad(rgba_line, width * bpp);
          unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, width, bpp);
          unsigned sub_score   = filter_sub(sub_filtered, rgba_line, width, bpp);
-         unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, width, bpp);
-         unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, width, bpp);
+         unsigned avg_score   = fast ? (unsigned)-1
+            : filter_avg(avg_filtered, rgba_line, prev_encoded, width, bpp);
+         unsigned paeth_score = fast ? (unsigned)-1
+            : filter_paeth(paeth_filtered, rgba_line, prev_encoded, width, bpp);
 
          uint8_t filter       = 0;
          unsigned min_sad     = none_score;
@@ -325,6 +331,10 @@ bool rpng_save_image_stream(const uint8_t *data, intfstream_t* intf_s,
    if (!stream)
       GOTO_END_ERROR();
 
+   /* Z_BEST_SPEED, the default is the best compression */
+   if (fast && stream_backend->define)
+      stream_backend->define(stream, "level", 1);
+
    stream_backend->set_in(
          stream,
          encode_buf,
@@ -377,14 +387,15 @@ bool rpng_save_image_argb(const char *path, const uint32_t *data,
 
    ret = rpng_save_image_stream((const uint8_t*) data, intf_s,
                                 width, height,
-                                (signed) pitch, sizeof(uint32_t));
+                                (signed) pitch, sizeof(uint32_t), false);
    intfstream_close(intf_s);
    free(intf_s);
    return ret;
 }
 
-bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
-      unsigned width, unsigned height, unsigned pitch)
+static bool rpng_save_image_bgr24_file(const char *path,
+      const uint8_t *data, unsigned width, unsigned height,
+      unsigned pitch, bool fast)
 {
    bool ret                      = false;
    intfstream_t* intf_s          = NULL;
@@ -393,12 +404,26 @@ bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
          RETRO_VFS_FILE_ACCESS_WRITE,
          RETRO_VFS_FILE_ACCESS_HINT_NONE);
    ret = rpng_save_image_stream(data, intf_s, width, height, 
-                                (signed) pitch, 3);
+                                (signed) pitch, 3, fast);
    intfstream_close(intf_s);
    free(intf_s);
    return ret;
 }
 
+bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   return rpng_save_image_bgr24_file(path, data,
+         width, height, pitch, false);
+}
+
+bool rpng_save_image_bgr24_fast(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   return rpng_save_image_bgr24_file(path, data,
+         width, height, pitch, true);
+}
+
 
 uint8_t* rpng_save_image_bgr24_string(const uint8_t *data,
       unsigned width, unsigned height, signed pitch, uint64_t* bytes)
@@ -420,7 +445,7 @@ uint8_t* rpng_save_image_bgr24_string(const uint8_t *data,
          buf_length);
 
    ret = rpng_save_image_stream((const uint8_t*)data, 
-            intf_s, width, height, pitch, 3);
+            intf_s, width, height, pitch, 3, false);
 
    *bytes = intfstream_get_ptr(intf_s);
    intfstream_rewind(intf_s);
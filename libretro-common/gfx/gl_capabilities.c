@@ -324,6 +324,14 @@ bool gl_check_capability(enum gl_capability_enum enum_idx)
 #else
          if (gl_query_extension("EXT_texture_storage"))
             return true;
+#endif
+         break;
+      case GL_CAPS_BUFFER_STORAGE:
+#ifndef HAVE_OPENGLES
+         if ((major > 4 || (major == 4 && minor >= 4)
+                  || gl_query_extension("ARB_buffer_storage"))
+               && glBufferStorage)
+            return true;
 #endif
          break;
       case GL_CAPS_NONE:
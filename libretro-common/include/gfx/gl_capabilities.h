@@ -48,7 +48,8 @@ enum gl_capability_enum
    GL_CAPS_BGRA8888,
    GL_CAPS_GLES3_SUPPORTED,
    GL_CAPS_TEX_STORAGE,
-   GL_CAPS_TEX_STORAGE_EXT
+   GL_CAPS_TEX_STORAGE_EXT,
+   GL_CAPS_BUFFER_STORAGE
 };
 
 bool gl_query_core_context_in_use(void);
@@ -68,25 +68,14 @@ bool file_list_insert(file_list_t *list,
       size_t entry_idx,
       size_t idx)
 {
-   int i;
-
    /* Expand file list if needed */
    if (list->size >= list->capacity)
       if (!file_list_reserve(list, list->capacity * 2 + 1))
          return false;
 
-   for (i = (unsigned)list->size; i > (int)idx; i--)
-   {
-      struct item_file *copy = (struct item_file*)
-         calloc(1, sizeof(struct item_file));
-
-      memcpy(copy, &list->list[i-1], sizeof(struct item_file));
-
-      memcpy(&list->list[i-1], &list->list[i], sizeof(struct item_file));
-      memcpy(&list->list[i],             copy, sizeof(struct item_file));
-
-      free(copy);
-   }
+   if (idx < list->size)
+      memmove(&list->list[idx + 1], &list->list[idx],
+            (list->size - idx) * sizeof(struct item_file));
 
    list->list[idx].path          = NULL;
    list->list[idx].label         = NULL;
@@ -0,0 +1,243 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rpng_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Decode benchmark
+ * > Decodes each PNG file given on the command line
+ *   a number of times (from memory, so that I/O is
+ *   not measured), and reports the throughput of
+ *   the inflate and line filter/pixel conversion
+ *   stages in MB/s of decoded (ARGB8888) image data
+ * > Each image is also encoded once as BGR24, the way
+ *   screenshots are saved, in the default and fast modes
+ * > Usage: rpng_bench [-n <iterations>] <png files...> */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <features/features_cpu.h>
+#include <file/file_path.h>
+#include <formats/rpng.h>
+#include <formats/image.h>
+#include <streams/file_stream.h>
+
+#define RPNG_BENCH_TMP "rpng_bench.tmp.png"
+
+struct rpng_bench_stats
+{
+   retro_time_t inflate_usec;
+   retro_time_t filter_usec;
+   uint64_t in_bytes;
+   uint64_t out_bytes;
+   unsigned images;
+
+   /* Encoder, index 1 is the fast mode */
+   retro_time_t encode_usec[2];
+   uint64_t encode_bytes[2];
+   uint64_t encode_in_bytes;
+};
+
+static void rpng_bench_encode(const uint32_t *data,
+      unsigned width, unsigned height, struct rpng_bench_stats *stats)
+{
+   unsigned i;
+   uint8_t *bgr = (uint8_t*)malloc((size_t)width * height * 3);
+
+   if (!bgr)
+      return;
+
+   for (i = 0; i < width * height; i++)
+   {
+      bgr[i * 3 + 0] = (uint8_t)(data[i] >>  0);
+      bgr[i * 3 + 1] = (uint8_t)(data[i] >>  8);
+      bgr[i * 3 + 2] = (uint8_t)(data[i] >> 16);
+   }
+
+   for (i = 0; i < 2; i++)
+   {
+      bool ok;
+      retro_time_t start = cpu_features_get_time_usec();
+
+      if (i)
+         ok = rpng_save_image_bgr24_fast(RPNG_BENCH_TMP, bgr,
+               width, height, width * 3);
+      else
+         ok = rpng_save_image_bgr24(RPNG_BENCH_TMP, bgr,
+               width, height, width * 3);
+
+      stats->encode_usec[i] += cpu_features_get_time_usec() - start;
+
+      if (ok)
+         stats->encode_bytes[i] += path_get_size(RPNG_BENCH_TMP);
+   }
+
+   filestream_delete(RPNG_BENCH_TMP);
+   stats->encode_in_bytes += (uint64_t)width * height * 3;
+   free(bgr);
+}
+
+static bool rpng_bench_decode(uint8_t *buf, size_t len,
+      bool encode, struct rpng_bench_stats *stats)
+{
+   int retval;
+   retro_time_t start;
+   uint32_t *data  = NULL;
+   unsigned width  = 0;
+   unsigned height = 0;
+   bool ret        = false;
+   rpng_t *rpng    = rpng_alloc();
+
+   if (!rpng)
+      return false;
+
+   start = cpu_features_get_time_usec();
+
+   if (!rpng_set_buf_ptr(rpng, buf, len))
+      goto end;
+
+   if (!rpng_start(rpng))
+      goto end;
+
+   while (rpng_iterate_image(rpng));
+
+   if (!rpng_is_valid(rpng))
+      goto end;
+
+   /* First two calls initialise the decoder
+    * and inflate the image data */
+   retval = rpng_process_image(rpng, (void**)&data, len, &width, &height);
+   if (retval == IMAGE_PROCESS_NEXT)
+      retval = rpng_process_image(rpng, (void**)&data, len, &width, &height);
+
+   stats->inflate_usec += cpu_features_get_time_usec() - start;
+   start                = cpu_features_get_time_usec();
+
+   while (retval == IMAGE_PROCESS_NEXT)
+      retval = rpng_process_image(rpng, (void**)&data, len, &width, &height);
+
+   stats->filter_usec  += cpu_features_get_time_usec() - start;
+
+   if (retval == IMAGE_PROCESS_ERROR || retval == IMAGE_PROCESS_ERROR_END)
+      goto end;
+
+   stats->in_bytes     += len;
+   stats->out_bytes    += (uint64_t)width * height * sizeof(uint32_t);
+   stats->images++;
+   ret                  = true;
+
+   if (encode)
+      rpng_bench_encode(data, width, height, stats);
+
+end:
+   if (data)
+      free(data);
+   rpng_free(rpng);
+   return ret;
+}
+
+static double rpng_bench_mbps(uint64_t bytes, retro_time_t usec)
+{
+   if (usec <= 0)
+      return 0.0;
+   return ((double)bytes / (1024.0 * 1024.0)) / ((double)usec / 1000000.0);
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+   struct rpng_bench_stats stats;
+   unsigned iterations = 10;
+   int first_file      = 1;
+   unsigned failed     = 0;
+
+   memset(&stats, 0, sizeof(stats));
+
+   if (argc > 3 && !strcmp(argv[1], "-n"))
+   {
+      iterations = (unsigned)strtoul(argv[2], NULL, 10);
+      first_file = 3;
+   }
+
+   if (first_file >= argc || iterations < 1)
+   {
+      fprintf(stderr, "Usage: %s [-n <iterations>] <png files...>\n", argv[0]);
+      return 1;
+   }
+
+   for (i = first_file; i < argc; i++)
+   {
+      unsigned j;
+      void *buf   = NULL;
+      int64_t len = 0;
+
+      if (!filestream_read_file(argv[i], &buf, &len) || len <= 0)
+      {
+         fprintf(stderr, "Failed to read %s.\n", argv[i]);
+         failed++;
+         continue;
+      }
+
+      for (j = 0; j < iterations; j++)
+      {
+         if (!rpng_bench_decode((uint8_t*)buf, (size_t)len,
+                  j == 0, &stats))
+         {
+            fprintf(stderr, "Failed to decode %s.\n", argv[i]);
+            failed++;
+            break;
+         }
+      }
+
+      free(buf);
+   }
+
+   if (stats.images < 1)
+      return 1;
+
+   printf("Images decoded : %u (%u failed)\n", stats.images, failed);
+   printf("Input          : %.2f MB\n",
+         (double)stats.in_bytes / (1024.0 * 1024.0));
+   printf("Output         : %.2f MB\n",
+         (double)stats.out_bytes / (1024.0 * 1024.0));
+   printf("Inflate        : %.3f s, %.1f MB/s\n",
+         (double)stats.inflate_usec / 1000000.0,
+         rpng_bench_mbps(stats.out_bytes, stats.inflate_usec));
+   printf("Unfilter       : %.3f s, %.1f MB/s\n",
+         (double)stats.filter_usec / 1000000.0,
+         rpng_bench_mbps(stats.out_bytes, stats.filter_usec));
+   printf("Total          : %.3f s, %.1f MB/s\n",
+         (double)(stats.inflate_usec + stats.filter_usec) / 1000000.0,
+         rpng_bench_mbps(stats.out_bytes,
+            stats.inflate_usec + stats.filter_usec));
+   printf("Encode         : %.3f s, %.1f MB/s, %.2f MB\n",
+         (double)stats.encode_usec[0] / 1000000.0,
+         rpng_bench_mbps(stats.encode_in_bytes, stats.encode_usec[0]),
+         (double)stats.encode_bytes[0] / (1024.0 * 1024.0));
+   printf("Encode (fast)  : %.3f s, %.1f MB/s, %.2f MB\n",
+         (double)stats.encode_usec[1] / 1000000.0,
+         rpng_bench_mbps(stats.encode_in_bytes, stats.encode_usec[1]),
+         (double)stats.encode_bytes[1] / (1024.0 * 1024.0));
+
+   return failed ? 2 : 0;
+}
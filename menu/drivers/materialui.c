@@ -5787,6 +5787,23 @@ static void materialui_layout(materialui_handle_t *mui, bool video_is_threaded)
 
    gfx_display_set_header_height(new_header_height);
 
+   /* The largest thumbnail bounding box is that of
+    * a single fullscreen thumbnail (see
+    * materialui_render_fullscreen_thumbnails()) - there
+    * is no need to decode images any larger than this */
+   {
+      int thumbnail_margin = (int)(mui->margin * 4);
+      int view_width       = (int)mui->last_width -
+            (int)mui->nav_bar_layout_width - thumbnail_margin;
+      int view_height      = (int)mui->last_height -
+            (int)mui->nav_bar_layout_height -
+            (int)new_header_height - thumbnail_margin;
+
+      gfx_thumbnail_set_max_size(
+            (view_width  > 0) ? (unsigned)view_width  : 0,
+            (view_height > 0) ? (unsigned)view_height : 0);
+   }
+
    if (mui->font_data.title.font)
    {
       gfx_display_font_free(mui->font_data.title.font);
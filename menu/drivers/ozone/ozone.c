@@ -560,6 +560,24 @@ static void ozone_set_layout(ozone_handle_t *ozone, bool is_threaded)
    ozone->dimensions.spacer_3px = (unsigned)((scale_factor * 3.0f) + 0.5f);
    ozone->dimensions.spacer_5px = (unsigned)((scale_factor * 5.0f) + 0.5f);
 
+   /* The largest thumbnail bounding box is that of
+    * a single fullscreen thumbnail (see
+    * ozone_draw_fullscreen_thumbnails()) - there is no
+    * need to decode images any larger than this */
+   {
+      int thumbnail_margin = ozone->dimensions.fullscreen_thumbnail_padding * 2;
+      int view_width       = (int)ozone->last_width - thumbnail_margin;
+      int view_height      = (int)ozone->last_height -
+            ozone->dimensions.header_height -
+            ozone->dimensions.footer_height -
+            (int)ozone->dimensions.spacer_1px -
+            thumbnail_margin;
+
+      gfx_thumbnail_set_max_size(
+            (view_width  > 0) ? (unsigned)view_width  : 0,
+            (view_height > 0) ? (unsigned)view_height : 0);
+   }
+
    /* Determine movement delta size for activating
     * pointer input (note: not a dimension as such,
     * so not included in the 'dimensions' struct) */
@@ -5118,6 +5118,18 @@ static void xmb_layout(xmb_handle_t *xmb)
    else
       xmb_layout_psp(xmb, width);
 
+   /* The largest thumbnail bounding box is that of
+    * a single fullscreen thumbnail (see
+    * xmb_draw_fullscreen_thumbnails()) - there is no
+    * need to decode images any larger than this */
+   {
+      unsigned thumbnail_margin = (unsigned)(xmb->icon_size / 2.0f) * 2;
+
+      gfx_thumbnail_set_max_size(
+            (width  > thumbnail_margin) ? width  - thumbnail_margin : 0,
+            (height > thumbnail_margin) ? height - thumbnail_margin : 0);
+   }
+
 #ifdef XMB_DEBUG
    RARCH_LOG("[XMB] margin screen left: %.2f\n",  xmb->margins_screen_left);
    RARCH_LOG("[XMB] margin screen top:  %.2f\n",  xmb->margins_screen_top);
@@ -852,6 +852,7 @@ static int menu_displaylist_parse_playlist(menu_displaylist_info_t *info,
    char label_spacer[PL_LABEL_SPACER_MAXLEN];
    size_t           list_size        = playlist_size(playlist);
    settings_t       *settings        = config_get_ptr();
+   menu_handle_t    *menu            = menu_driver_get_ptr();
    bool show_inline_core_name        = false;
    const char *menu_driver           = menu_driver_ident();
    unsigned pl_show_inline_core_name = settings->uints.playlist_show_inline_core_name;
@@ -910,6 +911,17 @@ static int menu_displaylist_parse_playlist(menu_displaylist_info_t *info,
       menu_driver_set_thumbnail_system(lpl_basename, sizeof(lpl_basename));
    }
 
+   /* Record source playlist, for use when searching */
+   if (menu)
+   {
+      const char *conf_path = playlist_get_conf_path(playlist);
+
+      menu->rpl_list.size                  = list_size;
+      menu->rpl_list.show_inline_core_name = show_inline_core_name;
+      strlcpy(menu->rpl_list.path, conf_path ? conf_path : "",
+            sizeof(menu->rpl_list.path));
+   }
+
    /* Preallocate the file list */
    file_list_reserve(info->list, list_size);
 
@@ -40,6 +40,8 @@
 #include "widgets/menu_dialog.h"
 #include "widgets/menu_input_bind_dialog.h"
 
+#include "../gfx/gfx_thumbnail.h"
+
 #if defined(HAVE_CG) || defined(HAVE_GLSL) || defined(HAVE_SLANG) || defined(HAVE_HLSL)
 #include "menu_shader.h"
 #endif
@@ -55,6 +57,7 @@
 #include "../list_special.h"
 #include "../tasks/tasks_internal.h"
 #include "../verbosity.h"
+#include "../performance_counters.h"
 #include "../tasks/task_powerstate.h"
 #ifdef HAVE_NETWORKING
 #include "../core_updater_list.h"
@@ -638,6 +641,67 @@ static size_t menu_entries_begin                   = 0;
 static rarch_setting_t *menu_entries_list_settings = NULL;
 static menu_list_t *menu_entries_list              = NULL;
 
+/* Callbacks bound to the last entry added by
+ * menu_entries_append_enum(). Binding only depends on
+ * the entry label, type and enum and on the menu being
+ * built (top of the stack), so long runs of similar
+ * entries - playlist items, files of a directory - copy
+ * them instead of matching every label again.
+ * Invalidated whenever a list is cleared. */
+typedef struct menu_entries_bind_cache
+{
+   bool valid;
+   unsigned type;
+   enum msg_hash_enums enum_idx;
+   enum msg_hash_enums menu_enum_idx;
+   const file_list_t *list;
+   const menu_ctx_driver_t *driver;
+   char label[256];
+   char menu_label[256];
+   menu_file_list_cbs_t cbs;
+} menu_entries_bind_cache_t;
+
+static menu_entries_bind_cache_t menu_entries_bind_cache;
+
+/* Sublabels whose callback reported them as constant.
+ * Entries are hashed on list and position, and each one
+ * holds a copy sized to its string instead of the fixed
+ * buffer that used to live in every menu_file_list_cbs_t.
+ * Nodes are only created for entries that have been
+ * looked up, so lists of any length cache every row a
+ * menu driver measures during layout. A node is only
+ * reused when callbacks and entry strings still match. */
+#define MENU_SUBLABEL_CACHE_MIN_BUCKETS 64
+
+typedef struct menu_sublabel_cache_node
+{
+   const file_list_t *list;
+   const menu_file_list_cbs_t *cbs;
+   struct menu_sublabel_cache_node *next;
+   char *sublabel;
+   size_t idx;
+   uint32_t hash;
+} menu_sublabel_cache_node_t;
+
+typedef struct menu_sublabel_cache
+{
+   menu_sublabel_cache_node_t **buckets;
+   size_t num_buckets; /* Always a power of two */
+   size_t count;
+} menu_sublabel_cache_t;
+
+/* Title of the menu on top of the stack, when its callback
+ * reported it as constant */
+typedef struct menu_title_cache
+{
+   const menu_file_list_cbs_t *cbs;
+   uint32_t hash;
+   char title[512];
+} menu_title_cache_t;
+
+static menu_sublabel_cache_t menu_sublabel_cache;
+static menu_title_cache_t menu_title_cache;
+
 struct menu_list
 {
    size_t menu_stack_size;
@@ -995,6 +1059,166 @@ float menu_entry_num_max(uint32_t i)
    return (float)max;
 }
 
+static uint32_t menu_entries_hash_entry(const char *menu_label,
+      const char *path, const char *label, unsigned type)
+{
+   uint32_t hash = type;
+
+   if (!string_is_empty(menu_label))
+      hash = hash * 33 ^ msg_hash_calculate(menu_label);
+   if (!string_is_empty(path))
+      hash = hash * 33 ^ msg_hash_calculate(path);
+   if (!string_is_empty(label))
+      hash = hash * 33 ^ msg_hash_calculate(label);
+
+   return hash;
+}
+
+static size_t menu_entries_sublabel_cache_bucket(
+      const file_list_t *list, size_t idx, size_t num_buckets)
+{
+   size_t key = (size_t)((uintptr_t)list >> 4) ^ (idx * 2654435761U);
+   return (key ^ (key >> 16)) & (num_buckets - 1);
+}
+
+static menu_sublabel_cache_node_t *menu_entries_sublabel_cache_find(
+      const file_list_t *list, size_t idx)
+{
+   menu_sublabel_cache_t *cache     = &menu_sublabel_cache;
+   menu_sublabel_cache_node_t *node = NULL;
+
+   if (!cache->buckets)
+      return NULL;
+
+   node = cache->buckets[menu_entries_sublabel_cache_bucket(
+         list, idx, cache->num_buckets)];
+
+   for (; node; node = node->next)
+      if (node->list == list && node->idx == idx)
+         return node;
+
+   return NULL;
+}
+
+/* Keeps the average chain length at or below one */
+static bool menu_entries_sublabel_cache_grow(void)
+{
+   size_t i;
+   menu_sublabel_cache_t *cache         = &menu_sublabel_cache;
+   size_t num_buckets                   = cache->num_buckets
+      ? cache->num_buckets * 2 : MENU_SUBLABEL_CACHE_MIN_BUCKETS;
+   menu_sublabel_cache_node_t **buckets = (menu_sublabel_cache_node_t**)
+      calloc(num_buckets, sizeof(*buckets));
+
+   if (!buckets)
+      return false;
+
+   for (i = 0; i < cache->num_buckets; i++)
+   {
+      menu_sublabel_cache_node_t *node = cache->buckets[i];
+
+      while (node)
+      {
+         menu_sublabel_cache_node_t *next = node->next;
+         size_t bucket                    =
+            menu_entries_sublabel_cache_bucket(
+                  node->list, node->idx, num_buckets);
+
+         node->next                       = buckets[bucket];
+         buckets[bucket]                  = node;
+         node                             = next;
+      }
+   }
+
+   free(cache->buckets);
+   cache->buckets     = buckets;
+   cache->num_buckets = num_buckets;
+   return true;
+}
+
+static void menu_entries_sublabel_cache_set(const file_list_t *list,
+      const menu_file_list_cbs_t *cbs, size_t idx, uint32_t hash,
+      const char *sublabel)
+{
+   menu_sublabel_cache_t *cache     = &menu_sublabel_cache;
+   menu_sublabel_cache_node_t *node =
+      menu_entries_sublabel_cache_find(list, idx);
+   char *copy                       = strdup(sublabel);
+
+   if (!copy)
+      return;
+
+   if (!node)
+   {
+      size_t bucket;
+
+      if (cache->count >= cache->num_buckets)
+         if (!menu_entries_sublabel_cache_grow())
+         {
+            free(copy);
+            return;
+         }
+
+      if (!(node = (menu_sublabel_cache_node_t*)
+               calloc(1, sizeof(*node))))
+      {
+         free(copy);
+         return;
+      }
+
+      bucket               = menu_entries_sublabel_cache_bucket(
+            list, idx, cache->num_buckets);
+      node->list           = list;
+      node->idx            = idx;
+      node->next           = cache->buckets[bucket];
+      cache->buckets[bucket] = node;
+      cache->count++;
+   }
+   else
+      free(node->sublabel);
+
+   node->cbs      = cbs;
+   node->hash     = hash;
+   node->sublabel = copy;
+}
+
+/* Drops the cached sublabels of 'list', or of
+ * every list (releasing the table) if it is NULL */
+static void menu_entries_sublabel_cache_clear(const file_list_t *list)
+{
+   size_t i;
+   menu_sublabel_cache_t *cache = &menu_sublabel_cache;
+
+   for (i = 0; i < cache->num_buckets; i++)
+   {
+      menu_sublabel_cache_node_t **prev = &cache->buckets[i];
+
+      while (*prev)
+      {
+         menu_sublabel_cache_node_t *node = *prev;
+
+         if (list && node->list != list)
+         {
+            prev = &node->next;
+            continue;
+         }
+
+         *prev = node->next;
+         free(node->sublabel);
+         free(node);
+         cache->count--;
+      }
+   }
+
+   if (!list)
+   {
+      free(cache->buckets);
+      cache->buckets     = NULL;
+      cache->num_buckets = 0;
+      cache->count       = 0;
+   }
+}
+
 void menu_entry_get(menu_entry_t *entry, size_t stack_idx,
       size_t i, void *userdata, bool use_representation)
 {
@@ -1069,28 +1293,32 @@ void menu_entry_get(menu_entry_t *entry, size_t stack_idx,
          }
       }
 
-      if (entry->sublabel_enabled)
+      if (entry->sublabel_enabled && cbs->action_sublabel)
       {
-         if (!string_is_empty(cbs->action_sublabel_cache))
+         menu_sublabel_cache_node_t *node =
+            menu_entries_sublabel_cache_find(list, i);
+         uint32_t hash                    = menu_entries_hash_entry(
+               label, path, entry_label, entry->type);
+
+         if (     node
+               && node->cbs  == cbs
+               && node->hash == hash)
             strlcpy(entry->sublabel,
-                     cbs->action_sublabel_cache, sizeof(entry->sublabel));
-         else if (cbs->action_sublabel)
+                     node->sublabel, sizeof(entry->sublabel));
+         else
          {
             char tmp[MENU_SUBLABEL_MAX_LENGTH];
             tmp[0] = '\0';
 
+            /* If this function callback returns true,
+             * we know that the value won't change - so we
+             * can cache it instead. */
             if (cbs->action_sublabel(list,
                      entry->type, (unsigned)i,
                      label, path,
                      tmp,
                      sizeof(tmp)) > 0)
-            {
-               /* If this function callback returns true,
-                * we know that the value won't change - so we
-                * can cache it instead. */
-               strlcpy(cbs->action_sublabel_cache,
-                     tmp, sizeof(cbs->action_sublabel_cache));
-            }
+               menu_entries_sublabel_cache_set(list, cbs, i, hash, tmp);
 
             strlcpy(entry->sublabel, tmp, sizeof(entry->sublabel));
          }
@@ -1461,15 +1689,26 @@ int menu_entries_get_title(char *s, size_t len)
    if (cbs && cbs->action_get_title)
    {
       int ret;
-      if (!string_is_empty(cbs->action_title_cache))
+      uint32_t hash;
+      menu_title_cache_t *cache = &menu_title_cache;
+
+      menu_entries_get_last_stack(&path, &label, &menu_type, NULL, NULL);
+      hash = menu_entries_hash_entry(label, path, NULL, menu_type);
+
+      if (     cache->cbs  == cbs
+            && cache->hash == hash
+            && !string_is_empty(cache->title))
       {
-         strlcpy(s, cbs->action_title_cache, len);
+         strlcpy(s, cache->title, len);
          return 0;
       }
-      menu_entries_get_last_stack(&path, &label, &menu_type, NULL, NULL);
       ret = cbs->action_get_title(path, label, menu_type, s, len);
       if (ret == 1)
-         strlcpy(cbs->action_title_cache, s, sizeof(cbs->action_title_cache));
+      {
+         cache->cbs  = cbs;
+         cache->hash = hash;
+         strlcpy(cache->title, s, sizeof(cache->title));
+      }
       return ret;
    }
    return 0;
@@ -1537,6 +1776,8 @@ static void menu_entries_list_deinit(void)
    if (menu_entries_list)
       menu_list_free(menu_entries_list);
    menu_entries_list     = NULL;
+
+   menu_entries_sublabel_cache_clear(NULL);
 }
 
 static void menu_entries_settings_deinit(void)
@@ -1545,6 +1786,9 @@ static void menu_entries_settings_deinit(void)
    if (menu_entries_list_settings)
       free(menu_entries_list_settings);
    menu_entries_list_settings = NULL;
+
+   /* Cached bindings point into the settings list */
+   menu_entries_bind_cache.valid = false;
 }
 
 
@@ -1594,10 +1838,7 @@ void menu_entries_append(file_list_t *list, const char *path, const char *label,
 
    list_info.list     = list;
    list_info.path     = path;
-   list_info.fullpath = NULL;
-
-   if (!string_is_empty(menu_path))
-      list_info.fullpath = strdup(menu_path);
+   list_info.fullpath = menu_path;
 
    list_info.label       = label;
    list_info.idx         = idx;
@@ -1605,9 +1846,6 @@ void menu_entries_append(file_list_t *list, const char *path, const char *label,
 
    menu_driver_list_insert(&list_info);
 
-   if (list_info.fullpath)
-      free(list_info.fullpath);
-
    file_list_free_actiondata(list, idx);
    cbs = (menu_file_list_cbs_t*)
       calloc(1, sizeof(menu_file_list_cbs_t));
@@ -1623,6 +1861,59 @@ void menu_entries_append(file_list_t *list, const char *path, const char *label,
    menu_cbs_init(list, cbs, path, label, type, idx);
 }
 
+/* Binds the callbacks of a new entry, or copies them
+ * from the bind cache if the last entry bound had the
+ * same label, type and enum in the same menu */
+static void menu_entries_bind_cbs(file_list_t *list,
+      menu_file_list_cbs_t *cbs,
+      const char *path, const char *label,
+      enum msg_hash_enums enum_idx,
+      unsigned type, size_t idx)
+{
+   menu_entries_bind_cache_t *cache  = &menu_entries_bind_cache;
+   const char *menu_label            = NULL;
+   enum msg_hash_enums menu_enum_idx = MSG_UNKNOWN;
+
+   menu_entries_get_last_stack(NULL, &menu_label, NULL,
+         &menu_enum_idx, NULL);
+
+   if (     cache->valid
+         && (cache->list          == list)
+         && (cache->driver        == menu_driver_ctx)
+         && (cache->type          == type)
+         && (cache->enum_idx      == enum_idx)
+         && (cache->menu_enum_idx == menu_enum_idx)
+         && string_is_equal(cache->label, label)
+         && string_is_equal(cache->menu_label,
+               menu_label ? menu_label : ""))
+   {
+      memcpy(cbs, &cache->cbs, sizeof(*cbs));
+      return;
+   }
+
+   cbs->enum_idx = enum_idx;
+
+   if (   enum_idx != MENU_ENUM_LABEL_PLAYLIST_ENTRY
+       && enum_idx != MENU_ENUM_LABEL_PLAYLIST_COLLECTION_ENTRY
+       && enum_idx != MENU_ENUM_LABEL_RDB_ENTRY)
+      cbs->setting  = menu_setting_find_enum(enum_idx);
+
+   menu_cbs_init(list, cbs, path, label, type, idx);
+
+   /* Labels that do not fit are not cached */
+   cache->valid         =
+            (strlcpy(cache->label, label,
+                  sizeof(cache->label)) < sizeof(cache->label))
+         && (strlcpy(cache->menu_label, menu_label ? menu_label : "",
+                  sizeof(cache->menu_label)) < sizeof(cache->menu_label));
+   cache->list          = list;
+   cache->driver        = menu_driver_ctx;
+   cache->type          = type;
+   cache->enum_idx      = enum_idx;
+   cache->menu_enum_idx = menu_enum_idx;
+   memcpy(&cache->cbs, cbs, sizeof(*cbs));
+}
+
 bool menu_entries_append_enum(file_list_t *list, const char *path,
       const char *label,
       enum msg_hash_enums enum_idx,
@@ -1643,10 +1934,7 @@ bool menu_entries_append_enum(file_list_t *list, const char *path,
 
    idx                   = list->size - 1;
 
-   list_info.fullpath    = NULL;
-
-   if (!string_is_empty(menu_path))
-      list_info.fullpath = strdup(menu_path);
+   list_info.fullpath    = menu_path;
    list_info.list        = list;
    list_info.path        = path;
    list_info.label       = label;
@@ -1655,24 +1943,23 @@ bool menu_entries_append_enum(file_list_t *list, const char *path,
 
    menu_driver_list_insert(&list_info);
 
-   if (list_info.fullpath)
-      free(list_info.fullpath);
-
    file_list_free_actiondata(list, idx);
    cbs = (menu_file_list_cbs_t*)
       calloc(1, sizeof(menu_file_list_cbs_t));
 
    file_list_set_actiondata(list, idx, cbs);
 
-   cbs->enum_idx = enum_idx;
-
-   if (   enum_idx != MENU_ENUM_LABEL_PLAYLIST_ENTRY
-       && enum_idx != MENU_ENUM_LABEL_PLAYLIST_COLLECTION_ENTRY
-       && enum_idx != MENU_ENUM_LABEL_RDB_ENTRY)
-      cbs->setting  = menu_setting_find_enum(enum_idx);
+   if (string_is_equal(menu_ident, "null"))
+   {
+      cbs->enum_idx = enum_idx;
 
-   if (!string_is_equal(menu_ident, "null"))
-      menu_cbs_init(list, cbs, path, label, type, idx);
+      if (   enum_idx != MENU_ENUM_LABEL_PLAYLIST_ENTRY
+          && enum_idx != MENU_ENUM_LABEL_PLAYLIST_COLLECTION_ENTRY
+          && enum_idx != MENU_ENUM_LABEL_RDB_ENTRY)
+         cbs->setting  = menu_setting_find_enum(enum_idx);
+   }
+   else
+      menu_entries_bind_cbs(list, cbs, path, label, enum_idx, type, idx);
 
    return true;
 }
@@ -1695,10 +1982,7 @@ void menu_entries_prepend(file_list_t *list,
 
    idx              = 0;
 
-   list_info.fullpath    = NULL;
-
-   if (!string_is_empty(menu_path))
-      list_info.fullpath = strdup(menu_path);
+   list_info.fullpath    = menu_path;
    list_info.list        = list;
    list_info.path        = path;
    list_info.label       = label;
@@ -1707,9 +1991,6 @@ void menu_entries_prepend(file_list_t *list,
 
    menu_driver_list_insert(&list_info);
 
-   if (list_info.fullpath)
-      free(list_info.fullpath);
-
    file_list_free_actiondata(list, idx);
    cbs = (menu_file_list_cbs_t*)
       calloc(1, sizeof(menu_file_list_cbs_t));
@@ -1858,6 +2139,11 @@ bool menu_entries_ctl(enum menu_entries_ctl_state state, void *data)
                file_list_free_actiondata(list, i);
 
             file_list_clear(list);
+
+            /* Bindings may depend on state that changes
+             * between two builds of a list */
+            menu_entries_bind_cache.valid = false;
+            menu_entries_sublabel_cache_clear(list);
          }
          break;
       case MENU_ENTRIES_CTL_SHOW_BACK:
@@ -2106,6 +2392,24 @@ static bool menu_init(menu_handle_t *menu_data)
    menu_shader_manager_init();
 #endif
 
+   /* Configure thumbnail caches */
+   gfx_thumbnail_set_cache_size(
+         (size_t)settings->uints.gfx_thumbnail_cache_size * 1024 * 1024);
+   gfx_thumbnail_set_disk_cache_size(
+         (size_t)settings->uints.gfx_thumbnail_disk_cache_size * 1024 * 1024);
+
+   if (!string_is_empty(settings->paths.directory_cache))
+   {
+      char thumbnail_cache_dir[PATH_MAX_LENGTH];
+
+      fill_pathname_join(thumbnail_cache_dir,
+            settings->paths.directory_cache, "thumbnails",
+            sizeof(thumbnail_cache_dir));
+      gfx_thumbnail_set_cache_dir(thumbnail_cache_dir);
+   }
+   else
+      gfx_thumbnail_set_cache_dir(NULL);
+
    gfx_display_init();
 
    return true;
@@ -2124,7 +2428,13 @@ void menu_driver_frame(video_frame_info_t *video_info)
 {
    bool menu_is_alive = video_info->menu_is_alive;
    if (menu_is_alive && menu_driver_ctx->frame)
+   {
+      retro_time_t span_start = perf_span_begin();
       menu_driver_ctx->frame(menu_userdata, video_info);
+      /* Draw any quads still queued */
+      gfx_display_flush();
+      perf_span_end(PERF_SPAN_MENU_FRAME, span_start);
+   }
 }
 
 bool menu_driver_get_load_content_animation_data(uintptr_t *icon, char **playlist_name)
@@ -2691,9 +3001,14 @@ bool menu_driver_ctl(enum rarch_menu_ctl_state state, void *data)
          if (menu_driver_ctx && menu_driver_ctx->context_destroy)
             menu_driver_ctx->context_destroy(menu_userdata);
 
+         /* Cached thumbnail textures belong to
+          * the old video context */
+         gfx_thumbnail_cache_flush();
+
          if (menu_driver_data_own)
             return true;
 
+         gfx_thumbnail_deinit();
          playlist_free_cached();
 #if defined(HAVE_CG) || defined(HAVE_GLSL) || defined(HAVE_SLANG) || defined(HAVE_HLSL)
          menu_shader_manager_free();
@@ -319,6 +319,17 @@ typedef struct
    {
       unsigned                unsigned_var;
    } scratchpad;
+
+   /* Records the playlist from which the most recent
+    * list of FILE_TYPE_RPL_ENTRY entries was generated,
+    * so that searches can be performed on the playlist
+    * itself rather than on the menu entry labels */
+   struct
+   {
+      size_t size;
+      bool show_inline_core_name;
+      char path[PATH_MAX_LENGTH];
+   } rpl_list;
    const menu_ctx_driver_t *driver_ctx;
    void *userdata;
 } menu_handle_t;
@@ -63,7 +63,7 @@ typedef struct menu_ctx_list
 {
    enum menu_list_type type;
    const char *path;
-   char       *fullpath;
+   const char *fullpath;
    const char *label;
    unsigned entry_type;
    unsigned action;
@@ -77,9 +77,6 @@ typedef struct menu_ctx_list
 
 typedef struct menu_file_list_cbs
 {
-   char action_sublabel_cache[MENU_SUBLABEL_MAX_LENGTH];
-   char action_title_cache   [512];
-
    enum msg_hash_enums enum_idx;
 
    bool checked;
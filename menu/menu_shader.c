@@ -39,6 +39,10 @@
 
 static struct video_shader *menu_driver_shader = NULL;
 
+/* Copy of the shader as last loaded into the video driver
+ * through the shader manager, NULL if not known */
+static struct video_shader *menu_driver_shader_applied = NULL;
+
 static enum rarch_shader_type shader_types[] =
 {
    RARCH_SHADER_GLSL, RARCH_SHADER_SLANG, RARCH_SHADER_CG
@@ -58,11 +62,31 @@ struct video_shader *menu_shader_get(void)
    return NULL;
 }
 
+void menu_shader_manager_clear_applied(void)
+{
+   if (menu_driver_shader_applied)
+      free(menu_driver_shader_applied);
+   menu_driver_shader_applied = NULL;
+}
+
+static void menu_shader_manager_set_applied(
+      const struct video_shader *shader)
+{
+   if (!menu_driver_shader_applied)
+      menu_driver_shader_applied = (struct video_shader*)
+         malloc(sizeof(*menu_driver_shader_applied));
+
+   if (menu_driver_shader_applied)
+      memcpy(menu_driver_shader_applied, shader,
+            sizeof(*menu_driver_shader_applied));
+}
+
 void menu_shader_manager_free(void)
 {
    if (menu_driver_shader)
       free(menu_driver_shader);
    menu_driver_shader = NULL;
+   menu_shader_manager_clear_applied();
 }
 
 /**
@@ -126,8 +150,9 @@ bool menu_shader_manager_init(void)
          goto end;
       }
 
-      if (video_shader_read_conf_preset(conf, menu_shader))
-         video_shader_resolve_parameters(conf, menu_shader);
+      if (     video_shader_read_conf_preset(conf, menu_shader)
+            && video_shader_resolve_parameters(conf, menu_shader))
+         menu_shader_manager_set_applied(menu_shader);
 
       menu_shader->modified = false;
 
@@ -177,6 +202,14 @@ bool menu_shader_manager_set_preset(struct video_shader *shader,
       goto end;
    }
 
+   /* retroarch_apply_shader() has loaded the preset into
+    * the shader manager already, don't parse it again */
+   if (apply && shader == menu_driver_shader)
+   {
+      ret = true;
+      goto end;
+   }
+
    /* Load stored Preset into menu on success.
     * Used when a preset is directly loaded.
     * No point in updating when the Preset was
@@ -189,8 +222,12 @@ bool menu_shader_manager_set_preset(struct video_shader *shader,
 
    RARCH_LOG("Setting Menu shader: %s.\n", preset_path);
 
-   if (video_shader_read_conf_preset(conf, shader))
-      video_shader_resolve_parameters(conf, shader);
+   if (     video_shader_read_conf_preset(conf, shader)
+         && video_shader_resolve_parameters(conf, shader)
+         && shader == menu_driver_shader)
+      menu_shader_manager_set_applied(shader);
+   else
+      menu_shader_manager_clear_applied();
 
    if (conf)
       config_file_free(conf);
@@ -213,10 +250,53 @@ clear:
     *   turn lead to the menu selection pointer going out
     *   of bounds. This causes undefined behaviour/segfaults */
    menu_shader_manager_clear_num_passes(shader);
+   menu_shader_manager_clear_applied();
    command_event(CMD_EVENT_SHADER_PRESET_LOADED, NULL);
    return ret;
 }
 
+/**
+ * menu_shader_manager_apply_parameters:
+ * @shader                   : Shader handle.
+ * @preset_path              : Preset @shader was saved to.
+ *
+ * Applies @shader by updating the parameters of the running
+ * shader, if that is all which changed since it was loaded.
+ * This spares recompiling the passes and reallocating their
+ * framebuffers while parameters are being tuned.
+ *
+ * Returns: true if @shader was applied, otherwise false.
+ **/
+static bool menu_shader_manager_apply_parameters(
+      const struct video_shader *shader, const char *preset_path)
+{
+   unsigned i;
+   struct video_shader *applied = menu_driver_shader_applied;
+
+   if (!applied || !video_shader_is_same_chain(shader, applied))
+      return false;
+
+   /* Applying without any change reloads the shader,
+    * to pick up edits of its source files */
+   for (i = 0; i < shader->num_parameters; i++)
+      if (shader->parameters[i].current != applied->parameters[i].current)
+         break;
+
+   if (i == shader->num_parameters)
+      return false;
+
+   if (!retroarch_apply_shader_parameters(shader, preset_path))
+      return false;
+
+   for (i = 0; i < shader->num_parameters; i++)
+      applied->parameters[i].current = shader->parameters[i].current;
+
+   if (shader == menu_driver_shader)
+      menu_driver_shader->modified = false;
+
+   return true;
+}
+
 static bool menu_shader_manager_save_preset_internal(
       const struct video_shader *shader, const char *basename,
       const char *dir_video_shader,
@@ -321,7 +401,8 @@ static bool menu_shader_manager_save_preset_internal(
                " and/or config directory are writable.\n");
    }
 
-   if (ret && apply)
+   if (     ret && apply
+         && !menu_shader_manager_apply_parameters(shader, preset_path))
       menu_shader_manager_set_preset(NULL, type, preset_path, true);
 
    return ret;
@@ -35,6 +35,14 @@ struct video_shader *menu_shader_get(void);
 
 void menu_shader_manager_free(void);
 
+/**
+ * menu_shader_manager_clear_applied:
+ *
+ * Forgets which shader the video driver was given, so
+ * that applying changes rebuilds it from disk.
+ **/
+void menu_shader_manager_clear_applied(void);
+
 /**
  * menu_shader_manager_init:
  *
@@ -51,6 +51,13 @@ static size_t buf_remaining(struct socket_buffer *sbuf)
    return sbuf->bufsz - buf_used(sbuf) - 1;
 }
 
+static size_t buf_read(struct socket_buffer *sbuf)
+{
+   if (sbuf->read < sbuf->start)
+      return sbuf->bufsz - sbuf->start + sbuf->read;
+   return sbuf->read - sbuf->start;
+}
+
 /**
  * netplay_init_socket_buffer
  *
@@ -63,6 +70,7 @@ bool netplay_init_socket_buffer(struct socket_buffer *sbuf, size_t size)
       return false;
    sbuf->bufsz = size;
    sbuf->start = sbuf->read = sbuf->end = 0;
+   sbuf->pos   = 0;
    return true;
 }
 
@@ -140,9 +148,12 @@ bool netplay_send(struct socket_buffer *sbuf, int sockfd, const void *buf,
        * we just need to do a blocking send */
       if (!socket_send_all_blocking(sockfd, buf, len, false))
          return false;
+      sbuf->pos += (uint32_t)len;
       return true;
    }
 
+   sbuf->pos += (uint32_t)len;
+
    /* Copy it into our buffer */
    if (sbuf->bufsz - sbuf->end < len)
    {
@@ -318,11 +329,13 @@ ssize_t netplay_recv(struct socket_buffer *sbuf, int sockfd, void *buf,
    /* Perhaps block for more data */
    if (block)
    {
+      sbuf->pos  += (uint32_t)buf_read(sbuf);
       sbuf->start = sbuf->read;
       if (recvd < 0 || recvd < (ssize_t) len)
       {
          if (!socket_receive_all_blocking(sockfd, (unsigned char *) buf + recvd, len - recvd))
             return -1;
+         sbuf->pos += (uint32_t)(len - recvd);
          recvd = len;
 
       }
@@ -350,5 +363,6 @@ void netplay_recv_reset(struct socket_buffer *sbuf)
  */
 void netplay_recv_flush(struct socket_buffer *sbuf)
 {
+   sbuf->pos  += (uint32_t)buf_read(sbuf);
    sbuf->start = sbuf->read;
 }
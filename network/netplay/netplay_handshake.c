@@ -24,6 +24,7 @@
 #include <string/stdstring.h>
 #include <rhash.h>
 #include <retro_timers.h>
+#include <features/features_cpu.h>
 
 #include "netplay_private.h"
 
@@ -189,6 +190,28 @@ static uint32_t simple_rand_uint32(void)
             parts[2]);
 }
 
+/* Salts and UDP tokens must not be guessable by whoever
+ * knows roughly when the host started. Take them from the
+ * system's random source, and only where there is none,
+ * from the seeded generator mixed with the current time. */
+static uint32_t netplay_random_uint32(void)
+{
+   uint32_t val = 0;
+   FILE *file   = fopen("/dev/urandom", "rb");
+
+   if (file)
+   {
+      size_t len = fread(&val, 1, sizeof(val), file);
+      fclose(file);
+      if (len == sizeof(val))
+         return val;
+   }
+
+   if (simple_rand_next == 1)
+      simple_srand((unsigned int) time(NULL));
+   return simple_rand_uint32() ^ (uint32_t)cpu_features_get_time_usec();
+}
+
 /**
  * netplay_handshake_init_send
  *
@@ -204,7 +227,8 @@ bool netplay_handshake_init_send(netplay_t *netplay,
 
    header[0] = htonl(netplay_magic);
    header[1] = htonl(netplay_platform_magic());
-   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED);
+   header[2] = htonl(NETPLAY_COMPRESSION_SUPPORTED |
+         (netplay->udp_input ? NETPLAY_FEATURE_UDP_INPUT : 0));
    header[3] = 0;
    header[4] = htonl(NETPLAY_PROTOCOL_VERSION);
    header[5] = htonl(netplay_impl_magic());
@@ -214,9 +238,7 @@ bool netplay_handshake_init_send(netplay_t *netplay,
         netplay_spectate_password[0]))
    {
       /* Demand a password */
-      if (simple_rand_next == 1)
-         simple_srand((unsigned int) time(NULL));
-      connection->salt = simple_rand_uint32();
+      connection->salt = netplay_random_uint32();
       if (connection->salt == 0)
          connection->salt = 1;
       conn_salt           = connection->salt;
@@ -367,6 +389,8 @@ bool netplay_handshake_init(netplay_t *netplay,
 
    /* Check what compression is supported */
    compression  = ntohl(header[2]);
+   connection->udp.supported = netplay->udp_input &&
+      (compression & NETPLAY_FEATURE_UDP_INPUT);
    compression &= NETPLAY_COMPRESSION_SUPPORTED;
 
    if (compression & NETPLAY_COMPRESSION_ZLIB)
@@ -674,6 +698,32 @@ static bool netplay_handshake_sync(netplay_t *netplay,
    autosave_unlock();
 #endif
 
+   /* Offer input over UDP if they can take it */
+   if (netplay->udp_fd >= 0 && connection->udp.supported &&
+       netplay_udp_set_peer(connection))
+   {
+      uint32_t token;
+
+      do
+      {
+         connection->udp.token = netplay_random_uint32();
+         for (i = 0; i < netplay->connections_size; i++)
+         {
+            struct netplay_connection *sc = &netplay->connections[i];
+            if (sc != connection && sc->active &&
+                  sc->udp.token == connection->udp.token)
+               break;
+         }
+      } while (!connection->udp.token || i < netplay->connections_size);
+
+      token = htonl(connection->udp.token);
+      if (!netplay_send_raw_cmd(netplay, connection, NETPLAY_CMD_UDP,
+               &token, sizeof(token)) ||
+          !netplay_send_flush(&connection->send_packet_buffer, connection->fd,
+               false))
+         return false;
+   }
+
    /* Now we're ready! */
    connection->mode = NETPLAY_CONNECTION_SPECTATING;
    netplay_handshake_ready(netplay, connection);
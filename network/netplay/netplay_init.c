@@ -230,6 +230,11 @@ static bool init_socket(netplay_t *netplay, void *direct_host,
    if (netplay->is_server && netplay->nat_traversal)
       netplay_init_nat_traversal(netplay);
 
+   /* Without UDP, input simply stays on TCP */
+   if (netplay->is_server && netplay->udp_input && !netplay_udp_init(netplay))
+      RARCH_WARN("[netplay] Could not open UDP port %hu, sending input over TCP.\n",
+            (unsigned short)port);
+
    return true;
 }
 
@@ -407,6 +412,7 @@ static bool netplay_init_buffers(netplay_t *netplay)
  * @check_frames         : Frequency with which to check CRCs.
  * @cb                   : Libretro callbacks.
  * @nat_traversal        : If true, attempt NAT traversal.
+ * @udp_input            : If true, offer or accept input over UDP.
  * @nick                 : Nickname of user.
  * @quirks               : Netplay quirks required for this session.
  *
@@ -417,8 +423,8 @@ static bool netplay_init_buffers(netplay_t *netplay)
  */
 netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
    bool stateless_mode, int check_frames,
-   const struct retro_callbacks *cb, bool nat_traversal, const char *nick,
-   const char *netplay_password,
+   const struct retro_callbacks *cb, bool nat_traversal, bool udp_input,
+   const char *nick, const char *netplay_password,
    const char *netplay_spectate_password,
    uint64_t quirks)
 {
@@ -427,6 +433,8 @@ netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
       return NULL;
 
    netplay->listen_fd            = -1;
+   netplay->udp_fd               = -1;
+   netplay->udp_input            = udp_input;
    netplay->tcp_port             = port;
    netplay->cbs                  = *cb;
    netplay->is_server            = (direct_host == NULL && server == NULL);
@@ -516,6 +524,8 @@ error:
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
+   netplay_udp_deinit(netplay);
+
    if (netplay->connections && netplay->connections[0].fd >= 0)
       socket_close(netplay->connections[0].fd);
 
@@ -533,9 +543,25 @@ void netplay_free(netplay_t *netplay)
 {
    size_t i;
 
+   if (netplay->stats.frames)
+   {
+      RARCH_LOG("[netplay] Session: %u frames, %u rollbacks, %u frames replayed, "
+            "%u frames stalled (%u ms).\n",
+            netplay->stats.frames, netplay->stats.rollbacks,
+            netplay->stats.replayed_frames, netplay->stats.stalled_frames,
+            (unsigned)(netplay->stats.stall_time / 1000));
+      if (netplay->stats.udp_packets_sent || netplay->stats.udp_packets_recv)
+         RARCH_LOG("[netplay] UDP: %u packets sent, %u received, "
+               "%u frames received, %u frames resent over TCP.\n",
+               netplay->stats.udp_packets_sent, netplay->stats.udp_packets_recv,
+               netplay->stats.udp_frames_recv, netplay->stats.udp_tcp_frames);
+   }
+
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
+   netplay_udp_deinit(netplay);
+
    for (i = 0; i < netplay->connections_size; i++)
    {
       struct netplay_connection *connection = &netplay->connections[i];
@@ -138,6 +138,7 @@ void netplay_hangup(netplay_t *netplay, struct netplay_connection *connection)
    connection->active = false;
    netplay_deinit_socket_buffer(&connection->send_packet_buffer);
    netplay_deinit_socket_buffer(&connection->recv_packet_buffer);
+   memset(&connection->udp, 0, sizeof(connection->udp));
 
    if (!netplay->is_server)
    {
@@ -224,22 +225,19 @@ void netplay_delayed_state_change(netplay_t *netplay)
    }
 }
 
-/* Send the specified input data */
-static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
-      struct netplay_connection *only, struct netplay_connection *except,
-      uint32_t client_num, bool slave)
+/**
+ * netplay_input_frame_data
+ *
+ * Pack a client's input for a frame into @data, in network byte order.
+ *
+ * Returns the number of words packed.
+ */
+size_t netplay_input_frame_data(netplay_t *netplay, struct delta_frame *dframe,
+      uint32_t client_num, bool slave, uint32_t *data, size_t size)
 {
-#define BUFSZ 16 /* FIXME: Arbitrary restriction */
-   uint32_t buffer[BUFSZ], devices, device;
-   size_t bufused, i;
-
-   /* Set up the basic buffer */
-   bufused = 4;
-   buffer[0] = htonl(NETPLAY_CMD_INPUT);
-   buffer[2] = htonl(dframe->frame);
-   buffer[3] = htonl(client_num);
+   uint32_t devices, device;
+   size_t used = 0, i;
 
-   /* Add the device data */
    devices = netplay->client_devices[client_num];
    for (device = 0; device < MAX_INPUT_DEVICES; device++)
    {
@@ -251,12 +249,33 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
          istate = istate->next;
       if (!istate)
          continue;
-      if (bufused + istate->size >= BUFSZ)
+      if (used + istate->size > size)
          continue; /* FIXME: More severe? */
       for (i = 0; i < istate->size; i++)
-         buffer[bufused+i] = htonl(istate->data[i]);
-      bufused += istate->size;
+         data[used+i] = htonl(istate->data[i]);
+      used += istate->size;
    }
+
+   return used;
+}
+
+/* Send the specified input data */
+static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
+      struct netplay_connection *only, struct netplay_connection *except,
+      uint32_t client_num, bool slave, bool tcp_only)
+{
+#define BUFSZ 16 /* FIXME: Arbitrary restriction */
+   uint32_t buffer[BUFSZ];
+   size_t bufused, i;
+
+   /* Set up the basic buffer */
+   buffer[0] = htonl(NETPLAY_CMD_INPUT);
+   buffer[2] = htonl(dframe->frame);
+   buffer[3] = htonl(client_num);
+
+   /* Add the device data */
+   bufused   = 4 + netplay_input_frame_data(netplay, dframe, client_num, slave,
+         buffer + 4, BUFSZ - 4 - 1);
    buffer[1] = htonl((bufused-2) * sizeof(uint32_t));
 
 #ifdef DEBUG_NETPLAY_STEPS
@@ -266,6 +285,9 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
 
    if (only)
    {
+      if (!tcp_only && !slave &&
+            netplay_udp_queue_input(netplay, only, dframe->frame, client_num))
+         return true;
       if (!netplay_send(&only->send_packet_buffer, only->fd, buffer, bufused*sizeof(uint32_t)))
       {
          netplay_hangup(netplay, only);
@@ -284,6 +306,10 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
              (connection->mode != NETPLAY_CONNECTION_PLAYING ||
               i+1 != client_num))
          {
+            if (!tcp_only && !slave &&
+                  netplay_udp_queue_input(netplay, connection,
+                     dframe->frame, client_num))
+               continue;
             if (!netplay_send(&connection->send_packet_buffer, connection->fd,
                   buffer, bufused*sizeof(uint32_t)))
                netplay_hangup(netplay, connection);
@@ -295,6 +321,116 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
 #undef BUFSZ
 }
 
+/**
+ * netplay_send_input_tcp
+ *
+ * Send a client's input for a frame to a given connection over TCP.
+ *
+ * Returns true if successful, false otherwise.
+ */
+bool netplay_send_input_tcp(netplay_t *netplay,
+   struct netplay_connection *connection, struct delta_frame *dframe,
+   uint32_t client_num)
+{
+   return send_input_frame(netplay, dframe, connection, NULL, client_num,
+         false, true);
+}
+
+/* Account for a client's input for the next frame having been read */
+static void input_frame_received(netplay_t *netplay,
+      struct netplay_connection *connection, struct delta_frame *dframe,
+      uint32_t client_num)
+{
+   dframe->have_real[client_num] = true;
+   connection->udp.ack_pending   = true;
+
+   /* Slaves may go through several packets of data in the same frame
+    * if latency is choppy, so we advance and send their data after
+    * handling all network data this frame */
+   if (connection->mode == NETPLAY_CONNECTION_PLAYING)
+   {
+      netplay->read_ptr[client_num] = NEXT_PTR(netplay->read_ptr[client_num]);
+      netplay->read_frame_count[client_num]++;
+
+      if (netplay->is_server)
+      {
+         /* Forward it on if it's past data */
+         if (dframe->frame <= netplay->self_frame_count)
+            send_input_frame(netplay, dframe, NULL, connection, client_num, false, false);
+      }
+   }
+
+   /* If this was server data, advance our server pointer too */
+   if (!netplay->is_server && client_num == 0)
+   {
+      netplay->server_ptr = netplay->read_ptr[0];
+      netplay->server_frame_count = netplay->read_frame_count[0];
+   }
+}
+
+/**
+ * netplay_recv_input_frame
+ *
+ * Take a client's input for a frame which arrived out of band (over UDP).
+ * Input which doesn't fit the current state of the connection is dropped,
+ * as the peer sends it again until acknowledged.
+ *
+ * Returns true if the input was taken.
+ */
+bool netplay_recv_input_frame(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t client_num,
+   uint32_t frame, uint32_t devices, const uint32_t *data, size_t size)
+{
+   uint32_t device;
+   struct delta_frame *dframe;
+
+   if (netplay->is_server)
+   {
+      /* Only from the client itself, and not from slaves */
+      if (connection->mode != NETPLAY_CONNECTION_PLAYING ||
+          client_num != (uint32_t)(connection - netplay->connections + 1))
+         return false;
+   }
+   else if (client_num == netplay->self_client_num &&
+         netplay->self_mode == NETPLAY_CONNECTION_PLAYING)
+      return false;
+
+   if (client_num >= MAX_CLIENTS ||
+       !(netplay->connected_players & (1<<client_num)) ||
+       devices != netplay->client_devices[client_num] ||
+       size != netplay_expected_input_size(netplay, devices))
+      return false;
+
+   /* Only the next frame will do, as on TCP */
+   if (frame != netplay->read_frame_count[client_num])
+      return false;
+
+   dframe = &netplay->buffer[netplay->read_ptr[client_num]];
+   if (!netplay_delta_frame_ready(netplay, dframe, frame))
+      return false;
+
+   for (device = 0; device < MAX_INPUT_DEVICES; device++)
+   {
+      netplay_input_state_t istate;
+      uint32_t dsize, di;
+      if (!(devices & (1<<device)))
+         continue;
+
+      dsize  = netplay_expected_input_size(netplay, 1 << device);
+      istate = netplay_input_state_for(&dframe->real_input[device],
+            client_num, dsize, false, false);
+      if (!istate)
+         return false;
+      for (di = 0; di < dsize; di++)
+         istate->data[di] = ntohl(data[di]);
+      data += dsize;
+   }
+
+   input_frame_received(netplay, connection, dframe, client_num);
+   netplay->stats.udp_frames_recv++;
+   return true;
+}
+
 /**
  * netplay_send_cur_input
  *
@@ -323,7 +459,7 @@ bool netplay_send_cur_input(netplay_t *netplay,
          {
             if (dframe->have_real[from_client])
             {
-               if (!send_input_frame(netplay, dframe, connection, NULL, from_client, false))
+               if (!send_input_frame(netplay, dframe, connection, NULL, from_client, false, false))
                   return false;
             }
          }
@@ -346,7 +482,7 @@ bool netplay_send_cur_input(netplay_t *netplay,
    {
       if (!send_input_frame(netplay, dframe, connection, NULL,
             netplay->self_client_num,
-            netplay->self_mode == NETPLAY_CONNECTION_SLAVE))
+            netplay->self_mode == NETPLAY_CONNECTION_SLAVE, false))
          return false;
    }
 
@@ -370,6 +506,15 @@ bool netplay_send_raw_cmd(netplay_t *netplay,
 {
    uint32_t cmdbuf[2];
 
+   /* Neither of these cares which input arrived first: a late NOINPUT is
+    * ignored, and a CRC is kept until its frame has been played */
+   if (cmd != NETPLAY_CMD_NOINPUT && cmd != NETPLAY_CMD_CRC)
+   {
+      netplay_udp_sync_point(netplay, connection);
+      if (!connection->active)
+         return false;
+   }
+
    cmdbuf[0] = htonl(cmd);
    cmdbuf[1] = htonl(size);
 
@@ -1055,30 +1200,7 @@ static bool netplay_get_cmd(netplay_t *netplay,
                for (di = 0; di < dsize; di++)
                   istate->data[di] = ntohl(istate->data[di]);
             }
-            dframe->have_real[client_num] = true;
-
-            /* Slaves may go through several packets of data in the same frame
-             * if latency is choppy, so we advance and send their data after
-             * handling all network data this frame */
-            if (connection->mode == NETPLAY_CONNECTION_PLAYING)
-            {
-               netplay->read_ptr[client_num] = NEXT_PTR(netplay->read_ptr[client_num]);
-               netplay->read_frame_count[client_num]++;
-
-               if (netplay->is_server)
-               {
-                  /* Forward it on if it's past data */
-                  if (dframe->frame <= netplay->self_frame_count)
-                     send_input_frame(netplay, dframe, NULL, connection, client_num, false);
-               }
-            }
-
-            /* If this was server data, advance our server pointer too */
-            if (!netplay->is_server && client_num == 0)
-            {
-               netplay->server_ptr = netplay->read_ptr[0];
-               netplay->server_frame_count = netplay->read_frame_count[0];
-            }
+            input_frame_received(netplay, connection, dframe, client_num);
 
 #ifdef DEBUG_NETPLAY_STEPS
             RARCH_LOG("[netplay] Received input from %u\n", client_num);
@@ -1316,7 +1438,7 @@ static bool netplay_get_cmd(netplay_t *netplay,
                      }
                      dframe->have_local = true;
                      dframe->have_real[client_num] = true;
-                     send_input_frame(netplay, dframe, connection, NULL, client_num, false);
+                     send_input_frame(netplay, dframe, connection, NULL, client_num, false, false);
                      if (dframe->frame == netplay->self_frame_count) break;
                      NEXT();
                   }
@@ -1798,6 +1920,34 @@ static bool netplay_get_cmd(netplay_t *netplay,
          remote_unpaused(netplay, connection);
          break;
 
+      case NETPLAY_CMD_UDP:
+         {
+            uint32_t token;
+
+            if (cmd_size != sizeof(uint32_t))
+            {
+               RARCH_ERR("NETPLAY_CMD_UDP with incorrect payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(&token, sizeof(token))
+            {
+               RARCH_ERR("Failed to receive NETPLAY_CMD_UDP payload.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            if (netplay->is_server)
+            {
+               RARCH_ERR("NETPLAY_CMD_UDP from a client.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            /* Without UDP on our side, just keep using TCP */
+            if (netplay->udp_input && connection->udp.supported)
+               netplay_udp_accept(netplay, connection, ntohl(token));
+            break;
+         }
+
       case NETPLAY_CMD_STALL:
          {
             uint32_t frames;
@@ -1874,6 +2024,9 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
    if (max_fd == 0)
       return 0;
 
+   if (netplay->udp_fd >= max_fd)
+      max_fd = netplay->udp_fd + 1;
+
    netplay->timeout_cnt = 0;
 
    do
@@ -1890,6 +2043,10 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
             netplay_hangup(netplay, connection);
       }
 
+      /* And whatever came in over UDP, which may need the commands above */
+      if (netplay->udp_fd >= 0)
+         netplay_udp_poll(netplay);
+
       if (block)
       {
          netplay_update_unread_ptr(netplay);
@@ -1905,6 +2062,10 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
             struct timeval tv = {0};
             tv.tv_usec = RETRY_MS * 1000;
 
+            /* The peer may be waiting on us in turn */
+            if (netplay->udp_fd >= 0)
+               netplay_udp_send(netplay);
+
             FD_ZERO(&fds);
             for (i = 0; i < netplay->connections_size; i++)
             {
@@ -1912,6 +2073,8 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
                if (connection->active)
                   FD_SET(connection->fd, &fds);
             }
+            if (netplay->udp_fd >= 0)
+               FD_SET(netplay->udp_fd, &fds);
 
             if (socket_select(max_fd, &fds, NULL, NULL, &tv) < 0)
                return -1;
@@ -1925,6 +2088,10 @@ int netplay_poll_net_input(netplay_t *netplay, bool block)
       }
    } while (had_input || block);
 
+   /* Answer with our own input and acknowledgements */
+   if (netplay->udp_fd >= 0)
+      netplay_udp_send(netplay);
+
    return 0;
 }
 
@@ -1988,7 +2155,7 @@ void netplay_handle_slaves(netplay_t *netplay)
          }
 
          /* Send it along */
-         send_input_frame(netplay, frame, NULL, NULL, client_num, false);
+         send_input_frame(netplay, frame, NULL, NULL, client_num, false, false);
 
          /* And mark it as "read" */
          netplay->read_ptr[client_num] = NEXT_PTR(netplay->self_ptr);
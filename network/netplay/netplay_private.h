@@ -95,6 +95,22 @@ typedef uint32_t client_bitmap_t;
 #define NETPLAY_COMPRESSION_SUPPORTED 0
 #endif
 
+/* Features, advertised alongside the compression protocols */
+#define NETPLAY_FEATURE_UDP_INPUT (1<<16)
+
+/* UDP input transport */
+#define NETPLAY_UDP_MAGIC              0x52414E55 /* RANU */
+#define NETPLAY_UDP_MAX_PACKET         1200
+/* Unacknowledged frames repeated in every packet */
+#define NETPLAY_UDP_REDUNDANCY         16
+/* Frames still unacknowledged after this long are also sent over TCP */
+#define NETPLAY_UDP_TCP_FALLBACK_FRAMES 20
+#define NETPLAY_UDP_KEEPALIVE_USEC     (100*1000)
+#define NETPLAY_UDP_TIMEOUT_USEC       (1000*1000)
+
+/* Set in a UDP packet when its sender is receiving our packets */
+#define NETPLAY_UDP_FLAG_HEARD         (1<<0)
+
 enum netplay_cmd
 {
    /* Basic commands */
@@ -175,7 +191,10 @@ enum netplay_cmd
    /* CMD_CFG streamlines sending multiple
       configurations. This acknowledges
       each one individually */
-   NETPLAY_CMD_CFG_ACK        = 0x0062
+   NETPLAY_CMD_CFG_ACK        = 0x0062,
+
+   /* Offer input over UDP, with the token identifying this connection */
+   NETPLAY_CMD_UDP            = 0x0063
 };
 
 #define NETPLAY_CMD_SYNC_BIT_PAUSED    (1U<<31)
@@ -322,6 +341,77 @@ struct socket_buffer
    size_t bufsz;
    size_t start, end;
    size_t read;
+
+   /* Bytes ever queued (send) or consumed (receive), which orders UDP input
+    * against the TCP stream */
+   uint32_t pos;
+};
+
+/* Input frames of one client, as sent to one peer over UDP */
+struct netplay_udp_stream
+{
+   /* Are this client's frames going over UDP? */
+   bool active;
+
+   /* The peer has every frame before this one */
+   uint32_t ack;
+
+   /* Every frame before this one has also been sent over TCP */
+   uint32_t tcp_frame;
+
+   /* One past the last frame queued */
+   uint32_t end;
+};
+
+/* UDP state of a connection */
+struct netplay_udp_connection
+{
+   /* Token identifying the connection in packets, 0 if UDP isn't offered */
+   uint32_t token;
+
+   /* Does the peer support UDP input? */
+   bool supported;
+
+   /* Have we heard from the peer lately, and have they heard from us? */
+   bool established;
+   bool heard;
+
+   /* Has input arrived from the peer since our last packet? */
+   bool ack_pending;
+
+   /* A control command was sent since our last packet */
+   bool sync_pending;
+
+   /* TCP stream position input sent from now on must wait for */
+   uint32_t sync_pos;
+
+   struct sockaddr_storage addr;
+   socklen_t addr_len;
+
+   /* Other end of the TCP connection. Packets from any other host are
+    * dropped, whatever token they carry. */
+   struct sockaddr_storage peer_addr;
+   socklen_t peer_addr_len;
+
+   retro_time_t last_recv, last_send;
+
+   struct netplay_udp_stream streams[MAX_CLIENTS];
+};
+
+/* Session statistics, logged when netplay ends */
+struct netplay_stats
+{
+   uint32_t frames;
+   uint32_t rollbacks;
+   uint32_t replayed_frames;
+   uint32_t stalled_frames;
+   retro_time_t stall_time;
+   retro_time_t stall_begin;
+
+   uint32_t udp_packets_sent;
+   uint32_t udp_packets_recv;
+   uint32_t udp_frames_recv;
+   uint32_t udp_tcp_frames;
 };
 
 /* Each connection gets a connection struct */
@@ -369,6 +459,9 @@ struct netplay_connection
    /* For the server: When was the last time we requested this client to stall?
     * For the client: How many frames of stall do we have left? */
    uint32_t stall_frame;
+
+   /* Input over UDP */
+   struct netplay_udp_connection udp;
 };
 
 /* Compression transcoder */
@@ -444,6 +537,12 @@ struct netplay
    /* TCP port (only set if serving) */
    uint16_t tcp_port;
 
+   /* Should we offer or accept input over UDP? */
+   bool udp_input;
+
+   /* UDP socket for input, on the TCP port if serving */
+   int udp_fd;
+
    /* NAT traversal info (if NAT traversal is used and serving) */
    bool nat_traversal, nat_traversal_task_oustanding;
    struct natt_status nat_traversal_state;
@@ -567,6 +666,8 @@ struct netplay
 
    /* Are they valid? */
    bool crcs_valid;
+
+   struct netplay_stats stats;
 };
 
 /***************************************************************
@@ -779,6 +880,7 @@ bool netplay_wait_and_init_serialization(netplay_t *netplay);
  * @check_frames         : Frequency with which to check CRCs.
  * @cb                   : Libretro callbacks.
  * @nat_traversal        : If true, attempt NAT traversal.
+ * @udp_input            : If true, offer or accept input over UDP.
  * @nick                 : Nickname of user.
  * @quirks               : Netplay quirks required for this session.
  *
@@ -789,8 +891,8 @@ bool netplay_wait_and_init_serialization(netplay_t *netplay);
  */
 netplay_t *netplay_new(void *direct_host, const char *server, uint16_t port,
    bool stateless_mode, int check_frames,
-   const struct retro_callbacks *cb, bool nat_traversal, const char *nick,
-   const char *netplay_password,
+   const struct retro_callbacks *cb, bool nat_traversal, bool udp_input,
+   const char *nick, const char *netplay_password,
    const char *netplay_spectate_password,
    uint64_t quirks);
 
@@ -831,6 +933,40 @@ void netplay_delayed_state_change(netplay_t *netplay);
 bool netplay_send_cur_input(netplay_t *netplay,
    struct netplay_connection *connection);
 
+/**
+ * netplay_input_frame_data
+ *
+ * Pack a client's input for a frame into @data, in network byte order.
+ *
+ * Returns the number of words packed.
+ */
+size_t netplay_input_frame_data(netplay_t *netplay, struct delta_frame *dframe,
+   uint32_t client_num, bool slave, uint32_t *data, size_t size);
+
+/**
+ * netplay_send_input_tcp
+ *
+ * Send a client's input for a frame to a given connection over TCP.
+ *
+ * Returns true if successful, false otherwise.
+ */
+bool netplay_send_input_tcp(netplay_t *netplay,
+   struct netplay_connection *connection, struct delta_frame *dframe,
+   uint32_t client_num);
+
+/**
+ * netplay_recv_input_frame
+ *
+ * Take a client's input for a frame which arrived out of band (over UDP).
+ * Input which doesn't fit the current state of the connection is dropped,
+ * as the peer sends it again until acknowledged.
+ *
+ * Returns true if the input was taken.
+ */
+bool netplay_recv_input_frame(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t client_num,
+   uint32_t frame, uint32_t devices, const uint32_t *data, size_t size);
+
 /**
  * netplay_send_raw_cmd
  *
@@ -912,6 +1048,84 @@ void netplay_announce_nat_traversal(netplay_t *netplay);
  */
 void netplay_init_nat_traversal(netplay_t *netplay);
 
+/***************************************************************
+ * NETPLAY-UDP.C
+ **************************************************************/
+
+/**
+ * netplay_udp_init
+ *
+ * Open the server's UDP socket, on the same port as the TCP one.
+ */
+bool netplay_udp_init(netplay_t *netplay);
+
+/**
+ * netplay_udp_deinit
+ *
+ * Close the UDP socket.
+ */
+void netplay_udp_deinit(netplay_t *netplay);
+
+/**
+ * netplay_udp_set_peer
+ *
+ * Remember the host at the other end of the TCP connection, the only one
+ * UDP packets for the connection are taken from.
+ */
+bool netplay_udp_set_peer(struct netplay_connection *connection);
+
+/**
+ * netplay_udp_accept
+ *
+ * Accept the server's offer of input over UDP.
+ */
+bool netplay_udp_accept(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t token);
+
+/**
+ * netplay_udp_queue_input
+ *
+ * Queue a client's input for a frame to go to the given connection over UDP.
+ *
+ * Returns false if it has to go over TCP instead.
+ */
+bool netplay_udp_queue_input(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t frame,
+   uint32_t client_num);
+
+/**
+ * netplay_udp_sync_point
+ *
+ * Call before sending a control command over TCP. Input queued so far is
+ * sent ahead of it over TCP, and input queued later only takes effect on the
+ * other side once the command has.
+ */
+void netplay_udp_sync_point(netplay_t *netplay,
+   struct netplay_connection *connection);
+
+/**
+ * netplay_udp_stop
+ *
+ * Send everything still unacknowledged over TCP and stop using UDP for the
+ * connection until both sides hear each other again.
+ */
+void netplay_udp_stop(netplay_t *netplay,
+   struct netplay_connection *connection);
+
+/**
+ * netplay_udp_poll
+ *
+ * Read all pending UDP packets.
+ */
+void netplay_udp_poll(netplay_t *netplay);
+
+/**
+ * netplay_udp_send
+ *
+ * Send queued input, acknowledgements and keepalives to every connection.
+ */
+void netplay_udp_send(netplay_t *netplay);
+
 /***************************************************************
  * NETPLAY-KEYBOARD.C
  **************************************************************/
@@ -788,6 +788,22 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
       return;
    }
 
+   /* Keep score of stalls while there's somebody to wait for */
+   if (stalled)
+   {
+      if (netplay->stats.stall_begin)
+         netplay->stats.stall_time += current_time - netplay->stats.stall_begin;
+      netplay->stats.stall_begin = current_time;
+      netplay->stats.stalled_frames++;
+   }
+   else
+   {
+      if (netplay->stats.stall_begin)
+         netplay->stats.stall_time += current_time - netplay->stats.stall_begin;
+      netplay->stats.stall_begin = 0;
+      netplay->stats.frames++;
+   }
+
    /* Reset if it was requested */
    if (netplay->force_reset)
    {
@@ -845,6 +861,9 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
 
       /* Replay frames. */
       netplay->is_replay = true;
+      netplay->stats.rollbacks++;
+      netplay->stats.replayed_frames +=
+         netplay->run_frame_count - netplay->replay_frame_count;
 
       /* If we have a keyboard device, we replay the previous frame's input
        * just to assert that the keydown/keyup events work if the core
@@ -0,0 +1,694 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Input over UDP.
+ *
+ * Every packet repeats the input frames the peer hasn't acknowledged yet, so
+ * a lost packet costs nothing as long as a later one arrives, and nothing
+ * waits behind it. Everything else stays on the TCP connection, which also
+ * remains the fallback: frames are sent over TCP ahead of every control
+ * command, once they go unacknowledged for too long, and for good once the
+ * peers stop hearing each other.
+ *
+ * Packet format, all 32-bit words in network byte order:
+ *    magic, token, flags, TCP position,
+ *    acknowledgement count, block count,
+ *    acknowledgements: { client number, next frame needed },
+ *    blocks: { client number, devices, first frame, frame count,
+ *              words per frame, input data } */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <boolean.h>
+
+#include "netplay_private.h"
+
+#define NETPLAY_UDP_HEADER_WORDS 6
+#define NETPLAY_UDP_BLOCK_WORDS  5
+#define NETPLAY_UDP_MAX_WORDS    (NETPLAY_UDP_MAX_PACKET / sizeof(uint32_t))
+
+/* Find a frame we've sent or forwarded which is still in the buffer */
+static struct delta_frame *netplay_udp_frame(netplay_t *netplay,
+      uint32_t frame)
+{
+   struct delta_frame *dframe;
+   uint32_t behind;
+
+   if (frame > netplay->self_frame_count)
+      return NULL;
+
+   behind = netplay->self_frame_count - frame;
+   if (behind >= netplay->buffer_size)
+      return NULL;
+
+   dframe = &netplay->buffer[(netplay->self_ptr + netplay->buffer_size - behind)
+      % netplay->buffer_size];
+   if (!dframe->used || dframe->frame != frame)
+      return NULL;
+
+   return dframe;
+}
+
+/* Send a client's frames before @until over TCP, from wherever TCP or the
+ * peer is up to. Returns false if the connection was lost. */
+static bool netplay_udp_send_tcp(netplay_t *netplay,
+      struct netplay_connection *connection, uint32_t client_num,
+      uint32_t until)
+{
+   struct netplay_udp_stream *stream = &connection->udp.streams[client_num];
+   uint32_t frame                    = stream->ack > stream->tcp_frame
+      ? stream->ack : stream->tcp_frame;
+
+   for (; frame < until; frame++)
+   {
+      struct delta_frame *dframe = netplay_udp_frame(netplay, frame);
+
+      if (!dframe)
+      {
+         /* TCP can't skip frames */
+         RARCH_ERR("[netplay] Input for frame %u is gone before reaching the peer.\n",
+               frame);
+         netplay_hangup(netplay, connection);
+         return false;
+      }
+
+      if (!netplay_send_input_tcp(netplay, connection, dframe, client_num))
+         return false;
+
+      netplay->stats.udp_tcp_frames++;
+   }
+
+   if (stream->tcp_frame < frame)
+      stream->tcp_frame = frame;
+
+   return true;
+}
+
+/**
+ * netplay_udp_init
+ *
+ * Open the server's UDP socket, on the same port as the TCP one.
+ */
+bool netplay_udp_init(netplay_t *netplay)
+{
+#ifdef HAVE_SOCKET_LEGACY
+   return false;
+#else
+   int fd;
+   struct sockaddr_storage addr;
+   socklen_t addr_len = sizeof(addr);
+
+   if (getsockname(netplay->listen_fd, (struct sockaddr*)&addr, &addr_len) < 0)
+      return false;
+
+   fd = socket(addr.ss_family, SOCK_DGRAM, 0);
+   if (fd < 0)
+      return false;
+
+#if defined(AF_INET6) && defined(IPPROTO_IPV6) && defined(IPV6_V6ONLY)
+   /* Take packets over both IPv6 and IPv4, like the TCP socket */
+   if (addr.ss_family == AF_INET6)
+   {
+      int on = 0;
+      if (setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, (const char*)&on, sizeof(on)) < 0)
+         RARCH_WARN("[netplay] Failed to take UDP input over both IPv6 and IPv4.\n");
+   }
+#endif
+
+#if defined(F_SETFD) && defined(FD_CLOEXEC)
+   fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+
+   if (bind(fd, (struct sockaddr*)&addr, addr_len) < 0 ||
+       !socket_nonblock(fd))
+   {
+      socket_close(fd);
+      return false;
+   }
+
+   netplay->udp_fd = fd;
+   return true;
+#endif
+}
+
+/**
+ * netplay_udp_deinit
+ *
+ * Close the UDP socket.
+ */
+void netplay_udp_deinit(netplay_t *netplay)
+{
+   if (netplay->udp_fd >= 0)
+      socket_close(netplay->udp_fd);
+   netplay->udp_fd = -1;
+}
+
+/**
+ * netplay_udp_set_peer
+ *
+ * Remember the host at the other end of the TCP connection, the only one
+ * UDP packets for the connection are taken from.
+ */
+bool netplay_udp_set_peer(struct netplay_connection *connection)
+{
+#ifdef HAVE_SOCKET_LEGACY
+   return false;
+#else
+   struct netplay_udp_connection *udp = &connection->udp;
+   socklen_t addr_len                 = sizeof(udp->peer_addr);
+
+   if (getpeername(connection->fd,
+            (struct sockaddr*)&udp->peer_addr, &addr_len) < 0)
+      return false;
+
+   udp->peer_addr_len = addr_len;
+   return true;
+#endif
+}
+
+/**
+ * netplay_udp_accept
+ *
+ * Accept the server's offer of input over UDP.
+ */
+bool netplay_udp_accept(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t token)
+{
+#ifdef HAVE_SOCKET_LEGACY
+   return false;
+#else
+   struct netplay_udp_connection *udp = &connection->udp;
+   socklen_t addr_len                 = 0;
+
+   /* Packets go to the address and port we're connected to */
+   if (!token || !netplay_udp_set_peer(connection))
+      return false;
+
+   memcpy(&udp->addr, &udp->peer_addr, udp->peer_addr_len);
+   addr_len = udp->peer_addr_len;
+
+   if (netplay->udp_fd < 0)
+   {
+      int fd = socket(udp->addr.ss_family, SOCK_DGRAM, 0);
+      if (fd < 0)
+         return false;
+      if (!socket_nonblock(fd))
+      {
+         socket_close(fd);
+         return false;
+      }
+      netplay->udp_fd = fd;
+   }
+
+   udp->addr_len     = addr_len;
+   udp->token        = token;
+   udp->sync_pending = true;
+
+   RARCH_LOG("[netplay] Host offers input over UDP.\n");
+   return true;
+#endif
+}
+
+/**
+ * netplay_udp_queue_input
+ *
+ * Queue a client's input for a frame to go to the given connection over UDP.
+ *
+ * Returns false if it has to go over TCP instead.
+ */
+bool netplay_udp_queue_input(netplay_t *netplay,
+   struct netplay_connection *connection, uint32_t frame,
+   uint32_t client_num)
+{
+   struct netplay_udp_stream *stream;
+
+   if (!connection->udp.established || !connection->udp.heard ||
+       client_num >= MAX_CLIENTS)
+      return false;
+
+   stream = &connection->udp.streams[client_num];
+
+   if (stream->active)
+   {
+      /* Already on its way */
+      if (frame < stream->end)
+         return true;
+
+      if (frame == stream->end)
+      {
+         stream->end++;
+         return true;
+      }
+
+      /* The client started over, finish the previous run first */
+      if (!netplay_udp_send_tcp(netplay, connection, client_num, stream->end))
+         return true;
+   }
+
+   /* Everything before this went over TCP */
+   stream->active    = true;
+   stream->ack       = frame;
+   stream->tcp_frame = frame;
+   stream->end       = frame + 1;
+   return true;
+}
+
+/**
+ * netplay_udp_sync_point
+ *
+ * Call before sending a control command over TCP. Input queued so far is
+ * sent ahead of it over TCP, and input queued later only takes effect on the
+ * other side once the command has.
+ */
+void netplay_udp_sync_point(netplay_t *netplay,
+   struct netplay_connection *connection)
+{
+   uint32_t client_num;
+
+   if (!connection->udp.token)
+      return;
+
+   for (client_num = 0; client_num < MAX_CLIENTS; client_num++)
+   {
+      struct netplay_udp_stream *stream = &connection->udp.streams[client_num];
+      if (stream->active &&
+            !netplay_udp_send_tcp(netplay, connection, client_num, stream->end))
+         return;
+   }
+
+   connection->udp.sync_pending = true;
+}
+
+/**
+ * netplay_udp_stop
+ *
+ * Send everything still unacknowledged over TCP and stop using UDP for the
+ * connection until both sides hear each other again.
+ */
+void netplay_udp_stop(netplay_t *netplay,
+   struct netplay_connection *connection)
+{
+   uint32_t client_num;
+
+   for (client_num = 0; client_num < MAX_CLIENTS; client_num++)
+   {
+      struct netplay_udp_stream *stream = &connection->udp.streams[client_num];
+      if (!stream->active)
+         continue;
+      if (!netplay_udp_send_tcp(netplay, connection, client_num, stream->end))
+         return;
+      stream->active = false;
+   }
+}
+
+#ifndef HAVE_SOCKET_LEGACY
+/* Copy the host part of an address, with IPv4 peers seen through a
+ * dual-stack socket reduced to plain IPv4. Returns its length, 0 for
+ * unknown families. */
+static size_t netplay_udp_host(const struct sockaddr_storage *addr,
+      uint8_t *host)
+{
+   if (addr->ss_family == AF_INET)
+   {
+      memcpy(host, &((const struct sockaddr_in*)addr)->sin_addr, 4);
+      return 4;
+   }
+#if defined(AF_INET6)
+   if (addr->ss_family == AF_INET6)
+   {
+      static const uint8_t v4_mapped[12] =
+         { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+      const uint8_t *bytes = (const uint8_t*)
+         &((const struct sockaddr_in6*)addr)->sin6_addr;
+
+      if (!memcmp(bytes, v4_mapped, sizeof(v4_mapped)))
+      {
+         memcpy(host, bytes + sizeof(v4_mapped), 4);
+         return 4;
+      }
+
+      memcpy(host, bytes, 16);
+      return 16;
+   }
+#endif
+   return 0;
+}
+
+/* Does a packet come from the host a connection's TCP stream goes to? Only
+ * the address is compared, the port of a NATed peer's UDP flow can differ. */
+static bool netplay_udp_same_host(const struct sockaddr_storage *a,
+      const struct sockaddr_storage *b)
+{
+   uint8_t host_a[16], host_b[16];
+   size_t len_a = netplay_udp_host(a, host_a);
+   size_t len_b = netplay_udp_host(b, host_b);
+
+   return len_a && len_a == len_b && !memcmp(host_a, host_b, len_a);
+}
+#endif
+
+/* Do the acknowledgements and input blocks a packet claims to carry all fit
+ * in it? */
+static bool netplay_udp_packet_valid(const uint32_t *packet, size_t words,
+      uint32_t acks, uint32_t blocks)
+{
+   uint32_t i;
+   size_t pos = NETPLAY_UDP_HEADER_WORDS;
+
+   if (acks > (words - pos) / 2)
+      return false;
+   pos += acks * 2;
+
+   for (i = 0; i < blocks; i++)
+   {
+      uint32_t client_num, count, size;
+
+      if (words - pos < NETPLAY_UDP_BLOCK_WORDS)
+         return false;
+
+      client_num = ntohl(packet[pos]);
+      count      = ntohl(packet[pos + 3]);
+      size       = ntohl(packet[pos + 4]);
+      pos       += NETPLAY_UDP_BLOCK_WORDS;
+
+      if (client_num >= MAX_CLIENTS || !size ||
+          count > (words - pos) / size)
+         return false;
+
+      pos += count * size;
+   }
+
+   return true;
+}
+
+static void netplay_udp_recv_packet(netplay_t *netplay,
+      const uint32_t *packet, size_t words,
+      const struct sockaddr_storage *addr, socklen_t addr_len)
+{
+   size_t i, pos;
+   uint32_t token, flags, sync_pos, acks, blocks;
+   struct netplay_connection *connection = NULL;
+   struct netplay_udp_connection *udp    = NULL;
+
+   if (words < NETPLAY_UDP_HEADER_WORDS ||
+       ntohl(packet[0]) != NETPLAY_UDP_MAGIC)
+      return;
+
+   token    = ntohl(packet[1]);
+   flags    = ntohl(packet[2]);
+   sync_pos = ntohl(packet[3]);
+   acks     = ntohl(packet[4]);
+   blocks   = ntohl(packet[5]);
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      if (  netplay->connections[i].active &&
+            netplay->connections[i].udp.token &&
+            netplay->connections[i].udp.token == token)
+      {
+         connection = &netplay->connections[i];
+         break;
+      }
+   }
+   if (!connection)
+      return;
+
+   udp = &connection->udp;
+
+   /* A guessed or replayed token must not be enough to inject input or
+    * redirect the server's packets */
+#ifndef HAVE_SOCKET_LEGACY
+   if (!netplay_udp_same_host(addr, &udp->peer_addr))
+      return;
+#endif
+   if (!netplay_udp_packet_valid(packet, words, acks, blocks))
+      return;
+
+   netplay->stats.udp_packets_recv++;
+
+   /* The server answers wherever the client's packets come from */
+   if (netplay->is_server)
+   {
+      memcpy(&udp->addr, addr, addr_len);
+      udp->addr_len = addr_len;
+   }
+
+   if (!udp->established)
+      RARCH_LOG("[netplay] Receiving input over UDP from %s.\n",
+            connection->nick[0] ? connection->nick : "host");
+   udp->established = true;
+   udp->last_recv   = cpu_features_get_time_usec();
+
+   if (udp->heard && !(flags & NETPLAY_UDP_FLAG_HEARD))
+   {
+      udp->heard = false;
+      netplay_udp_stop(netplay, connection);
+      if (!connection->active)
+         return;
+   }
+   else if (flags & NETPLAY_UDP_FLAG_HEARD)
+      udp->heard = true;
+
+   /* Acknowledgements */
+   pos = NETPLAY_UDP_HEADER_WORDS;
+   for (i = 0; i < acks; i++, pos += 2)
+   {
+      uint32_t client_num = ntohl(packet[pos]);
+      uint32_t frame      = ntohl(packet[pos + 1]);
+      struct netplay_udp_stream *stream;
+
+      if (client_num >= MAX_CLIENTS)
+         continue;
+      stream = &udp->streams[client_num];
+      if (stream->active && frame > stream->ack)
+         stream->ack = frame;
+   }
+
+   /* Input sent after a control command waits for the command, exactly as
+    * it would behind it on TCP */
+   if ((int32_t)(connection->recv_packet_buffer.pos - sync_pos) < 0)
+      return;
+
+   for (i = 0; i < blocks; i++)
+   {
+      uint32_t client_num, devices, frame, count, size, j;
+
+      client_num = ntohl(packet[pos]);
+      devices    = ntohl(packet[pos + 1]);
+      frame      = ntohl(packet[pos + 2]);
+      count      = ntohl(packet[pos + 3]);
+      size       = ntohl(packet[pos + 4]);
+      pos       += NETPLAY_UDP_BLOCK_WORDS;
+
+      for (j = 0; j < count; j++, frame++)
+      {
+         /* Already have it, from an earlier packet or over TCP */
+         if (frame < netplay->read_frame_count[client_num])
+            continue;
+
+         if (!netplay_recv_input_frame(netplay, connection, client_num,
+                  frame, devices, packet + pos + j * size, size))
+            break;
+
+         if (!connection->active)
+            return;
+      }
+
+      pos += count * size;
+   }
+}
+
+/**
+ * netplay_udp_poll
+ *
+ * Read all pending UDP packets.
+ */
+void netplay_udp_poll(netplay_t *netplay)
+{
+   uint32_t packet[NETPLAY_UDP_MAX_WORDS];
+
+   for (;;)
+   {
+      struct sockaddr_storage addr;
+      socklen_t addr_len = sizeof(addr);
+      ssize_t recvd      = recvfrom(netplay->udp_fd, (char*)packet,
+            sizeof(packet), 0, (struct sockaddr*)&addr, &addr_len);
+
+      if (recvd <= 0)
+         break;
+
+      netplay_udp_recv_packet(netplay, packet,
+            (size_t)recvd / sizeof(uint32_t), &addr, addr_len);
+   }
+}
+
+/* Repeat every unacknowledged frame of a client which fits */
+static size_t netplay_udp_pack_stream(netplay_t *netplay,
+      struct netplay_connection *connection, uint32_t client_num,
+      uint32_t *packet, size_t room)
+{
+   struct netplay_udp_stream *stream = &connection->udp.streams[client_num];
+   uint32_t devices                  = netplay->client_devices[client_num];
+   uint32_t size                     = netplay_expected_input_size(netplay,
+         devices);
+   uint32_t frame                    = stream->ack;
+   uint32_t count                    = 0;
+   uint32_t max;
+
+   if (!size || frame >= stream->end || room < NETPLAY_UDP_BLOCK_WORDS + size)
+      return 0;
+
+   max = (uint32_t)((room - NETPLAY_UDP_BLOCK_WORDS) / size);
+   if (max > NETPLAY_UDP_REDUNDANCY)
+      max = NETPLAY_UDP_REDUNDANCY;
+   if (max > stream->end - frame)
+      max = stream->end - frame;
+
+   for (; count < max; count++)
+   {
+      uint32_t *data             = packet + NETPLAY_UDP_BLOCK_WORDS
+         + count * size;
+      struct delta_frame *dframe = netplay_udp_frame(netplay, frame + count);
+
+      if (!dframe || netplay_input_frame_data(netplay, dframe, client_num,
+               false, data, size) != size)
+         break;
+   }
+
+   if (!count)
+      return 0;
+
+   packet[0] = htonl(client_num);
+   packet[1] = htonl(devices);
+   packet[2] = htonl(frame);
+   packet[3] = htonl(count);
+   packet[4] = htonl(size);
+   return NETPLAY_UDP_BLOCK_WORDS + count * size;
+}
+
+static void netplay_udp_send_packet(netplay_t *netplay,
+      struct netplay_connection *connection, retro_time_t now)
+{
+   uint32_t packet[NETPLAY_UDP_MAX_WORDS];
+   uint32_t client_num;
+   uint32_t acks                      = 0;
+   uint32_t blocks                    = 0;
+   size_t pos                         = NETPLAY_UDP_HEADER_WORDS;
+   struct netplay_udp_connection *udp = &connection->udp;
+
+   /* What we have of their input */
+   for (client_num = 0; client_num < MAX_CLIENTS; client_num++)
+   {
+      if (!(netplay->connected_players & (1<<client_num)))
+         continue;
+      if (netplay->is_server
+            ? client_num != (uint32_t)(connection - netplay->connections + 1)
+            : client_num == netplay->self_client_num)
+         continue;
+      packet[pos++] = htonl(client_num);
+      packet[pos++] = htonl(netplay->read_frame_count[client_num]);
+      acks++;
+   }
+
+   /* What they don't have of ours */
+   for (client_num = 0; client_num < MAX_CLIENTS; client_num++)
+   {
+      size_t used;
+      if (!udp->streams[client_num].active)
+         continue;
+      used = netplay_udp_pack_stream(netplay, connection, client_num,
+            packet + pos, NETPLAY_UDP_MAX_WORDS - pos);
+      if (used)
+      {
+         pos += used;
+         blocks++;
+      }
+   }
+
+   if (!blocks && !udp->ack_pending &&
+         now - udp->last_send < NETPLAY_UDP_KEEPALIVE_USEC)
+      return;
+
+   if (udp->sync_pending)
+   {
+      udp->sync_pos     = connection->send_packet_buffer.pos;
+      udp->sync_pending = false;
+   }
+
+   packet[0] = htonl(NETPLAY_UDP_MAGIC);
+   packet[1] = htonl(udp->token);
+   packet[2] = htonl(udp->established ? NETPLAY_UDP_FLAG_HEARD : 0);
+   packet[3] = htonl(udp->sync_pos);
+   packet[4] = htonl(acks);
+   packet[5] = htonl(blocks);
+
+   sendto(netplay->udp_fd, (const char*)packet, pos * sizeof(uint32_t), 0,
+         (struct sockaddr*)&udp->addr, udp->addr_len);
+
+   udp->ack_pending = false;
+   udp->last_send   = now;
+   netplay->stats.udp_packets_sent++;
+}
+
+/**
+ * netplay_udp_send
+ *
+ * Send queued input, acknowledgements and keepalives to every connection.
+ */
+void netplay_udp_send(netplay_t *netplay)
+{
+   size_t i;
+   retro_time_t now = cpu_features_get_time_usec();
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      uint32_t client_num;
+      struct netplay_connection *connection = &netplay->connections[i];
+      struct netplay_udp_connection *udp    = &connection->udp;
+
+      /* The server has to hear from the client before it knows where to
+       * send anything */
+      if (!connection->active || !udp->token || !udp->addr_len)
+         continue;
+
+      if (udp->established && now - udp->last_recv > NETPLAY_UDP_TIMEOUT_USEC)
+      {
+         RARCH_WARN("[netplay] Lost UDP contact with %s, sending input over TCP.\n",
+               connection->nick[0] ? connection->nick : "host");
+         udp->established = false;
+         udp->heard       = false;
+         netplay_udp_stop(netplay, connection);
+         if (!connection->active)
+            continue;
+      }
+
+      /* Don't leave anything to UDP for too long */
+      for (client_num = 0; client_num < MAX_CLIENTS; client_num++)
+      {
+         struct netplay_udp_stream *stream = &udp->streams[client_num];
+         if (  stream->active &&
+               stream->end > NETPLAY_UDP_TCP_FALLBACK_FRAMES &&
+               !netplay_udp_send_tcp(netplay, connection, client_num,
+                  stream->end - NETPLAY_UDP_TCP_FALLBACK_FRAMES))
+            break;
+      }
+      if (!connection->active)
+         continue;
+
+      netplay_udp_send_packet(netplay, connection, now);
+   }
+}
@@ -16,6 +16,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -25,6 +26,15 @@
 #endif
 
 #include <compat/strl.h>
+#include <streams/file_stream.h>
+
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#if defined(_MSC_VER) && defined(HAVE_THREADS)
+#include <windows.h>
+#endif
 
 #include "performance_counters.h"
 
@@ -37,6 +47,73 @@
 #define PERF_LOG_FMT "[PERF]: Avg (%s): %llu ticks, %llu runs.\n"
 #endif
 
+/* Per-thread span ring buffers. Holds about 45 seconds
+ * of spans at 60 fps on the main thread. */
+#define PERF_SPAN_RING_SIZE   16384
+#define PERF_SPAN_MAX_THREADS 8
+
+/* The ring count and each ring's span count are read
+ * without the lock by other threads. They are stored with
+ * release ordering after what they publish (the ring
+ * pointer, the span), and loaded with acquire ordering,
+ * so that on weakly ordered CPUs a reader never sees a
+ * count ahead of the data it covers. */
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+#define PERF_SPAN_LOAD_ACQUIRE(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define PERF_SPAN_STORE_RELEASE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#if defined(__GNUC__)
+#define PERF_SPAN_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER) && defined(HAVE_THREADS)
+#define PERF_SPAN_BARRIER() MemoryBarrier()
+#else
+#define PERF_SPAN_BARRIER()
+#endif
+
+static unsigned perf_span_load_acquire(volatile unsigned *p)
+{
+   unsigned v = *p;
+   PERF_SPAN_BARRIER();
+   return v;
+}
+
+#define PERF_SPAN_LOAD_ACQUIRE(p)     perf_span_load_acquire(p)
+#define PERF_SPAN_STORE_RELEASE(p, v) do { PERF_SPAN_BARRIER(); *(p) = (v); } while (0)
+#endif
+
+struct perf_span
+{
+   retro_time_t start;
+   retro_time_t duration;
+   enum perf_span_type type;
+};
+
+struct perf_span_ring
+{
+   struct perf_span spans[PERF_SPAN_RING_SIZE];
+   uintptr_t owner;
+   /* Written only by the owner, after the span */
+   volatile unsigned count;
+};
+
+static const char *perf_span_names[PERF_SPAN_LAST] = {
+   "Input poll",
+   "Core run",
+   "Audio flush",
+   "Video frame",
+   "Menu frame",
+   "Present",
+   "Sync wait"
+};
+
+static struct perf_span_ring *perf_span_rings[PERF_SPAN_MAX_THREADS];
+static volatile unsigned perf_span_num_rings;
+static retro_time_t *perf_span_scratch;
+static bool perf_spans_enable;
+#ifdef HAVE_THREADS
+static slock_t *perf_span_lock;
+#endif
+
 static struct retro_perf_counter *perf_counters_rarch[MAX_COUNTERS];
 static struct retro_perf_counter *perf_counters_libretro[MAX_COUNTERS];
 static unsigned perf_ptr_rarch;
@@ -118,6 +195,247 @@ void retro_perf_log(void)
    log_counters(perf_counters_libretro, perf_ptr_libretro);
 }
 
+const char *perf_span_name(enum perf_span_type type)
+{
+   if (type >= PERF_SPAN_LAST)
+      return "";
+   return perf_span_names[type];
+}
+
+void perf_spans_set_enable(bool enable)
+{
+#ifdef HAVE_THREADS
+   /* Created here, from the main thread, so that rings
+    * can be claimed safely from any thread later on */
+   if (enable && !perf_span_lock)
+      perf_span_lock = slock_new();
+#endif
+   perf_spans_enable = enable;
+}
+
+bool perf_spans_is_enabled(void)
+{
+   return perf_spans_enable;
+}
+
+retro_time_t perf_span_begin(void)
+{
+   if (!perf_spans_enable)
+      return 0;
+   return cpu_features_get_time_usec();
+}
+
+static struct perf_span_ring *perf_span_get_ring(void)
+{
+   unsigned i;
+   struct perf_span_ring *ring = NULL;
+#ifdef HAVE_THREADS
+   uintptr_t owner             = sthread_get_current_thread_id();
+   unsigned num_rings          = PERF_SPAN_LOAD_ACQUIRE(
+         &perf_span_num_rings);
+
+   for (i = 0; i < num_rings; i++)
+      if (perf_span_rings[i]->owner == owner)
+         return perf_span_rings[i];
+
+   if (!perf_span_lock)
+      return NULL;
+
+   slock_lock(perf_span_lock);
+   if (perf_span_num_rings < PERF_SPAN_MAX_THREADS)
+   {
+      ring = (struct perf_span_ring*)calloc(1, sizeof(*ring));
+      if (ring)
+      {
+         ring->owner                           = owner;
+         perf_span_rings[perf_span_num_rings]  = ring;
+         PERF_SPAN_STORE_RELEASE(&perf_span_num_rings,
+               perf_span_num_rings + 1);
+      }
+   }
+   slock_unlock(perf_span_lock);
+#else
+   (void)i;
+
+   if (perf_span_num_rings)
+      return perf_span_rings[0];
+
+   ring = (struct perf_span_ring*)calloc(1, sizeof(*ring));
+   if (ring)
+   {
+      perf_span_rings[0]  = ring;
+      perf_span_num_rings = 1;
+   }
+#endif
+
+   return ring;
+}
+
+void perf_span_end(enum perf_span_type type, retro_time_t start)
+{
+   struct perf_span *span      = NULL;
+   struct perf_span_ring *ring = NULL;
+
+   if (!start || !perf_spans_enable)
+      return;
+
+   ring = perf_span_get_ring();
+   if (!ring)
+      return;
+
+   span           = &ring->spans[ring->count & (PERF_SPAN_RING_SIZE - 1)];
+   span->start    = start;
+   span->duration = cpu_features_get_time_usec() - start;
+   span->type     = type;
+   PERF_SPAN_STORE_RELEASE(&ring->count, ring->count + 1);
+}
+
+static int perf_span_time_cmp(const void *a, const void *b)
+{
+   retro_time_t x = *(const retro_time_t*)a;
+   retro_time_t y = *(const retro_time_t*)b;
+   return (x > y) - (x < y);
+}
+
+bool perf_spans_get_stats(struct perf_span_stats *stats,
+      retro_time_t since)
+{
+   unsigned i, j, t;
+   bool found             = false;
+   unsigned num_rings     = PERF_SPAN_LOAD_ACQUIRE(&perf_span_num_rings);
+
+   memset(stats, 0, PERF_SPAN_LAST * sizeof(*stats));
+
+   if (!num_rings)
+      return false;
+
+   if (!perf_span_scratch)
+   {
+      perf_span_scratch = (retro_time_t*)malloc(
+            PERF_SPAN_MAX_THREADS * PERF_SPAN_RING_SIZE
+            * sizeof(*perf_span_scratch));
+      if (!perf_span_scratch)
+         return false;
+   }
+
+   for (t = 0; t < PERF_SPAN_LAST; t++)
+   {
+      unsigned n = 0;
+
+      for (i = 0; i < num_rings; i++)
+      {
+         const struct perf_span_ring *ring = perf_span_rings[i];
+         unsigned count                    =
+            PERF_SPAN_LOAD_ACQUIRE(&ring->count);
+         unsigned avail                    = count < PERF_SPAN_RING_SIZE
+            ? count : PERF_SPAN_RING_SIZE;
+
+         /* Spans are recorded in order, walk back from
+          * the newest one until @since is reached.
+          * The owner may be overwriting the oldest entry
+          * meanwhile, which at worst skews a sample. */
+         for (j = 1; j <= avail; j++)
+         {
+            const struct perf_span *span =
+               &ring->spans[(count - j) & (PERF_SPAN_RING_SIZE - 1)];
+
+            if (span->start < since)
+               break;
+            if (span->type == (enum perf_span_type)t)
+               perf_span_scratch[n++] = span->duration;
+         }
+      }
+
+      if (!n)
+         continue;
+
+      qsort(perf_span_scratch, n, sizeof(*perf_span_scratch),
+            perf_span_time_cmp);
+
+      stats[t].p50   = perf_span_scratch[(n - 1) * 50 / 100];
+      stats[t].p95   = perf_span_scratch[(n - 1) * 95 / 100];
+      stats[t].p99   = perf_span_scratch[(n - 1) * 99 / 100];
+      stats[t].count = n;
+      found          = true;
+   }
+
+   return found;
+}
+
+bool perf_spans_export(const char *path)
+{
+   unsigned i, j;
+   bool first         = true;
+   unsigned num_rings = PERF_SPAN_LOAD_ACQUIRE(&perf_span_num_rings);
+   RFILE *file        = NULL;
+
+   if (!num_rings)
+      return false;
+
+   file = filestream_open(path,
+         RETRO_VFS_FILE_ACCESS_WRITE,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
+   if (!file)
+      return false;
+
+   filestream_printf(file, "{\"traceEvents\":[\n");
+
+   for (i = 0; i < num_rings; i++)
+   {
+      const struct perf_span_ring *ring = perf_span_rings[i];
+      unsigned count                    =
+         PERF_SPAN_LOAD_ACQUIRE(&ring->count);
+      unsigned avail                    = count < PERF_SPAN_RING_SIZE
+         ? count : PERF_SPAN_RING_SIZE;
+
+      filestream_printf(file,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+            "\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+            first ? "" : ",\n", i, i ? "Thread" : "Main", i);
+      first = false;
+
+      for (j = count - avail; j != count; j++)
+      {
+         const struct perf_span *span =
+            &ring->spans[j & (PERF_SPAN_RING_SIZE - 1)];
+
+         filestream_printf(file,
+               ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+               "\"ts\":%" PRId64 ",\"dur\":%" PRId64 "}",
+               perf_span_name(span->type), i,
+               (int64_t)span->start, (int64_t)span->duration);
+      }
+   }
+
+   filestream_printf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+   filestream_close(file);
+
+   return true;
+}
+
+void perf_spans_deinit(void)
+{
+   unsigned i;
+
+   perf_spans_enable = false;
+
+   for (i = 0; i < PERF_SPAN_MAX_THREADS; i++)
+   {
+      free(perf_span_rings[i]);
+      perf_span_rings[i] = NULL;
+   }
+   perf_span_num_rings = 0;
+
+   free(perf_span_scratch);
+   perf_span_scratch   = NULL;
+
+#ifdef HAVE_THREADS
+   if (perf_span_lock)
+      slock_free(perf_span_lock);
+   perf_span_lock      = NULL;
+#endif
+}
+
 void rarch_timer_tick(rarch_timer_t *timer, retro_time_t current_time)
 {
    if (!timer)
@@ -30,6 +30,27 @@ RETRO_BEGIN_DECLS
 #define MAX_COUNTERS 64
 #endif
 
+/* Phases of a frame timed by perf_span_begin/perf_span_end */
+enum perf_span_type
+{
+   PERF_SPAN_INPUT_POLL = 0,
+   PERF_SPAN_CORE_RUN,
+   PERF_SPAN_AUDIO_FLUSH,
+   PERF_SPAN_VIDEO_FRAME,
+   PERF_SPAN_MENU_FRAME,
+   PERF_SPAN_PRESENT,
+   PERF_SPAN_SYNC_WAIT,
+   PERF_SPAN_LAST
+};
+
+struct perf_span_stats
+{
+   retro_time_t p50;
+   retro_time_t p95;
+   retro_time_t p99;
+   unsigned count;
+};
+
 typedef struct rarch_timer
 {
    int64_t current;
@@ -89,6 +110,59 @@ void rarch_perf_register(struct retro_perf_counter *perf);
  **/
 #define performance_counter_stop_plus(is_perfcnt_enable, perf) performance_counter_stop_internal(is_perfcnt_enable, perf)
 
+/**
+ * perf_span_begin:
+ *
+ * Returns: start time of a span to pass to perf_span_end,
+ * or 0 if spans are not being recorded.
+ **/
+retro_time_t perf_span_begin(void);
+
+/**
+ * perf_span_end:
+ * @type               : phase of the frame the span covers
+ * @start              : value returned by perf_span_begin
+ *
+ * Records a span in the ring buffer of the calling thread.
+ * Every thread owns its ring buffer, so recording takes
+ * no lock once a thread has recorded its first span.
+ **/
+void perf_span_end(enum perf_span_type type, retro_time_t start);
+
+void perf_spans_set_enable(bool enable);
+
+bool perf_spans_is_enabled(void);
+
+const char *perf_span_name(enum perf_span_type type);
+
+/**
+ * perf_spans_get_stats:
+ * @stats              : array of PERF_SPAN_LAST entries
+ * @since              : time of the oldest span to include,
+ *                       or 0 for all spans still held
+ *
+ * Computes the median, 95th and 99th percentile duration
+ * of each type of span.
+ *
+ * Returns: true if any span was recorded in that time.
+ **/
+bool perf_spans_get_stats(struct perf_span_stats *stats,
+      retro_time_t since);
+
+/**
+ * perf_spans_export:
+ * @path               : file to write
+ *
+ * Writes the spans held in the ring buffers as a Chrome
+ * trace event file, which can be loaded in about:tracing
+ * or the Perfetto UI.
+ *
+ * Returns: true on success.
+ **/
+bool perf_spans_export(const char *path);
+
+void perf_spans_deinit(void);
+
 void rarch_timer_tick(rarch_timer_t *timer, retro_time_t current_time);
 
 bool rarch_timer_is_running(rarch_timer_t *timer);
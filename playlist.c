@@ -25,6 +25,7 @@
 #include <retro_assert.h>
 #include <retro_miscellaneous.h>
 #include <compat/posix_string.h>
+#include <compat/strcasestr.h>
 #include <string/stdstring.h>
 #include <streams/interface_stream.h>
 #include <streams/file_stream.h>
@@ -32,6 +33,11 @@
 #include <lists/string_list.h>
 #include <formats/jsonsax_full.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <features/features_cpu.h>
+#endif
+
 #include "playlist.h"
 #include "verbosity.h"
 #include "file_path_special.h"
@@ -40,9 +46,94 @@
 #define PLAYLIST_ENTRIES 6
 #endif
 
+/* Playlist journal
+ * > When a (new format) playlist is modified, changes
+ *   are appended to a journal file next to the playlist
+ *   instead of rewriting the entire JSON file
+ * > The journal is replayed when the playlist is read,
+ *   and is discarded whenever the playlist is written
+ *   in full ('compaction') */
+#define PLAYLIST_JOURNAL_EXTENSION ".jrn"
+#define PLAYLIST_JOURNAL_HEADER    "RAPLJ1"
+
+/* Playlists with fewer entries than this are
+ * always written in full */
+#ifndef PLAYLIST_JOURNAL_MIN_SIZE
+#define PLAYLIST_JOURNAL_MIN_SIZE 512
+#endif
+
+/* Hash index of playlist entries.
+ * Each slot records a 32-bit key (hash) and the
+ * number of playlist entries sharing that key.
+ * Since only counts are stored, the index remains
+ * valid when entries are reordered (bump to top,
+ * qsort) and lookups of content which is *not*
+ * in the playlist - the common case when scanning
+ * or importing - complete in constant time. */
+typedef struct
+{
+   uint32_t key;
+   uint32_t count;
+} playlist_index_slot_t;
+
+typedef struct
+{
+   playlist_index_slot_t *slots;
+   size_t cap; /* Always a power of 2 */
+   size_t used;
+} playlist_index_t;
+
+/* Index keys of a playlist entry. Kept out of
+ * struct playlist_entry, since callers copy entries
+ * around and the keys are only meaningful to the
+ * playlist that computed them */
+typedef struct
+{
+   uint32_t path;
+   uint32_t crc32;
+} playlist_entry_hash_t;
+
+/* String pool used to intern entry values which
+ * are typically shared by many entries (core path,
+ * core name, database name). Pooled strings are
+ * owned by the playlist and reference counted, so
+ * a string is freed once no entry uses it */
+typedef struct
+{
+   char *str;
+   uint32_t hash;
+   uint32_t refs;
+} playlist_string_pool_slot_t;
+
+typedef struct
+{
+   playlist_string_pool_slot_t *slots;
+   size_t cap; /* Always a power of 2 */
+   size_t count;
+} playlist_string_pool_t;
+
+/* String arena holding the per-entry values (path,
+ * label, crc32) read from the playlist file, so that
+ * loading a playlist costs a handful of allocations
+ * rather than several per entry. Values set later
+ * are heap allocated as usual, so the arena never
+ * grows after loading; arena strings replaced by
+ * updates are only reclaimed with the playlist */
+#define PLAYLIST_ARENA_BLOCK_MIN (16 * 1024)
+#define PLAYLIST_ARENA_BLOCK_MAX (4 * 1024 * 1024)
+
+typedef struct playlist_arena_block
+{
+   struct playlist_arena_block *next;
+   size_t size;
+   size_t used;
+   char data[1];
+} playlist_arena_block_t;
+
 struct content_playlist
 {
    bool modified;
+   bool index_valid;
 
    enum playlist_label_display_mode label_display_mode;
    enum playlist_thumbnail_mode right_thumbnail_mode;
@@ -51,11 +142,34 @@ struct content_playlist
 
    size_t size;
    size_t cap;
+   size_t entries_alloc; /* Number of allocated entries (<= cap) */
 
    char *conf_path;
    char *default_core_path;
    char *default_core_name;
    struct playlist_entry *entries;
+   playlist_entry_hash_t *hashes; /* Parallel to entries */
+
+   playlist_index_t path_index;
+   playlist_index_t crc32_index;
+
+   playlist_string_pool_t string_pool;
+   playlist_arena_block_t *arena; /* Most recent block first */
+
+   /* Collation keys (case folded labels) */
+   bool keys_sorted;           /* Keys are in ascending order */
+   char *keys_buf;
+   size_t *keys;               /* Offset of each entry's key in keys_buf */
+
+   /* Journal state */
+   bool journal_dirty;         /* Pending changes cannot be journaled */
+   size_t journal_records;     /* Records in journal file */
+   size_t journal_base_count;  /* Entries in base file */
+   int64_t journal_base_size;  /* Size of base file, -1 if unknown */
+   char *journal_buf;          /* Pending records */
+   size_t journal_buf_len;
+   size_t journal_buf_cap;
+   size_t journal_buf_records;
 };
 
 typedef struct
@@ -75,6 +189,7 @@ typedef struct
    char *current_meta_string;
    char *current_items_string;
    char **current_entry_val;
+   bool current_entry_val_interned;
    char **current_meta_val;
    int *current_entry_int_val;
    unsigned *current_entry_uint_val;
@@ -90,6 +205,942 @@ typedef int (playlist_sort_fun_t)(
       const struct playlist_entry *a,
       const struct playlist_entry *b);
 
+/* Playlist hash index */
+
+static void playlist_index_free(playlist_index_t *index)
+{
+   if (index->slots)
+      free(index->slots);
+
+   index->slots = NULL;
+   index->cap   = 0;
+   index->used  = 0;
+}
+
+static playlist_index_slot_t *playlist_index_find(
+      const playlist_index_t *index, uint32_t key)
+{
+   size_t mask;
+   size_t i;
+
+   if (!index->slots)
+      return NULL;
+
+   mask = index->cap - 1;
+
+   for (i = key & mask; index->slots[i].key; i = (i + 1) & mask)
+      if (index->slots[i].key == key)
+         return &index->slots[i];
+
+   return NULL;
+}
+
+static bool playlist_index_resize(playlist_index_t *index, size_t cap)
+{
+   size_t i;
+   size_t mask                  = cap - 1;
+   playlist_index_slot_t *slots = (playlist_index_slot_t*)
+      calloc(cap, sizeof(*slots));
+
+   if (!slots)
+      return false;
+
+   index->used = 0;
+
+   /* Re-insert all live keys - keys with a zero
+    * count are dropped at this point */
+   for (i = 0; i < index->cap; i++)
+   {
+      size_t j;
+      const playlist_index_slot_t *slot = &index->slots[i];
+
+      if (!slot->key || !slot->count)
+         continue;
+
+      for (j = slot->key & mask; slots[j].key; j = (j + 1) & mask);
+
+      slots[j] = *slot;
+      index->used++;
+   }
+
+   if (index->slots)
+      free(index->slots);
+
+   index->slots = slots;
+   index->cap   = cap;
+
+   return true;
+}
+
+static void playlist_index_add(playlist_index_t *index, uint32_t key)
+{
+   size_t mask;
+   size_t i;
+   playlist_index_slot_t *slot = NULL;
+
+   if (!key)
+      return;
+
+   if ((slot = playlist_index_find(index, key)))
+   {
+      slot->count++;
+      return;
+   }
+
+   /* Keep load factor below 3/4 */
+   if ((index->used + 1) * 4 > index->cap * 3)
+   {
+      size_t cap = index->cap ? index->cap : 64;
+
+      while ((index->used + 1) * 4 > cap * 3)
+         cap <<= 1;
+
+      if (!playlist_index_resize(index, cap))
+         return;
+   }
+
+   mask = index->cap - 1;
+
+   for (i = key & mask; index->slots[i].key; i = (i + 1) & mask);
+
+   index->slots[i].key   = key;
+   index->slots[i].count = 1;
+   index->used++;
+}
+
+static void playlist_index_remove(playlist_index_t *index, uint32_t key)
+{
+   playlist_index_slot_t *slot = NULL;
+
+   if (!key)
+      return;
+
+   /* Note: slot is left in place with a zero
+    * count, to avoid breaking probe sequences */
+   if ((slot = playlist_index_find(index, key)) && slot->count)
+      slot->count--;
+}
+
+static bool playlist_index_contains(
+      const playlist_index_t *index, uint32_t key)
+{
+   const playlist_index_slot_t *slot = playlist_index_find(index, key);
+   return slot && slot->count;
+}
+
+/**
+ * playlist_path_hash:
+ * @real_path           : 'Real' path, generated by path_resolve_realpath()
+ *
+ * Returns hash key of real_path, or 0 if real_path
+ * is empty. Only the archive file component of
+ * [archive_path][delimiter][rom_file] paths is hashed,
+ * so that 'incomplete' archive paths share the same
+ * key (see playlist_path_equal())
+ **/
+static uint32_t playlist_path_hash(const char *real_path)
+{
+   const unsigned char *str = (const unsigned char*)real_path;
+   const unsigned char *end = NULL;
+   uint32_t hash            = 5381;
+
+   if (string_is_empty(real_path))
+      return 0;
+
+   end = (const unsigned char*)path_get_archive_delim(real_path);
+
+   for (; *str && (str != end); str++)
+#ifdef _WIN32
+      /* Handle case-insensitive operating systems */
+      hash = (hash << 5) + hash + (uint32_t)tolower(*str);
+#else
+      hash = (hash << 5) + hash + *str;
+#endif
+
+   return hash ? hash : 1;
+}
+
+static uint32_t playlist_crc32_hash(const char *crc32, const char *db_name)
+{
+   const unsigned char *str = (const unsigned char*)crc32;
+   uint32_t hash            = 5381;
+
+   if (string_is_empty(crc32))
+      return 0;
+
+   for (; *str; str++)
+      hash = (hash << 5) + hash + *str;
+
+   /* Separator, so that 'ab'+'c' and 'a'+'bc' differ */
+   hash = (hash << 5) + hash + '|';
+
+   if (db_name)
+      for (str = (const unsigned char*)db_name; *str; str++)
+         hash = (hash << 5) + hash + *str;
+
+   return hash ? hash : 1;
+}
+
+static void playlist_index_entry_add(playlist_t *playlist, size_t idx)
+{
+   char real_path[PATH_MAX_LENGTH];
+   const struct playlist_entry *entry = &playlist->entries[idx];
+   playlist_entry_hash_t *hash        = &playlist->hashes[idx];
+
+   real_path[0] = '\0';
+
+   if (!playlist->index_valid)
+      return;
+
+   if (!string_is_empty(entry->path))
+   {
+      strlcpy(real_path, entry->path, sizeof(real_path));
+      path_resolve_realpath(real_path, sizeof(real_path), true);
+   }
+
+   hash->path  = playlist_path_hash(real_path);
+   hash->crc32 = playlist_crc32_hash(entry->crc32, entry->db_name);
+
+   playlist_index_add(&playlist->path_index, hash->path);
+   playlist_index_add(&playlist->crc32_index, hash->crc32);
+}
+
+static void playlist_index_entry_remove(playlist_t *playlist, size_t idx)
+{
+   playlist_entry_hash_t *hash = &playlist->hashes[idx];
+
+   if (!playlist->index_valid)
+      return;
+
+   playlist_index_remove(&playlist->path_index, hash->path);
+   playlist_index_remove(&playlist->crc32_index, hash->crc32);
+
+   hash->path  = 0;
+   hash->crc32 = 0;
+}
+
+/**
+ * playlist_index_build:
+ * @playlist            : Playlist handle.
+ *
+ * Builds playlist hash indexes, if required.
+ * Indexes are generated on demand (i.e. on first
+ * lookup) rather than when reading the playlist file,
+ * since most playlists are loaded for display only.
+ **/
+static void playlist_index_build(playlist_t *playlist)
+{
+   size_t i;
+
+   if (playlist->index_valid)
+      return;
+
+   playlist_index_free(&playlist->path_index);
+   playlist_index_free(&playlist->crc32_index);
+
+   playlist->index_valid = true;
+
+   for (i = 0; i < playlist->size; i++)
+      playlist_index_entry_add(playlist, i);
+}
+
+/* Playlist string pool */
+
+static void playlist_string_pool_free(playlist_string_pool_t *pool)
+{
+   size_t i;
+
+   if (!pool->slots)
+      return;
+
+   for (i = 0; i < pool->cap; i++)
+      if (pool->slots[i].str)
+         free(pool->slots[i].str);
+
+   free(pool->slots);
+
+   pool->slots = NULL;
+   pool->cap   = 0;
+   pool->count = 0;
+}
+
+static uint32_t playlist_string_hash(const char *str)
+{
+   const unsigned char *aux = (const unsigned char*)str;
+   uint32_t hash            = 5381;
+
+   while (*aux)
+      hash = (hash << 5) + hash + *aux++;
+
+   return hash;
+}
+
+static bool playlist_string_pool_resize(playlist_string_pool_t *pool,
+      size_t cap)
+{
+   size_t i;
+   size_t mask                        = cap - 1;
+   playlist_string_pool_slot_t *slots = (playlist_string_pool_slot_t*)
+      calloc(cap, sizeof(*slots));
+
+   if (!slots)
+      return false;
+
+   for (i = 0; i < pool->cap; i++)
+   {
+      size_t j;
+
+      if (!pool->slots[i].str)
+         continue;
+
+      for (j = pool->slots[i].hash & mask; slots[j].str; j = (j + 1) & mask);
+
+      slots[j] = pool->slots[i];
+   }
+
+   if (pool->slots)
+      free(pool->slots);
+
+   pool->slots = slots;
+   pool->cap   = cap;
+
+   return true;
+}
+
+/**
+ * playlist_intern:
+ * @playlist            : Playlist handle.
+ * @str                 : String to intern.
+ *
+ * Returns: pooled copy of @str (owned by playlist,
+ * must be released with playlist_unintern() rather
+ * than freed), or NULL if @str is NULL.
+ **/
+static char *playlist_intern(playlist_t *playlist, const char *str)
+{
+   playlist_string_pool_t *pool = &playlist->string_pool;
+   uint32_t hash;
+   size_t mask;
+   size_t i;
+
+   if (!str)
+      return NULL;
+
+   hash = playlist_string_hash(str);
+
+   if (pool->slots)
+   {
+      mask = pool->cap - 1;
+
+      for (i = hash & mask; pool->slots[i].str; i = (i + 1) & mask)
+      {
+         if (     (pool->slots[i].hash == hash)
+               && string_is_equal(pool->slots[i].str, str))
+         {
+            pool->slots[i].refs++;
+            return pool->slots[i].str;
+         }
+      }
+   }
+
+   /* Keep load factor below 1/2 */
+   if ((pool->count + 1) * 2 > pool->cap)
+      if (!playlist_string_pool_resize(pool,
+               pool->cap ? pool->cap << 1 : 32))
+         return NULL;
+
+   mask = pool->cap - 1;
+
+   for (i = hash & mask; pool->slots[i].str; i = (i + 1) & mask);
+
+   if (!(pool->slots[i].str = strdup(str)))
+      return NULL;
+
+   pool->slots[i].hash = hash;
+   pool->slots[i].refs = 1;
+   pool->count++;
+
+   return pool->slots[i].str;
+}
+
+/**
+ * playlist_unintern:
+ * @playlist            : Playlist handle.
+ * @str                 : String returned by playlist_intern().
+ *
+ * Releases a reference to a pooled string, freeing
+ * it when it was the last one.
+ **/
+static void playlist_unintern(playlist_t *playlist, char *str)
+{
+   playlist_string_pool_t *pool = &playlist->string_pool;
+   size_t mask;
+   size_t i, j;
+
+   if (!str || !pool->slots)
+      return;
+
+   mask = pool->cap - 1;
+
+   for (i = playlist_string_hash(str) & mask; pool->slots[i].str;
+         i = (i + 1) & mask)
+      if (pool->slots[i].str == str)
+         break;
+
+   if (!pool->slots[i].str || --pool->slots[i].refs)
+      return;
+
+   free(pool->slots[i].str);
+   pool->slots[i].str = NULL;
+   pool->count--;
+
+   /* Shift back any following slots which would no
+    * longer be reachable across the gap (linear probing
+    * deletion, so that no tombstones are needed) */
+   for (j = (i + 1) & mask; pool->slots[j].str; j = (j + 1) & mask)
+   {
+      size_t home = pool->slots[j].hash & mask;
+
+      if (((j - home) & mask) < ((j - i) & mask))
+         continue;
+
+      pool->slots[i]     = pool->slots[j];
+      pool->slots[j].str = NULL;
+      i                  = j;
+   }
+}
+
+/* Playlist string arena */
+
+static void playlist_arena_free(playlist_t *playlist)
+{
+   playlist_arena_block_t *block = playlist->arena;
+
+   while (block)
+   {
+      playlist_arena_block_t *next = block->next;
+      free(block);
+      block = next;
+   }
+
+   playlist->arena = NULL;
+}
+
+/**
+ * playlist_arena_strdup:
+ * @playlist            : Playlist handle.
+ * @str                 : String to copy.
+ *
+ * Returns: copy of @str, which must be released with
+ * playlist_free_string() rather than free().
+ **/
+static char *playlist_arena_strdup(playlist_t *playlist, const char *str)
+{
+   playlist_arena_block_t *block = playlist->arena;
+   size_t len                    = strlen(str) + 1;
+   char *copy;
+
+   if (!block || (block->size - block->used < len))
+   {
+      size_t size = block ? block->size << 1 : PLAYLIST_ARENA_BLOCK_MIN;
+
+      if (size > PLAYLIST_ARENA_BLOCK_MAX)
+         size = PLAYLIST_ARENA_BLOCK_MAX;
+
+      /* Odd long strings are not worth a block */
+      if (len > size / 4)
+         return strdup(str);
+
+      if (!(block = (playlist_arena_block_t*)malloc(
+            sizeof(*block) + size)))
+         return strdup(str);
+
+      block->next     = playlist->arena;
+      block->size     = size;
+      block->used     = 0;
+      playlist->arena = block;
+   }
+
+   copy         = block->data + block->used;
+   block->used += len;
+   memcpy(copy, str, len);
+
+   return copy;
+}
+
+/* Frees an entry string, unless it lives in the arena */
+static void playlist_free_string(playlist_t *playlist, char *str)
+{
+   const playlist_arena_block_t *block;
+
+   if (!str)
+      return;
+
+   /* Blocks double in size, so there are few of them */
+   for (block = playlist->arena; block; block = block->next)
+      if ((str >= block->data) && (str < block->data + block->used))
+         return;
+
+   free(str);
+}
+
+/* Replaces the pooled string in @field with @str */
+static void playlist_intern_set(playlist_t *playlist,
+      char **field, const char *str)
+{
+   char *old = *field;
+   *field    = playlist_intern(playlist, str);
+   playlist_unintern(playlist, old);
+}
+
+/**
+ * playlist_reserve:
+ * @playlist            : Playlist handle.
+ * @size                : Required number of entries.
+ *
+ * Ensures that at least @size entries are allocated.
+ * Entries are allocated on demand (rather than up
+ * to the full playlist capacity) so that the memory
+ * footprint of a playlist is proportional to its size.
+ * Note that this may move the entries array.
+ *
+ * Returns: true if successful.
+ **/
+static bool playlist_reserve(playlist_t *playlist, size_t size)
+{
+   size_t alloc                   = playlist->entries_alloc;
+   struct playlist_entry *entries = NULL;
+   playlist_entry_hash_t *hashes  = NULL;
+
+   if (size <= alloc)
+      return true;
+
+   if (size > playlist->cap)
+      return false;
+
+   if (alloc < 32)
+      alloc = 32;
+
+   while (alloc < size)
+      alloc <<= 1;
+
+   if (alloc > playlist->cap)
+      alloc = playlist->cap;
+
+   if (!(hashes = (playlist_entry_hash_t*)realloc(playlist->hashes,
+         alloc * sizeof(*hashes))))
+      return false;
+   playlist->hashes = hashes;
+
+   if (!(entries = (struct playlist_entry*)realloc(playlist->entries,
+         alloc * sizeof(*entries))))
+      return false;
+
+   /* New entries must be zero initialised */
+   memset(entries + playlist->entries_alloc, 0,
+         (alloc - playlist->entries_alloc) * sizeof(*entries));
+   memset(hashes + playlist->entries_alloc, 0,
+         (alloc - playlist->entries_alloc) * sizeof(*hashes));
+
+   playlist->entries       = entries;
+   playlist->entries_alloc = alloc;
+
+   return true;
+}
+
+/**
+ * playlist_move_entries:
+ * @playlist            : Playlist handle.
+ * @dst                 : Destination index.
+ * @src                 : Source index.
+ * @count               : Number of entries to move.
+ *
+ * memmove() for entries, keeping their index
+ * keys alongside.
+ **/
+static void playlist_move_entries(playlist_t *playlist,
+      size_t dst, size_t src, size_t count)
+{
+   memmove(playlist->entries + dst, playlist->entries + src,
+         count * sizeof(*playlist->entries));
+   memmove(playlist->hashes + dst, playlist->hashes + src,
+         count * sizeof(*playlist->hashes));
+}
+
+/* Moves entry @idx to the top of the playlist */
+static void playlist_bump_entry(playlist_t *playlist, size_t idx)
+{
+   struct playlist_entry entry = playlist->entries[idx];
+   playlist_entry_hash_t hash  = playlist->hashes[idx];
+
+   playlist_move_entries(playlist, 1, 0, idx);
+
+   playlist->entries[0] = entry;
+   playlist->hashes[0]  = hash;
+}
+
+/* Collation keys */
+
+static void playlist_keys_free(playlist_t *playlist)
+{
+   if (playlist->keys_buf)
+      free(playlist->keys_buf);
+   if (playlist->keys)
+      free(playlist->keys);
+
+   playlist->keys_buf    = NULL;
+   playlist->keys        = NULL;
+   playlist->keys_sorted = false;
+}
+
+/* Returns label used when sorting/searching entry.
+ * Must match the behaviour of
+ * menu_displaylist_parse_playlist(): if the label
+ * is blank, the filename is used as a fallback,
+ * and if the filename is also blank, the core name */
+static const char *playlist_get_collation_label(
+      const struct playlist_entry *entry,
+      char *s, size_t len)
+{
+   if (!string_is_empty(entry->label))
+      return entry->label;
+
+   s[0] = '\0';
+
+   if (!string_is_empty(entry->path))
+      fill_short_pathname_representation(s, entry->path, len);
+   else if (!string_is_empty(entry->core_name))
+      strlcpy(s, entry->core_name, len);
+
+   return s;
+}
+
+/**
+ * playlist_keys_build:
+ * @playlist            : Playlist handle.
+ *
+ * Generates the (case folded) collation key of each
+ * playlist entry. Keys are stored contiguously in
+ * a single buffer, such that sorting and searching
+ * never have to regenerate fallback labels or
+ * perform case-insensitive comparisons. Keys are
+ * discarded whenever entries are added, removed
+ * or modified.
+ *
+ * Returns: true if successful.
+ **/
+static bool playlist_keys_build(playlist_t *playlist)
+{
+   size_t i;
+   size_t buf_len  = 0;
+   size_t buf_cap  = 0;
+   char *buf       = NULL;
+   size_t *offsets = NULL;
+   bool sorted     = true;
+
+   if (playlist->keys)
+      return true;
+
+   if (playlist->size < 1)
+      return false;
+
+   if (!(offsets = (size_t*)malloc(playlist->size * sizeof(size_t))))
+      return false;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      char fallback_label[PATH_MAX_LENGTH];
+      const char *label = playlist_get_collation_label(
+            &playlist->entries[i], fallback_label, sizeof(fallback_label));
+      size_t len        = strlen(label);
+      size_t j;
+
+      if (buf_len + len + 1 > buf_cap)
+      {
+         size_t new_cap = buf_cap ? buf_cap : 4096;
+         char *new_buf  = NULL;
+
+         while (buf_len + len + 1 > new_cap)
+            new_cap <<= 1;
+
+         if (!(new_buf = (char*)realloc(buf, new_cap)))
+         {
+            free(buf);
+            free(offsets);
+            return false;
+         }
+
+         buf     = new_buf;
+         buf_cap = new_cap;
+      }
+
+      for (j = 0; j < len; j++)
+         buf[buf_len + j] = tolower((unsigned char)label[j]);
+      buf[buf_len + len] = '\0';
+
+      offsets[i]         = buf_len;
+      buf_len           += len + 1;
+
+      if (sorted && (i > 0) &&
+            (strcmp(buf + offsets[i - 1], buf + offsets[i]) > 0))
+         sorted = false;
+   }
+
+   playlist->keys_buf    = buf;
+   playlist->keys        = offsets;
+   playlist->keys_sorted = sorted;
+
+   return true;
+}
+
+/* Playlist journal */
+
+static void playlist_journal_free_buf(playlist_t *playlist)
+{
+   if (playlist->journal_buf)
+      free(playlist->journal_buf);
+
+   playlist->journal_buf         = NULL;
+   playlist->journal_buf_len     = 0;
+   playlist->journal_buf_cap     = 0;
+   playlist->journal_buf_records = 0;
+}
+
+/**
+ * playlist_journal_invalidate:
+ * @playlist            : Playlist handle.
+ *
+ * Flags that pending changes cannot be represented
+ * by the journal (e.g. playlist has been sorted or
+ * metadata has changed) - next call of
+ * playlist_write_file() will write the playlist in full.
+ **/
+static void playlist_journal_invalidate(playlist_t *playlist)
+{
+   playlist->journal_dirty = true;
+   playlist_journal_free_buf(playlist);
+}
+
+static void playlist_journal_get_path(playlist_t *playlist,
+      char *s, size_t len)
+{
+   strlcpy(s, playlist->conf_path, len);
+   strlcat(s, PLAYLIST_JOURNAL_EXTENSION, len);
+}
+
+static size_t playlist_journal_max_records(playlist_t *playlist)
+{
+   /* Compact once the journal reaches a quarter
+    * of the playlist size - this keeps the journal
+    * small relative to the base file, and amortises
+    * the cost of compaction to O(1) per change */
+   return playlist->size / 4;
+}
+
+/* Appends a single line to the pending journal buffer */
+static void playlist_journal_append_line(playlist_t *playlist,
+      const char *str)
+{
+   size_t len = str ? strlen(str) : 0;
+
+   if (playlist->journal_dirty)
+      return;
+
+   /* Values must fit on a single line, and in the
+    * buffer used by playlist_journal_replay() */
+   if ((len >= PATH_MAX_LENGTH - 1) || (str && strchr(str, '\n')))
+   {
+      playlist_journal_invalidate(playlist);
+      return;
+   }
+
+   if (playlist->journal_buf_len + len + 1 > playlist->journal_buf_cap)
+   {
+      size_t cap = playlist->journal_buf_cap
+         ? playlist->journal_buf_cap : 4096;
+      char *buf  = NULL;
+
+      while (playlist->journal_buf_len + len + 1 > cap)
+         cap <<= 1;
+
+      if (!(buf = (char*)realloc(playlist->journal_buf, cap)))
+      {
+         playlist_journal_invalidate(playlist);
+         return;
+      }
+
+      playlist->journal_buf     = buf;
+      playlist->journal_buf_cap = cap;
+   }
+
+   if (len)
+      memcpy(playlist->journal_buf + playlist->journal_buf_len, str, len);
+   playlist->journal_buf[playlist->journal_buf_len + len] = '\n';
+   playlist->journal_buf_len += len + 1;
+}
+
+/**
+ * playlist_journal_record:
+ * @playlist            : Playlist handle.
+ * @op                  : Operation: 'I' (insert), 'S' (set),
+ *                        'D' (delete) or 'M' (move to top).
+ * @idx                 : Index of affected entry.
+ * @entry               : New entry value ('I' and 'S' only).
+ *
+ * Records an entry operation in the pending journal buffer.
+ **/
+static void playlist_journal_record(playlist_t *playlist,
+      char op, size_t idx, const struct playlist_entry *entry)
+{
+   char line[32];
+
+   if (playlist->journal_dirty)
+      return;
+
+   /* If the journal would exceed its size limit,
+    * a full write is required anyway - stop
+    * buffering records */
+   if (playlist->journal_records + playlist->journal_buf_records >=
+         playlist_journal_max_records(playlist))
+   {
+      playlist_journal_invalidate(playlist);
+      return;
+   }
+
+   line[0] = '\0';
+   snprintf(line, sizeof(line), "%c %u", op, (unsigned)idx);
+   playlist_journal_append_line(playlist, line);
+
+   if (entry)
+   {
+      unsigned num_roms = entry->subsystem_roms
+         ? (unsigned)entry->subsystem_roms->size : 0;
+      unsigned i;
+
+      playlist_journal_append_line(playlist, entry->path);
+      playlist_journal_append_line(playlist, entry->label);
+      playlist_journal_append_line(playlist, entry->core_path);
+      playlist_journal_append_line(playlist, entry->core_name);
+      playlist_journal_append_line(playlist, entry->crc32);
+      playlist_journal_append_line(playlist, entry->db_name);
+      playlist_journal_append_line(playlist, entry->subsystem_ident);
+      playlist_journal_append_line(playlist, entry->subsystem_name);
+
+      line[0] = '\0';
+      snprintf(line, sizeof(line), "%u", num_roms);
+      playlist_journal_append_line(playlist, line);
+
+      for (i = 0; i < num_roms; i++)
+         playlist_journal_append_line(playlist,
+               entry->subsystem_roms->elems[i].data);
+   }
+
+   playlist->journal_buf_records++;
+}
+
+/**
+ * playlist_journal_flush:
+ * @playlist            : Playlist handle.
+ *
+ * Appends pending changes to the playlist journal.
+ *
+ * Returns: true if all pending changes were written,
+ * false if the playlist must be written in full.
+ **/
+static bool playlist_journal_flush(playlist_t *playlist)
+{
+   char journal_path[PATH_MAX_LENGTH];
+   RFILE *file = NULL;
+
+   journal_path[0] = '\0';
+
+   if (     playlist->journal_dirty
+         || (playlist->journal_base_size < 0))
+      return false;
+
+   /* Only values which are not saved to the
+    * playlist file have changed */
+   if (!playlist->journal_buf_records)
+      return true;
+
+   if (     (playlist->size < PLAYLIST_JOURNAL_MIN_SIZE)
+         || (playlist->journal_records + playlist->journal_buf_records >
+               playlist_journal_max_records(playlist)))
+      return false;
+
+   playlist_journal_get_path(playlist, journal_path, sizeof(journal_path));
+
+   if (playlist->journal_records == 0)
+   {
+      file = filestream_open(journal_path,
+            RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+      if (file)
+         filestream_printf(file, "%s %u %u\n", PLAYLIST_JOURNAL_HEADER,
+               (unsigned)playlist->journal_base_count,
+               (unsigned)playlist->journal_base_size);
+   }
+   else
+   {
+      file = filestream_open(journal_path,
+            RETRO_VFS_FILE_ACCESS_READ_WRITE |
+            RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+            RETRO_VFS_FILE_ACCESS_HINT_NONE);
+
+      if (file)
+         filestream_seek(file, 0, SEEK_END);
+   }
+
+   if (!file)
+      return false;
+
+   if (filestream_write(file, playlist->journal_buf,
+            playlist->journal_buf_len) !=
+         (int64_t)playlist->journal_buf_len)
+   {
+      filestream_close(file);
+      return false;
+   }
+
+   filestream_close(file);
+
+   playlist->journal_records += playlist->journal_buf_records;
+   playlist_journal_free_buf(playlist);
+
+   RARCH_LOG("Written to playlist journal: %s\n", journal_path);
+
+   return true;
+}
+
+/**
+ * playlist_journal_reset:
+ * @playlist            : Playlist handle.
+ * @base_size           : Size of (newly written) base file,
+ *                        or -1 if journaling is not possible.
+ *
+ * Discards journal after playlist has been written in full.
+ **/
+static void playlist_journal_reset(playlist_t *playlist, int64_t base_size)
+{
+   char journal_path[PATH_MAX_LENGTH];
+
+   journal_path[0] = '\0';
+
+   if (playlist->journal_records > 0 || playlist->journal_dirty)
+   {
+      playlist_journal_get_path(playlist, journal_path, sizeof(journal_path));
+      if (path_is_valid(journal_path))
+         filestream_delete(journal_path);
+   }
+
+   playlist_journal_free_buf(playlist);
+
+   playlist->journal_dirty      = false;
+   playlist->journal_records    = 0;
+   playlist->journal_base_count = playlist->size;
+   playlist->journal_base_size  = base_size;
+}
+
 /**
  * playlist_path_equal:
  * @real_path           : 'Real' search path, generated by path_resolve_realpath()
@@ -256,31 +1307,28 @@ void playlist_get_index(playlist_t *playlist,
 
 /**
  * playlist_free_entry:
+ * @playlist            : Playlist owning the entry's strings.
  * @entry               : Playlist entry handle.
  *
  * Frees playlist entry.
  **/
-static void playlist_free_entry(struct playlist_entry *entry)
+static void playlist_free_entry(playlist_t *playlist,
+      struct playlist_entry *entry)
 {
    if (!entry)
       return;
 
-   if (entry->path != NULL)
-      free(entry->path);
-   if (entry->label != NULL)
-      free(entry->label);
-   if (entry->core_path != NULL)
-      free(entry->core_path);
-   if (entry->core_name != NULL)
-      free(entry->core_name);
-   if (entry->db_name != NULL)
-      free(entry->db_name);
-   if (entry->crc32 != NULL)
-      free(entry->crc32);
-   if (entry->subsystem_ident != NULL)
-      free(entry->subsystem_ident);
-   if (entry->subsystem_name != NULL)
-      free(entry->subsystem_name);
+   /* Note: path, label, crc32 and the subsystem values
+    * may be held by the string arena, while core_path, core_name and
+    * db_name are interned (owned by the string pool) */
+   playlist_free_string(playlist, entry->path);
+   playlist_free_string(playlist, entry->label);
+   playlist_unintern(playlist, entry->core_path);
+   playlist_unintern(playlist, entry->core_name);
+   playlist_unintern(playlist, entry->db_name);
+   playlist_free_string(playlist, entry->crc32);
+   playlist_free_string(playlist, entry->subsystem_ident);
+   playlist_free_string(playlist, entry->subsystem_name);
    if (entry->runtime_str != NULL)
       free(entry->runtime_str);
    if (entry->last_played_str != NULL)
@@ -329,16 +1377,21 @@ void playlist_delete_index(playlist_t *playlist,
    if (idx >= playlist->size)
       return;
 
+   playlist_journal_record(playlist, 'D', idx, NULL);
+   playlist_keys_free(playlist);
+
    playlist->size     = playlist->size - 1;
 
    /* Free unwanted entry */
    entry_to_delete = (struct playlist_entry *)(playlist->entries + idx);
    if (entry_to_delete)
-      playlist_free_entry(entry_to_delete);
+   {
+      playlist_index_entry_remove(playlist, idx);
+      playlist_free_entry(playlist, entry_to_delete);
+   }
 
    /* Shift remaining entries to fill the gap */
-   memmove(playlist->entries + idx, playlist->entries + idx + 1,
-         (playlist->size - idx) * sizeof(struct playlist_entry));
+   playlist_move_entries(playlist, idx, idx + 1, playlist->size - idx);
 
    playlist->modified = true;
 }
@@ -356,6 +1409,7 @@ void playlist_delete_by_path(playlist_t *playlist,
       bool fuzzy_archive_match)
 {
    size_t i = 0;
+   uint32_t path_hash;
    char real_search_path[PATH_MAX_LENGTH];
 
    real_search_path[0] = '\0';
@@ -367,9 +1421,16 @@ void playlist_delete_by_path(playlist_t *playlist,
    strlcpy(real_search_path, search_path, sizeof(real_search_path));
    path_resolve_realpath(real_search_path, sizeof(real_search_path), true);
 
+   playlist_index_build(playlist);
+   path_hash = playlist_path_hash(real_search_path);
+
+   if (!playlist_index_contains(&playlist->path_index, path_hash))
+      return;
+
    while (i < playlist->size)
    {
-      if (!playlist_path_equal(real_search_path, playlist->entries[i].path,
+      if ((playlist->hashes[i].path != path_hash) ||
+          !playlist_path_equal(real_search_path, playlist->entries[i].path,
             fuzzy_archive_match))
       {
          i++;
@@ -390,6 +1451,7 @@ void playlist_get_index_by_path(playlist_t *playlist,
       bool fuzzy_archive_match)
 {
    size_t i;
+   uint32_t path_hash;
    char real_search_path[PATH_MAX_LENGTH];
 
    real_search_path[0] = '\0';
@@ -401,8 +1463,17 @@ void playlist_get_index_by_path(playlist_t *playlist,
    strlcpy(real_search_path, search_path, sizeof(real_search_path));
    path_resolve_realpath(real_search_path, sizeof(real_search_path), true);
 
+   playlist_index_build(playlist);
+   path_hash = playlist_path_hash(real_search_path);
+
+   if (!playlist_index_contains(&playlist->path_index, path_hash))
+      return;
+
    for (i = 0; i < playlist->size; i++)
    {
+      if (playlist->hashes[i].path != path_hash)
+         continue;
+
       if (!playlist_path_equal(real_search_path, playlist->entries[i].path,
                fuzzy_archive_match))
          continue;
@@ -417,6 +1488,7 @@ bool playlist_entry_exists(playlist_t *playlist,
       const char *path, bool fuzzy_archive_match)
 {
    size_t i;
+   uint32_t path_hash;
    char real_search_path[PATH_MAX_LENGTH];
 
    real_search_path[0] = '\0';
@@ -428,72 +1500,110 @@ bool playlist_entry_exists(playlist_t *playlist,
    strlcpy(real_search_path, path, sizeof(real_search_path));
    path_resolve_realpath(real_search_path, sizeof(real_search_path), true);
 
+   playlist_index_build(playlist);
+   path_hash = playlist_path_hash(real_search_path);
+
+   if (!playlist_index_contains(&playlist->path_index, path_hash))
+      return false;
+
    for (i = 0; i < playlist->size; i++)
-      if (playlist_path_equal(real_search_path, playlist->entries[i].path,
+      if ((playlist->hashes[i].path == path_hash) &&
+          playlist_path_equal(real_search_path, playlist->entries[i].path,
                fuzzy_archive_match))
          return true;
 
    return false;
 }
 
+bool playlist_entry_exists_by_crc32(playlist_t *playlist,
+      const char *crc32, const char *db_name)
+{
+   size_t i;
+   uint32_t crc32_hash;
+
+   if (!playlist || string_is_empty(crc32))
+      return false;
+
+   playlist_index_build(playlist);
+   crc32_hash = playlist_crc32_hash(crc32, db_name);
+
+   if (!playlist_index_contains(&playlist->crc32_index, crc32_hash))
+      return false;
+
+   for (i = 0; i < playlist->size; i++)
+   {
+      const struct playlist_entry *entry = &playlist->entries[i];
+
+      if (playlist->hashes[i].crc32 != crc32_hash)
+         continue;
+
+      if (!string_is_equal(entry->crc32, crc32))
+         continue;
+
+      if (string_is_empty(db_name) && string_is_empty(entry->db_name))
+         return true;
+
+      if (string_is_equal(entry->db_name, db_name))
+         return true;
+   }
+
+   return false;
+}
+
 void playlist_update(playlist_t *playlist, size_t idx,
       const struct playlist_entry *update_entry)
 {
    struct playlist_entry *entry = NULL;
 
-   if (!playlist || idx > playlist->size)
+   if (!playlist || idx >= playlist->size)
       return;
 
    entry            = &playlist->entries[idx];
 
+   playlist_index_entry_remove(playlist, idx);
+   playlist_keys_free(playlist);
+
    if (update_entry->path && (update_entry->path != entry->path))
    {
-      if (entry->path != NULL)
-         free(entry->path);
+      playlist_free_string(playlist, entry->path);
       entry->path        = strdup(update_entry->path);
       playlist->modified = true;
    }
 
    if (update_entry->label && (update_entry->label != entry->label))
    {
-      if (entry->label != NULL)
-         free(entry->label);
+      playlist_free_string(playlist, entry->label);
       entry->label       = strdup(update_entry->label);
       playlist->modified = true;
    }
 
    if (update_entry->core_path && (update_entry->core_path != entry->core_path))
    {
-      if (entry->core_path != NULL)
-         free(entry->core_path);
-      entry->core_path   = NULL;
-      entry->core_path   = strdup(update_entry->core_path);
+      playlist_intern_set(playlist, &entry->core_path, update_entry->core_path);
       playlist->modified = true;
    }
 
    if (update_entry->core_name && (update_entry->core_name != entry->core_name))
    {
-      if (entry->core_name != NULL)
-         free(entry->core_name);
-      entry->core_name   = strdup(update_entry->core_name);
+      playlist_intern_set(playlist, &entry->core_name, update_entry->core_name);
       playlist->modified = true;
    }
 
    if (update_entry->db_name && (update_entry->db_name != entry->db_name))
    {
-      if (entry->db_name != NULL)
-         free(entry->db_name);
-      entry->db_name     = strdup(update_entry->db_name);
+      playlist_intern_set(playlist, &entry->db_name, update_entry->db_name);
       playlist->modified = true;
    }
 
    if (update_entry->crc32 && (update_entry->crc32 != entry->crc32))
    {
-      if (entry->crc32 != NULL)
-         free(entry->crc32);
+      playlist_free_string(playlist, entry->crc32);
       entry->crc32       = strdup(update_entry->crc32);
       playlist->modified = true;
    }
+
+   playlist_index_entry_add(playlist, idx);
+   playlist_journal_record(playlist, 'S', idx, entry);
 }
 
 void playlist_update_runtime(playlist_t *playlist, size_t idx,
@@ -501,28 +1611,29 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
       bool register_update)
 {
    struct playlist_entry *entry = NULL;
+   bool paths_updated           = false;
 
-   if (!playlist || idx > playlist->size)
+   if (!playlist || idx >= playlist->size)
       return;
 
    entry            = &playlist->entries[idx];
 
    if (update_entry->path && (update_entry->path != entry->path))
    {
-      if (entry->path != NULL)
-         free(entry->path);
-      entry->path        = NULL;
+      playlist_index_entry_remove(playlist, idx);
+      playlist_free_string(playlist, entry->path);
       entry->path        = strdup(update_entry->path);
+      playlist_index_entry_add(playlist, idx);
+      playlist_keys_free(playlist);
       playlist->modified = playlist->modified || register_update;
+      paths_updated      = true;
    }
 
    if (update_entry->core_path && (update_entry->core_path != entry->core_path))
    {
-      if (entry->core_path != NULL)
-         free(entry->core_path);
-      entry->core_path   = NULL;
-      entry->core_path   = strdup(update_entry->core_path);
+      playlist_intern_set(playlist, &entry->core_path, update_entry->core_path);
       playlist->modified = playlist->modified || register_update;
+      paths_updated      = true;
    }
 
    if (update_entry->runtime_status != entry->runtime_status)
@@ -602,6 +1713,11 @@ void playlist_update_runtime(playlist_t *playlist, size_t idx,
       entry->last_played_str = strdup(update_entry->last_played_str);
       playlist->modified = playlist->modified || register_update;
    }
+
+   /* Note: runtime values are only stored in runtime
+    * log files, so do not need to be journaled */
+   if (paths_updated && register_update)
+      playlist_journal_record(playlist, 'S', idx, entry);
 }
 
 bool playlist_push_runtime(playlist_t *playlist,
@@ -609,6 +1725,7 @@ bool playlist_push_runtime(playlist_t *playlist,
       bool fuzzy_archive_match)
 {
    size_t i;
+   uint32_t path_hash;
    char real_path[PATH_MAX_LENGTH];
    char real_core_path[PATH_MAX_LENGTH];
 
@@ -642,13 +1759,23 @@ bool playlist_push_runtime(playlist_t *playlist,
       return false;
    }
 
-   for (i = 0; i < playlist->size; i++)
+   /* Skip search entirely if content is not
+    * in the playlist */
+   playlist_index_build(playlist);
+   path_hash = playlist_path_hash(real_path);
+
+   if (path_hash && !playlist_index_contains(&playlist->path_index, path_hash))
+      i = playlist->size;
+   else
+      i = 0;
+
+   for (; i < playlist->size; i++)
    {
-      struct playlist_entry tmp;
       const char *entry_path = playlist->entries[i].path;
       bool equal_path        =
-         (string_is_empty(real_path) && string_is_empty(entry_path)) ||
-         playlist_path_equal(real_path, entry_path, fuzzy_archive_match);
+         (playlist->hashes[i].path == path_hash) &&
+         ((string_is_empty(real_path) && string_is_empty(entry_path)) ||
+         playlist_path_equal(real_path, entry_path, fuzzy_archive_match));
 
       /* Core name can have changed while still being the same core.
        * Differentiate based on the core path only. */
@@ -664,10 +1791,8 @@ bool playlist_push_runtime(playlist_t *playlist,
          return false;
 
       /* Seen it before, bump to top. */
-      tmp = playlist->entries[i];
-      memmove(playlist->entries + 1, playlist->entries,
-            i * sizeof(struct playlist_entry));
-      playlist->entries[0] = tmp;
+      playlist_journal_record(playlist, 'M', i, NULL);
+      playlist_bump_entry(playlist, i);
 
       goto success;
    }
@@ -677,14 +1802,19 @@ bool playlist_push_runtime(playlist_t *playlist,
       struct playlist_entry *last_entry = &playlist->entries[playlist->cap - 1];
 
       if (last_entry)
-         playlist_free_entry(last_entry);
+      {
+         playlist_journal_record(playlist, 'D', playlist->cap - 1, NULL);
+         playlist_index_entry_remove(playlist, playlist->cap - 1);
+         playlist_free_entry(playlist, last_entry);
+      }
       playlist->size--;
    }
 
-   if (playlist->entries)
+   if (playlist_reserve(playlist, playlist->size + 1))
    {
-      memmove(playlist->entries + 1, playlist->entries,
-            (playlist->cap - 1) * sizeof(struct playlist_entry));
+      /* Only existing entries need to be shifted
+       * (size is always < cap at this point) */
+      playlist_move_entries(playlist, 1, 0, playlist->size);
 
       playlist->entries[0].path            = NULL;
       playlist->entries[0].core_path       = NULL;
@@ -692,7 +1822,7 @@ bool playlist_push_runtime(playlist_t *playlist,
       if (!string_is_empty(real_path))
          playlist->entries[0].path      = strdup(real_path);
       if (!string_is_empty(real_core_path))
-         playlist->entries[0].core_path = strdup(real_core_path);
+         playlist->entries[0].core_path = playlist_intern(playlist, real_core_path);
 
       playlist->entries[0].runtime_status = entry->runtime_status;
       playlist->entries[0].runtime_hours = entry->runtime_hours;
@@ -712,11 +1842,14 @@ bool playlist_push_runtime(playlist_t *playlist,
          playlist->entries[0].runtime_str     = strdup(entry->runtime_str);
       if (!string_is_empty(entry->last_played_str))
          playlist->entries[0].last_played_str = strdup(entry->last_played_str);
-   }
 
-   playlist->size++;
+      playlist_index_entry_add(playlist, 0);
+      playlist_journal_record(playlist, 'I', 0, &playlist->entries[0]);
+      playlist->size++;
+   }
 
 success:
+   playlist_keys_free(playlist);
    playlist->modified = true;
 
    return true;
@@ -777,6 +1910,7 @@ bool playlist_push(playlist_t *playlist,
       bool fuzzy_archive_match)
 {
    size_t i;
+   uint32_t path_hash;
    char real_path[PATH_MAX_LENGTH];
    char real_core_path[PATH_MAX_LENGTH];
    const char *core_name = entry->core_name;
@@ -825,13 +1959,23 @@ bool playlist_push(playlist_t *playlist,
       }
    }
 
-   for (i = 0; i < playlist->size; i++)
+   /* Skip search entirely if content is not
+    * in the playlist */
+   playlist_index_build(playlist);
+   path_hash = playlist_path_hash(real_path);
+
+   if (path_hash && !playlist_index_contains(&playlist->path_index, path_hash))
+      i = playlist->size;
+   else
+      i = 0;
+
+   for (; i < playlist->size; i++)
    {
-      struct playlist_entry tmp;
       const char *entry_path = playlist->entries[i].path;
       bool equal_path        =
-         (string_is_empty(real_path) && string_is_empty(entry_path)) ||
-         playlist_path_equal(real_path, entry_path, fuzzy_archive_match);
+         (playlist->hashes[i].path == path_hash) &&
+         ((string_is_empty(real_path) && string_is_empty(entry_path)) ||
+         playlist_path_equal(real_path, entry_path, fuzzy_archive_match));
 
       /* Core name can have changed while still being the same core.
        * Differentiate based on the core path only. */
@@ -909,17 +2053,23 @@ bool playlist_push(playlist_t *playlist,
          playlist->entries[i].label   = strdup(entry->label);
          entry_updated                = true;
       }
-      if (!playlist->entries[i].crc32 && !string_is_empty(entry->crc32))
+      if ((!playlist->entries[i].crc32   && !string_is_empty(entry->crc32)) ||
+          (!playlist->entries[i].db_name && !string_is_empty(entry->db_name)))
       {
-         playlist->entries[i].crc32   = strdup(entry->crc32);
-         entry_updated                = true;
-      }
-      if (!playlist->entries[i].db_name && !string_is_empty(entry->db_name))
-      {
-         playlist->entries[i].db_name = strdup(entry->db_name);
+         playlist_index_entry_remove(playlist, i);
+
+         if (!playlist->entries[i].crc32 && !string_is_empty(entry->crc32))
+            playlist->entries[i].crc32   = strdup(entry->crc32);
+         if (!playlist->entries[i].db_name && !string_is_empty(entry->db_name))
+            playlist->entries[i].db_name = playlist_intern(playlist, entry->db_name);
+
+         playlist_index_entry_add(playlist, i);
          entry_updated                = true;
       }
 
+      if (entry_updated)
+         playlist_journal_record(playlist, 'S', i, &playlist->entries[i]);
+
       /* If top entry, we don't want to push a new entry since
        * the top and the entry to be pushed are the same. */
       if (i == 0)
@@ -931,10 +2081,8 @@ bool playlist_push(playlist_t *playlist,
       }
 
       /* Seen it before, bump to top. */
-      tmp = playlist->entries[i];
-      memmove(playlist->entries + 1, playlist->entries,
-            i * sizeof(struct playlist_entry));
-      playlist->entries[0] = tmp;
+      playlist_journal_record(playlist, 'M', i, NULL);
+      playlist_bump_entry(playlist, i);
 
       goto success;
    }
@@ -945,14 +2093,19 @@ bool playlist_push(playlist_t *playlist,
          &playlist->entries[playlist->cap - 1];
 
       if (last_entry)
-         playlist_free_entry(last_entry);
+      {
+         playlist_journal_record(playlist, 'D', playlist->cap - 1, NULL);
+         playlist_index_entry_remove(playlist, playlist->cap - 1);
+         playlist_free_entry(playlist, last_entry);
+      }
       playlist->size--;
    }
 
-   if (playlist->entries)
+   if (playlist_reserve(playlist, playlist->size + 1))
    {
-      memmove(playlist->entries + 1, playlist->entries,
-            (playlist->cap - 1) * sizeof(struct playlist_entry));
+      /* Only existing entries need to be shifted
+       * (size is always < cap at this point) */
+      playlist_move_entries(playlist, 1, 0, playlist->size);
 
       playlist->entries[0].path               = NULL;
       playlist->entries[0].label              = NULL;
@@ -980,11 +2133,11 @@ bool playlist_push(playlist_t *playlist,
       if (!string_is_empty(entry->label))
          playlist->entries[0].label           = strdup(entry->label);
       if (!string_is_empty(real_core_path))
-         playlist->entries[0].core_path       = strdup(real_core_path);
+         playlist->entries[0].core_path       = playlist_intern(playlist, real_core_path);
       if (!string_is_empty(core_name))
-         playlist->entries[0].core_name       = strdup(core_name);
+         playlist->entries[0].core_name       = playlist_intern(playlist, core_name);
       if (!string_is_empty(entry->db_name))
-         playlist->entries[0].db_name         = strdup(entry->db_name);
+         playlist->entries[0].db_name         = playlist_intern(playlist, entry->db_name);
       if (!string_is_empty(entry->crc32))
          playlist->entries[0].crc32           = strdup(entry->crc32);
       if (!string_is_empty(entry->subsystem_ident))
@@ -1001,11 +2154,14 @@ bool playlist_push(playlist_t *playlist,
          for (i = 0; i < entry->subsystem_roms->size; i++)
             string_list_append(playlist->entries[0].subsystem_roms, entry->subsystem_roms->elems[i].data, attributes);
       }
-   }
 
-   playlist->size++;
+      playlist_index_entry_add(playlist, 0);
+      playlist_journal_record(playlist, 'I', 0, &playlist->entries[0]);
+      playlist->size++;
+   }
 
 success:
+   playlist_keys_free(playlist);
    playlist->modified = true;
 
    return true;
@@ -1263,7 +2419,9 @@ void playlist_write_runtime_file(playlist_t *playlist)
    JSON_Writer_WriteNewLine(context.writer);
    JSON_Writer_Free(context.writer);
 
+   /* Runtime values are not journaled */
    playlist->modified = false;
+   playlist_journal_reset(playlist, -1);
 
    RARCH_LOG("Written to playlist file: %s\n", playlist->conf_path);
 end:
@@ -1274,10 +2432,19 @@ void playlist_write_file(playlist_t *playlist, bool use_old_format)
 {
    size_t i;
    RFILE          *file = NULL;
+   int64_t    base_size = -1;
 
    if (!playlist || !playlist->modified)
       return;
 
+   /* If possible, just append changes to
+    * the playlist journal */
+   if (!use_old_format && playlist_journal_flush(playlist))
+   {
+      playlist->modified = false;
+      return;
+   }
+
    file = filestream_open(playlist->conf_path,
          RETRO_VFS_FILE_ACCESS_WRITE, RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
@@ -1626,9 +2793,12 @@ void playlist_write_file(playlist_t *playlist, bool use_old_format)
       JSON_Writer_WriteEndObject(context.writer);
       JSON_Writer_WriteNewLine(context.writer);
       JSON_Writer_Free(context.writer);
+
+      base_size = filestream_tell(file);
    }
 
    playlist->modified = false;
+   playlist_journal_reset(playlist, base_size);
 
    RARCH_LOG("Written to playlist file: %s\n", playlist->conf_path);
 end:
@@ -1665,11 +2835,20 @@ void playlist_free(playlist_t *playlist)
       struct playlist_entry *entry = &playlist->entries[i];
 
       if (entry)
-         playlist_free_entry(entry);
+         playlist_free_entry(playlist, entry);
    }
 
    free(playlist->entries);
    playlist->entries = NULL;
+   free(playlist->hashes);
+   playlist->hashes  = NULL;
+
+   playlist_index_free(&playlist->path_index);
+   playlist_index_free(&playlist->crc32_index);
+   playlist_journal_free_buf(playlist);
+   playlist_string_pool_free(&playlist->string_pool);
+   playlist_arena_free(playlist);
+   playlist_keys_free(playlist);
 
    free(playlist);
 }
@@ -1691,9 +2870,19 @@ void playlist_clear(playlist_t *playlist)
       struct playlist_entry *entry = &playlist->entries[i];
 
       if (entry)
-         playlist_free_entry(entry);
+         playlist_free_entry(playlist, entry);
    }
    playlist->size = 0;
+
+   /* Nothing references the arena any more */
+   playlist_arena_free(playlist);
+
+   playlist_index_free(&playlist->path_index);
+   playlist_index_free(&playlist->crc32_index);
+   playlist->index_valid = true;
+
+   playlist_keys_free(playlist);
+   playlist_journal_invalidate(playlist);
 }
 
 /**
@@ -1790,7 +2979,15 @@ static JSON_Parser_HandlerResult JSONStartObjectHandler(JSON_Parser parser)
       if ((pCtx->array_depth == 1) && !pCtx->capacity_exceeded)
       {
          if (pCtx->playlist->size < pCtx->playlist->cap)
+         {
+            if (!playlist_reserve(pCtx->playlist, pCtx->playlist->size + 1))
+            {
+               RARCH_ERR("Failed to allocate memory for playlist entries.\n");
+               return JSON_Parser_Abort;
+            }
+
             pCtx->current_entry = &pCtx->playlist->entries[pCtx->playlist->size];
+         }
          else
          {
             /* Hit max item limit.
@@ -1804,6 +3001,7 @@ static JSON_Parser_HandlerResult JSONStartObjectHandler(JSON_Parser parser)
              * (i.e. the playlist is not the same as when it was
              * last saved to disk...) */
             pCtx->playlist->modified = true;
+            playlist_journal_invalidate(pCtx->playlist);
          }
       }
    }
@@ -1851,9 +3049,16 @@ static JSON_Parser_HandlerResult JSONStringHandler(JSON_Parser parser, char *pVa
       {
          if (pCtx->current_entry_val && length && !string_is_empty(pValue))
          {
-            if (*pCtx->current_entry_val)
-               free(*pCtx->current_entry_val);
-            *pCtx->current_entry_val = strdup(pValue);
+            if (pCtx->current_entry_val_interned)
+               playlist_intern_set(pCtx->playlist,
+                     pCtx->current_entry_val, pValue);
+            else
+            {
+               playlist_free_string(pCtx->playlist,
+                     *pCtx->current_entry_val);
+               *pCtx->current_entry_val = playlist_arena_strdup(
+                     pCtx->playlist, pValue);
+            }
          }
          else
          {
@@ -1881,8 +3086,9 @@ static JSON_Parser_HandlerResult JSONStringHandler(JSON_Parser parser, char *pVa
       }
    }
 
-   pCtx->current_entry_val = NULL;
-   pCtx->current_meta_val  = NULL;
+   pCtx->current_entry_val          = NULL;
+   pCtx->current_entry_val_interned = false;
+   pCtx->current_meta_val           = NULL;
 
    return JSON_Parser_Continue;
 }
@@ -1973,13 +3179,22 @@ static JSON_Parser_HandlerResult JSONObjectMemberHandler(JSON_Parser parser, cha
                else if (string_is_equal(pValue, "label"))
                   pCtx->current_entry_val = &pCtx->current_entry->label;
                else if (string_is_equal(pValue, "core_path"))
-                  pCtx->current_entry_val = &pCtx->current_entry->core_path;
+               {
+                  pCtx->current_entry_val          = &pCtx->current_entry->core_path;
+                  pCtx->current_entry_val_interned = true;
+               }
                else if (string_is_equal(pValue, "core_name"))
-                  pCtx->current_entry_val = &pCtx->current_entry->core_name;
+               {
+                  pCtx->current_entry_val          = &pCtx->current_entry->core_name;
+                  pCtx->current_entry_val_interned = true;
+               }
                else if (string_is_equal(pValue, "crc32"))
                   pCtx->current_entry_val = &pCtx->current_entry->crc32;
                else if (string_is_equal(pValue, "db_name"))
-                  pCtx->current_entry_val = &pCtx->current_entry->db_name;
+               {
+                  pCtx->current_entry_val          = &pCtx->current_entry->db_name;
+                  pCtx->current_entry_val_interned = true;
+               }
                else if (string_is_equal(pValue, "subsystem_ident"))
                   pCtx->current_entry_val = &pCtx->current_entry->subsystem_ident;
                else if (string_is_equal(pValue, "subsystem_name"))
@@ -2079,6 +3294,204 @@ static void get_old_format_metadata_value(
    strlcpy(value, start, len);
 }
 
+/* Reads a single journal line, minus its terminating
+ * newline. Returns false if line is incomplete (i.e.
+ * journal was truncated while being written) */
+static bool playlist_journal_read_line(RFILE *file, char *s, size_t len)
+{
+   size_t line_len;
+
+   if (!filestream_gets(file, s, len))
+      return false;
+
+   line_len = strlen(s);
+
+   if ((line_len < 1) || (s[line_len - 1] != '\n'))
+      return false;
+
+   s[line_len - 1] = '\0';
+   return true;
+}
+
+static bool playlist_journal_read_entry(playlist_t *playlist, RFILE *file,
+      struct playlist_entry *entry, char *s, size_t len)
+{
+   char **fields[8];
+   unsigned num_roms;
+   unsigned i;
+
+   fields[0] = &entry->path;
+   fields[1] = &entry->label;
+   fields[2] = &entry->core_path;
+   fields[3] = &entry->core_name;
+   fields[4] = &entry->crc32;
+   fields[5] = &entry->db_name;
+   fields[6] = &entry->subsystem_ident;
+   fields[7] = &entry->subsystem_name;
+
+   for (i = 0; i < ARRAY_SIZE(fields); i++)
+   {
+      if (!playlist_journal_read_line(file, s, len))
+         return false;
+
+      if (string_is_empty(s))
+         continue;
+
+      /* Core path, core name and database name
+       * are interned */
+      if ((i == 2) || (i == 3) || (i == 5))
+         *fields[i] = playlist_intern(playlist, s);
+      else
+         *fields[i] = strdup(s);
+   }
+
+   if (!playlist_journal_read_line(file, s, len))
+      return false;
+
+   num_roms = string_to_unsigned(s);
+
+   if (num_roms > 0)
+   {
+      union string_list_elem_attr attr = {0};
+
+      if (!(entry->subsystem_roms = string_list_new()))
+         return false;
+
+      for (i = 0; i < num_roms; i++)
+      {
+         if (!playlist_journal_read_line(file, s, len))
+            return false;
+
+         string_list_append(entry->subsystem_roms, s, attr);
+      }
+   }
+
+   return true;
+}
+
+/**
+ * playlist_journal_replay:
+ * @playlist            : Playlist handle.
+ * @base_size           : Size of playlist file.
+ *
+ * Applies any changes recorded in the playlist
+ * journal to a freshly read playlist.
+ **/
+static void playlist_journal_replay(playlist_t *playlist, int64_t base_size)
+{
+   struct playlist_entry entry;
+   char journal_path[PATH_MAX_LENGTH];
+   char line[PATH_MAX_LENGTH];
+   char header[32];
+   RFILE *file = NULL;
+
+   journal_path[0] = '\0';
+   line[0]         = '\0';
+   header[0]       = '\0';
+
+   playlist->journal_base_count = playlist->size;
+   playlist->journal_base_size  = base_size;
+
+   playlist_journal_get_path(playlist, journal_path, sizeof(journal_path));
+
+   if (!path_is_valid(journal_path))
+      return;
+
+   if (!(file = filestream_open(journal_path,
+         RETRO_VFS_FILE_ACCESS_READ, RETRO_VFS_FILE_ACCESS_HINT_NONE)))
+      return;
+
+   /* Journal is only valid for the exact base
+    * file it was created against (playlist may
+    * have been written by another program, or by
+    * an older version of RetroArch) */
+   snprintf(header, sizeof(header), "%s %u %u", PLAYLIST_JOURNAL_HEADER,
+         (unsigned)playlist->size, (unsigned)base_size);
+
+   if (!playlist_journal_read_line(file, line, sizeof(line)) ||
+       !string_is_equal(line, header))
+   {
+      RARCH_WARN("Ignoring stale playlist journal: %s\n", journal_path);
+      playlist->journal_dirty = true;
+      goto end;
+   }
+
+   for (;;)
+   {
+      char op;
+      size_t idx;
+
+      memset(&entry, 0, sizeof(entry));
+
+      if (!playlist_journal_read_line(file, line, sizeof(line)))
+         break;
+
+      if (string_is_empty(line) || line[1] != ' ')
+         goto error;
+
+      op  = line[0];
+      idx = (size_t)string_to_unsigned(line + 2);
+
+      switch (op)
+      {
+         case 'I':
+            if (  (idx > playlist->size)
+                || !playlist_reserve(playlist, playlist->size + 1)
+                || !playlist_journal_read_entry(playlist, file, &entry,
+                      line, sizeof(line)))
+               goto error_entry;
+
+            playlist_move_entries(playlist, idx + 1, idx,
+                  playlist->size - idx);
+            playlist->entries[idx] = entry;
+            playlist->size++;
+            break;
+         case 'S':
+            if (  (idx >= playlist->size)
+                || !playlist_journal_read_entry(playlist, file, &entry,
+                      line, sizeof(line)))
+               goto error_entry;
+
+            playlist_free_entry(playlist, &playlist->entries[idx]);
+            playlist->entries[idx] = entry;
+            break;
+         case 'D':
+            if (idx >= playlist->size)
+               goto error;
+
+            playlist_free_entry(playlist, &playlist->entries[idx]);
+            playlist_move_entries(playlist, idx, idx + 1,
+                  playlist->size - idx - 1);
+            playlist->size--;
+            break;
+         case 'M':
+            if (idx >= playlist->size)
+               goto error;
+
+            playlist_bump_entry(playlist, idx);
+            break;
+         default:
+            goto error;
+      }
+
+      playlist->journal_records++;
+   }
+
+   goto end;
+
+error_entry:
+   /* Entry may have been partially read */
+   playlist_free_entry(playlist, &entry);
+error:
+   /* Any records applied so far are valid - the
+    * journal will be discarded on next write */
+   RARCH_WARN("Failed to replay playlist journal: %s\n", journal_path);
+   playlist->journal_dirty = true;
+
+end:
+   filestream_close(file);
+}
+
 static bool playlist_read_file(
       playlist_t *playlist, const char *path)
 {
@@ -2197,6 +3610,11 @@ static bool playlist_read_file(
          goto json_cleanup;
       }
 
+      /* Apply any changes recorded since the
+       * playlist was last written in full */
+      if (!context.capacity_exceeded)
+         playlist_journal_replay(playlist, filestream_get_size(file));
+
 json_cleanup:
 
       JSON_Parser_Free(context.parser);
@@ -2369,22 +3787,25 @@ json_cleanup:
                *last = '\0';
          }
 
+         if (!playlist_reserve(playlist, playlist->size + 1))
+            goto end;
+
          entry = &playlist->entries[playlist->size];
 
          if (!*buf[2] || !*buf[3])
             continue;
 
          if (*buf[0])
-            entry->path      = strdup(buf[0]);
+            entry->path      = playlist_arena_strdup(playlist, buf[0]);
          if (*buf[1])
-            entry->label     = strdup(buf[1]);
+            entry->label     = playlist_arena_strdup(playlist, buf[1]);
 
-         entry->core_path    = strdup(buf[2]);
-         entry->core_name    = strdup(buf[3]);
+         entry->core_path    = playlist_intern(playlist, buf[2]);
+         entry->core_name    = playlist_intern(playlist, buf[3]);
          if (*buf[4])
-            entry->crc32     = strdup(buf[4]);
+            entry->crc32     = playlist_arena_strdup(playlist, buf[4]);
          if (*buf[5])
-            entry->db_name   = strdup(buf[5]);
+            entry->db_name   = playlist_intern(playlist, buf[5]);
          playlist->size++;
       }
    }
@@ -2428,35 +3849,296 @@ bool playlist_init_cached(const char *path, size_t size)
  **/
 playlist_t *playlist_init(const char *path, size_t size)
 {
-   struct playlist_entry *entries = NULL;
    playlist_t           *playlist = (playlist_t*)malloc(sizeof(*playlist));
    if (!playlist)
       return NULL;
 
-   entries = (struct playlist_entry*)calloc(size, sizeof(*entries));
-   if (!entries)
-   {
-      free(playlist);
-      return NULL;
-   }
-
    playlist->modified             = false;
+   playlist->index_valid          = false;
    playlist->size                 = 0;
    playlist->cap                  = size;
    playlist->conf_path            = strdup(path);
    playlist->default_core_name    = NULL;
    playlist->default_core_path    = NULL;
-   playlist->entries              = entries;
+   playlist->entries              = NULL;
+   playlist->hashes               = NULL;
+   playlist->entries_alloc        = 0;
    playlist->label_display_mode   = LABEL_DISPLAY_MODE_DEFAULT;
    playlist->right_thumbnail_mode = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
    playlist->left_thumbnail_mode  = PLAYLIST_THUMBNAIL_MODE_DEFAULT;
    playlist->sort_mode            = PLAYLIST_SORT_MODE_DEFAULT;
 
+   playlist->path_index.slots     = NULL;
+   playlist->path_index.cap       = 0;
+   playlist->path_index.used      = 0;
+   playlist->crc32_index.slots    = NULL;
+   playlist->crc32_index.cap      = 0;
+   playlist->crc32_index.used     = 0;
+   playlist->string_pool.slots    = NULL;
+   playlist->string_pool.cap      = 0;
+   playlist->string_pool.count    = 0;
+   playlist->arena                = NULL;
+
+   playlist->keys_sorted          = false;
+   playlist->keys_buf             = NULL;
+   playlist->keys                 = NULL;
+
+   playlist->journal_dirty        = false;
+   playlist->journal_records      = 0;
+   playlist->journal_base_count   = 0;
+   playlist->journal_base_size    = -1;
+   playlist->journal_buf          = NULL;
+   playlist->journal_buf_len      = 0;
+   playlist->journal_buf_cap      = 0;
+   playlist->journal_buf_records  = 0;
+
    playlist_read_file(playlist, path);
 
    return playlist;
 }
 
+/* Sorting
+ * > Entries are sorted by collation key, with ties
+ *   resolved by original position (i.e. the sort is
+ *   stable, and the result does not depend on the
+ *   number of threads used)
+ * > Large playlists are split into chunks which are
+ *   sorted concurrently, then merged */
+#ifdef HAVE_THREADS
+#ifndef PLAYLIST_SORT_THREADS_MAX
+#define PLAYLIST_SORT_THREADS_MAX 8
+#endif
+
+/* Minimum number of entries sorted by each thread */
+#ifndef PLAYLIST_SORT_THREAD_MIN_SIZE
+#define PLAYLIST_SORT_THREAD_MIN_SIZE 4096
+#endif
+#endif
+
+typedef struct
+{
+   const char *key;
+   size_t idx;
+} playlist_sort_item_t;
+
+static int playlist_sort_item_cmp(const void *a, const void *b)
+{
+   const playlist_sort_item_t *item_a = (const playlist_sort_item_t*)a;
+   const playlist_sort_item_t *item_b = (const playlist_sort_item_t*)b;
+   int ret                            = strcmp(item_a->key, item_b->key);
+
+   if (ret != 0)
+      return ret;
+
+   return (item_a->idx < item_b->idx) ? -1 : (item_a->idx > item_b->idx);
+}
+
+#ifdef HAVE_THREADS
+typedef struct
+{
+   playlist_sort_item_t *items;
+   size_t count;
+} playlist_sort_task_t;
+
+static void playlist_sort_thread(void *data)
+{
+   playlist_sort_task_t *task = (playlist_sort_task_t*)data;
+
+   qsort(task->items, task->count,
+         sizeof(playlist_sort_item_t), playlist_sort_item_cmp);
+}
+
+static void playlist_sort_merge(const playlist_sort_item_t *a, size_t a_count,
+      const playlist_sort_item_t *b, size_t b_count,
+      playlist_sort_item_t *out)
+{
+   size_t i = 0;
+   size_t j = 0;
+
+   while (i < a_count && j < b_count)
+   {
+      if (playlist_sort_item_cmp(&b[j], &a[i]) < 0)
+         *out++ = b[j++];
+      else
+         *out++ = a[i++];
+   }
+
+   if (i < a_count)
+      memcpy(out, a + i, (a_count - i) * sizeof(*out));
+   if (j < b_count)
+      memcpy(out, b + j, (b_count - j) * sizeof(*out));
+}
+
+static bool playlist_sort_items_threaded(
+      playlist_sort_item_t *items, size_t count)
+{
+   playlist_sort_task_t tasks[PLAYLIST_SORT_THREADS_MAX];
+   sthread_t *threads[PLAYLIST_SORT_THREADS_MAX];
+   size_t bounds[PLAYLIST_SORT_THREADS_MAX + 1];
+   playlist_sort_item_t *src = items;
+   playlist_sort_item_t *dst = NULL;
+   unsigned num_runs         = cpu_features_get_core_amount();
+   unsigned i;
+
+   if (num_runs > PLAYLIST_SORT_THREADS_MAX)
+      num_runs = PLAYLIST_SORT_THREADS_MAX;
+   if (num_runs > count / PLAYLIST_SORT_THREAD_MIN_SIZE)
+      num_runs = (unsigned)(count / PLAYLIST_SORT_THREAD_MIN_SIZE);
+
+   if (num_runs < 2)
+      return false;
+
+   if (!(dst = (playlist_sort_item_t*)malloc(count * sizeof(*dst))))
+      return false;
+
+   for (i = 0; i < num_runs; i++)
+      bounds[i] = (count / num_runs) * i;
+   bounds[num_runs] = count;
+
+   /* Sort each chunk (the first on the
+    * calling thread) */
+   for (i = 0; i < num_runs; i++)
+   {
+      tasks[i].items = items + bounds[i];
+      tasks[i].count = bounds[i + 1] - bounds[i];
+      threads[i]     = NULL;
+
+      if (i > 0)
+         threads[i]  = sthread_create(playlist_sort_thread, &tasks[i]);
+   }
+
+   for (i = 0; i < num_runs; i++)
+   {
+      if (threads[i])
+         sthread_join(threads[i]);
+      else
+         playlist_sort_thread(&tasks[i]);
+   }
+
+   /* Merge adjacent runs until only one remains */
+   while (num_runs > 1)
+   {
+      playlist_sort_item_t *tmp = NULL;
+      unsigned new_runs         = 0;
+
+      for (i = 0; i < num_runs; i += 2)
+      {
+         size_t start = bounds[i];
+
+         if (i + 1 < num_runs)
+            playlist_sort_merge(
+                  src + start, bounds[i + 1] - start,
+                  src + bounds[i + 1], bounds[i + 2] - bounds[i + 1],
+                  dst + start);
+         else
+            memcpy(dst + start, src + start,
+                  (bounds[i + 1] - start) * sizeof(*dst));
+
+         bounds[new_runs++] = start;
+      }
+
+      bounds[new_runs] = count;
+      num_runs         = new_runs;
+
+      tmp = src;
+      src = dst;
+      dst = tmp;
+   }
+
+   if (src != items)
+   {
+      memcpy(items, src, count * sizeof(*items));
+      dst = src;
+   }
+
+   free(dst);
+
+   return true;
+}
+#endif
+
+/**
+ * playlist_sort_by_keys:
+ * @playlist            : Playlist handle.
+ *
+ * Sorts playlist entries using the cached collation
+ * keys (which must have been generated beforehand).
+ * Keys are reordered along with the entries.
+ *
+ * Returns: true if successful.
+ **/
+static bool playlist_sort_by_keys(playlist_t *playlist)
+{
+   size_t i;
+   size_t count                   = playlist->size;
+   playlist_sort_item_t *items    = NULL;
+   struct playlist_entry *entries = NULL;
+   playlist_entry_hash_t *hashes  = NULL;
+   size_t *keys                   = NULL;
+
+   if (!(items = (playlist_sort_item_t*)malloc(count * sizeof(*items))))
+      goto error;
+
+   if (!(entries = (struct playlist_entry*)malloc(
+         playlist->entries_alloc * sizeof(*entries))))
+      goto error;
+
+   if (!(hashes = (playlist_entry_hash_t*)malloc(
+         playlist->entries_alloc * sizeof(*hashes))))
+      goto error;
+
+   if (!(keys = (size_t*)malloc(count * sizeof(*keys))))
+      goto error;
+
+   for (i = 0; i < count; i++)
+   {
+      items[i].key = playlist->keys_buf + playlist->keys[i];
+      items[i].idx = i;
+   }
+
+#ifdef HAVE_THREADS
+   if (!playlist_sort_items_threaded(items, count))
+#endif
+      qsort(items, count, sizeof(*items), playlist_sort_item_cmp);
+
+   /* Apply new order */
+   for (i = 0; i < count; i++)
+   {
+      entries[i] = playlist->entries[items[i].idx];
+      hashes[i]  = playlist->hashes[items[i].idx];
+      keys[i]    = playlist->keys[items[i].idx];
+   }
+
+   memset(entries + count, 0,
+         (playlist->entries_alloc - count) * sizeof(*entries));
+   memset(hashes + count, 0,
+         (playlist->entries_alloc - count) * sizeof(*hashes));
+
+   free(playlist->entries);
+   free(playlist->hashes);
+   free(playlist->keys);
+   free(items);
+
+   playlist->entries     = entries;
+   playlist->hashes      = hashes;
+   playlist->keys        = keys;
+   playlist->keys_sorted = true;
+
+   return true;
+
+error:
+   if (items)
+      free(items);
+   if (entries)
+      free(entries);
+   if (hashes)
+      free(hashes);
+   if (keys)
+      free(keys);
+
+   return false;
+}
+
 static int playlist_qsort_func(const struct playlist_entry *a,
       const struct playlist_entry *b)
 {
@@ -2538,15 +4220,149 @@ end:
 
 void playlist_qsort(playlist_t *playlist)
 {
+   size_t i;
+
    /* Avoid inadvertent sorting if 'sort mode'
     * has been set explicitly to PLAYLIST_SORT_MODE_OFF */
    if (!playlist ||
        (playlist->sort_mode == PLAYLIST_SORT_MODE_OFF))
       return;
 
+   if (playlist->size < 2)
+      return;
+
+   /* Playlists are normally saved in sorted order,
+    * so check whether sorting is actually required
+    * (reordering entries invalidates the journal) */
+   if (playlist_keys_build(playlist))
+   {
+      if (playlist->keys_sorted)
+         return;
+
+      playlist_journal_invalidate(playlist);
+
+      if (playlist_sort_by_keys(playlist))
+         return;
+   }
+   else
+   {
+      for (i = 1; i < playlist->size; i++)
+         if (playlist_qsort_func(&playlist->entries[i - 1],
+                  &playlist->entries[i]) > 0)
+            break;
+
+      if (i >= playlist->size)
+         return;
+
+      playlist_journal_invalidate(playlist);
+   }
+
+   /* Fallback (out of memory). The index keys cannot
+    * follow the entries here, so the index is rebuilt
+    * on the next lookup */
    qsort(playlist->entries, playlist->size,
          sizeof(struct playlist_entry),
          (int (*)(const void *, const void *))playlist_qsort_func);
+   playlist_keys_free(playlist);
+   playlist->index_valid = false;
+}
+
+/**
+ * playlist_search:
+ * @playlist            : Playlist handle.
+ * @needle              : Search string.
+ * @idx                 : Index of matching entry.
+ *
+ * Case-insensitive search of playlist entry labels
+ * (or fallback labels, for entries without a label).
+ * As with file_list_search(), the first entry whose
+ * label starts with @needle takes precedence over
+ * entries with a match elsewhere in the label.
+ *
+ * Returns: true if a match was found.
+ **/
+bool playlist_search(playlist_t *playlist, const char *needle,
+      bool search_core_name, size_t *idx)
+{
+   size_t i;
+   size_t len;
+   char folded[PATH_MAX_LENGTH];
+
+   if (!playlist || !idx || string_is_empty(needle))
+      return false;
+
+   if (!playlist_keys_build(playlist))
+      return false;
+
+   strlcpy(folded, needle, sizeof(folded));
+   for (i = 0; folded[i]; i++)
+      folded[i] = tolower((unsigned char)folded[i]);
+   len = i;
+
+   /* Prefix match
+    * > If keys are ordered, all entries with
+    *   the required prefix are adjacent, starting
+    *   at the lower bound of the search string */
+   if (playlist->keys_sorted)
+   {
+      size_t lo = 0;
+      size_t hi = playlist->size;
+
+      while (lo < hi)
+      {
+         size_t mid = lo + ((hi - lo) >> 1);
+
+         if (strcmp(playlist->keys_buf + playlist->keys[mid], folded) < 0)
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+
+      if ((lo < playlist->size) &&
+          !strncmp(playlist->keys_buf + playlist->keys[lo], folded, len))
+      {
+         *idx = lo;
+         return true;
+      }
+   }
+   else
+   {
+      for (i = 0; i < playlist->size; i++)
+      {
+         if (!strncmp(playlist->keys_buf + playlist->keys[i], folded, len))
+         {
+            *idx = i;
+            return true;
+         }
+      }
+   }
+
+   /* Substring match
+    * > If the menu shows the associated core name
+    *   after each label, it is searched here too */
+   for (i = 0; i < playlist->size; i++)
+   {
+      const struct playlist_entry *entry = &playlist->entries[i];
+
+      if (strstr(playlist->keys_buf + playlist->keys[i], folded))
+      {
+         *idx = i;
+         return true;
+      }
+
+      if (search_core_name &&
+          !string_is_empty(entry->core_name) &&
+          !string_is_equal(entry->core_name, "DETECT") &&
+          !string_is_empty(entry->core_path) &&
+          !string_is_equal(entry->core_path, "DETECT") &&
+          strcasestr(entry->core_name, needle))
+      {
+         *idx = i;
+         return true;
+      }
+   }
+
+   return false;
 }
 
 void command_playlist_push_write(
@@ -2741,6 +4557,7 @@ void playlist_set_default_core_path(playlist_t *playlist, const char *core_path)
          free(playlist->default_core_path);
       playlist->default_core_path = strdup(real_core_path);
       playlist->modified = true;
+      playlist_journal_invalidate(playlist);
    }
 }
 
@@ -2755,6 +4572,7 @@ void playlist_set_default_core_name(playlist_t *playlist, const char *core_name)
          free(playlist->default_core_name);
       playlist->default_core_name = strdup(core_name);
       playlist->modified = true;
+      playlist_journal_invalidate(playlist);
    }
 }
 
@@ -2768,6 +4586,7 @@ void playlist_set_label_display_mode(playlist_t *playlist,
    {
       playlist->label_display_mode = label_display_mode;
       playlist->modified = true;
+      playlist_journal_invalidate(playlist);
    }
 }
 
@@ -2789,6 +4608,8 @@ void playlist_set_thumbnail_mode(
          playlist->modified            = true;
          break;
    }
+
+   playlist_journal_invalidate(playlist);
 }
 
 void playlist_set_sort_mode(playlist_t *playlist, enum playlist_sort_mode sort_mode)
@@ -2800,5 +4621,6 @@ void playlist_set_sort_mode(playlist_t *playlist, enum playlist_sort_mode sort_m
    {
       playlist->sort_mode = sort_mode;
       playlist->modified  = true;
+      playlist_journal_invalidate(playlist);
    }
 }
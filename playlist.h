@@ -19,6 +19,7 @@
 #define _PLAYLIST_H__
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <retro_common_api.h>
 #include <boolean.h>
@@ -242,6 +243,18 @@ void playlist_get_index_by_path(playlist_t *playlist,
 bool playlist_entry_exists(playlist_t *playlist,
       const char *path, bool fuzzy_archive_match);
 
+/**
+ * playlist_entry_exists_by_crc32:
+ * @playlist            : Playlist handle.
+ * @crc32               : Content CRC32 string.
+ * @db_name             : Database name (may be NULL).
+ *
+ * Returns true if the playlist contains an entry
+ * with matching 'crc32' and 'db_name' values.
+ **/
+bool playlist_entry_exists_by_crc32(playlist_t *playlist,
+      const char *crc32, const char *db_name);
+
 char *playlist_get_conf_path(playlist_t *playlist);
 
 uint32_t playlist_get_size(playlist_t *playlist);
@@ -252,6 +265,24 @@ void playlist_write_runtime_file(playlist_t *playlist);
 
 void playlist_qsort(playlist_t *playlist);
 
+/**
+ * playlist_search:
+ * @playlist            : Playlist handle.
+ * @needle              : Search string.
+ * @search_core_name    : Also match against entry core names.
+ * @idx                 : Index of matching entry.
+ *
+ * Case-insensitive search of playlist entry labels.
+ * Entries whose label starts with @needle take
+ * precedence over entries with a match elsewhere
+ * in the label (or in the core name, if
+ * @search_core_name is true).
+ *
+ * Returns: true if a match was found.
+ **/
+bool playlist_search(playlist_t *playlist, const char *needle,
+      bool search_core_name, size_t *idx);
+
 void playlist_free_cached(void);
 
 playlist_t *playlist_get_cached(void);
@@ -38,6 +38,10 @@
 #include <signal.h>
 #endif
 
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
 #if defined(_WIN32_WINNT) && _WIN32_WINNT < 0x0500 || defined(_XBOX)
 #ifndef LEGACY_WIN32
 #define LEGACY_WIN32
@@ -137,6 +141,7 @@
 #include "input/input_osk.h"
 
 #ifdef HAVE_MENU
+#include "gfx/gfx_thumbnail.h"
 #include "menu/menu_driver.h"
 #include "menu/menu_input.h"
 #include "menu/widgets/menu_dialog.h"
@@ -186,6 +191,10 @@
 #include "gfx/common/gl_core_common.h"
 #endif
 
+#ifdef HAVE_SLANG
+#include "gfx/drivers_shader/glslang_util.h"
+#endif
+
 #include "autosave.h"
 #include "command.h"
 #include "config.features.h"
@@ -278,6 +287,43 @@ audio_driver_t audio_null = {
    NULL
 };
 
+/* Used instead of the configured audio driver by
+ * --benchmark: no device, and writes never block */
+static void *audio_benchmark_init(const char *device, unsigned rate,
+      unsigned latency, unsigned block_frames, unsigned *new_rate)
+{
+   return (void*)-1;
+}
+
+static ssize_t audio_benchmark_write(void *data,
+      const void *buf, size_t size)
+{
+   return size;
+}
+
+static bool audio_benchmark_stop(void *data) { return true; }
+static bool audio_benchmark_start(void *data, bool is_shutdown) { return true; }
+static bool audio_benchmark_alive(void *data) { return true; }
+static void audio_benchmark_set_nonblock_state(void *data, bool toggle) { }
+static void audio_benchmark_free(void *data) { }
+static bool audio_benchmark_use_float(void *data) { return true; }
+
+static audio_driver_t audio_benchmark = {
+   audio_benchmark_init,
+   audio_benchmark_write,
+   audio_benchmark_stop,
+   audio_benchmark_start,
+   audio_benchmark_alive,
+   audio_benchmark_set_nonblock_state,
+   audio_benchmark_free,
+   audio_benchmark_use_float,
+   "benchmark",
+   NULL,
+   NULL,
+   NULL, /* write_avail */
+   NULL
+};
+
 static const audio_driver_t *audio_drivers[] = {
 #ifdef HAVE_ALSA
    &audio_alsa,
@@ -390,6 +436,9 @@ static void *video_null_init(const video_info_t *video,
    *input       = NULL;
    *input_data = NULL;
 
+   /* Give the menu a viewport to lay itself out in */
+   video_driver_set_size(video->width, video->height);
+
    return (void*)-1;
 }
 
@@ -397,6 +446,12 @@ static bool video_null_frame(void *data, const void *frame,
       unsigned frame_width, unsigned frame_height, uint64_t frame_count,
       unsigned pitch, const char *msg, video_frame_info_t *video_info)
 {
+#ifdef HAVE_MENU
+   /* Menu is laid out and drawn through the null
+    * display driver, so that it can be benchmarked
+    * headless */
+   menu_driver_frame(video_info);
+#endif
    return true;
 }
 
@@ -663,6 +718,35 @@ static input_driver_t input_null = {
    false,
 };
 
+/* Used instead of the configured input driver by
+ * --benchmark: no device, nothing is ever pressed */
+static void *input_benchmark_init(const char *joypad_driver) { return (void*)-1; }
+static void input_benchmark_poll(void *data) { }
+static int16_t input_benchmark_input_state(void *data,
+      rarch_joypad_info_t *joypad_info,
+      const struct retro_keybind **retro_keybinds,
+      unsigned port, unsigned device, unsigned index, unsigned id)
+{
+   return 0;
+}
+
+static input_driver_t input_benchmark = {
+   input_benchmark_init,
+   input_benchmark_poll,
+   input_benchmark_input_state,
+   NULL, /* free */
+   NULL, /* set_sensor_state */
+   NULL,
+   NULL, /* get_capabilities */
+   "benchmark",
+   NULL, /* grab_mouse */
+   NULL,
+   NULL, /* set_rumble */
+   NULL,
+   NULL,
+   false,
+};
+
 static input_driver_t *input_drivers[] = {
 #ifdef ORBIS
    &input_ps4,
@@ -1059,7 +1143,8 @@ enum
    RA_OPT_MAX_FRAMES_SCREENSHOT,
    RA_OPT_MAX_FRAMES_SCREENSHOT_PATH,
    RA_OPT_SET_SHADER,
-   RA_OPT_ACCESSIBILITY
+   RA_OPT_ACCESSIBILITY,
+   RA_OPT_BENCHMARK
 };
 
 enum  runloop_state
@@ -1163,6 +1248,11 @@ static bool runloop_core_running                                = false;
 static bool runloop_perfcnt_enable                              = false;
 #ifdef HAVE_CONFIGFILE
 static bool rarch_block_config_read                             = false;
+#endif
+/* Set for the whole run by --benchmark, so that the
+ * settings it overrides never reach a config file */
+static bool rarch_block_config_write                            = false;
+#ifdef HAVE_CONFIGFILE
 static bool runloop_overrides_active                            = false;
 static bool runloop_remaps_core_active                          = false;
 static bool runloop_remaps_game_active                          = false;
@@ -1277,6 +1367,33 @@ typedef struct bsv_movie bsv_movie_t;
 static bsv_movie_t     *bsv_movie_state_handle = NULL;
 static struct bsv_state bsv_movie_state;
 
+typedef uint64_t (*benchmark_alloc_count_t)(void);
+
+/* Headless benchmark (--benchmark) */
+struct benchmark_state
+{
+   /* Time and allocation count at the end of
+    * the first and of the latest frame */
+   retro_time_t start;
+   retro_time_t end;
+   uint64_t allocs_start;
+   uint64_t allocs_end;
+
+   /* Exported by an allocation counting library
+    * preloaded into the process, if there is one */
+   benchmark_alloc_count_t alloc_count;
+
+   /* Display driver draw calls and batched quads
+    * (menu and widgets), excluding the first frame */
+   uint64_t draw_calls;
+   uint64_t batched_quads;
+
+   unsigned frames;
+   bool enable;
+};
+
+static struct benchmark_state runloop_benchmark;
+
 
 /* Forward declarations */
 #ifdef HAVE_NETWORKING
@@ -2694,11 +2811,39 @@ static void menu_input_search_cb(void *userdata, const char *str)
 {
    size_t idx = 0;
    file_list_t *selection_buf = menu_entries_get_selection_buf_ptr(0);
+   menu_handle_t *menu        = menu_driver_get_ptr();
+   playlist_t *playlist       = playlist_get_cached();
+   bool found                 = false;
 
    if (!selection_buf)
       return;
 
-   if (str && *str && file_list_search(selection_buf, str, &idx))
+   if (str && *str)
+   {
+      const char *conf_path   = playlist ?
+            playlist_get_conf_path(playlist) : NULL;
+
+      /* If the current menu list was generated from
+       * the cached playlist (with unmodified labels),
+       * search the playlist itself - this uses cached
+       * case folded keys, and a binary search for
+       * prefix matches when the playlist is sorted */
+      if (menu &&
+          !string_is_empty(conf_path) &&
+          string_is_equal(conf_path, menu->rpl_list.path) &&
+          (selection_buf->size > 0) &&
+          (selection_buf->size == menu->rpl_list.size) &&
+          (selection_buf->size == playlist_size(playlist)) &&
+          (selection_buf->list[0].type == FILE_TYPE_RPL_ENTRY) &&
+          (playlist_get_label_display_mode(playlist) ==
+               LABEL_DISPLAY_MODE_DEFAULT))
+         found = playlist_search(playlist, str,
+               menu->rpl_list.show_inline_core_name, &idx);
+      else
+         found = file_list_search(selection_buf, str, &idx);
+   }
+
+   if (found)
    {
       menu_navigation_set_selection(idx);
       menu_driver_navigation_set(true);
@@ -3120,6 +3265,10 @@ static unsigned video_driver_height                      = 0;
 static enum rarch_display_type video_driver_display_type = RARCH_DISPLAY_NONE;
 static char video_driver_title_buf[64]                   = {0};
 static char video_driver_window_title[512]               = {0};
+/* FPS, frame count and memory text, rebuilt only when
+ * one of them is shown and its value changes */
+static char video_driver_fps_text[128]                   = {0};
+static char video_driver_mem_text[64]                    = {0};
 static bool video_driver_window_title_update             = true;
 
 static retro_time_t video_driver_frame_time_samples[MEASURE_FRAME_TIME_SAMPLES_COUNT];
@@ -5076,6 +5225,7 @@ static void netplay_send_savestate(netplay_t *netplay,
           connection->compression_supported != cx)
          continue;
 
+      netplay_udp_sync_point(netplay, connection);
       if (!netplay_send(&connection->send_packet_buffer, connection->fd, header,
             sizeof(header)) ||
           !netplay_send(&connection->send_packet_buffer, connection->fd,
@@ -5168,6 +5318,7 @@ static void netplay_core_reset(netplay_t *netplay)
             connection->mode < NETPLAY_CONNECTION_CONNECTED)
          continue;
 
+      netplay_udp_sync_point(netplay, connection);
       if (!netplay_send(&connection->send_packet_buffer, connection->fd, cmd,
                sizeof(cmd)))
          netplay_hangup(netplay, connection);
@@ -5296,6 +5447,7 @@ static bool init_netplay(void *direct_host, const char *server, unsigned port)
    bool netplay_stateless_mode     = settings->bools.netplay_stateless_mode;
    bool netplay_nat_traversal      = settings->bools.netplay_nat_traversal;
    bool netplay_use_mitm_server    = settings->bools.netplay_use_mitm_server;
+   bool netplay_udp_input          = settings->bools.netplay_udp_input;
    const char *netplay_password    = settings->paths.netplay_password;
    const char *netplay_spectate_pw = settings->paths.netplay_spectate_password;
    int netplay_check_frames        = settings->ints.netplay_check_frames;
@@ -5363,6 +5515,9 @@ static bool init_netplay(void *direct_host, const char *server, unsigned port)
          &cbs,
          netplay_nat_traversal 
          && !netplay_use_mitm_server,
+         /* The relay server only forwards TCP */
+         netplay_udp_input
+         && (_netplay_is_client || !netplay_use_mitm_server),
          path_username,
          netplay_password,
          netplay_spectate_pw,
@@ -5607,6 +5762,70 @@ bool retroarch_apply_shader(enum rarch_shader_type type, const char *preset_path
 #endif
 }
 
+/**
+ * retroarch_apply_shader_parameters:
+ * @shader       : Shader to take the parameter values from.
+ * @preset_path  : Preset @shader was saved to.
+ *
+ * Sets the parameters of the running shader to the values
+ * in @shader, without rebuilding it. Drivers read them every
+ * frame, so the new values show up on the next frame.
+ * @preset_path becomes the runtime preset, like it would
+ * with retroarch_apply_shader().
+ *
+ * Returns: false if the running shader is unknown or lacks
+ * any parameter of @shader, and was left untouched.
+ **/
+bool retroarch_apply_shader_parameters(
+      const struct video_shader *shader, const char *preset_path)
+{
+#if defined(HAVE_CG) || defined(HAVE_GLSL) || defined(HAVE_SLANG) || defined(HAVE_HLSL)
+   unsigned i, j;
+   video_shader_ctx_t shader_info;
+   struct video_shader *current = NULL;
+
+   if (string_is_empty(preset_path))
+      return false;
+
+   video_shader_driver_get_current_shader(&shader_info);
+
+   if (!(current = shader_info.data))
+      return false;
+
+   for (i = 0; i < shader->num_parameters; i++)
+   {
+      for (j = 0; j < current->num_parameters; j++)
+         if (string_is_equal(current->parameters[j].id,
+                  shader->parameters[i].id))
+            break;
+
+      if (j == current->num_parameters)
+         return false;
+   }
+
+   for (i = 0; i < shader->num_parameters; i++)
+   {
+      for (j = 0; j < current->num_parameters; j++)
+      {
+         if (string_is_equal(current->parameters[j].id,
+                  shader->parameters[i].id))
+         {
+            current->parameters[j].current = shader->parameters[i].current;
+            break;
+         }
+      }
+   }
+
+   strlcpy(current->path, preset_path, sizeof(current->path));
+   retroarch_set_runtime_shader_preset(preset_path);
+
+   RARCH_LOG("Updated shader parameters from \"%s\".\n", preset_path);
+   return true;
+#else
+   return false;
+#endif
+}
+
 static bool command_set_shader(const char *arg)
 {
 #if defined(HAVE_CG) || defined(HAVE_GLSL) || defined(HAVE_SLANG) || defined(HAVE_HLSL)
@@ -10051,6 +10270,115 @@ static void global_free(void)
 }
 
 
+static void retroarch_benchmark_tick(void)
+{
+   retro_time_t now        = cpu_features_get_time_usec();
+   uint64_t allocs         = 0;
+   unsigned draw_calls     = 0;
+   unsigned batched_quads  = 0;
+
+   gfx_display_get_draw_stats(&draw_calls, &batched_quads);
+
+   if (!runloop_benchmark.frames)
+   {
+#if defined(HAVE_DYNAMIC) && !defined(__WINRT__)
+      function_t sym = dylib_proc(NULL, "alloc_count_get");
+      runloop_benchmark.alloc_count = (benchmark_alloc_count_t)sym;
+#endif
+   }
+
+   if (runloop_benchmark.alloc_count)
+      allocs = runloop_benchmark.alloc_count();
+
+   /* The first frame is left out, it does the
+    * one-off work of starting the content */
+   if (!runloop_benchmark.frames++)
+   {
+      runloop_benchmark.start        = now;
+      runloop_benchmark.allocs_start = allocs;
+   }
+   else
+   {
+      runloop_benchmark.draw_calls    += draw_calls;
+      runloop_benchmark.batched_quads += batched_quads;
+   }
+
+   runloop_benchmark.end             = now;
+   runloop_benchmark.allocs_end      = allocs;
+}
+
+/**
+ * retroarch_benchmark_report:
+ *
+ * Prints the results of a --benchmark run to stdout.
+ **/
+static void retroarch_benchmark_report(void)
+{
+   unsigned i;
+   struct perf_span_stats span_stats[PERF_SPAN_LAST];
+   struct retro_perf_counter **counters = retro_get_perf_counter_libretro();
+   unsigned num_counters                = retro_get_perf_count_libretro();
+   unsigned frames                      = runloop_benchmark.frames > 1
+      ? runloop_benchmark.frames - 1 : 0;
+   double secs                          = (runloop_benchmark.end
+         - runloop_benchmark.start) / 1000000.0;
+
+   printf("=== Benchmark ===================================\n");
+   printf("Frames:      %u\n", frames);
+   printf("Time:        %.3f s\n", secs);
+   if (secs > 0.0)
+      printf("Frame rate:  %.2f fps\n", frames / secs);
+   if (runloop_benchmark.alloc_count && frames)
+      printf("Allocations: %.2f per frame\n",
+            (double)(runloop_benchmark.allocs_end
+               - runloop_benchmark.allocs_start) / frames);
+   else
+      printf("Allocations: n/a (no allocation counter preloaded)\n");
+   if (frames)
+      printf("Draw calls:  %.2f per frame (%.2f quads batched)\n",
+            (double)runloop_benchmark.draw_calls / frames,
+            (double)runloop_benchmark.batched_quads / frames);
+#if defined(__linux__) || defined(__APPLE__)
+   {
+      struct rusage usage;
+      if (getrusage(RUSAGE_SELF, &usage) == 0)
+#ifdef __APPLE__
+         printf("Peak RSS:    %.2f MiB\n",
+               usage.ru_maxrss / (1024.0 * 1024.0));
+#else
+         printf("Peak RSS:    %.2f MiB\n", usage.ru_maxrss / 1024.0);
+#endif
+   }
+#endif
+
+   if (perf_spans_get_stats(span_stats, runloop_benchmark.start))
+   {
+      printf("Frame spans (p50 / p95 / p99):\n");
+      for (i = 0; i < PERF_SPAN_LAST; i++)
+         if (span_stats[i].count)
+            printf("  %-12s %8.3f / %8.3f / %8.3f ms (%u)\n",
+                  perf_span_name((enum perf_span_type)i),
+                  span_stats[i].p50 / 1000.0,
+                  span_stats[i].p95 / 1000.0,
+                  span_stats[i].p99 / 1000.0,
+                  span_stats[i].count);
+   }
+
+   if (num_counters)
+   {
+      printf("Core performance counters (average ticks, calls):\n");
+      for (i = 0; i < num_counters; i++)
+         if (counters[i]->call_cnt)
+            printf("  %-24s %" PRIu64 " %" PRIu64 "\n",
+                  counters[i]->ident,
+                  (uint64_t)(counters[i]->total / counters[i]->call_cnt),
+                  (uint64_t)counters[i]->call_cnt);
+   }
+
+   printf("=================================================\n");
+   fflush(stdout);
+}
+
 /**
  * main_exit:
  *
@@ -10061,9 +10389,16 @@ static void global_free(void)
  **/
 void main_exit(void *args)
 {
+   char trace_path[PATH_MAX_LENGTH];
    settings_t *settings     = configuration_settings;
    bool config_save_on_exit = settings->bools.config_save_on_exit;
 
+   trace_path[0]            = '\0';
+
+   if (runloop_perfcnt_enable)
+      fill_pathname_join(trace_path, settings->paths.log_dir,
+            "retroarch_trace.json", sizeof(trace_path));
+
    if (cached_video_driver[0])
    {
       configuration_set_string(settings, 
@@ -10085,11 +10420,20 @@ void main_exit(void *args)
    /* Do not want menu context to live any more. */
    menu_driver_ctl(RARCH_MENU_CTL_UNSET_OWN_DRIVER, NULL);
 #endif
+   if (runloop_benchmark.enable)
+      retroarch_benchmark_report();
+
    rarch_ctl(RARCH_CTL_MAIN_DEINIT, NULL);
 
    if (runloop_perfcnt_enable)
+   {
       rarch_perf_log();
 
+      if (perf_spans_export(trace_path))
+         RARCH_LOG("[PERF]: Frame trace written to \"%s\".\n", trace_path);
+   }
+   perf_spans_deinit();
+
 #if defined(HAVE_LOGGER) && !defined(ANDROID)
    logger_shutdown();
 #endif
@@ -15802,12 +16146,7 @@ float input_sensor_get_input(unsigned port, unsigned id)
    return 0.0f;
 }
 
-/**
- * input_poll:
- *
- * Input polling callback function.
- **/
-static void input_driver_poll(void)
+static void input_driver_poll_internal(void)
 {
    size_t i;
    rarch_joypad_info_t joypad_info[MAX_USERS];
@@ -15991,6 +16330,18 @@ static void input_driver_poll(void)
 #endif
 }
 
+/**
+ * input_poll:
+ *
+ * Input polling callback function.
+ **/
+static void input_driver_poll(void)
+{
+   retro_time_t span_start = perf_span_begin();
+   input_driver_poll_internal();
+   perf_span_end(PERF_SPAN_INPUT_POLL, span_start);
+}
+
 static int16_t input_state_device(
       int16_t ret,
       unsigned port, unsigned device,
@@ -18165,6 +18516,12 @@ static bool input_driver_find_driver(void)
    driver_ctx_info_t drv;
    settings_t *settings = configuration_settings;
 
+   if (runloop_benchmark.enable)
+   {
+      current_input     = &input_benchmark;
+      return true;
+   }
+
    drv.label            = "input_driver";
    drv.s                = settings->arrays.input_driver;
 
@@ -20847,6 +21204,12 @@ static bool audio_driver_find_driver(void)
    driver_ctx_info_t drv;
    settings_t *settings    = configuration_settings;
 
+   if (runloop_benchmark.enable)
+   {
+      current_audio        = &audio_benchmark;
+      return true;
+   }
+
    drv.label = "audio_driver";
    drv.s     = settings->arrays.audio_driver;
 
@@ -21080,6 +21443,7 @@ static void audio_driver_flush(const int16_t *data, size_t samples,
    float slowmotion_ratio            = configuration_settings->floats.slowmotion_ratio;
    float audio_volume_gain           = !audio_driver_mute_enable ?
       audio_driver_volume_gain : 0.0f;
+   retro_time_t span_start           = perf_span_begin();
 
    src_data.data_out                 = NULL;
    src_data.output_frames            = 0;
@@ -21180,6 +21544,8 @@ static void audio_driver_flush(const int16_t *data, size_t samples,
                output_data, output_frames * 2) < 0)
          audio_driver_active = false;
    }
+
+   perf_span_end(PERF_SPAN_AUDIO_FLUSH, span_start);
 }
 
 /**
@@ -22816,6 +23182,33 @@ static void video_driver_set_viewport_square_pixel(void)
    aspectratio_lut[ASPECT_RATIO_SQUARE].value = (float)aspect_x / aspect_y;
 }
 
+/* Directory for compiled shaders and driver pipeline caches,
+ * under the cache directory or else next to the config file.
+ * Sets 's' to an empty string when neither is known. */
+void video_driver_get_shader_cache_dir(char *s, size_t len,
+      const char *subdir)
+{
+   char cache_dir[PATH_MAX_LENGTH];
+   settings_t *settings = configuration_settings;
+
+   cache_dir[0] = '\0';
+   *s           = '\0';
+
+   if (settings && !string_is_empty(settings->paths.directory_cache))
+      strlcpy(cache_dir, settings->paths.directory_cache,
+            sizeof(cache_dir));
+   else if (!path_is_empty(RARCH_PATH_CONFIG))
+   {
+      fill_pathname_basedir(cache_dir, path_get(RARCH_PATH_CONFIG),
+            sizeof(cache_dir));
+      fill_pathname_join(cache_dir, cache_dir, "cache",
+            sizeof(cache_dir));
+   }
+
+   if (!string_is_empty(cache_dir))
+      fill_pathname_join(s, cache_dir, subdir, len);
+}
+
 static bool video_driver_init_internal(bool *video_is_threaded)
 {
    video_info_t video;
@@ -22830,6 +23223,15 @@ static bool video_driver_init_internal(bool *video_is_threaded)
    if (!string_is_empty(path_softfilter_plugin))
       video_driver_init_filter(video_driver_pix_fmt);
 
+#ifdef HAVE_SLANG
+   {
+      char spirv_cache_dir[PATH_MAX_LENGTH];
+      video_driver_get_shader_cache_dir(spirv_cache_dir,
+            sizeof(spirv_cache_dir), "slang");
+      glslang_set_spirv_cache_dir(spirv_cache_dir);
+   }
+#endif
+
    max_dim   = MAX(geom->max_width, geom->max_height);
    scale     = next_pow2(max_dim) / RARCH_SCALE_BASE;
    scale     = MAX(scale, 1);
@@ -23832,6 +24234,11 @@ void video_driver_reinit(int flags)
    video_driver_cache_context_ack = false;
    video_driver_reinit_context(flags);
    video_driver_cache_context = false;
+
+#ifdef HAVE_MENU
+   /* The new context has nothing onscreen yet */
+   gfx_display_request_redraw();
+#endif
 }
 
 bool video_driver_is_hw_context(void)
@@ -23986,6 +24393,10 @@ static void video_driver_frame(const void *data, unsigned width,
    static retro_time_t curr_time;
    static retro_time_t fps_time;
    static float last_fps, frame_time;
+   static unsigned last_fps_text_flags;
+   unsigned fps_text_flags;
+   bool fps_text_show;
+   bool fps_text_changed = false;
    retro_time_t new_time = cpu_features_get_time_usec();
 #if defined(HAVE_GFX_WIDGETS)
    bool widgets_active   = gfx_widgets_active();
@@ -24017,10 +24428,16 @@ static void video_driver_frame(const void *data, unsigned width,
 
    video_driver_build_info(&video_info);
 
+   fps_text_flags = (video_info.fps_show        ? 1 : 0)
+                  | (video_info.framecount_show ? 2 : 0)
+                  | (video_info.memory_show     ? 4 : 0);
+   fps_text_show  = fps_text_flags != 0;
+
    /* Get the amount of frames per seconds. */
    if (video_driver_frame_count)
    {
-      size_t buf_pos       = 1; /* set this to 1 to avoid an offset issue */
+      bool fps_update      = (video_driver_frame_count
+            % video_info.fps_update_interval) == 0;
       unsigned write_index                         =
          video_driver_frame_time_count++ &
          (MEASURE_FRAME_TIME_SAMPLES_COUNT - 1);
@@ -24028,55 +24445,79 @@ static void video_driver_frame(const void *data, unsigned width,
       video_driver_frame_time_samples[write_index] = frame_time;
       fps_time                                     = new_time;
 
-      if (video_info.fps_show)
-         buf_pos = snprintf(
-               video_info.fps_text, sizeof(video_info.fps_text),
-               "FPS: %6.2f", last_fps);
-
-      if (video_info.framecount_show)
+      if (fps_update)
       {
-         char frames_text[64];
-         if (video_info.fps_text[buf_pos-1] != '\0')
-            strlcat(video_info.fps_text, " || ", sizeof(video_info.fps_text));
-         snprintf(frames_text,
-               sizeof(frames_text),
-               "%s: %" PRIu64, msg_hash_to_str(MSG_FRAMES),
-               (uint64_t)video_driver_frame_count);
-         buf_pos = strlcat(video_info.fps_text, frames_text, sizeof(video_info.fps_text));
+         last_fps  = TIME_TO_FPS(curr_time, new_time,
+               video_info.fps_update_interval);
+         curr_time = new_time;
       }
 
-      if (video_info.memory_show)
+      /* Memory use is sampled once per update, and
+       * as soon as it is shown */
+      if (     video_info.memory_show
+            && (fps_update || !(last_fps_text_flags & 4)))
       {
-         char mem[128];
          uint64_t mem_bytes_used  = frontend_driver_get_free_memory();
          uint64_t mem_bytes_total = frontend_driver_get_total_memory();
 
-         mem[0] = '\0';
-         snprintf(
-               mem, sizeof(mem), "MEM: %.2f/%.2fMB", mem_bytes_used / (1024.0f * 1024.0f),
+         snprintf(video_driver_mem_text, sizeof(video_driver_mem_text),
+               "MEM: %.2f/%.2fMB", mem_bytes_used / (1024.0f * 1024.0f),
                mem_bytes_total / (1024.0f * 1024.0f));
-         if (video_info.fps_text[buf_pos-1] != '\0')
-            strlcat(video_info.fps_text, " || ", sizeof(video_info.fps_text));
-         strlcat(video_info.fps_text, mem, sizeof(video_info.fps_text));
       }
 
-      if ((video_driver_frame_count % video_info.fps_update_interval) == 0)
+      /* The frame count changes every frame, the
+       * other values only on an update */
+      if (fps_text_show && (fps_update || video_info.framecount_show
+               || fps_text_flags != last_fps_text_flags))
       {
-         last_fps = TIME_TO_FPS(curr_time, new_time,
-               video_info.fps_update_interval);
+         size_t buf_pos           = 0;
+
+         video_driver_fps_text[0] = '\0';
+
+         if (video_info.fps_show)
+            buf_pos = snprintf(
+                  video_driver_fps_text, sizeof(video_driver_fps_text),
+                  "FPS: %6.2f", last_fps);
 
+         if (video_info.framecount_show)
+         {
+            char frames_text[64];
+            if (buf_pos)
+               strlcat(video_driver_fps_text, " || ",
+                     sizeof(video_driver_fps_text));
+            snprintf(frames_text,
+                  sizeof(frames_text),
+                  "%s: %" PRIu64, msg_hash_to_str(MSG_FRAMES),
+                  (uint64_t)video_driver_frame_count);
+            buf_pos = strlcat(video_driver_fps_text, frames_text,
+                  sizeof(video_driver_fps_text));
+         }
+
+         if (video_info.memory_show)
+         {
+            if (buf_pos)
+               strlcat(video_driver_fps_text, " || ",
+                     sizeof(video_driver_fps_text));
+            strlcat(video_driver_fps_text, video_driver_mem_text,
+                  sizeof(video_driver_fps_text));
+         }
+
+         fps_text_changed = true;
+      }
+
+      if (fps_update)
+      {
          strlcpy(video_driver_window_title,
                video_driver_title_buf, sizeof(video_driver_window_title));
 
-         if (!string_is_empty(video_info.fps_text))
+         if (fps_text_show && !string_is_empty(video_driver_fps_text))
          {
             strlcat(video_driver_window_title,
                   " || ", sizeof(video_driver_window_title));
             strlcat(video_driver_window_title,
-                  video_info.fps_text, sizeof(video_driver_window_title));
+                  video_driver_fps_text, sizeof(video_driver_window_title));
          }
 
-         curr_time                        = new_time;
          video_driver_window_title_update = true;
       }
    }
@@ -24088,11 +24529,14 @@ static void video_driver_frame(const void *data, unsigned width,
             video_driver_title_buf,
             sizeof(video_driver_window_title));
 
+      video_driver_fps_text[0] = '\0';
+      video_driver_mem_text[0] = '\0';
       if (video_info.fps_show)
-         strlcpy(video_info.fps_text,
+         strlcpy(video_driver_fps_text,
                msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NOT_AVAILABLE),
-               sizeof(video_info.fps_text));
+               sizeof(video_driver_fps_text));
 
+      fps_text_changed                 = true;
       video_driver_window_title_update = true;
    }
 
@@ -24144,7 +24588,28 @@ static void video_driver_frame(const void *data, unsigned width,
 
    video_driver_msg[0] = '\0';
 
-   if (runloop_msg_queue_size > 0)
+#if defined(HAVE_GFX_WIDGETS)
+   if (fps_text_show && !widgets_active)
+#else
+   if (fps_text_show)
+#endif
+   {
+      /* The FPS text is shown in place of regular OSD
+       * messages, which used to be flushed every frame
+       * by queueing it */
+      if (runloop_msg_queue_size > 0)
+      {
+         runloop_msg_queue_lock();
+         msg_queue_clear(runloop_msg_queue);
+         runloop_msg_queue_size = 0;
+         runloop_msg_queue_unlock();
+      }
+
+      if (video_info.font_enable)
+         strlcpy(video_driver_msg, video_driver_fps_text,
+               sizeof(video_driver_msg));
+   }
+   else if (runloop_msg_queue_size > 0)
    {
       /* If widgets are currently enabled, then
        * messages were pushed to the queue before
@@ -24197,8 +24662,12 @@ static void video_driver_frame(const void *data, unsigned width,
       }
    }
 
+   perf_spans_set_enable(video_info.statistics_show
+         || runloop_perfcnt_enable);
+
    if (video_info.statistics_show)
    {
+      struct perf_span_stats span_stats[PERF_SPAN_LAST];
       audio_statistics_t audio_stats         = {0.0f};
       double stddev                          = 0.0;
       struct retro_system_av_info *av_info   = &video_driver_av_info;
@@ -24248,6 +24717,29 @@ static void video_driver_frame(const void *data, unsigned width,
             av_info->timing.fps,
             av_info->timing.sample_rate);
 
+      /* Percentiles over the last two seconds */
+      if (perf_spans_get_stats(span_stats, new_time - 2000000))
+      {
+         unsigned i;
+         size_t len = strlcat(video_info.stat_text,
+               "Frame Spans (p50 / p95 / p99):\n",
+               sizeof(video_info.stat_text));
+
+         for (i = 0; i < PERF_SPAN_LAST; i++)
+         {
+            if (!span_stats[i].count || len >= sizeof(video_info.stat_text))
+               continue;
+
+            len += snprintf(video_info.stat_text + len,
+                  sizeof(video_info.stat_text) - len,
+                  " -%s: %.2f / %.2f / %.2f ms\n",
+                  perf_span_name((enum perf_span_type)i),
+                  span_stats[i].p50 / 1000.0f,
+                  span_stats[i].p95 / 1000.0f,
+                  span_stats[i].p99 / 1000.0f);
+         }
+      }
+
       /* TODO/FIXME - add OSD chat text here */
 #if 0
       snprintf(video_info.chat_text, sizeof(video_info.chat_text),
@@ -24256,28 +24748,22 @@ static void video_driver_frame(const void *data, unsigned width,
    }
 
    if (current_video && current_video->frame)
+   {
+      retro_time_t span_start = perf_span_begin();
       video_driver_active = current_video->frame(
             video_driver_data, data, width, height,
             video_driver_frame_count,
             (unsigned)pitch, video_driver_msg, &video_info);
+      perf_span_end(PERF_SPAN_VIDEO_FRAME, span_start);
+   }
 
    video_driver_frame_count++;
 
-   /* Display the FPS, with a higher priority. */
-   if (     video_info.fps_show
-         || video_info.framecount_show
-         || video_info.memory_show
-         )
-   {
 #if defined(HAVE_GFX_WIDGETS)
-      if (widgets_active)
-         gfx_widgets_set_fps_text(video_info.fps_text);
-      else
+   if (fps_text_changed && widgets_active)
+      gfx_widgets_set_fps_text(video_driver_fps_text);
 #endif
-      {
-         runloop_msg_queue_push(video_info.fps_text, 2, 1, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
-      }
-   }
+   last_fps_text_flags = fps_text_flags;
 
    /* trigger set resolution*/
    if (video_info.crt_switch_resolution)
@@ -24443,8 +24929,6 @@ void video_driver_build_info(video_frame_info_t *video_info)
    video_info->custom_vp_full_width  = custom_vp->full_width;
    video_info->custom_vp_full_height = custom_vp->full_height;
 
-   video_info->fps_text[0]           = '\0';
-
 #if defined(HAVE_GFX_WIDGETS)
    video_info->widgets_is_paused          = gfx_widgets_paused;
    video_info->widgets_is_fast_forwarding = gfx_widgets_fast_forward;
@@ -26973,6 +27457,10 @@ static void retroarch_print_help(const char *arg0)
             "                        Takes a screenshot at the end of max-frames.\n", sizeof(buf));
       strlcat(buf, "      --max-frames-ss-path=FILE\n"
             "                        Path to save the screenshot to at the end of max-frames.\n", sizeof(buf));
+      strlcat(buf, "      --benchmark=NUMBER\n"
+            "                        Runs the specified number of frames as fast as possible\n"
+            "                        with no display, audio or input device, then prints\n"
+            "                        timings. Combine with --bsvplay to replay input.\n", sizeof(buf));
       puts(buf);
    }
    printf("      --accessibility\n"
@@ -27067,6 +27555,7 @@ static void retroarch_parse_input_and_config(int argc, char *argv[])
       { "version",            0, NULL, RA_OPT_VERSION },
       { "log-file",           1, NULL, RA_OPT_LOG_FILE },
       { "accessibility",      0, NULL, RA_OPT_ACCESSIBILITY},
+      { "benchmark",          1, NULL, RA_OPT_BENCHMARK },
       { NULL, 0, NULL, 0 }
    };
 
@@ -27543,6 +28032,43 @@ static void retroarch_parse_input_and_config(int argc, char *argv[])
                strlcpy(runloop_max_frames_screenshot_path, optarg, sizeof(runloop_max_frames_screenshot_path));
                break;
 
+            case RA_OPT_BENCHMARK:
+               {
+                  settings_t *settings     = configuration_settings;
+
+                  runloop_max_frames       = (unsigned)strtoul(optarg, NULL, 10);
+                  runloop_perfcnt_enable   = true;
+                  runloop_benchmark.enable = true;
+
+                  /* The overrides below only hold for this run,
+                   * nothing may save them to a config file */
+                  rarch_ctl(RARCH_CTL_SET_BLOCK_CONFIG_WRITE, NULL);
+
+                  /* Measure the frontend only: no display, audio or
+                   * input device, and nothing that paces or delays
+                   * frames. The audio and input drivers are replaced
+                   * when they are looked up. */
+                  configuration_set_string(settings,
+                        settings->arrays.video_driver, "null");
+                  configuration_set_bool(settings,
+                        settings->bools.video_vsync, false);
+                  configuration_set_bool(settings,
+                        settings->bools.video_threaded, false);
+                  configuration_set_bool(settings,
+                        settings->bools.audio_sync, false);
+                  configuration_set_bool(settings,
+                        settings->bools.vrr_runloop_enable, false);
+                  configuration_set_float(settings,
+                        settings->floats.fastforward_ratio, 0.0f);
+                  configuration_set_uint(settings,
+                        settings->uints.video_frame_delay, 0);
+#ifdef HAVE_MENU
+                  configuration_set_bool(settings,
+                        settings->bools.menu_throttle_framerate, false);
+#endif
+               }
+               break;
+
             case RA_OPT_SUBSYSTEM:
                path_set(RARCH_PATH_SUBSYSTEM, optarg);
                break;
@@ -28468,6 +28994,11 @@ bool rarch_ctl(enum rarch_ctl_state state, void *data)
          rarch_block_config_read = false;
          break;
 #endif
+      case RARCH_CTL_SET_BLOCK_CONFIG_WRITE:
+         rarch_block_config_write = true;
+         break;
+      case RARCH_CTL_IS_BLOCK_CONFIG_WRITE:
+         return rarch_block_config_write;
       case RARCH_CTL_GET_CORE_OPTION_SIZE:
          {
             unsigned *idx = (unsigned*)data;
@@ -29141,6 +29672,11 @@ void runloop_msg_queue_push(const char *msg,
       runloop_msg_queue_size = msg_queue_size(runloop_msg_queue);
    }
 
+#ifdef HAVE_MENU
+   /* Show the message now, even if the menu is idle */
+   gfx_display_request_redraw();
+#endif
+
    ui_companion_driver_msg_queue_push(msg,
          prio, duration, flush);
 
@@ -29334,6 +29870,87 @@ static bool menu_display_libretro(retro_time_t current_time)
    video_driver_cached_frame();
    return true;
 }
+
+/* Idle menus are still redrawn at this interval (in us),
+ * so that the clock and battery status stay current */
+#define MENU_IDLE_REDRAW_INTERVAL 500000
+
+/* Returns true if drawing the menu can be skipped this
+ * frame, because nothing onscreen can have changed since
+ * the last frame that was drawn. 'active' is true if the
+ * caller already knows of input or animations. */
+static bool menu_driver_is_idle_frame(
+      settings_t *settings, menu_handle_t *menu_data,
+      bool active, retro_time_t current_time)
+{
+   static retro_time_t last_redraw_time = 0;
+   static bool was_active               = true;
+   static unsigned last_width           = 0;
+   static unsigned last_height          = 0;
+   static bool last_focused             = false;
+   static menu_input_pointer_hw_state_t last_pointer;
+   bool focused                         = video_has_focus();
+   menu_input_pointer_hw_state_t *pointer = &menu_input_pointer_hw_state;
+   bool ticker_scrolled                 = gfx_animation_ticker_scrolled();
+   bool redraw_requested                = gfx_display_take_redraw_request();
+
+   if (     (pointer->active         != last_pointer.active)
+         || (pointer->x              != last_pointer.x)
+         || (pointer->y              != last_pointer.y)
+         || (pointer->select_pressed != last_pointer.select_pressed)
+         || (pointer->cancel_pressed != last_pointer.cancel_pressed)
+         || (pointer->up_pressed     != last_pointer.up_pressed)
+         || (pointer->down_pressed   != last_pointer.down_pressed)
+         || (pointer->left_pressed   != last_pointer.left_pressed)
+         || (pointer->right_pressed  != last_pointer.right_pressed))
+   {
+      last_pointer = *pointer;
+      active       = true;
+   }
+
+   /* Window events are polled every frame by the video
+    * driver's alive() callback - redraw as soon as the
+    * window is resized or gains/loses focus */
+   if (     (video_driver_width  != last_width)
+         || (video_driver_height != last_height)
+         || (focused             != last_focused))
+   {
+      last_width   = video_driver_width;
+      last_height  = video_driver_height;
+      last_focused = focused;
+      active       = true;
+   }
+
+   active = active
+      || ticker_scrolled
+      || redraw_requested
+      || !settings->bools.menu_skip_idle_frames
+      || !menu_data
+      || BIT64_GET(menu_data->state, MENU_STATE_RENDER_MESSAGEBOX)
+      || menu_input_dialog_get_display_kb()
+      || (runloop_msg_queue_size > 0)
+      || menu_display_libretro_running()
+      || (runloop_max_frames != 0)
+      || video_driver_is_threaded_internal()
+      || recording_data
+      || settings->bools.audio_enable_menu
+      || settings->bools.video_fps_show
+      || settings->bools.video_framecount_show
+      || settings->bools.video_memory_show
+      || settings->bools.video_statistics_show
+      || ((current_time - last_redraw_time) >= MENU_IDLE_REDRAW_INTERVAL);
+
+   /* Always draw one more frame after activity stops,
+    * so that the final state of any animation is shown */
+   if (active || was_active)
+   {
+      was_active       = active;
+      last_redraw_time = current_time;
+      return false;
+   }
+
+   return true;
+}
 #endif
 
 static void update_savestate_slot(void)
@@ -29402,6 +30019,9 @@ static enum runloop_state runloop_check_state(retro_time_t current_time)
    bool menu_is_alive                  = menu_driver_alive;
    bool display_kb                     = menu_input_dialog_get_display_kb();
 #endif
+#if defined(HAVE_MENU) || defined(HAVE_GFX_WIDGETS)
+   bool animation_active               = false;
+#endif
 #if defined(HAVE_GFX_WIDGETS)
    bool widgets_active                 = gfx_widgets_active();
 #endif
@@ -29702,12 +30322,18 @@ static enum runloop_state runloop_check_state(retro_time_t current_time)
    }
 
 #if defined(HAVE_MENU) || defined(HAVE_GFX_WIDGETS)
-   gfx_animation_update(
+   animation_active = gfx_animation_update(
          current_time,
          settings->bools.menu_timedate_enable,
          settings->floats.menu_ticker_speed,
          video_driver_width, video_driver_height);
 
+#ifdef HAVE_MENU
+   /* Upload any thumbnails decoded since the last frame */
+   if (menu_driver_alive)
+      gfx_thumbnail_update(menu_navigation_get_selection());
+#endif
+
 #if defined(HAVE_GFX_WIDGETS)
    if (widgets_active)
    {
@@ -29732,6 +30358,8 @@ static enum runloop_state runloop_check_state(retro_time_t current_time)
       static enum menu_action
          old_action              = MENU_ACTION_CANCEL;
       bool focused               = false;
+      bool needs_refresh         = false;
+      bool skip_frame            = false;
       input_bits_t trigger_input = current_bits;
       global_t *global           = &g_extern;
 
@@ -29788,10 +30416,23 @@ static enum runloop_state runloop_check_state(retro_time_t current_time)
          }
       }
 
+      needs_refresh             = menu_entries_ctl(
+            MENU_ENTRIES_CTL_NEEDS_REFRESH, NULL);
+
       if (!menu_driver_iterate(&iter, current_time))
          retroarch_menu_running_finished(false);
 
-      if (focused || !runloop_idle)
+      /* Skip drawing while nothing onscreen changes */
+      skip_frame                = menu_driver_is_idle_frame(
+            settings, menu_driver_get_ptr(),
+               (action != MENU_ACTION_NOOP)
+            || needs_refresh
+            || animation_active
+            || bits_any_set(current_bits.data,
+                  ARRAY_SIZE(current_bits.data)),
+            current_time);
+
+      if ((focused || !runloop_idle) && !skip_frame)
       {
          bool libretro_running    = menu_display_libretro_running();
          menu_handle_t *menu_data = menu_driver_get_ptr();
@@ -29847,7 +30488,7 @@ static enum runloop_state runloop_check_state(retro_time_t current_time)
       old_input                 = current_bits;
       old_action                = action;
 
-      if (!focused || runloop_idle)
+      if (!focused || runloop_idle || skip_frame)
          return RUNLOOP_STATE_POLLED_AND_SLEEP;
    }
    else
@@ -29915,6 +30556,11 @@ static enum runloop_state runloop_check_state(retro_time_t current_time)
 
    if (menu_driver_alive)
    {
+      /* No core frame runs while the menu is up,
+       * so count the menu frame instead */
+      if (runloop_benchmark.enable)
+         retroarch_benchmark_tick();
+
       if (!settings->bools.menu_throttle_framerate && !fastforward_ratio)
          return RUNLOOP_STATE_MENU_ITERATE;
 
@@ -30252,6 +30898,11 @@ static enum runloop_state runloop_check_state(retro_time_t current_time)
          {
             rarch_timer_end(&timer);
             need_to_apply = false;
+#ifdef HAVE_MENU
+            /* Sources changed, the shader has to be rebuilt
+             * even if only parameters changed in the menu */
+            menu_shader_manager_clear_applied();
+#endif
             command_event(CMD_EVENT_SHADERS_APPLY_CHANGES, NULL);
          }
       }
@@ -30428,6 +31079,9 @@ int runloop_iterate(void)
     * core_run() or run_ahead() */
    libretro_core_runtime_usec += rarch_core_runtime_tick(current_time);
 
+   if (runloop_benchmark.enable)
+      retroarch_benchmark_tick();
+
 #ifdef HAVE_CHEEVOS
    if (  settings->bools.cheevos_enable &&
          rcheevos_loaded                &&
@@ -30522,7 +31176,8 @@ end:
 
       if (to_sleep_ms > 0)
       {
-         unsigned sleep_ms = (unsigned)to_sleep_ms;
+         unsigned sleep_ms       = (unsigned)to_sleep_ms;
+         retro_time_t span_start = perf_span_begin();
          /* Combat jitter a bit. */
          frame_limit_last_time += frame_limit_minimum_time;
          if (sleep_ms > 0)
@@ -30530,6 +31185,7 @@ end:
             if (!main_ui_companion_is_on_foreground)
 #endif
                retro_sleep(sleep_ms);
+         perf_span_end(PERF_SPAN_SYNC_WAIT, span_start);
          return 1;
       }
    }
@@ -30977,6 +31633,7 @@ bool core_run(void)
       : current_core.poll_type;
    bool early_polling     = new_poll_type == POLL_TYPE_EARLY;
    bool late_polling      = new_poll_type == POLL_TYPE_LATE;
+   retro_time_t span_start;
 #ifdef HAVE_NETWORKING
    bool netplay_preframe = netplay_driver_ctl_internal(
          RARCH_NETPLAY_CTL_PRE_FRAME, NULL);
@@ -30996,7 +31653,9 @@ bool core_run(void)
    else if (late_polling)
       current_core.input_polled = false;
 
+   span_start = perf_span_begin();
    current_core.retro_run();
+   perf_span_end(PERF_SPAN_CORE_RUN, span_start);
 
    if (late_polling && !current_core.input_polled)
       input_driver_poll();
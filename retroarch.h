@@ -106,6 +106,10 @@ enum rarch_ctl_state
    RARCH_CTL_UNSET_BLOCK_CONFIG_READ,
 #endif
 
+   /* Block config write */
+   RARCH_CTL_SET_BLOCK_CONFIG_WRITE,
+   RARCH_CTL_IS_BLOCK_CONFIG_WRITE,
+
    /* Username */
    RARCH_CTL_HAS_SET_USERNAME,
 
@@ -311,6 +315,9 @@ void retroarch_set_current_core_type(
 bool retroarch_apply_shader(enum rarch_shader_type type, const char *preset_path,
       bool message);
 
+bool retroarch_apply_shader_parameters(
+      const struct video_shader *shader, const char *preset_path);
+
 const char* retroarch_get_shader_preset(void);
 
 bool retroarch_is_switching_display_mode(void);
@@ -1162,8 +1169,7 @@ typedef struct video_frame_info
    float font_msg_color_b;
    float xmb_alpha_factor;
 
-   char fps_text[128];
-   char stat_text[512];
+   char stat_text[1024];
    char chat_text[256];
 
    uint64_t frame_count;
@@ -1511,6 +1517,9 @@ extern struct aspect_ratio_elem aspectratio_lut[ASPECT_RATIO_END];
 
 bool video_driver_has_windowed(void);
 
+void video_driver_get_shader_cache_dir(char *s, size_t len,
+      const char *subdir);
+
 bool video_driver_has_focus(void);
 
 bool video_driver_cached_frame_has_valid_framebuffer(void);
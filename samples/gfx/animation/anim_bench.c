@@ -0,0 +1,132 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Stress test for the menu animation engine.
+ *
+ * Keeps a large number of tweens running at once,
+ * with a mix of easing types, and every frame kills
+ * and restarts a fraction of them by tag - as menu
+ * drivers do for each entry while scrolling through
+ * a long list.
+ *
+ * Usage: anim_bench [tweens] [frames] */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <features/features_cpu.h>
+
+#include "../../../gfx/gfx_animation.h"
+#include "../../../gfx/font_driver.h"
+
+/* Number of tweens restarted per frame,
+ * as a fraction of the total */
+#define BENCH_RESTART_DIV 8
+
+/* The ticker functions reference the font driver,
+ * which is not used here */
+int font_driver_get_message_width(void *font_data,
+      const char *msg, unsigned len, float scale)
+{
+   return 0;
+}
+
+int font_driver_get_line_height(void *font_data, float scale)
+{
+   return 0;
+}
+
+static unsigned bench_callbacks;
+
+static void bench_cb(void *userdata)
+{
+   bench_callbacks++;
+}
+
+static void bench_push(float *subjects, unsigned i, unsigned frame)
+{
+   gfx_animation_ctx_entry_t entry;
+
+   entry.easing_enum  = (enum gfx_animation_easing_type)
+      ((i + frame) % EASING_LAST);
+   entry.tag          = (uintptr_t)&subjects[i];
+   entry.duration     = 100.0f + (float)(i % 7) * 50.0f;
+   entry.target_value = (subjects[i] < 0.5f) ? 1.0f : 0.0f;
+   entry.subject      = &subjects[i];
+   entry.cb           = (i & 1) ? bench_cb : NULL;
+   entry.userdata     = NULL;
+
+   gfx_animation_push(&entry);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, frame;
+   retro_time_t start;
+   retro_time_t update_time  = 0;
+   retro_time_t restart_time = 0;
+   retro_time_t now          = 1;
+   double checksum           = 0.0;
+   unsigned tweens           = (argc > 1) ? (unsigned)atoi(argv[1]) : 4096;
+   unsigned frames           = (argc > 2) ? (unsigned)atoi(argv[2]) : 1000;
+   unsigned restart          = tweens / BENCH_RESTART_DIV;
+   float *subjects           = (float*)calloc(tweens, sizeof(float));
+
+   if (!subjects || !tweens)
+      return 1;
+
+   for (i = 0; i < tweens; i++)
+      bench_push(subjects, i, 0);
+
+   for (frame = 0; frame < frames; frame++)
+   {
+      /* Restart a moving window of tweens, as a
+       * scrolling menu does for its visible entries */
+      start = cpu_features_get_time_usec();
+      for (i = 0; i < restart; i++)
+      {
+         unsigned idx            = (frame * restart + i) % tweens;
+         gfx_animation_ctx_tag tag = (uintptr_t)&subjects[idx];
+
+         gfx_animation_kill_by_tag(&tag);
+         bench_push(subjects, idx, frame);
+      }
+      restart_time += cpu_features_get_time_usec() - start;
+
+      /* Fixed 60 Hz frame time, so that results
+       * do not depend on timing */
+      now  += 16667;
+      start = cpu_features_get_time_usec();
+      gfx_animation_update(now, false, 1.0f, 1920, 1080);
+      update_time += cpu_features_get_time_usec() - start;
+   }
+
+   for (i = 0; i < tweens; i++)
+      checksum += subjects[i];
+
+   printf("%u tweens, %u restarted per frame, %u frames\n",
+         tweens, restart, frames);
+   printf("restart (kill + push): %8.2f us/frame\n",
+         (double)restart_time / frames);
+   printf("update:                %8.2f us/frame\n",
+         (double)update_time / frames);
+   printf("callbacks: %u\n", bench_callbacks);
+   printf("checksum: %f\n", checksum);
+
+   gfx_animation_ctl(MENU_ANIMATION_CTL_DEINIT, NULL);
+   free(subjects);
+
+   return 0;
+}
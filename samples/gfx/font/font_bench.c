@@ -0,0 +1,206 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Measures the CPU cost of laying out a synthetic
+ * menu frame with the stb_unicode font renderer:
+ * label measurement with and without the message
+ * width cache, quad generation, and glyph atlas
+ * eviction when more glyphs are used than fit
+ * in the atlas.
+ *
+ * Usage: font_bench [font.ttf] [frames] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <compat/strl.h>
+#include <encodings/utf.h>
+#include <features/features_cpu.h>
+
+#include "../../../gfx/font_driver.h"
+#include "../../../gfx/font_width_cache.h"
+
+#define BENCH_LABELS     256
+#define BENCH_FONT_SIZE  24.0f
+#define BENCH_MAX_QUADS  (BENCH_LABELS * 64)
+
+extern font_renderer_driver_t stb_unicode_font_renderer;
+
+static const char *bench_words[] = {
+   "Super", "Mega", "Street", "Fighter", "Kart", "Quest", "Légende",
+   "Donkey", "Sonic", "Zelda", "Château", "Tetris", "Metroid", "Ñandú",
+   "(USA)", "(Europe)", "(Japan)", "[!]", "Rev 1", "Über", "ファミコン"
+};
+
+static float bench_vertices[BENCH_MAX_QUADS * 4 * 2];
+
+/* Same as the 'get_message_width' implementation
+ * of the GL font driver */
+static int bench_measure(void *font, const char *msg, unsigned len)
+{
+   const char *msg_end = msg + len;
+   int delta_x         = 0;
+
+   while (msg < msg_end)
+   {
+      unsigned code                  = utf8_walk(&msg);
+      const struct font_glyph *glyph =
+         stb_unicode_font_renderer.get_glyph(font, code);
+
+      if (!glyph)
+         glyph = stb_unicode_font_renderer.get_glyph(font, '?');
+      if (!glyph)
+         continue;
+
+      delta_x += glyph->advance_x;
+   }
+
+   return delta_x;
+}
+
+/* Generates one quad per glyph, as the
+ * render_line() functions of the font drivers do */
+static unsigned bench_emit(void *font, const char *msg,
+      int x, int y, unsigned quads)
+{
+   while (*msg && quads < BENCH_MAX_QUADS)
+   {
+      unsigned code                  = utf8_walk(&msg);
+      const struct font_glyph *glyph =
+         stb_unicode_font_renderer.get_glyph(font, code);
+      float *v                       = NULL;
+      int x0, y0;
+
+      if (!glyph)
+         continue;
+
+      x0   = x + glyph->draw_offset_x;
+      y0   = y + glyph->draw_offset_y;
+      v    = &bench_vertices[quads * 8];
+      v[0] = x0;                 v[1] = y0;
+      v[2] = x0 + glyph->width;  v[3] = y0;
+      v[4] = x0;                 v[5] = y0 + glyph->height;
+      v[6] = x0 + glyph->width;  v[7] = y0 + glyph->height;
+      x   += glyph->advance_x;
+      quads++;
+   }
+
+   return quads;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned i, frame;
+   retro_time_t start;
+   retro_time_t t_measure         = 0;
+   retro_time_t t_measure_cached  = 0;
+   retro_time_t t_emit            = 0;
+   retro_time_t t_churn           = 0;
+   char labels[BENCH_LABELS][128];
+   unsigned lens[BENCH_LABELS];
+   const char *font_path          = NULL;
+   unsigned frames                = 1000;
+   unsigned words                 = sizeof(bench_words) / sizeof(bench_words[0]);
+   long checksum                  = 0;
+   font_width_cache_t *cache      = NULL;
+   void *font                     = NULL;
+
+   if (argc > 1)
+      font_path = argv[1];
+   if (argc > 2)
+      frames    = (unsigned)strtoul(argv[2], NULL, 10);
+
+   if (!(font = stb_unicode_font_renderer.init(font_path, BENCH_FONT_SIZE)))
+   {
+      fprintf(stderr, "Failed to load font.\n");
+      return 1;
+   }
+
+   if (!(cache = font_width_cache_new()))
+      return 1;
+
+   /* Menu-like labels of 2-5 words */
+   srand(1);
+   for (i = 0; i < BENCH_LABELS; i++)
+   {
+      unsigned j;
+      unsigned count = 2 + rand() % 4;
+
+      snprintf(labels[i], sizeof(labels[i]), "%u.", i);
+      for (j = 0; j < count; j++)
+      {
+         strlcat(labels[i], " ", sizeof(labels[i]));
+         strlcat(labels[i], bench_words[rand() % words], sizeof(labels[i]));
+      }
+      lens[i] = (unsigned)strlen(labels[i]);
+   }
+
+   for (frame = 0; frame < frames; frame++)
+   {
+      unsigned quads = 0;
+
+      start = cpu_features_get_time_usec();
+      for (i = 0; i < BENCH_LABELS; i++)
+         checksum += bench_measure(font, labels[i], lens[i]);
+      t_measure += cpu_features_get_time_usec() - start;
+
+      start = cpu_features_get_time_usec();
+      for (i = 0; i < BENCH_LABELS; i++)
+      {
+         int width;
+         if (!font_width_cache_get(cache, labels[i], lens[i], 1.0f, &width))
+         {
+            width = bench_measure(font, labels[i], lens[i]);
+            font_width_cache_set(cache, labels[i], lens[i], 1.0f, width);
+         }
+         checksum += width;
+      }
+      t_measure_cached += cpu_features_get_time_usec() - start;
+
+      start = cpu_features_get_time_usec();
+      for (i = 0; i < BENCH_LABELS; i++)
+         quads = bench_emit(font, labels[i], 0, i * 32, quads);
+      t_emit += cpu_features_get_time_usec() - start;
+      checksum += quads;
+   }
+
+   /* Cycle through twice as many CJK glyphs as the
+    * atlas holds, so that every lookup evicts a slot */
+   start = cpu_features_get_time_usec();
+   for (i = 0; i < 8192; i++)
+   {
+      const struct font_glyph *glyph = stb_unicode_font_renderer.get_glyph(
+            font, 0x4E00 + (i % 512));
+      if (glyph)
+         checksum += glyph->advance_x;
+   }
+   t_churn = cpu_features_get_time_usec() - start;
+
+   printf("%u labels, %u frames\n", BENCH_LABELS, frames);
+   printf("measure (uncached): %8.2f us/frame\n",
+         (double)t_measure / frames);
+   printf("measure (cached):   %8.2f us/frame\n",
+         (double)t_measure_cached / frames);
+   printf("emit quads:         %8.2f us/frame\n",
+         (double)t_emit / frames);
+   printf("glyph eviction:     %8.2f us/glyph\n",
+         (double)t_churn / 8192);
+   printf("checksum: %ld\n", checksum);
+
+   font_width_cache_free(cache);
+   stb_unicode_font_renderer.free(font);
+   return 0;
+}
@@ -0,0 +1,365 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Cold/warm load times of slang shader presets
+ * with the on-disk SPIR-V cache.
+ *
+ * Every pass of each preset is compiled once with an
+ * empty cache directory, then again with the cache
+ * filled by the first run. A second cold load compiles
+ * all passes concurrently, as the preset loaders do.
+ * Warm and parallel results are checked against the
+ * serially compiled SPIR-V. Runs on CPU only.
+ *
+ * Without arguments, a synthetic multi-pass preset
+ * is generated in the cache directory.
+ *
+ * Usage: slang_cache_bench [-v] [cache_dir] [preset.slangp|shader.slang ...] */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <file/config_file.h>
+#include <file/file_path.h>
+#include <lists/dir_list.h>
+#include <streams/file_stream.h>
+#include <string/stdstring.h>
+#include <features/features_cpu.h>
+
+#include "../../../gfx/drivers_shader/glslang_util.h"
+#include "../../../gfx/drivers_shader/glslang_util_cxx.h"
+#include "../../../verbosity.h"
+
+#define BENCH_SYNTHETIC_PASSES 12
+
+static bool bench_verbose;
+
+static void bench_log_v(const char *fmt, va_list ap)
+{
+   if (bench_verbose)
+      vfprintf(stderr, fmt, ap);
+}
+
+void RARCH_LOG_V(const char *tag, const char *fmt, va_list ap)
+{
+   bench_log_v(fmt, ap);
+}
+
+void RARCH_LOG(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   bench_log_v(fmt, ap);
+   va_end(ap);
+}
+
+void RARCH_WARN(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+void RARCH_ERR(const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   vfprintf(stderr, fmt, ap);
+   va_end(ap);
+}
+
+static const char bench_common_source[] =
+   "layout(push_constant) uniform Push\n"
+   "{\n"
+   "   vec4 SourceSize;\n"
+   "   vec4 OutputSize;\n"
+   "   uint FrameCount;\n"
+   "   float SCANLINE_WEIGHT;\n"
+   "   float MASK_STRENGTH;\n"
+   "} params;\n"
+   "\n"
+   "#pragma parameter SCANLINE_WEIGHT \"Scanline Weight\" 0.3 0.0 1.0 0.05\n"
+   "#pragma parameter MASK_STRENGTH \"Mask Strength\" 0.5 0.0 1.0 0.05\n"
+   "\n"
+   "layout(std140, set = 0, binding = 0) uniform UBO\n"
+   "{\n"
+   "   mat4 MVP;\n"
+   "} global;\n"
+   "\n"
+   "vec3 to_linear(vec3 c) { return pow(c, vec3(2.4)); }\n"
+   "vec3 to_gamma(vec3 c)  { return pow(c, vec3(1.0 / 2.2)); }\n"
+   "\n"
+   "float lanczos(float x)\n"
+   "{\n"
+   "   x = max(abs(x), 1e-5);\n"
+   "   return sin(3.14159265 * x) * sin(1.57079632 * x) / (x * x);\n"
+   "}\n";
+
+static void bench_write_synthetic(const char *dir, char *preset, size_t len)
+{
+   unsigned i;
+   char path[PATH_MAX_LENGTH];
+   std::string preset_source;
+
+   path_mkdir(dir);
+
+   fill_pathname_join(path, dir, "common.inc", sizeof(path));
+   filestream_write_file(path, bench_common_source,
+         strlen(bench_common_source));
+
+   preset_source = "shaders = " + std::to_string(BENCH_SYNTHETIC_PASSES)
+      + "\n";
+
+   for (i = 0; i < BENCH_SYNTHETIC_PASSES; i++)
+   {
+      char name[64];
+      std::string taps = std::to_string(4 + i * 2);
+      std::string src  =
+         "#version 450\n"
+         "#include \"common.inc\"\n"
+         "\n"
+         "#pragma stage vertex\n"
+         "layout(location = 0) in vec4 Position;\n"
+         "layout(location = 1) in vec2 TexCoord;\n"
+         "layout(location = 0) out vec2 vTexCoord;\n"
+         "\n"
+         "void main()\n"
+         "{\n"
+         "   gl_Position = global.MVP * Position;\n"
+         "   vTexCoord   = TexCoord;\n"
+         "}\n"
+         "\n"
+         "#pragma stage fragment\n"
+         "layout(location = 0) in vec2 vTexCoord;\n"
+         "layout(location = 0) out vec4 FragColor;\n"
+         "layout(set = 0, binding = 2) uniform sampler2D Source;\n"
+         "\n"
+         "#define TAPS " + taps + "\n"
+         "\n"
+         "vec3 resample(vec2 uv)\n"
+         "{\n"
+         "   vec3 sum  = vec3(0.0);\n"
+         "   float w   = 0.0;\n"
+         "   vec2 texel = params.SourceSize.zw;\n"
+         "   for (int y = -TAPS / 2; y < TAPS / 2; y++)\n"
+         "   {\n"
+         "      for (int x = -TAPS / 2; x < TAPS / 2; x++)\n"
+         "      {\n"
+         "         float k = lanczos(float(x) * 0.5) * lanczos(float(y) * 0.5);\n"
+         "         sum    += k * to_linear(texture(Source,\n"
+         "                  uv + vec2(x, y) * texel).rgb);\n"
+         "         w      += k;\n"
+         "      }\n"
+         "   }\n"
+         "   return sum / w;\n"
+         "}\n"
+         "\n"
+         "void main()\n"
+         "{\n"
+         "   vec3 col     = resample(vTexCoord);\n"
+         "   float line   = fract(vTexCoord.y * params.SourceSize.y);\n"
+         "   float scan   = exp(-pow((line - 0.5) / params.SCANLINE_WEIGHT, 2.0));\n"
+         "   int mask_idx = int(mod(gl_FragCoord.x, 3.0));\n"
+         "   vec3 mask    = vec3(1.0 - params.MASK_STRENGTH);\n"
+         "   mask[mask_idx] = 1.0;\n"
+         "   FragColor    = vec4(to_gamma(col * scan * mask), 1.0);\n"
+         "}\n";
+
+      snprintf(name, sizeof(name), "pass%u.slang", i);
+      fill_pathname_join(path, dir, name, sizeof(path));
+      filestream_write_file(path, src.data(), src.size());
+
+      preset_source += "shader" + std::to_string(i) + " = " + name + "\n";
+   }
+
+   fill_pathname_join(preset, dir, "synthetic.slangp", len);
+   filestream_write_file(preset, preset_source.data(),
+         preset_source.size());
+}
+
+/* Collects the passes of a .slangp preset, or a
+ * single .slang shader */
+static void bench_add_shaders(const char *path,
+      std::vector<std::string> &shaders)
+{
+   unsigned i, count   = 0;
+   config_file_t *conf = NULL;
+
+   if (!string_is_equal_noncase(path_get_extension(path), "slangp"))
+   {
+      shaders.push_back(path);
+      return;
+   }
+
+   if (!(conf = config_file_new_from_path_to_string(path)))
+   {
+      fprintf(stderr, "Could not read preset \"%s\".\n", path);
+      return;
+   }
+
+   config_get_uint(conf, "shaders", &count);
+
+   for (i = 0; i < count; i++)
+   {
+      char key[64];
+      char pass[PATH_MAX_LENGTH];
+      char resolved[PATH_MAX_LENGTH];
+
+      snprintf(key, sizeof(key), "shader%u", i);
+      if (!config_get_path(conf, key, pass, sizeof(pass)))
+         continue;
+
+      fill_pathname_resolve_relative(resolved, path, pass,
+            sizeof(resolved));
+      shaders.push_back(resolved);
+   }
+
+   config_file_free(conf);
+}
+
+static void bench_clear_cache(const char *dir)
+{
+   unsigned i;
+   struct string_list *list = dir_list_new(dir, "spv",
+         false, true, false, false);
+
+   if (!list)
+      return;
+
+   for (i = 0; i < list->size; i++)
+      filestream_delete(list->elems[i].data);
+
+   string_list_free(list);
+}
+
+static bool bench_run(const std::vector<std::string> &shaders,
+      std::vector<glslang_output> &outputs, retro_time_t *time)
+{
+   size_t i;
+   retro_time_t start = cpu_features_get_time_usec();
+
+   outputs.resize(shaders.size());
+
+   for (i = 0; i < shaders.size(); i++)
+   {
+      if (!glslang_compile_shader(shaders[i].c_str(), &outputs[i]))
+      {
+         fprintf(stderr, "Failed to compile \"%s\".\n", shaders[i].c_str());
+         return false;
+      }
+   }
+
+   *time = cpu_features_get_time_usec() - start;
+   return true;
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+   size_t j;
+   char cache_dir[PATH_MAX_LENGTH];
+   std::vector<std::string> shaders;
+   std::vector<glslang_output> cold;
+   std::vector<glslang_output> warm;
+   std::vector<glslang_output> parallel;
+   std::vector<const char*> paths;
+   retro_time_t cold_time     = 0;
+   retro_time_t warm_time     = 0;
+   retro_time_t parallel_time = 0;
+   int arg                = 1;
+
+   if (arg < argc && string_is_equal(argv[arg], "-v"))
+   {
+      bench_verbose = true;
+      arg++;
+   }
+
+   strlcpy(cache_dir, (arg < argc) ? argv[arg++] : "slang_cache_bench.tmp",
+         sizeof(cache_dir));
+   path_mkdir(cache_dir);
+
+   if (arg >= argc)
+   {
+      char dir[PATH_MAX_LENGTH];
+      char preset[PATH_MAX_LENGTH];
+
+      fill_pathname_join(dir, cache_dir, "synthetic", sizeof(dir));
+      bench_write_synthetic(dir, preset, sizeof(preset));
+      bench_add_shaders(preset, shaders);
+   }
+
+   for (i = arg; i < argc; i++)
+      bench_add_shaders(argv[i], shaders);
+
+   if (shaders.empty())
+      return 1;
+
+   glslang_set_spirv_cache_dir(cache_dir);
+   bench_clear_cache(cache_dir);
+
+   if (!bench_run(shaders, cold, &cold_time))
+      return 1;
+   if (!bench_run(shaders, warm, &warm_time))
+      return 1;
+
+   for (j = 0; j < shaders.size(); j++)
+      paths.push_back(shaders[j].c_str());
+
+   bench_clear_cache(cache_dir);
+   parallel_time = cpu_features_get_time_usec();
+   if (!glslang_compile_shaders(paths.data(), (unsigned)paths.size(),
+            &parallel))
+      return 1;
+   parallel_time = cpu_features_get_time_usec() - parallel_time;
+
+   for (j = 0; j < shaders.size(); j++)
+   {
+      if (     cold[j].vertex   != warm[j].vertex
+            || cold[j].fragment != warm[j].fragment)
+      {
+         fprintf(stderr, "Cached SPIR-V differs for \"%s\".\n",
+               shaders[j].c_str());
+         return 1;
+      }
+
+      if (     cold[j].vertex   != parallel[j].vertex
+            || cold[j].fragment != parallel[j].fragment)
+      {
+         fprintf(stderr, "Parallel SPIR-V differs for \"%s\".\n",
+               shaders[j].c_str());
+         return 1;
+      }
+   }
+
+   printf("%u passes, %u cores\n", (unsigned)shaders.size(),
+         cpu_features_get_core_amount());
+   printf("cold (glslang):    %10.2f ms\n", cold_time / 1000.0);
+   printf("cold (parallel):   %10.2f ms\n", parallel_time / 1000.0);
+   printf("warm (SPIR-V hit): %10.2f ms\n", warm_time / 1000.0);
+   printf("parallel speedup:  %10.1fx\n",
+         parallel_time ? (double)cold_time / parallel_time : 0.0);
+   printf("warm speedup:      %10.1fx\n",
+         warm_time ? (double)cold_time / warm_time : 0.0);
+
+   return 0;
+}
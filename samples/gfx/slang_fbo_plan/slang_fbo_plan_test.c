@@ -0,0 +1,193 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Framebuffer plan of a synthetic 20-pass chain
+ * rendering a 320x240 input to a 4K viewport.
+ *
+ * Checks that no framebuffer is written while a later
+ * pass still samples it, that passes sharing a framebuffer
+ * have the same size and format, and that feedback passes
+ * keep their own. Prints the offscreen memory with one
+ * framebuffer per pass and with the plan.
+ *
+ * Runs on CPU only. */
+
+#include <stdio.h>
+#include <math.h>
+
+#include "../../../gfx/drivers_shader/slang_fbo_plan.h"
+
+#define TEST_PASSES      20
+#define TEST_INPUT_W     320
+#define TEST_INPUT_H     240
+#define TEST_VIEWPORT_W  3840
+#define TEST_VIEWPORT_H  2160
+
+/* Bytes per pixel, indexed by 'format' */
+static const unsigned test_format_bytes[] = { 4, 8 };
+
+struct test_pass
+{
+   enum slang_fbo_plan_scale type;
+   float scale;
+   unsigned format;
+   unsigned levels;
+   bool feedback;
+   /* Passes sampled as PassOutput, besides Source */
+   int reads[2];
+};
+
+/* Loosely modelled on the larger CRT presets: linearize,
+ * a blur pyramid, bloom and halation at viewport size,
+ * and a final mask pass. */
+static const struct test_pass test_chain[TEST_PASSES] =
+{
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 1, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 1, 1, true,  { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 1, 1, false, {  0, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   0.5f, 1, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   0.5f, 1, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   0.5f, 1, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   0.5f, 1, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_ORIGINAL, 1.0f, 1, 1, false, {  2, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 1, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 1, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_VIEWPORT, 1.0f, 0, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 0, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 0, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_VIEWPORT, 1.0f, 0, 1, false, {  9, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 0, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 0, 1, false, { 11, -1 } },
+   { SLANG_FBO_PLAN_SCALE_VIEWPORT, 1.0f, 0, 1, false, { -1, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 0, 1, false, { 13, -1 } },
+   { SLANG_FBO_PLAN_SCALE_SOURCE,   1.0f, 0, 1, false, { 15, 16 } },
+   /* Final pass, renders to the backbuffer */
+   { SLANG_FBO_PLAN_SCALE_VIEWPORT, 1.0f, 0, 1, false, { 17, -1 } },
+};
+
+static unsigned test_scale(enum slang_fbo_plan_scale type, float scale,
+      unsigned original, unsigned source, unsigned viewport)
+{
+   switch (type)
+   {
+      case SLANG_FBO_PLAN_SCALE_ORIGINAL:
+         return (unsigned)roundf(original * scale);
+      case SLANG_FBO_PLAN_SCALE_SOURCE:
+         return (unsigned)roundf(source * scale);
+      case SLANG_FBO_PLAN_SCALE_VIEWPORT:
+         return (unsigned)roundf(viewport * scale);
+      default:
+         break;
+   }
+
+   return (unsigned)scale;
+}
+
+int main(void)
+{
+   unsigned i, j, k;
+   unsigned num_framebuffers;
+   unsigned num_passes          = TEST_PASSES - 1;
+   unsigned width               = TEST_INPUT_W;
+   unsigned height              = TEST_INPUT_H;
+   unsigned widths[TEST_PASSES];
+   unsigned heights[TEST_PASSES];
+   unsigned slots[TEST_PASSES];
+   size_t slot_bytes[TEST_PASSES] = {0};
+   struct slang_fbo_plan_pass plan[TEST_PASSES];
+   size_t dedicated             = 0;
+   size_t planned               = 0;
+
+   for (i = 0; i < num_passes; i++)
+   {
+      const struct test_pass *pass = &test_chain[i];
+
+      width      = test_scale(pass->type, pass->scale,
+            TEST_INPUT_W, width, TEST_VIEWPORT_W);
+      height     = test_scale(pass->type, pass->scale,
+            TEST_INPUT_H, height, TEST_VIEWPORT_H);
+      widths[i]  = width;
+      heights[i] = height;
+
+      plan[i].scale_type_x = pass->type;
+      plan[i].scale_type_y = pass->type;
+      plan[i].scale_x      = pass->scale;
+      plan[i].scale_y      = pass->scale;
+      plan[i].format       = pass->format;
+      plan[i].levels       = pass->levels;
+      plan[i].feedback     = pass->feedback;
+      plan[i].last_reader  = i + 1;
+
+      for (j = i + 2; j < TEST_PASSES; j++)
+         for (k = 0; k < 2; k++)
+            if (test_chain[j].reads[k] == (int)i)
+               plan[i].last_reader = j;
+
+      dedicated += (size_t)width * height
+         * test_format_bytes[pass->format] * (pass->feedback ? 2 : 1);
+   }
+
+   num_framebuffers = slang_fbo_plan(plan, num_passes, slots);
+
+   for (i = 0; i < num_passes; i++)
+   {
+      for (j = i + 1; j < num_passes; j++)
+      {
+         if (slots[j] != slots[i])
+            continue;
+
+         if (j <= plan[i].last_reader)
+         {
+            printf("FAIL: pass #%u overwrites pass #%u, read until #%u.\n",
+                  j, i, plan[i].last_reader);
+            return 1;
+         }
+
+         if (     widths[j]      != widths[i]
+               || heights[j]     != heights[i]
+               || plan[j].format != plan[i].format)
+         {
+            printf("FAIL: passes #%u and #%u differ in size or format.\n",
+                  i, j);
+            return 1;
+         }
+
+         if (plan[i].feedback || plan[j].feedback)
+         {
+            printf("FAIL: feedback pass #%u is shared.\n",
+                  plan[i].feedback ? i : j);
+            return 1;
+         }
+      }
+
+      slot_bytes[slots[i]] = (size_t)widths[i] * heights[i]
+         * test_format_bytes[plan[i].format]
+         * (plan[i].feedback ? 2 : 1);
+   }
+
+   for (i = 0; i < num_framebuffers; i++)
+      planned += slot_bytes[i];
+
+   for (i = 0; i < num_passes; i++)
+      printf("pass #%2u: %4ux%-4u -> framebuffer %u\n",
+            i, widths[i], heights[i], slots[i]);
+
+   printf("%u offscreen passes, %u framebuffers\n",
+         num_passes, num_framebuffers);
+   printf("dedicated: %8.2f MiB\n", dedicated / (1024.0 * 1024.0));
+   printf("planned:   %8.2f MiB\n", planned   / (1024.0 * 1024.0));
+
+   return 0;
+}
@@ -108,13 +108,24 @@ static bool screenshot_dump_direct(screenshot_task_state_t *state)
 
    scaler_ctx_gen_reset(&state->scaler);
 
-   ret = rpng_save_image_bgr24(
-         state->filename,
-         state->out_buffer,
-         state->width,
-         state->height,
-         state->width * 3
-         );
+   /* While content is running, encoding competes with
+    * the core for CPU time, so favour speed over size. */
+   if (state->is_idle || state->is_paused)
+      ret = rpng_save_image_bgr24(
+            state->filename,
+            state->out_buffer,
+            state->width,
+            state->height,
+            state->width * 3
+            );
+   else
+      ret = rpng_save_image_bgr24_fast(
+            state->filename,
+            state->out_buffer,
+            state->width,
+            state->height,
+            state->width * 3
+            );
 
    free(state->out_buffer);
 #elif defined(HAVE_RBMP)
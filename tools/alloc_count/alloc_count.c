@@ -0,0 +1,74 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Counts calls to malloc, calloc, realloc and the aligned
+ * allocators. RetroArch looks up alloc_count_get() when
+ * it runs a benchmark (--benchmark) and reports the number
+ * of allocations per frame. */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+
+static uint64_t alloc_count;
+
+#define ALLOC_COUNT_INC() __atomic_fetch_add(&alloc_count, 1, __ATOMIC_RELAXED)
+
+uint64_t alloc_count_get(void)
+{
+   return __atomic_load_n(&alloc_count, __ATOMIC_RELAXED);
+}
+
+void *malloc(size_t size)
+{
+   ALLOC_COUNT_INC();
+   return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+   ALLOC_COUNT_INC();
+   return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+   ALLOC_COUNT_INC();
+   return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size)
+{
+   ALLOC_COUNT_INC();
+   return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+   ALLOC_COUNT_INC();
+   return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+   ALLOC_COUNT_INC();
+   *ptr = __libc_memalign(alignment, size);
+   return *ptr ? 0 : ENOMEM;
+}
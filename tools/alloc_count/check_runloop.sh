@@ -0,0 +1,41 @@
+#!/bin/sh
+
+# usage: check_runloop.sh <retroarch> <core> [content] [config]
+#
+# Runs the core headless for a few thousand frames under the allocation
+# counter and fails if the steady-state frame path allocates. Pass a
+# config enabling the FPS/frame count/memory/statistics overlays to
+# check those paths as well.
+
+RETROARCH=$1
+CORE=$2
+CONTENT=$3
+CONFIG=${4:-/dev/null}
+FRAMES=3000
+
+if [ -z "$RETROARCH" ] || [ -z "$CORE" ]; then
+   echo "usage: $0 <retroarch> <core> [content] [config]"
+   exit 1
+fi
+
+cd "$(dirname "$0")" && make -s || exit 1
+LIB=$(pwd)/alloc_count.so
+cd - > /dev/null
+
+OUT=$(LD_PRELOAD="$LIB" "$RETROARCH" -c "$CONFIG" -L "$CORE" \
+   --benchmark=$FRAMES $CONTENT 2>/dev/null)
+echo "$OUT"
+
+ALLOCS=$(echo "$OUT" | sed -n 's/^Allocations: *\([0-9.]*\) per frame$/\1/p')
+
+if [ -z "$ALLOCS" ]; then
+   echo "FAIL: no allocation count reported"
+   exit 1
+fi
+
+if [ "$ALLOCS" != "0.00" ]; then
+   echo "FAIL: $ALLOCS allocations per frame"
+   exit 1
+fi
+
+echo "OK: no allocations per frame"
@@ -0,0 +1,514 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2011-2020 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Loopback proxy putting a lossy link between a netplay client and host.
+ *
+ * TCP and UDP on the listening port are forwarded to the same protocol on
+ * the host's port, both ways, with added latency and jitter. A lost UDP
+ * packet is gone. A lost TCP segment is modelled the way the peer sees it:
+ * the stream stalls for a retransmission timeout and everything behind it
+ * waits.
+ *
+ * Null input never changes, so nothing is ever mispredicted. Give each
+ * instance's network remote pad port with -p to have the shaper press
+ * buttons on it. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#define SHAPER_MAX_PACKET 65536
+#define SHAPER_MAX_PADS   4
+
+/* Same layout as RetroArch's network remote pad, host byte order */
+struct shaper_pad_message
+{
+   int port;
+   int device;
+   int index;
+   int id;
+   unsigned short state;
+};
+
+struct shaper_pad
+{
+   int fd;
+   long long next;
+   unsigned short buttons;
+};
+
+struct shaper_item
+{
+   struct shaper_item *next;
+   long long deliver;
+   size_t len;
+   char data[1];
+};
+
+struct shaper_queue
+{
+   struct shaper_item *head;
+   struct shaper_item *tail;
+   long long last;
+};
+
+struct shaper_stats
+{
+   unsigned long sent;
+   unsigned long lost;
+};
+
+static double shaper_loss;
+static long long shaper_latency;
+static long long shaper_jitter;
+static long long shaper_rto = 200 * 1000;
+
+static long long shaper_now(void)
+{
+   struct timeval tv;
+   gettimeofday(&tv, NULL);
+   return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static int shaper_lost(void)
+{
+   return shaper_loss > 0 && rand() < shaper_loss * ((double)RAND_MAX + 1.0);
+}
+
+static long long shaper_delay(void)
+{
+   long long delay = shaper_latency;
+   if (shaper_jitter > 0)
+      delay += (long long)(rand() % (2 * shaper_jitter + 1)) - shaper_jitter;
+   return delay > 0 ? delay : 0;
+}
+
+static void shaper_push(struct shaper_queue *queue, long long deliver,
+      const char *data, size_t len)
+{
+   struct shaper_item *item = (struct shaper_item*)
+      malloc(sizeof(*item) + len);
+   struct shaper_item **pos = &queue->head;
+
+   if (!item)
+      return;
+
+   item->next    = NULL;
+   item->deliver = deliver;
+   item->len     = len;
+   memcpy(item->data, data, len);
+
+   /* Sorted by delivery time, so jitter may reorder datagrams */
+   while (*pos && (*pos)->deliver <= deliver)
+      pos = &(*pos)->next;
+   item->next = *pos;
+   *pos       = item;
+   if (!item->next)
+      queue->tail = item;
+}
+
+static struct shaper_item *shaper_pop(struct shaper_queue *queue,
+      long long now)
+{
+   struct shaper_item *item = queue->head;
+   if (!item || item->deliver > now)
+      return NULL;
+   queue->head = item->next;
+   if (!queue->head)
+      queue->tail = NULL;
+   return item;
+}
+
+static void shaper_clear(struct shaper_queue *queue)
+{
+   struct shaper_item *item;
+   while ((item = shaper_pop(queue, 0x7FFFFFFFFFFFFFFFLL)))
+      free(item);
+   queue->last = 0;
+}
+
+/* TCP stays in order: nothing overtakes a delayed or retransmitted chunk */
+static void shaper_push_tcp(struct shaper_queue *queue,
+      struct shaper_stats *stats, const char *data, size_t len)
+{
+   long long deliver = shaper_now() + shaper_delay();
+
+   if (shaper_lost())
+   {
+      deliver += shaper_rto;
+      stats->lost++;
+   }
+   if (deliver < queue->last)
+      deliver = queue->last;
+   queue->last = deliver;
+   stats->sent++;
+
+   shaper_push(queue, deliver, data, len);
+}
+
+static void shaper_push_udp(struct shaper_queue *queue,
+      struct shaper_stats *stats, const char *data, size_t len)
+{
+   stats->sent++;
+   if (shaper_lost())
+   {
+      stats->lost++;
+      return;
+   }
+   shaper_push(queue, shaper_now() + shaper_delay(), data, len);
+}
+
+static int shaper_socket(int type, unsigned short port, int do_bind)
+{
+   struct sockaddr_in addr;
+   int one = 1;
+   int fd  = socket(AF_INET, type, 0);
+
+   if (fd < 0)
+      return -1;
+
+   memset(&addr, 0, sizeof(addr));
+   addr.sin_family      = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   addr.sin_port        = htons(port);
+
+   setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+   if (type == SOCK_STREAM)
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+   if (do_bind
+         ? bind(fd, (struct sockaddr*)&addr, sizeof(addr))
+         : connect(fd, (struct sockaddr*)&addr, sizeof(addr)))
+   {
+      close(fd);
+      return -1;
+   }
+
+   return fd;
+}
+
+static void shaper_flush(int fd, struct shaper_queue *queue, long long now,
+      const struct sockaddr *to, socklen_t to_len)
+{
+   struct shaper_item *item;
+
+   while ((item = shaper_pop(queue, now)))
+   {
+      if (to)
+         sendto(fd, item->data, item->len, 0, to, to_len);
+      else
+      {
+         /* Loopback buffers are large, so a short write means the peer
+          * stopped reading and the stream is as good as dead */
+         size_t done = 0;
+         while (done < item->len)
+         {
+            ssize_t ret = send(fd, item->data + done, item->len - done, 0);
+            if (ret <= 0)
+               break;
+            done += ret;
+         }
+      }
+      free(item);
+   }
+}
+
+static long long shaper_next(const struct shaper_queue *queue,
+      long long next)
+{
+   if (queue->head && queue->head->deliver < next)
+      return queue->head->deliver;
+   return next;
+}
+
+/* Hold or release B, Y, A or X every tenth to half a second. Face buttons
+ * rather than the D-pad, which netplay keeps predicting from stale input
+ * while it resimulates, so every late frame of it rolls back again. */
+static void shaper_press(struct shaper_pad *pad, long long now)
+{
+   static const int ids[] = { 0, 1, 8, 9 };
+   struct shaper_pad_message msg;
+   int id = ids[rand() % 4];
+
+   pad->buttons ^= 1 << id;
+
+   memset(&msg, 0, sizeof(msg));
+   msg.device = 1; /* RETRO_DEVICE_JOYPAD */
+   msg.id     = id;
+   msg.state  = (pad->buttons >> id) & 1;
+   send(pad->fd, (const char*)&msg, sizeof(msg), 0);
+
+   pad->next  = now + (100 + rand() % 400) * 1000LL;
+}
+
+static void shaper_usage(const char *name)
+{
+   fprintf(stderr,
+         "usage: %s <listen port> <host port> [options]\n"
+         "  -l <percent>   packet loss (default 0)\n"
+         "  -d <ms>        one-way latency (default 0)\n"
+         "  -j <ms>        jitter, added as +/- up to this (default 0)\n"
+         "  -r <ms>        TCP retransmission timeout (default 200)\n"
+         "  -s <seed>      random seed\n"
+         "  -p <port>      press buttons on a network remote pad port,\n"
+         "                 may be given up to %d times\n",
+         name, SHAPER_MAX_PADS);
+}
+
+int main(int argc, char **argv)
+{
+   int i;
+   struct shaper_pad pads[SHAPER_MAX_PADS];
+   int num_pads = 0;
+   unsigned short listen_port, host_port;
+   int listen_fd, udp_fd, udp_host_fd;
+   int client_fd = -1, host_fd = -1;
+   struct shaper_queue tcp_up, tcp_down, udp_up, udp_down;
+   struct shaper_stats tcp_stats, udp_stats;
+   struct sockaddr_storage udp_client;
+   socklen_t udp_client_len = 0;
+   static char buf[SHAPER_MAX_PACKET];
+   unsigned seed            = (unsigned)time(NULL);
+
+   if (argc < 3)
+   {
+      shaper_usage(argv[0]);
+      return 1;
+   }
+
+   listen_port = (unsigned short)atoi(argv[1]);
+   host_port   = (unsigned short)atoi(argv[2]);
+
+   for (i = 3; i + 1 < argc; i += 2)
+   {
+      if (!strcmp(argv[i], "-l"))
+         shaper_loss    = atof(argv[i + 1]) / 100.0;
+      else if (!strcmp(argv[i], "-d"))
+         shaper_latency = (long long)(atof(argv[i + 1]) * 1000);
+      else if (!strcmp(argv[i], "-j"))
+         shaper_jitter  = (long long)(atof(argv[i + 1]) * 1000);
+      else if (!strcmp(argv[i], "-r"))
+         shaper_rto     = (long long)(atof(argv[i + 1]) * 1000);
+      else if (!strcmp(argv[i], "-s"))
+         seed           = (unsigned)atoi(argv[i + 1]);
+      else if (!strcmp(argv[i], "-p") && num_pads < SHAPER_MAX_PADS)
+      {
+         pads[num_pads].fd      = shaper_socket(SOCK_DGRAM,
+               (unsigned short)atoi(argv[i + 1]), 0);
+         pads[num_pads].next    = 0;
+         pads[num_pads].buttons = 0;
+         if (pads[num_pads].fd < 0)
+         {
+            perror("netplay_shaper");
+            return 1;
+         }
+         num_pads++;
+      }
+      else
+      {
+         shaper_usage(argv[0]);
+         return 1;
+      }
+   }
+   if (i != argc)
+   {
+      shaper_usage(argv[0]);
+      return 1;
+   }
+
+   srand(seed);
+   signal(SIGPIPE, SIG_IGN);
+
+   memset(&tcp_up,    0, sizeof(tcp_up));
+   memset(&tcp_down,  0, sizeof(tcp_down));
+   memset(&udp_up,    0, sizeof(udp_up));
+   memset(&udp_down,  0, sizeof(udp_down));
+   memset(&tcp_stats, 0, sizeof(tcp_stats));
+   memset(&udp_stats, 0, sizeof(udp_stats));
+
+   listen_fd   = shaper_socket(SOCK_STREAM, listen_port, 1);
+   udp_fd      = shaper_socket(SOCK_DGRAM,  listen_port, 1);
+   udp_host_fd = shaper_socket(SOCK_DGRAM,  host_port,   0);
+   if (listen_fd < 0 || udp_fd < 0 || udp_host_fd < 0 ||
+         listen(listen_fd, 1) < 0)
+   {
+      perror("netplay_shaper");
+      return 1;
+   }
+
+   fprintf(stderr, "netplay_shaper: %hu -> %hu, %.1f%% loss, "
+         "%lld ms latency, %lld ms jitter, %lld ms RTO, seed %u\n",
+         listen_port, host_port, shaper_loss * 100.0,
+         shaper_latency / 1000, shaper_jitter / 1000, shaper_rto / 1000,
+         seed);
+
+   for (;;)
+   {
+      fd_set fds;
+      struct timeval tv;
+      int max_fd     = listen_fd;
+      long long now  = shaper_now();
+      long long next = now + 100 * 1000;
+
+      shaper_flush(udp_host_fd, &udp_up, now, NULL, 0);
+      if (udp_client_len)
+         shaper_flush(udp_fd, &udp_down, now,
+               (struct sockaddr*)&udp_client, udp_client_len);
+      if (host_fd >= 0)
+         shaper_flush(host_fd, &tcp_up, now, NULL, 0);
+      if (client_fd >= 0)
+         shaper_flush(client_fd, &tcp_down, now, NULL, 0);
+
+      for (i = 0; i < num_pads; i++)
+      {
+         if (pads[i].next <= now)
+            shaper_press(&pads[i], now);
+         if (pads[i].next < next)
+            next = pads[i].next;
+      }
+
+      next = shaper_next(&udp_up,   next);
+      next = shaper_next(&udp_down, next);
+      next = shaper_next(&tcp_up,   next);
+      next = shaper_next(&tcp_down, next);
+
+      FD_ZERO(&fds);
+      FD_SET(listen_fd, &fds);
+      FD_SET(udp_fd, &fds);
+      FD_SET(udp_host_fd, &fds);
+      if (udp_fd > max_fd)
+         max_fd = udp_fd;
+      if (udp_host_fd > max_fd)
+         max_fd = udp_host_fd;
+      if (client_fd >= 0)
+      {
+         FD_SET(client_fd, &fds);
+         FD_SET(host_fd, &fds);
+         if (client_fd > max_fd)
+            max_fd = client_fd;
+         if (host_fd > max_fd)
+            max_fd = host_fd;
+      }
+
+      now        = shaper_now();
+      if (next < now)
+         next    = now;
+      tv.tv_sec  = (long)((next - now) / 1000000);
+      tv.tv_usec = (long)((next - now) % 1000000);
+
+      if (select(max_fd + 1, &fds, NULL, NULL, &tv) < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         perror("netplay_shaper");
+         return 1;
+      }
+
+      if (FD_ISSET(listen_fd, &fds))
+      {
+         int fd = accept(listen_fd, NULL, NULL);
+         if (fd >= 0)
+         {
+            int one = 1;
+            if (client_fd >= 0)
+               close(fd);
+            else if ((host_fd = shaper_socket(SOCK_STREAM, host_port, 0)) < 0)
+            {
+               perror("netplay_shaper");
+               close(fd);
+            }
+            else
+            {
+               setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+               client_fd = fd;
+            }
+         }
+      }
+
+      if (FD_ISSET(udp_fd, &fds))
+      {
+         struct sockaddr_storage from;
+         socklen_t from_len = sizeof(from);
+         ssize_t len        = recvfrom(udp_fd, buf, sizeof(buf), 0,
+               (struct sockaddr*)&from, &from_len);
+         if (len > 0)
+         {
+            /* Replies go wherever the client last sent from */
+            memcpy(&udp_client, &from, from_len);
+            udp_client_len = from_len;
+            shaper_push_udp(&udp_up, &udp_stats, buf, (size_t)len);
+         }
+      }
+
+      if (FD_ISSET(udp_host_fd, &fds))
+      {
+         ssize_t len = recv(udp_host_fd, buf, sizeof(buf), 0);
+         if (len > 0)
+            shaper_push_udp(&udp_down, &udp_stats, buf, (size_t)len);
+      }
+
+      if (client_fd >= 0)
+      {
+         int closed = 0;
+
+         if (FD_ISSET(client_fd, &fds))
+         {
+            ssize_t len = recv(client_fd, buf, sizeof(buf), 0);
+            if (len > 0)
+               shaper_push_tcp(&tcp_up, &tcp_stats, buf, (size_t)len);
+            else
+               closed = 1;
+         }
+
+         if (FD_ISSET(host_fd, &fds))
+         {
+            ssize_t len = recv(host_fd, buf, sizeof(buf), 0);
+            if (len > 0)
+               shaper_push_tcp(&tcp_down, &tcp_stats, buf, (size_t)len);
+            else
+               closed = 1;
+         }
+
+         if (closed)
+         {
+            fprintf(stderr, "netplay_shaper: connection closed, "
+                  "TCP %lu/%lu segments lost, UDP %lu/%lu packets lost\n",
+                  tcp_stats.lost, tcp_stats.sent,
+                  udp_stats.lost, udp_stats.sent);
+            close(client_fd);
+            close(host_fd);
+            client_fd = -1;
+            host_fd   = -1;
+            shaper_clear(&tcp_up);
+            shaper_clear(&tcp_down);
+            memset(&tcp_stats, 0, sizeof(tcp_stats));
+            memset(&udp_stats, 0, sizeof(udp_stats));
+         }
+      }
+   }
+
+   return 0;
+}
@@ -0,0 +1,98 @@
+#!/bin/sh
+
+# usage: run_loopback.sh <retroarch> <core> [content]
+#
+# Plays a headless netplay session between two instances on loopback, with
+# netplay_shaper between them, once with input over TCP and once over UDP,
+# and prints what each side reports for rollbacks and stalls. The shaper
+# presses random buttons on both instances through their network remote
+# pads, so there is input to mispredict.
+#
+# The link is set through the environment:
+#   LOSS=<percent> LATENCY=<ms> JITTER=<ms> RTO=<ms> FRAMES=<n> SEED=<n>
+
+RETROARCH=$1
+CORE=$2
+CONTENT=$3
+LOSS=${LOSS:-2}
+LATENCY=${LATENCY:-30}
+JITTER=${JITTER:-10}
+RTO=${RTO:-200}
+FRAMES=${FRAMES:-3600}
+SEED=${SEED:-1}
+PORT=55435
+PROXY_PORT=55436
+HOST_PAD_PORT=55440
+CLIENT_PAD_PORT=55450
+
+if [ -z "$RETROARCH" ] || [ -z "$CORE" ]; then
+   echo "usage: $0 <retroarch> <core> [content]"
+   exit 1
+fi
+
+cd "$(dirname "$0")" && make -s || exit 1
+SHAPER=$(pwd)/netplay_shaper
+cd - > /dev/null
+
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+
+config()
+{
+   mkdir -p "$DIR/$1"
+   if [ "$1" = host ]; then PAD_PORT=$HOST_PAD_PORT; else PAD_PORT=$CLIENT_PAD_PORT; fi
+   cat > "$DIR/$1/retroarch.cfg" << CFG
+video_driver = "null"
+audio_driver = "null"
+input_driver = "null"
+input_joypad_driver = "null"
+vrr_runloop_enable = "true"
+netplay_nat_traversal = "false"
+netplay_nickname = "$1"
+netplay_udp_input = "$2"
+network_remote_enable = "true"
+network_remote_enable_user_p1 = "true"
+network_remote_base_port = "$PAD_PORT"
+savestate_directory = "$DIR/$1"
+savefile_directory = "$DIR/$1"
+system_directory = "$DIR/$1"
+core_options_path = "$DIR/$1/retroarch-core-options.cfg"
+content_history_path = "$DIR/$1/history.lpl"
+CFG
+}
+
+session()
+{
+   config host "$1"
+   config client "$1"
+
+   "$RETROARCH" -c "$DIR/host/retroarch.cfg" -L "$CORE" --host \
+      --port $PORT --max-frames=$FRAMES -v $CONTENT > "$DIR/host.log" 2>&1 &
+   HOST=$!
+   sleep 1
+
+   "$SHAPER" $PROXY_PORT $PORT -l "$LOSS" -d "$LATENCY" -j "$JITTER" \
+      -r "$RTO" -s "$SEED" \
+      -p $HOST_PAD_PORT -p $CLIENT_PAD_PORT > "$DIR/shaper.log" 2>&1 &
+   PROXY=$!
+   sleep 1
+
+   "$RETROARCH" -c "$DIR/client/retroarch.cfg" -L "$CORE" \
+      --connect 127.0.0.1 --port $PROXY_PORT --max-frames=$FRAMES -v \
+      $CONTENT > "$DIR/client.log" 2>&1
+   wait $HOST
+   kill $PROXY
+   wait $PROXY 2> /dev/null
+
+   for SIDE in host client; do
+      sed -n "s/^.*\[netplay\] \(Session: .*\|UDP: .*\)$/  $SIDE: \1/p" \
+         "$DIR/$SIDE.log"
+   done
+   sed -n 's/^netplay_shaper: connection closed, /  link: /p' "$DIR/shaper.log"
+}
+
+echo "Link: $LOSS% loss, $LATENCY ms latency, $JITTER ms jitter, $RTO ms RTO"
+echo "Input over TCP:"
+session false
+echo "Input over UDP:"
+session true